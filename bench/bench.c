@@ -0,0 +1,260 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the sysd-bench microbenchmark harness.
+ *
+ * Allocations are counted by interposing malloc(), calloc() and realloc()
+ * on top of glibc's, which also catches the ones OVS and config-yaml make.
+ */
+
+/* For nftw(). */
+#define _GNU_SOURCE
+
+#include <config.h>
+
+#include <errno.h>
+#include <ftw.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <json.h>
+#include <util.h>
+
+#include "bench.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+static unsigned long long int alloc_count;
+static unsigned long long int alloc_bytes;
+
+void *
+malloc(size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    return __libc_malloc(size);
+}
+
+void *
+calloc(size_t n, size_t size)
+{
+    alloc_count++;
+    alloc_bytes += n * size;
+    return __libc_calloc(n, size);
+}
+
+void *
+realloc(void *p, size_t size)
+{
+    alloc_count++;
+    alloc_bytes += size;
+    return __libc_realloc(p, size);
+}
+
+unsigned long long int
+bench_alloc_count(void)
+{
+    return alloc_count;
+}
+
+unsigned long long int
+bench_alloc_bytes(void)
+{
+    return alloc_bytes;
+}
+
+long long int
+bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long int) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static long long int bench_min_ns = 200 * 1000 * 1000;
+static const char *bench_filter;
+static struct json *bench_results;
+
+void
+bench_init(long long int min_ns, const char *filter)
+{
+    bench_min_ns = min_ns;
+    bench_filter = filter;
+    bench_results = json_array_create_empty();
+}
+
+int
+bench_selected(const char *name)
+{
+    return !bench_filter || strstr(name, bench_filter) != NULL;
+}
+
+/*
+ * Function       : bench_run
+ * Responsibility : times 'op' in doubling batches after one untimed warm-up
+ *                  call, and records the first batch that runs for at
+ *                  least the minimum time
+ * Parameters     : name, op, aux, items and bytes processed per op
+ * Returns        : void
+ */
+void
+bench_run(const char *name, bench_op_func *op, void *aux,
+          double items, double bytes)
+{
+    unsigned long long int n, i, allocs, alloc_size;
+    long long int elapsed;
+    struct json *result;
+    double ns_per_op;
+
+    if (!bench_selected(name)) {
+        return;
+    }
+
+    op(aux);
+    for (n = 1; ; n *= 2) {
+        unsigned long long int count0 = alloc_count;
+        unsigned long long int bytes0 = alloc_bytes;
+        long long int start = bench_now_ns();
+
+        for (i = 0; i < n; i++) {
+            op(aux);
+        }
+        elapsed = bench_now_ns() - start;
+        allocs = alloc_count - count0;
+        alloc_size = alloc_bytes - bytes0;
+
+        if (elapsed >= bench_min_ns || n >= (1ULL << 40)) {
+            break;
+        }
+    }
+
+    ns_per_op = (double) elapsed / n;
+    result = json_object_create();
+    json_object_put_string(result, "name", name);
+    json_object_put(result, "iterations", json_integer_create(n));
+    json_object_put(result, "ns_per_op", json_real_create(ns_per_op));
+    json_object_put(result, "allocs_per_op",
+                    json_real_create((double) allocs / n));
+    json_object_put(result, "alloc_bytes_per_op",
+                    json_real_create((double) alloc_size / n));
+    if (items) {
+        json_object_put(result, "items_per_sec",
+                        json_real_create(items * 1e9 / ns_per_op));
+    }
+    if (bytes) {
+        json_object_put(result, "bytes_per_sec",
+                        json_real_create(bytes * 1e9 / ns_per_op));
+    }
+    json_array_add(bench_results, result);
+
+    fprintf(stderr, "%-40s %10llu %14.1f ns/op %10.1f allocs/op\n",
+            name, n, ns_per_op, (double) allocs / n);
+}
+
+/* Prints the results recorded so far to stdout as a JSON object. */
+void
+bench_report(void)
+{
+    struct json *report = json_object_create();
+    char *s;
+
+    json_object_put(report, "benchmarks", bench_results);
+    s = json_to_string(report, JSSF_PRETTY);
+    puts(s);
+    free(s);
+    json_destroy(report);
+    bench_results = NULL;
+}
+
+static char *tmpdir;
+
+static int
+bench_remove(const char *path, const struct stat *st OVS_UNUSED,
+             int flag OVS_UNUSED, struct FTW *ftw OVS_UNUSED)
+{
+    return remove(path);
+}
+
+static void
+bench_tmpdir_remove(void)
+{
+    nftw(tmpdir, bench_remove, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+const char *
+bench_tmpdir(void)
+{
+    if (!tmpdir) {
+        tmpdir = xstrdup("/tmp/sysd-bench.XXXXXX");
+        if (!mkdtemp(tmpdir)) {
+            ovs_fatal(errno, "%s: mkdtemp failed", tmpdir);
+        }
+        atexit(bench_tmpdir_remove);
+    }
+    return tmpdir;
+}
+
+/* Creates 'dir' and its parents, like "mkdir -p". */
+static void
+bench_mkdirs(const char *dir)
+{
+    char *copy, *parent;
+
+    if (!mkdir(dir, 0755) || errno == EEXIST) {
+        return;
+    }
+
+    copy = xstrdup(dir);
+    parent = dirname(copy);
+    if (strcmp(parent, dir)) {
+        bench_mkdirs(parent);
+    }
+    free(copy);
+
+    if (mkdir(dir, 0755) && errno != EEXIST) {
+        ovs_fatal(errno, "%s: mkdir failed", dir);
+    }
+}
+
+void
+bench_write_file(const char *path, const char *data, size_t n)
+{
+    char *copy = xstrdup(path);
+    FILE *f;
+
+    bench_mkdirs(dirname(copy));
+    free(copy);
+
+    f = fopen(path, "w");
+    if (!f || fwrite(data, 1, n, f) != n || fclose(f)) {
+        ovs_fatal(errno, "%s: write failed", path);
+    }
+}
+
+/** @} end of group ops-sysd */
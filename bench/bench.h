@@ -0,0 +1,79 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the sysd-bench microbenchmark harness and its kernels.
+ */
+
+#ifndef __SYSD_BENCH_H__
+#define __SYSD_BENCH_H__
+
+#include <stddef.h>
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Runs benchmarks for at least 'min_ns' per batch, only those whose names
+ * contain 'filter' if it is nonnull. */
+void bench_init(long long int min_ns, const char *filter);
+
+/* Prints the results to stdout as {"benchmarks": [...]}. */
+void bench_report(void);
+
+/* One operation of a benchmark. */
+typedef void bench_op_func(void *aux);
+
+/* Times 'op' in batches that double in size until a batch runs for the
+ * minimum time, and records the last batch under 'name' as ns/op,
+ * allocations/op and, if 'items' or 'bytes' is nonzero, the items or bytes
+ * processed per second given that each op processes that many.  Does
+ * nothing if 'name' does not match the filter given on the command line. */
+void bench_run(const char *name, bench_op_func *op, void *aux,
+               double items, double bytes);
+
+/* Whether a benchmark called 'name' is going to run.  Kernels use it to
+ * skip building inputs for benchmarks that are filtered out. */
+int bench_selected(const char *name);
+
+long long int bench_now_ns(void);
+
+/* Allocations made through malloc(), calloc() and realloc() so far. */
+unsigned long long int bench_alloc_count(void);
+unsigned long long int bench_alloc_bytes(void);
+
+/* A scratch directory for input files, removed at exit. */
+const char *bench_tmpdir(void);
+
+/* Writes 'n' bytes of 'data' to 'path', creating its directories.  Aborts
+ * on failure. */
+void bench_write_file(const char *path, const char *data, size_t n);
+
+/* The context the kernels run against.  Its IDL is never connected. */
+struct sysd_ctx;
+extern struct sysd_ctx *bench_ctx;
+
+/* Kernels. */
+void bench_eeprom(void);
+void bench_manifest(void);
+void bench_package_info(void);
+void bench_interface(void);
+void bench_qos_init(void);
+void bench_system_show(void);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_BENCH_H__ */
@@ -0,0 +1,710 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Main for sysd-cli-idl-bench, which measures what the columns registered
+ * by the sysd CLI plugin cost every vtysh session.
+ *
+ *     sysd-cli-idl-bench [OPTIONS] REMOTE
+ *
+ * compares the columns the plugin used to register with the ones "show
+ * system" and "show system json" read.  For each set it connects an IDL
+ * that registers the set to the ovsdb-server at REMOTE and reports the
+ * rows it replicates and the bytes of the registered columns' data.  It
+ * then changes a fan's rpm, an LED's state and a temperature sensor's
+ * temperature, and reports the monitor update bytes each change sends to
+ * a client of each set.  If the database has no Subsystem row, it is
+ * populated with one first.
+ *
+ * The IDL does not expose its connection, so updates are counted on a
+ * connection of our own that sends the monitor request the IDL sends for
+ * the set.  Use a scratch ovsdb-server: updates for other writers'
+ * changes would be counted too.
+ */
+
+#include <config.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <json.h>
+#include <jsonrpc.h>
+#include <ovsdb-data.h>
+#include <ovsdb-idl.h>
+#include <ovsdb-idl-provider.h>
+#include <poll-loop.h>
+#include <smap.h>
+#include <stream.h>
+#include <util.h>
+#include <vswitch-idl.h>
+#include <openvswitch/vlog.h>
+
+#include "system_show.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* The columns the plugin registered before it listed the ones each
+ * command reads.  System:switch_version was registered by vtysh. */
+static const struct ovsdb_idl_column *const old_columns[] = {
+    &ovsrec_system_col_switch_version,
+
+    &ovsrec_led_col_id,
+    &ovsrec_led_col_state,
+    &ovsrec_led_col_status,
+    &ovsrec_led_col_other_config,
+    &ovsrec_led_col_external_ids,
+
+    &ovsrec_subsystem_col_interfaces,
+    &ovsrec_subsystem_col_leds,
+    &ovsrec_subsystem_col_fans,
+    &ovsrec_subsystem_col_asset_tag_number,
+    &ovsrec_subsystem_col_name,
+    &ovsrec_subsystem_col_type,
+    &ovsrec_subsystem_col_hw_desc_dir,
+    &ovsrec_subsystem_col_other_info,
+    &ovsrec_subsystem_col_other_config,
+    &ovsrec_subsystem_col_external_ids,
+    &ovsrec_subsystem_col_power_supplies,
+    &ovsrec_subsystem_col_temp_sensors,
+
+    &ovsrec_power_supply_col_name,
+    &ovsrec_power_supply_col_status,
+
+    &ovsrec_temp_sensor_col_name,
+    &ovsrec_temp_sensor_col_location,
+    &ovsrec_temp_sensor_col_temperature,
+
+    &ovsrec_fan_col_status,
+    &ovsrec_fan_col_direction,
+    &ovsrec_fan_col_name,
+    &ovsrec_fan_col_rpm,
+    &ovsrec_fan_col_other_config,
+    &ovsrec_fan_col_hw_config,
+    &ovsrec_fan_col_external_ids,
+    &ovsrec_fan_col_speed,
+};
+
+/* Rows inserted when the database has no Subsystem. */
+#define BENCH_N_FANS 8
+#define BENCH_N_LEDS 4
+#define BENCH_N_PSUS 2
+
+/* Changes one sensor row in the IDL's open transaction.  Returns false if
+ * there is no row to change. */
+typedef bool bench_change_func(struct ovsdb_idl *);
+
+static bool
+change_fan_rpm(struct ovsdb_idl *idl)
+{
+    const struct ovsrec_fan *fan = ovsrec_fan_first(idl);
+    int64_t rpm;
+
+    if (!fan) {
+        return false;
+    }
+    rpm = fan->n_rpm ? fan->rpm[0] + 1 : 1;
+    ovsrec_fan_set_rpm(fan, &rpm, 1);
+    return true;
+}
+
+static bool
+change_led_state(struct ovsdb_idl *idl)
+{
+    const struct ovsrec_led *led = ovsrec_led_first(idl);
+
+    if (!led) {
+        return false;
+    }
+    ovsrec_led_set_state(led, (led->state && !strcmp(led->state, "on")
+                               ? "off" : "on"));
+    return true;
+}
+
+static bool
+change_temperature(struct ovsdb_idl *idl)
+{
+    const struct ovsrec_temp_sensor *sensor = ovsrec_temp_sensor_first(idl);
+
+    if (!sensor) {
+        return false;
+    }
+    ovsrec_temp_sensor_set_temperature(sensor, sensor->temperature + 1);
+    return true;
+}
+
+static const struct {
+    const char *name;
+    bench_change_func *change;
+} bench_changes[] = {
+    { "fan_rpm",                 change_fan_rpm },
+    { "led_state",               change_led_state },
+    { "temp_sensor_temperature", change_temperature },
+};
+
+#define BENCH_N_CHANGES ARRAY_SIZE(bench_changes)
+
+struct column_set {
+    const char *name;
+    const struct ovsdb_idl_column **columns;
+    size_t n_columns;
+
+    /* Results. */
+    size_t n_tables;
+    size_t n_rows;
+    size_t replica_bytes;
+    size_t initial_bytes;               /* Reply to the monitor request. */
+    size_t update_bytes[BENCH_N_CHANGES];
+    int n_changes[BENCH_N_CHANGES];     /* Changes made of each kind. */
+    struct jsonrpc *rpc;                /* Monitor connection. */
+};
+
+static void
+column_set_init(struct column_set *set, const char *name,
+                const struct ovsdb_idl_column *const *a, size_t n_a,
+                const struct ovsdb_idl_column *const *b, size_t n_b)
+{
+    memset(set, 0, sizeof *set);
+    set->name = name;
+    set->n_columns = n_a + n_b;
+    set->columns = xmalloc(set->n_columns * sizeof *set->columns);
+    memcpy(set->columns, a, n_a * sizeof *a);
+    if (n_b) {
+        memcpy(set->columns + n_a, b, n_b * sizeof *b);
+    }
+}
+
+static bool
+column_in_table(const struct ovsdb_idl_column *column,
+                const struct ovsdb_idl_table_class *tc)
+{
+    return column >= tc->columns && column < &tc->columns[tc->n_columns];
+}
+
+static bool
+column_refers_to(const struct ovsdb_idl_column *column,
+                 const struct ovsdb_idl_table_class *tc)
+{
+    const struct ovsdb_base_type *key = &column->type.key;
+    const struct ovsdb_base_type *value = &column->type.value;
+
+    return ((key->type == OVSDB_TYPE_UUID && key->u.uuid.refTableName
+             && !strcmp(key->u.uuid.refTableName, tc->name))
+            || (value->type == OVSDB_TYPE_UUID && value->u.uuid.refTableName
+                && !strcmp(value->u.uuid.refTableName, tc->name)));
+}
+
+/*
+ * Function       : monitor_params
+ * Responsibility : builds the "monitor" request an IDL that registers
+ *                  'set' sends.  Like ovsdb_idl_add_column(), a reference
+ *                  column also monitors the rows of the table it refers
+ *                  to, with no columns.
+ * Parameters     : set
+ * Returns        : the request's params
+ */
+static struct json *
+monitor_params(struct column_set *set)
+{
+    struct json *requests = json_object_create();
+    size_t i, j;
+
+    set->n_tables = 0;
+    for (i = 0; i < ovsrec_idl_class.n_tables; i++) {
+        const struct ovsdb_idl_table_class *tc = &ovsrec_idl_class.tables[i];
+        struct json *columns = json_array_create_empty();
+        struct json *request;
+        bool monitored = false;
+
+        for (j = 0; j < set->n_columns; j++) {
+            if (column_in_table(set->columns[j], tc)) {
+                json_array_add(columns,
+                               json_string_create(set->columns[j]->name));
+                monitored = true;
+            } else if (column_refers_to(set->columns[j], tc)) {
+                monitored = true;
+            }
+        }
+
+        if (!monitored) {
+            json_destroy(columns);
+            continue;
+        }
+        request = json_object_create();
+        json_object_put(request, "columns", columns);
+        json_object_put(requests, tc->name, request);
+        set->n_tables++;
+    }
+
+    return json_array_create_3(json_string_create(ovsrec_idl_class.database),
+                               json_null_create(), requests);
+}
+
+/* Returns the length of 'msg' as sent, and frees it. */
+static size_t
+msg_bytes(struct jsonrpc_msg *msg)
+{
+    struct json *json = jsonrpc_msg_to_json(msg);
+    char *s = json_to_string(json, 0);
+    size_t n = strlen(s);
+
+    free(s);
+    json_destroy(json);
+    return n;
+}
+
+static void
+monitor_open(struct column_set *set, const char *remote)
+{
+    struct jsonrpc_msg *request, *reply;
+    struct stream *stream;
+    int error;
+
+    error = stream_open_block(jsonrpc_stream_open(remote, &stream,
+                                                  DSCP_DEFAULT), &stream);
+    if (error) {
+        ovs_fatal(error, "%s: connection failed", remote);
+    }
+    set->rpc = jsonrpc_open(stream);
+
+    request = jsonrpc_create_request("monitor", monitor_params(set), NULL);
+    error = jsonrpc_transact_block(set->rpc, request, &reply);
+    if (error) {
+        ovs_fatal(error, "%s: monitor request failed", remote);
+    }
+    if (reply->type == JSONRPC_ERROR) {
+        char *s = json_to_string(reply->error, 0);
+
+        ovs_fatal(0, "%s: monitor request failed: %s", remote, s);
+    }
+    set->initial_bytes = msg_bytes(reply);
+}
+
+/*
+ * Function       : monitor_drain
+ * Responsibility : receives the updates for every transaction committed
+ *                  so far.  ovsdb-server flushes a client's pending
+ *                  updates before it reads its next request, so they all
+ *                  arrive ahead of the reply to an echo.
+ * Parameters     : set
+ * Returns        : bytes of the "update" notifications received
+ */
+static size_t
+monitor_drain(struct column_set *set)
+{
+    struct jsonrpc_msg *request;
+    size_t bytes = 0;
+    struct json *id;
+    int error;
+
+    request = jsonrpc_create_request("echo", json_array_create_empty(), &id);
+    error = jsonrpc_send_block(set->rpc, request);
+    while (!error) {
+        struct jsonrpc_msg *msg;
+
+        error = jsonrpc_recv_block(set->rpc, &msg);
+        if (error) {
+            break;
+        }
+
+        if (msg->type == JSONRPC_REPLY && json_equal(msg->id, id)) {
+            jsonrpc_msg_destroy(msg);
+            break;
+        } else if (msg->type == JSONRPC_NOTIFY
+                   && !strcmp(msg->method, "update")) {
+            bytes += msg_bytes(msg);
+        } else if (msg->type == JSONRPC_REQUEST
+                   && !strcmp(msg->method, "echo")) {
+            error = jsonrpc_send_block(set->rpc, jsonrpc_create_reply(
+                                           json_clone(msg->params), msg->id));
+            jsonrpc_msg_destroy(msg);
+        } else {
+            jsonrpc_msg_destroy(msg);
+        }
+    }
+    if (error) {
+        ovs_fatal(error, "%s: monitor connection failed",
+                  jsonrpc_get_name(set->rpc));
+    }
+
+    json_destroy(id);
+    return bytes;
+}
+
+static void
+idl_wait_connected(struct ovsdb_idl *idl, const char *remote)
+{
+    for (;;) {
+        ovsdb_idl_run(idl);
+        if (ovsdb_idl_has_ever_connected(idl)) {
+            return;
+        }
+        if (!ovsdb_idl_is_alive(idl)) {
+            ovs_fatal(0, "%s: connection failed", remote);
+        }
+        ovsdb_idl_wait(idl);
+        poll_block();
+    }
+}
+
+/* Commits 'txn' on 'idl' and waits until the replica has the change, so
+ * that the next change builds on it. */
+static void
+idl_commit(struct ovsdb_idl *idl, struct ovsdb_idl_txn *txn)
+{
+    unsigned int seqno = ovsdb_idl_get_seqno(idl);
+    enum ovsdb_idl_txn_status status;
+
+    status = ovsdb_idl_txn_commit_block(txn);
+    if (status != TXN_SUCCESS) {
+        ovs_fatal(0, "transaction failed: %s",
+                  ovsdb_idl_txn_status_to_string(status));
+    }
+    ovsdb_idl_txn_destroy(txn);
+
+    while (ovsdb_idl_get_seqno(idl) == seqno) {
+        ovsdb_idl_run(idl);
+        ovsdb_idl_wait(idl);
+        poll_block();
+    }
+}
+
+static void
+bench_smap(struct smap *smap, const char *prefix, int n)
+{
+    int i;
+
+    smap_init(smap);
+    for (i = 0; i < n; i++) {
+        char *key = xasprintf("%s_key_%d", prefix, i);
+        char *value = xasprintf("%s value %d", prefix, i);
+
+        smap_add(smap, key, value);
+        free(key);
+        free(value);
+    }
+}
+
+/* Inserts a subsystem with 'n_sensors' temperature sensors, and the
+ * columns only the old set reads filled in. */
+static void
+bench_populate(struct ovsdb_idl *idl, int n_sensors)
+{
+    struct ovsdb_idl_txn *txn = ovsdb_idl_txn_create(idl);
+    const struct ovsrec_system *system = ovsrec_system_first(idl);
+    struct ovsrec_subsystem *sys = ovsrec_subsystem_insert(txn);
+    struct ovsrec_fan *fans[BENCH_N_FANS];
+    struct ovsrec_led *leds[BENCH_N_LEDS];
+    struct ovsrec_power_supply *psus[BENCH_N_PSUS];
+    struct ovsrec_temp_sensor **sensors;
+    struct smap other_info, config, hw_config, external_ids;
+    int64_t rpm = 5000;
+    int i;
+
+    smap_init(&other_info);
+    smap_add(&other_info, "Product Name", "bench");
+    smap_add(&other_info, "vendor", "bench");
+    smap_add(&other_info, "platform_name", "x86_64-bench-r0");
+    smap_add(&other_info, "interface_count", "54");
+    smap_add(&other_info, "max_interface_speed", "40000");
+    bench_smap(&config, "config", 4);
+    bench_smap(&hw_config, "hw_config", 4);
+    bench_smap(&external_ids, "external_id", 4);
+
+    ovsrec_subsystem_set_name(sys, "base");
+    ovsrec_subsystem_set_type(sys, "system");
+    ovsrec_subsystem_set_asset_tag_number(sys, "bench-asset-tag");
+    ovsrec_subsystem_set_hw_desc_dir(sys,
+                                     "/etc/openswitch/platform/bench/bench");
+    ovsrec_subsystem_set_other_info(sys, &other_info);
+    ovsrec_subsystem_set_other_config(sys, &config);
+    ovsrec_subsystem_set_external_ids(sys, &external_ids);
+
+    for (i = 0; i < BENCH_N_FANS; i++) {
+        char *name = xasprintf("base-%dL", i + 1);
+
+        fans[i] = ovsrec_fan_insert(txn);
+        ovsrec_fan_set_name(fans[i], name);
+        ovsrec_fan_set_speed(fans[i], "normal");
+        ovsrec_fan_set_status(fans[i], "ok");
+        ovsrec_fan_set_direction(fans[i], "f2b");
+        ovsrec_fan_set_rpm(fans[i], &rpm, 1);
+        ovsrec_fan_set_other_config(fans[i], &config);
+        ovsrec_fan_set_hw_config(fans[i], &hw_config);
+        ovsrec_fan_set_external_ids(fans[i], &external_ids);
+        free(name);
+    }
+    for (i = 0; i < BENCH_N_LEDS; i++) {
+        char *name = xasprintf("base-%d", i + 1);
+
+        leds[i] = ovsrec_led_insert(txn);
+        ovsrec_led_set_id(leds[i], name);
+        ovsrec_led_set_state(leds[i], "on");
+        ovsrec_led_set_status(leds[i], "ok");
+        ovsrec_led_set_other_config(leds[i], &config);
+        ovsrec_led_set_external_ids(leds[i], &external_ids);
+        free(name);
+    }
+    for (i = 0; i < BENCH_N_PSUS; i++) {
+        char *name = xasprintf("base-%d", i + 1);
+
+        psus[i] = ovsrec_power_supply_insert(txn);
+        ovsrec_power_supply_set_name(psus[i], name);
+        ovsrec_power_supply_set_status(psus[i], "ok");
+        free(name);
+    }
+
+    sensors = xmalloc(n_sensors * sizeof *sensors);
+    for (i = 0; i < n_sensors; i++) {
+        char *name = xasprintf("base-%d", i + 1);
+
+        sensors[i] = ovsrec_temp_sensor_insert(txn);
+        ovsrec_temp_sensor_set_name(sensors[i], name);
+        ovsrec_temp_sensor_set_location(sensors[i], "Bench sensor location");
+        ovsrec_temp_sensor_set_temperature(sensors[i], 30000 + i);
+        free(name);
+    }
+
+    ovsrec_subsystem_set_fans(sys, fans, BENCH_N_FANS);
+    ovsrec_subsystem_set_leds(sys, leds, BENCH_N_LEDS);
+    ovsrec_subsystem_set_power_supplies(sys, psus, BENCH_N_PSUS);
+    ovsrec_subsystem_set_temp_sensors(sys, sensors, n_sensors);
+    free(sensors);
+
+    /* Subsystem is not a root table. */
+    if (!system) {
+        system = ovsrec_system_insert(txn);
+    }
+    ovsrec_system_set_subsystems(system, &sys, 1);
+
+    smap_destroy(&other_info);
+    smap_destroy(&config);
+    smap_destroy(&hw_config);
+    smap_destroy(&external_ids);
+
+    idl_commit(idl, txn);
+}
+
+static size_t
+atoms_bytes(const union ovsdb_atom *atoms, unsigned int n,
+            enum ovsdb_atomic_type type)
+{
+    size_t bytes = n * sizeof *atoms;
+    unsigned int i;
+
+    if (type == OVSDB_TYPE_STRING) {
+        for (i = 0; i < n; i++) {
+            bytes += strlen(atoms[i].string) + 1;
+        }
+    }
+    return bytes;
+}
+
+/*
+ * Function       : replica_measure
+ * Responsibility : connects an IDL that registers 'set', as the plugin
+ *                  does, and counts the rows it replicates and the bytes
+ *                  of the registered columns' data.  Row and index
+ *                  overhead is the same for every set that monitors the
+ *                  same tables, so it is not counted.
+ * Parameters     : set, remote
+ * Returns        : void
+ */
+static void
+replica_measure(struct column_set *set, const char *remote)
+{
+    struct ovsdb_idl *idl;
+    size_t i, j;
+
+    idl = ovsdb_idl_create(remote, &ovsrec_idl_class, false, false);
+    for (i = 0; i < set->n_columns; i++) {
+        ovsdb_idl_add_column(idl, set->columns[i]);
+    }
+    idl_wait_connected(idl, remote);
+
+    for (i = 0; i < ovsrec_idl_class.n_tables; i++) {
+        const struct ovsdb_idl_table_class *tc = &ovsrec_idl_class.tables[i];
+        const struct ovsdb_idl_row *row;
+
+        for (row = ovsdb_idl_first_row(idl, tc); row;
+             row = ovsdb_idl_next_row(row)) {
+            set->n_rows++;
+            for (j = 0; j < set->n_columns; j++) {
+                const struct ovsdb_idl_column *column = set->columns[j];
+                const struct ovsdb_datum *datum;
+
+                if (!column_in_table(column, tc)) {
+                    continue;
+                }
+                datum = ovsdb_idl_read(row, column);
+                set->replica_bytes += sizeof *datum;
+                set->replica_bytes += atoms_bytes(datum->keys, datum->n,
+                                                  column->type.key.type);
+                if (column->type.value.type != OVSDB_TYPE_VOID) {
+                    set->replica_bytes += atoms_bytes(
+                        datum->values, datum->n, column->type.value.type);
+                }
+            }
+        }
+    }
+
+    ovsdb_idl_destroy(idl);
+}
+
+static struct json *
+column_set_to_json(const struct column_set *set)
+{
+    struct json *json = json_object_create();
+    struct json *updates = json_object_create();
+    size_t i;
+
+    json_object_put(json, "columns", json_integer_create(set->n_columns));
+    json_object_put(json, "tables", json_integer_create(set->n_tables));
+    json_object_put(json, "rows", json_integer_create(set->n_rows));
+    json_object_put(json, "replica_bytes",
+                    json_integer_create(set->replica_bytes));
+    json_object_put(json, "monitor_initial_bytes",
+                    json_integer_create(set->initial_bytes));
+    for (i = 0; i < BENCH_N_CHANGES; i++) {
+        json_object_put(updates, bench_changes[i].name,
+                        (set->n_changes[i]
+                         ? json_real_create((double) set->update_bytes[i]
+                                            / set->n_changes[i])
+                         : json_null_create()));
+    }
+    json_object_put(json, "update_bytes_per_change", updates);
+    return json;
+}
+
+static void
+usage(void)
+{
+    printf("%s: measures the IDL columns of the sysd CLI plugin\n"
+           "usage: %s [OPTIONS] REMOTE\n"
+           "\nConnects to the ovsdb-server at REMOTE with the columns the"
+           "\nplugin used to register and with the ones it registers now,"
+           "\nand prints the replica and monitor update bytes of each as"
+           "\nJSON.  Populates the database first if it has no Subsystem.\n"
+           "\nOptions:\n"
+           "  --changes=N     changes of each kind to average over "
+           "(default: 100)\n"
+           "  --sensors=N     temperature sensors to populate with "
+           "(default: 16)\n"
+           "  -h, --help      display this help message\n",
+           program_name, program_name);
+    exit(EXIT_SUCCESS);
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct column_set sets[2];
+    const char *remote = NULL;
+    struct ovsdb_idl *writer;
+    struct json *report, *json;
+    int n_changes = 100;
+    int n_sensors = 16;
+    bool populated = false;
+    size_t i, j;
+    int k;
+    char *s;
+
+    set_program_name(argv[0]);
+    for (k = 1; k < argc; k++) {
+        if (!strncmp(argv[k], "--changes=", 10)) {
+            n_changes = MAX(atoi(argv[k] + 10), 1);
+        } else if (!strncmp(argv[k], "--sensors=", 10)) {
+            n_sensors = MAX(atoi(argv[k] + 10), 1);
+        } else if (!strcmp(argv[k], "-h") || !strcmp(argv[k], "--help")) {
+            usage();
+        } else if (argv[k][0] == '-' || remote) {
+            ovs_fatal(0, "%s: unexpected argument (use --help for help)",
+                      argv[k]);
+        } else {
+            remote = argv[k];
+        }
+    }
+    if (!remote) {
+        ovs_fatal(0, "missing REMOTE (use --help for help)");
+    }
+
+    vlog_set_levels(NULL, VLF_ANY_DESTINATION, VLL_WARN);
+    ovsrec_init();
+
+    column_set_init(&sets[0], "old", old_columns, ARRAY_SIZE(old_columns),
+                    NULL, 0);
+    column_set_init(&sets[1], "new",
+                    system_show_columns, system_show_n_columns,
+                    system_show_json_columns, system_show_json_n_columns);
+
+    writer = ovsdb_idl_create(remote, &ovsrec_idl_class, true, false);
+    idl_wait_connected(writer, remote);
+    if (!ovsrec_subsystem_first(writer)) {
+        bench_populate(writer, n_sensors);
+        populated = true;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(sets); i++) {
+        replica_measure(&sets[i], remote);
+        monitor_open(&sets[i], remote);
+    }
+
+    for (j = 0; j < BENCH_N_CHANGES; j++) {
+        for (k = 0; k < n_changes; k++) {
+            struct ovsdb_idl_txn *txn = ovsdb_idl_txn_create(writer);
+
+            if (!bench_changes[j].change(writer)) {
+                ovsdb_idl_txn_destroy(txn);
+                break;
+            }
+            idl_commit(writer, txn);
+        }
+        for (i = 0; i < ARRAY_SIZE(sets); i++) {
+            sets[i].update_bytes[j] = monitor_drain(&sets[i]);
+            sets[i].n_changes[j] = k;
+        }
+    }
+
+    report = json_object_create();
+    json_object_put_string(report, "remote", remote);
+    json_object_put(report, "populated", json_boolean_create(populated));
+    json_object_put(report, "changes", json_integer_create(n_changes));
+    json = json_object_create();
+    for (i = 0; i < ARRAY_SIZE(sets); i++) {
+        json_object_put(json, sets[i].name,
+                        column_set_to_json(&sets[i]));
+        fprintf(stderr, "%-4s %3"PRIuSIZE" columns %6"PRIuSIZE" rows "
+                "%10"PRIuSIZE" replica bytes %10"PRIuSIZE" initial bytes\n",
+                sets[i].name, sets[i].n_columns, sets[i].n_rows,
+                sets[i].replica_bytes, sets[i].initial_bytes);
+        jsonrpc_close(sets[i].rpc);
+        free(sets[i].columns);
+    }
+    json_object_put(report, "column_sets", json);
+
+    s = json_to_string(report, JSSF_PRETTY | JSSF_SORT);
+    puts(s);
+    free(s);
+    json_destroy(report);
+    ovsdb_idl_destroy(writer);
+    return 0;
+}
+
+/** @} end of group ops-sysd */
@@ -0,0 +1,162 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Microbenchmark for parsing ONIE TlvInfo FRU EEPROM images.
+ *
+ * The images are built in memory with every field sysd knows, a number of
+ * vendor extension TLVs and a valid CRC, so the whole image is parsed and
+ * checksummed on every iteration.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <util.h>
+
+#include "sysd_fru.h"
+#include "sysd_mem.h"
+#include "sysd_util.h"
+#include "bench.h"
+
+static const int bench_extensions[] = { 0, 8, 64 };
+
+struct bench_eeprom {
+    unsigned char buf[8192];
+    int len;                    /* Bytes of TLVs after the header. */
+};
+
+static void
+bench_eeprom_put(struct bench_eeprom *e, uint8_t code, const void *value,
+                 uint8_t len)
+{
+    unsigned char *p = e->buf + sizeof(fru_header_t) + e->len;
+
+    p[0] = code;
+    p[1] = len;
+    memcpy(p + 2, value, len);
+    e->len += 2 + len;
+}
+
+static void
+bench_eeprom_put_string(struct bench_eeprom *e, uint8_t code, const char *s)
+{
+    bench_eeprom_put(e, code, s, strlen(s));
+}
+
+static void
+bench_eeprom_build(struct bench_eeprom *e, int n_extensions)
+{
+    static const uint8_t mac[FRU_BASE_MAC_ADDRESS_LEN] = {
+        0x70, 0x72, 0xcf, 0x00, 0x00, 0x01
+    };
+    static const uint8_t num_macs[FRU_NUM_MACS_LEN] = { 0x00, 0x4a };
+    fru_header_t *header = (fru_header_t *) e->buf;
+    unsigned char extension[255];
+    unsigned int crc;
+    uint8_t crc_be[4];
+    int i;
+
+    memset(e, 0, sizeof *e);
+    memcpy(header->id, "TlvInfo", 8);
+    header->header_version = SUPPORTED_OCP_FRU_EEPROM_VERSION;
+
+    bench_eeprom_put_string(e, FRU_PRODUCT_NAME_TYPE, "bench-switch");
+    bench_eeprom_put_string(e, FRU_PART_NUMBER_TYPE, "BENCH-0001");
+    bench_eeprom_put_string(e, FRU_SERIAL_NUMBER_TYPE, "SN0123456789");
+    bench_eeprom_put(e, FRU_BASE_MAC_ADDRESS_TYPE, mac, sizeof mac);
+    bench_eeprom_put_string(e, FRU_MANUFACTURE_DATE_TYPE,
+                            "01/01/2016 00:00:00");
+    bench_eeprom_put(e, FRU_DEVICE_VERSION_TYPE, "\x01",
+                     FRU_DEVICE_VERSION_LEN);
+    bench_eeprom_put_string(e, FRU_LABEL_REVISION_TYPE, "R01");
+    bench_eeprom_put_string(e, FRU_PLATFORM_NAME_TYPE, "x86_64-bench-r0");
+    bench_eeprom_put_string(e, FRU_ONIE_VERSION_TYPE, "2016.05");
+    bench_eeprom_put(e, FRU_NUM_MAC_TYPE, num_macs, sizeof num_macs);
+    bench_eeprom_put_string(e, FRU_MANUFACTURER_TYPE, "bench");
+    bench_eeprom_put_string(e, FRU_COUNTRY_CODE_TYPE, "US");
+    bench_eeprom_put_string(e, FRU_VENDOR_TYPE, "bench");
+    bench_eeprom_put_string(e, FRU_DIAG_VERSION_TYPE, "1.0");
+    bench_eeprom_put_string(e, FRU_SERVICE_TAG_TYPE, "TAG0001");
+
+    memset(extension, 0xa5, sizeof extension);
+    for (i = 0; i < n_extensions; i++) {
+        bench_eeprom_put(e, FRU_VENDOR_EXTENSION_TYPE, extension, 64);
+    }
+
+    /* The CRC covers the header and every TLV up to the CRC's own value. */
+    e->len += FRU_CRC_LEN;
+    header->total_length[0] = e->len >> 8;
+    header->total_length[1] = e->len & 0xff;
+    e->len -= FRU_CRC_LEN;
+    e->buf[sizeof(fru_header_t) + e->len] = FRU_CRC_TYPE;
+    e->buf[sizeof(fru_header_t) + e->len + 1] = 4;
+    crc = calc_crc(e->buf, sizeof(fru_header_t) + e->len + 2);
+    crc_be[0] = crc >> 24;
+    crc_be[1] = crc >> 16;
+    crc_be[2] = crc >> 8;
+    crc_be[3] = crc;
+    bench_eeprom_put(e, FRU_CRC_TYPE, crc_be, sizeof crc_be);
+}
+
+static void
+bench_eeprom_free(fru_eeprom_t *fru)
+{
+    sysd_mem_free(fru->diag_version);
+    sysd_mem_free(fru->label_revision);
+    sysd_mem_free(fru->manufacturer);
+    sysd_mem_free(fru->onie_version);
+    sysd_mem_free(fru->part_number);
+    sysd_mem_free(fru->platform_name);
+    sysd_mem_free(fru->product_name);
+    sysd_mem_free(fru->serial_number);
+    sysd_mem_free(fru->service_tag);
+    sysd_mem_free(fru->vendor);
+}
+
+static void
+bench_eeprom_op(void *e_)
+{
+    struct bench_eeprom *e = e_;
+    fru_eeprom_t fru;
+
+    memset(&fru, 0, sizeof fru);
+    if (!sysd_process_eeprom(e->buf, &fru, e->len)) {
+        ovs_fatal(0, "benchmark EEPROM image does not parse");
+    }
+    bench_eeprom_free(&fru);
+}
+
+void
+bench_eeprom(void)
+{
+    static struct bench_eeprom e;
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(bench_extensions); i++) {
+        char name[64];
+
+        snprintf(name, sizeof name, "eeprom/extensions=%d",
+                 bench_extensions[i]);
+        bench_eeprom_build(&e, bench_extensions[i]);
+        bench_run(name, bench_eeprom_op, &e, 1,
+                  sizeof(fru_header_t) + e.len);
+    }
+}
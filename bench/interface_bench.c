@@ -0,0 +1,126 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Microbenchmark for building the initial Interface rows of a subsystem.
+ *
+ * Each port is added with sysd_initial_interface_add(), which builds its
+ * hw_intf_info smap, into a transaction on an IDL that never connects.
+ * The transaction is discarded after every iteration.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ovsdb-idl.h>
+#include <openswitch-idl.h>
+#include <util.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_ctx.h"
+#include "bench.h"
+
+static const int bench_ports[] = { 54, 256 };
+
+static int bench_speed_1g = 1000;
+static int bench_speed_10g = 10000;
+static int bench_speed_40g = 40000;
+static int *bench_speeds[] = {
+    &bench_speed_1g, &bench_speed_10g, &bench_speed_40g, NULL
+};
+static char *bench_capabilities[] = {
+    INTERFACE_HW_INTF_INFO_MAP_ENET1G, INTERFACE_HW_INTF_INFO_MAP_ENET10G,
+    INTERFACE_HW_INTF_INFO_MAP_ENET40G, INTERFACE_HW_INTF_INFO_MAP_SPLIT_4,
+    NULL
+};
+
+struct bench_interface {
+    sysd_subsystem_t subsys;
+    sysd_intf_info_t *ports;
+};
+
+static void
+bench_interface_init(struct bench_interface *b, int n_ports)
+{
+    int i;
+
+    memset(b, 0, sizeof *b);
+    ovs_strlcpy(b->subsys.name, "base", sizeof b->subsys.name);
+    b->subsys.system_mac_addr = 0x7072cf000001ULL;
+    b->subsys.intf_count = n_ports;
+    b->ports = xcalloc(n_ports, sizeof *b->ports);
+
+    for (i = 0; i < n_ports; i++) {
+        sysd_intf_info_t *port = &b->ports[i];
+
+        port->name = xasprintf("%d", i + 1);
+        port->pluggable = true;
+        port->connector = "QSFP_PLUS";
+        port->max_speed = bench_speed_40g;
+        port->speeds = bench_speeds;
+        port->device = 0;
+        port->device_port = i;
+        port->capabilities = bench_capabilities;
+    }
+}
+
+static void
+bench_interface_destroy(struct bench_interface *b)
+{
+    int i;
+
+    for (i = 0; i < b->subsys.intf_count; i++) {
+        free(b->ports[i].name);
+    }
+    free(b->ports);
+}
+
+static void
+bench_interface_op(void *b_)
+{
+    struct bench_interface *b = b_;
+    struct ovsdb_idl_txn *txn = ovsdb_idl_txn_create(bench_ctx->idl);
+    int i;
+
+    for (i = 0; i < b->subsys.intf_count; i++) {
+        sysd_initial_interface_add(txn, &b->subsys, &b->ports[i]);
+    }
+    ovsdb_idl_txn_destroy(txn);
+}
+
+void
+bench_interface(void)
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(bench_ports); i++) {
+        struct bench_interface b;
+        char name[64];
+
+        snprintf(name, sizeof name, "interface/ports=%d", bench_ports[i]);
+        if (bench_selected(name)) {
+            bench_interface_init(&b, bench_ports[i]);
+            bench_run(name, bench_interface_op, &b, bench_ports[i], 0);
+            bench_interface_destroy(&b);
+        }
+    }
+}
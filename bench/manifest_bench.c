@@ -0,0 +1,110 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Microbenchmark for reading image.manifest into the daemon model.
+ *
+ * A manifest with a given number of daemons is written under a scratch
+ * $OPENSWITCH_INSTALL_PATH and read again on every iteration, the way the
+ * ops-sysd/reload-manifest command does, so the file read, the JSON parse,
+ * the hardware level assignment and the swap of the daemon model are all
+ * timed.  Every fourth daemon is a hardware daemon in one of three stages,
+ * and every eighth depends on the one before it.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dynamic-string.h>
+#include <sset.h>
+#include <util.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_ctx.h"
+#include "bench.h"
+
+static const int bench_daemons[] = { 16, 256, 4096 };
+
+/* Returns the size of the manifest written. */
+static size_t
+bench_manifest_write(const char *path, int n_daemons)
+{
+    struct ds s = DS_EMPTY_INITIALIZER;
+    size_t size;
+    int i;
+
+    ds_put_format(&s, "{\"%s\": {", DAEMONS_TAG);
+    for (i = 0; i < n_daemons; i++) {
+        ds_put_format(&s, "%s\n  \"bench-daemon-%d\": {\"%s\": %s",
+                      i ? "," : "", i, HW_HANDLER_TAG,
+                      i % 4 ? "false" : "true");
+        if (i % 4 == 0) {
+            ds_put_format(&s, ", \"%s\": %d", HW_STAGE_TAG, 1 + i / 4 % 3);
+        }
+        if (i % 8 == 7) {
+            ds_put_format(&s, ", \"%s\": [\"bench-daemon-%d\"]",
+                          DEPENDS_ON_TAG, i - 1);
+        }
+        ds_put_char(&s, '}');
+    }
+    ds_put_format(&s, "},\n\"%s\": {\"%s\": \"eth0\"}}\n",
+                  MGMT_INTF_TAG, MGMT_INTF_NAME_TAG);
+
+    bench_write_file(path, s.string, s.length);
+    size = s.length;
+    ds_destroy(&s);
+
+    return size;
+}
+
+static void
+bench_manifest_op(void *aux OVS_UNUSED)
+{
+    struct sset removed = SSET_INITIALIZER(&removed);
+
+    if (sysd_reread_manifest_file(bench_ctx, &removed)) {
+        ovs_fatal(0, "benchmark image.manifest does not parse");
+    }
+    sset_destroy(&removed);
+}
+
+void
+bench_manifest(void)
+{
+    char *path;
+    size_t i;
+
+    setenv("OPENSWITCH_INSTALL_PATH", bench_tmpdir(), 1);
+    path = xasprintf("%s%s", bench_tmpdir(), IMAGE_MANIFEST_FILE_PATH);
+
+    for (i = 0; i < ARRAY_SIZE(bench_daemons); i++) {
+        char name[64];
+
+        snprintf(name, sizeof name, "manifest/daemons=%d", bench_daemons[i]);
+        if (bench_selected(name)) {
+            size_t size = bench_manifest_write(path, bench_daemons[i]);
+
+            bench_run(name, bench_manifest_op, NULL, bench_daemons[i], size);
+        }
+    }
+
+    free(path);
+}
@@ -0,0 +1,98 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Microbenchmark for reading version_detail.yaml into Package_Info batches.
+ *
+ * The batches are freed as soon as they are read instead of being queued
+ * for commit, so only the YAML parse and the row construction are timed.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dynamic-string.h>
+#include <util.h>
+
+#include "sysd_ovsdb_if.h"
+#include "bench.h"
+
+static const int bench_packages[] = { 100, 2000, 20000 };
+
+/* Returns the size of the file written. */
+static size_t
+bench_package_info_write(const char *path, int n_packages)
+{
+    struct ds s = DS_EMPTY_INITIALIZER;
+    size_t size;
+    int i;
+
+    for (i = 0; i < n_packages; i++) {
+        ds_put_format(&s,
+                      "bench-package-%d:\n"
+                      "  PKG: bench-package-%d\n"
+                      "  PV: 1.0.%d\n"
+                      "  SRCREV: 0123456789abcdef0123456789abcdef%08x\n"
+                      "  SRC_URL: https://git.example.com/bench-%d.git\n"
+                      "  TYPE: git\n", i, i, i, i, i);
+    }
+
+    bench_write_file(path, s.string, s.length);
+    size = s.length;
+    ds_destroy(&s);
+
+    return size;
+}
+
+static void
+bench_package_info_batch(struct sysd_pkg_batch *batch, void *aux OVS_UNUSED)
+{
+    sysd_pkg_batch_destroy(batch);
+}
+
+static void
+bench_package_info_op(void *path)
+{
+    if (sysd_read_package_info(path, bench_package_info_batch, NULL) < 0) {
+        ovs_fatal(0, "benchmark version_detail.yaml does not parse");
+    }
+}
+
+void
+bench_package_info(void)
+{
+    char *path = xasprintf("%s/version_detail.yaml", bench_tmpdir());
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(bench_packages); i++) {
+        char name[64];
+
+        snprintf(name, sizeof name, "package_info/packages=%d",
+                 bench_packages[i]);
+        if (bench_selected(name)) {
+            size_t size = bench_package_info_write(path, bench_packages[i]);
+
+            bench_run(name, bench_package_info_op, path, bench_packages[i],
+                      size);
+        }
+    }
+
+    free(path);
+}
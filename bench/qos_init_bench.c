@@ -0,0 +1,117 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Microbenchmark for the QoS queue and schedule profile builder.
+ *
+ * The profiles are assembled and committed into a transaction on an IDL
+ * that never connects, so only the builder and the IDL row construction
+ * are timed.  The transaction is discarded after every iteration.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <ovsdb-idl.h>
+#include <vswitch-idl.h>
+
+#include "qos_init.h"
+#include "sysd.h"
+#include "sysd_ctx.h"
+#include "sysd_qos_utils.h"
+#include "bench.h"
+
+static const struct {
+    int n_profiles;
+    int n_queues;
+} bench_sizes[] = {
+    { 2, 8 },
+    { 2, 1024 },
+    { 2, 16384 },
+    { 64, 8 },
+    { 1024, 8 },
+    { 256, 256 },
+};
+
+struct bench_qos {
+    char **names;
+    int n_profiles;
+    int n_queues;
+};
+
+static void
+bench_qos_init_op(void *b_)
+{
+    struct bench_qos *b = b_;
+    struct qos_profile_builder builder;
+    struct ovsdb_idl_txn *txn = ovsdb_idl_txn_create(bench_ctx->idl);
+    int p, q;
+
+    qos_profile_builder_init(&builder);
+    for (p = 0; p < b->n_profiles; p++) {
+        qos_profile_builder_add_queue_profile(&builder, b->names[p], p == 0);
+        qos_profile_builder_add_schedule_profile(&builder, b->names[p],
+                                                 p == 0);
+        for (q = 0; q < b->n_queues; q++) {
+            qos_profile_builder_add_queue(&builder, b->names[p], q,
+                                          q % QOS_LOCAL_PRIORITY_COUNT,
+                                          "bench");
+            qos_profile_builder_add_schedule(&builder, b->names[p], q,
+                                             "dwrr", q + 1);
+        }
+    }
+    qos_profile_builder_commit(&builder, txn);
+
+    qos_profile_builder_destroy(&builder);
+    ovsdb_idl_txn_destroy(txn);
+}
+
+void
+bench_qos_init(void)
+{
+    size_t i;
+    int p;
+
+    for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+        struct bench_qos b;
+        char name[64];
+
+        snprintf(name, sizeof name, "qos_init/profiles=%d,queues=%d",
+                 bench_sizes[i].n_profiles, bench_sizes[i].n_queues);
+        if (!bench_selected(name)) {
+            continue;
+        }
+
+        b.n_profiles = bench_sizes[i].n_profiles;
+        b.n_queues = bench_sizes[i].n_queues;
+        b.names = xmalloc(b.n_profiles * sizeof *b.names);
+        for (p = 0; p < b.n_profiles; p++) {
+            b.names[p] = xasprintf("profile-%d", p);
+        }
+
+        bench_run(name, bench_qos_init_op, &b,
+                  (double) b.n_profiles * b.n_queues, 0);
+
+        for (p = 0; p < b.n_profiles; p++) {
+            free(b.names[p]);
+        }
+        free(b.names);
+    }
+}
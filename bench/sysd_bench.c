@@ -0,0 +1,104 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Main for sysd-bench, the ops-sysd microbenchmark suite.
+ *
+ *     sysd-bench [--min-time=MS] [FILTER]
+ *
+ * runs every benchmark whose name contains FILTER and prints the results
+ * to stdout as a JSON object, for tools/sysd_bench_compare.py.  Progress
+ * goes to stderr.  The kernels share one libsysdcore context, whose IDL is
+ * never connected.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ovsdb-idl.h>
+#include <util.h>
+#include <vswitch-idl.h>
+#include <openvswitch/vlog.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_ctx.h"
+#include "bench.h"
+
+struct sysd_ctx *bench_ctx;
+
+static void
+usage(void)
+{
+    printf("%s: ops-sysd microbenchmarks\n"
+           "usage: %s [OPTIONS] [FILTER]\n"
+           "\nRuns the benchmarks whose names contain FILTER, or all of them,"
+           "\nand prints the results as JSON.\n"
+           "\nOptions:\n"
+           "  --min-time=MS   time each benchmark for at least MS ms "
+           "(default: 200)\n"
+           "  -h, --help      display this help message\n",
+           program_name, program_name);
+    exit(EXIT_SUCCESS);
+}
+
+int
+main(int argc, char *argv[])
+{
+    long long int min_ms = 200;
+    const char *filter = NULL;
+    int i;
+
+    set_program_name(argv[0]);
+    for (i = 1; i < argc; i++) {
+        if (!strncmp(argv[i], "--min-time=", 11)) {
+            min_ms = atoll(argv[i] + 11);
+        } else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+            usage();
+        } else if (argv[i][0] == '-' || filter) {
+            ovs_fatal(0, "%s: unexpected argument (use --help for help)",
+                      argv[i]);
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    /* Keep the kernels' informational logging out of the timings. */
+    vlog_set_levels(NULL, VLF_ANY_DESTINATION, VLL_WARN);
+    ovsrec_init();
+
+    /* The IDL is never run, so it never tries to reach the remote. */
+    bench_ctx = sysd_ctx_create();
+    bench_ctx->idl = ovsdb_idl_create("unix:/nonexistent", &ovsrec_idl_class,
+                                      false, false);
+
+    bench_init(MAX(min_ms, 1) * 1000 * 1000, filter);
+    bench_eeprom();
+    bench_manifest();
+    bench_package_info();
+    bench_interface();
+    bench_qos_init();
+    bench_system_show();
+    bench_report();
+
+    sysd_ctx_destroy(bench_ctx);
+    return 0;
+}
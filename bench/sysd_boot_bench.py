@@ -0,0 +1,450 @@
+#!/usr/bin/env python
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+"""Measure how long ops-sysd takes to bring a fresh database to ready.
+
+usage: sysd_boot_bench.py [OPTIONS]
+
+Each run creates a scratch root directory with an image.manifest, the
+hardware description files, os-release and version_detail.yaml, starts a
+throwaway ovsdb-server on an empty database created from the vswitch
+schema, and starts ops-sysd against it with $OPENSWITCH_INSTALL_PATH and
+$OPENSWITCH_DATA_PATH pointing at the scratch root.  ops-sysd must be built
+with -DPLATFORM_SIMULATION=ON, so that it does not need dmidecode or an
+EEPROM.  Nothing is installed and no network access is needed.
+
+The harness plays the part of the hardware daemons listed in the manifest:
+once ops-sysd creates a daemon's row, the harness sets its Daemon:cur_hw
+to 1 after that daemon's delay.  Over a JSON-RPC monitor on the database
+it timestamps, from the start of ops-sysd:
+
+  system_row       the System row appears
+  initial_config   ops-sysd commits its initial configuration, as
+                   ops-sysd/dump timings reports it
+  package_info     every version_detail.yaml package is in Package_Info
+  cur_hw           System:cur_hw reaches 1
+
+and prints the min, percentiles and max of each across the runs.
+
+With --replay every run uses the same scratch root path and shares one
+--initial-txn-file, so after the first run ops-sysd replays the initial
+configuration it recorded instead of building it.  Each run's JSON record
+says whether it was replayed.
+
+Options:
+  --sysd=PATH          ops-sysd binary (default: ops-sysd in $PATH)
+  --schema=PATH        vswitch schema (default: searched for under
+                       /usr/share/openvswitch and /usr/local/share/openvswitch)
+  --hw-desc=DIR        hardware description files
+                       (default: tests/test_hw_desc_files)
+  --daemons=N          simulated hardware daemons (default: 8)
+  --delay=MS[:MAX]     delay before each daemon reports cur_hw, or a range
+                       to draw each delay from uniformly (default: 50:200)
+  --packages=N         packages in version_detail.yaml (default: 500)
+  --runs=N             repetitions (default: 10)
+  --timeout=SEC        give up on a run after SEC seconds (default: 60)
+  --seed=N             seed for the delays (default: 0)
+  --json=FILE          also write every run and the summary to FILE
+  --keep               keep the scratch directories
+  --replay             share the recorded initial configuration across runs
+"""
+
+import errno
+import getopt
+import json
+import os
+import random
+import select
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+MILESTONES = ["system_row", "initial_config", "package_info", "cur_hw"]
+PERCENTILES = [50, 90, 99]
+
+PLATFORM_DIR = "etc/openswitch/platform/Generic-x86/X86-64"
+MANIFEST = "etc/openswitch/image.manifest"
+OS_RELEASE = "etc/os-release"
+VERSION_DETAIL = "var/lib/version_detail.yaml"
+
+SCHEMA_DIRS = ["/usr/share/openvswitch", "/usr/local/share/openvswitch"]
+
+if hasattr(time, "monotonic"):
+    now = time.monotonic
+else:
+    now = time.time
+
+
+class BenchError(Exception):
+    pass
+
+
+class Ovsdb(object):
+    """A minimal OVSDB JSON-RPC client: one monitor and fire-and-forget
+    transactions, with updates delivered through poll()."""
+
+    def __init__(self, path, db):
+        self.db = db
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.sock.connect(path)
+        self.buf = ""
+        self.next_id = 0
+        self.decoder = json.JSONDecoder()
+
+    def close(self):
+        self.sock.close()
+
+    def send(self, method, params):
+        self.next_id += 1
+        msg = {"method": method, "params": params, "id": self.next_id}
+        self.sock.sendall(json.dumps(msg).encode("utf-8"))
+        return self.next_id
+
+    def monitor(self, tables):
+        return self.send("monitor", [self.db, None, tables])
+
+    def transact(self, *ops):
+        return self.send("transact", [self.db] + list(ops))
+
+    def poll(self, timeout):
+        """Waits up to 'timeout' seconds and returns the table updates
+        received, as a list of {table: {uuid: {"old": row, "new": row}}}."""
+        updates = []
+        ready, _, _ = select.select([self.sock], [], [], max(timeout, 0))
+        if not ready:
+            return updates
+
+        data = self.sock.recv(65536)
+        if not data:
+            raise BenchError("ovsdb-server closed the connection")
+        self.buf += data.decode("utf-8")
+
+        while True:
+            self.buf = self.buf.lstrip()
+            if not self.buf:
+                break
+            try:
+                msg, end = self.decoder.raw_decode(self.buf)
+            except ValueError:
+                break
+            self.buf = self.buf[end:]
+
+            if msg.get("method") == "echo":
+                reply = {"result": msg["params"], "error": None,
+                         "id": msg["id"]}
+                self.sock.sendall(json.dumps(reply).encode("utf-8"))
+            elif msg.get("method") == "update":
+                updates.append(msg["params"][1])
+            elif msg.get("error"):
+                raise BenchError("ovsdb error: %s" % msg["error"])
+            elif isinstance(msg.get("result"), list):
+                for result in msg["result"]:
+                    if result and "error" in result:
+                        raise BenchError("ovsdb error: %s" % result)
+            elif isinstance(msg.get("result"), dict):
+                # The monitor's initial contents.
+                updates.append(msg["result"])
+        return updates
+
+
+def find_schema():
+    for d in SCHEMA_DIRS:
+        path = os.path.join(d, "vswitch.ovsschema")
+        if os.path.exists(path):
+            return path
+    raise BenchError("vswitch.ovsschema not found; use --schema")
+
+
+def write_file(root, relpath, text):
+    path = os.path.join(root, relpath)
+    try:
+        os.makedirs(os.path.dirname(path))
+    except OSError as e:
+        if e.errno != errno.EEXIST:
+            raise
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def populate_root(root, opts, names):
+    manifest = {"daemons": dict((n, {"is_hw_handler": True}) for n in names),
+                "mgmt_intf": {"intf": "eth0"}}
+    write_file(root, MANIFEST, json.dumps(manifest, indent=2))
+    write_file(root, OS_RELEASE,
+               'NAME="OpenSwitch"\nVERSION_ID="0.4.0"\n'
+               'BUILD_ID="bench"\n')
+    write_file(root, VERSION_DETAIL, "".join(
+        "bench-package-%d:\n"
+        "  PKG: bench-package-%d\n"
+        "  PV: 1.0.%d\n"
+        "  SRC_URL: https://git.example.com/bench-%d.git\n"
+        "  TYPE: git\n" % (i, i, i, i) for i in range(opts["packages"])))
+    shutil.copytree(opts["hw_desc"], os.path.join(root, PLATFORM_DIR))
+
+
+def wait_for_socket(path, proc, name, timeout):
+    deadline = now() + timeout
+    while not os.path.exists(path):
+        if proc.poll() is not None:
+            raise BenchError("%s exited with status %d"
+                             % (name, proc.returncode))
+        if now() > deadline:
+            raise BenchError("%s did not appear" % path)
+        time.sleep(0.005)
+
+
+def integer(datum):
+    """Returns the value of an optional integer column, or 0 if empty."""
+    if isinstance(datum, list):
+        return datum[1][0] if datum[0] == "set" and datum[1] else 0
+    return datum
+
+
+def stop(proc):
+    if proc and proc.poll() is None:
+        proc.terminate()
+        try:
+            proc.wait()
+        except OSError:
+            pass
+
+
+def sysd_initial_config(root, start):
+    """Returns the time from the start of ops-sysd to its initial
+    configuration commit, as it reports it, or None, and whether that
+    configuration was replayed."""
+    try:
+        out = subprocess.check_output(
+            ["ovs-appctl", "-t", os.path.join(root, "sysd.ctl"),
+             "ops-sysd/dump", "--json", "timings"])
+        timings = json.loads(out.decode("utf-8"))["timings"]
+    except (OSError, subprocess.CalledProcessError, ValueError, KeyError):
+        return None, None
+    msec = timings.get("initial_config_ms", -1)
+    return (msec / 1000.0 if msec >= 0 else None,
+            timings.get("initial_config_replayed"))
+
+
+def one_run(opts, rng, run):
+    if opts["replay_dir"]:
+        # The hardware description path is in the recorded rows, so the
+        # root must not move between runs.
+        root = os.path.join(opts["replay_dir"], "root")
+        shutil.rmtree(root, ignore_errors=True)
+        os.mkdir(root)
+    else:
+        root = tempfile.mkdtemp(prefix="sysd-boot-bench.")
+    names = ["sim-hw-daemon-%d" % i for i in range(opts["daemons"])]
+    delays = dict((n, rng.uniform(opts["delay_min"], opts["delay_max"])
+                   / 1000.0) for n in names)
+    server = sysd = client = None
+    result = dict((m, None) for m in MILESTONES)
+
+    try:
+        populate_root(root, opts, names)
+        db_file = os.path.join(root, "vswitch.db")
+        db_sock = os.path.join(root, "db.sock")
+        subprocess.check_call(["ovsdb-tool", "create", db_file,
+                               opts["schema"]])
+        server = subprocess.Popen(
+            ["ovsdb-server", "--remote=punix:" + db_sock,
+             "--unixctl=" + os.path.join(root, "ovsdb.ctl"),
+             "--log-file=" + os.path.join(root, "ovsdb-server.log"),
+             "-vconsole:off", "--no-chdir", db_file])
+        wait_for_socket(db_sock, server, "ovsdb-server", opts["timeout"])
+
+        with open(opts["schema"]) as f:
+            db_name = json.load(f)["name"]
+        client = Ovsdb(db_sock, db_name)
+        client.monitor({"System": {"columns": ["cur_hw"]},
+                        "Daemon": {"columns": ["name", "cur_hw"]},
+                        "Package_Info": {"columns": ["name"]}})
+
+        env = dict(os.environ, OPENSWITCH_INSTALL_PATH=root,
+                   OPENSWITCH_DATA_PATH=root)
+        args = [opts["sysd"], "unix:" + db_sock,
+                "--unixctl=" + os.path.join(root, "sysd.ctl"),
+                "--log-file=" + os.path.join(root, "ops-sysd.log"),
+                "-vconsole:off", "--no-chdir"]
+        if opts["replay_dir"]:
+            args.append("--initial-txn-file="
+                        + os.path.join(opts["replay_dir"], "initial-txn.json"))
+        start = now()
+        sysd = subprocess.Popen(args, env=env)
+
+        pending = {}        # Daemon name -> when to set its cur_hw.
+        seen = set()
+        packages = set()
+        deadline = start + opts["timeout"]
+        while result["cur_hw"] is None or result["package_info"] is None:
+            t = now()
+            if t > deadline:
+                raise BenchError("run %d timed out; see %s" % (run, root))
+            if sysd.poll() is not None:
+                raise BenchError("ops-sysd exited with status %d; see %s"
+                                 % (sysd.returncode, root))
+
+            for name, when in list(pending.items()):
+                if when <= t:
+                    client.transact({"op": "update", "table": "Daemon",
+                                     "where": [["name", "==", name]],
+                                     "row": {"cur_hw": 1}})
+                    del pending[name]
+
+            timeout = min([deadline] + list(pending.values())) - t
+            for update in client.poll(min(timeout, 0.1)):
+                t = now() - start
+                for uuid, row in update.get("System", {}).items():
+                    new = row.get("new")
+                    if new is not None and result["system_row"] is None:
+                        result["system_row"] = t
+                    if (new is not None and integer(new.get("cur_hw", 0)) >= 1
+                            and result["cur_hw"] is None):
+                        result["cur_hw"] = t
+                for uuid, row in update.get("Daemon", {}).items():
+                    name = (row.get("new") or {}).get("name")
+                    if name in delays and name not in seen:
+                        seen.add(name)
+                        pending[name] = start + t + delays[name]
+                for uuid, row in update.get("Package_Info", {}).items():
+                    if row.get("new") is not None:
+                        packages.add(uuid)
+                    else:
+                        packages.discard(uuid)
+                if (len(packages) >= opts["packages"]
+                        and result["package_info"] is None):
+                    result["package_info"] = t
+
+        result["initial_config"], result["replayed"] = \
+            sysd_initial_config(root, start)
+    finally:
+        if client:
+            client.close()
+        stop(sysd)
+        stop(server)
+        if not opts["keep"]:
+            shutil.rmtree(root, ignore_errors=True)
+    return result
+
+
+def percentile(values, pct):
+    values = sorted(values)
+    k = (len(values) - 1) * pct / 100.0
+    lo = int(k)
+    hi = min(lo + 1, len(values) - 1)
+    return values[lo] + (values[hi] - values[lo]) * (k - lo)
+
+
+def summarize(runs):
+    summary = {}
+    for m in MILESTONES:
+        values = [r[m] for r in runs if r[m] is not None]
+        if not values:
+            continue
+        s = {"n": len(values), "min": min(values), "max": max(values)}
+        for p in PERCENTILES:
+            s["p%d" % p] = percentile(values, p)
+        summary[m] = s
+    return summary
+
+
+def parse_options(argv):
+    opts = {"sysd": "ops-sysd", "schema": None,
+            "hw_desc": os.path.join(os.path.dirname(os.path.abspath(
+                __file__)), os.pardir, "tests", "test_hw_desc_files"),
+            "daemons": 8, "delay_min": 50.0, "delay_max": 200.0,
+            "packages": 500, "runs": 10, "timeout": 60.0, "seed": 0,
+            "json": None, "keep": False, "replay": False,
+            "replay_dir": None}
+    try:
+        options, args = getopt.gnu_getopt(
+            argv[1:], "h", ["help", "sysd=", "schema=", "hw-desc=",
+                            "daemons=", "delay=", "packages=", "runs=",
+                            "timeout=", "seed=", "json=", "keep",
+                            "replay"])
+    except getopt.GetoptError as e:
+        raise BenchError(str(e))
+    if args:
+        raise BenchError("unexpected argument %s" % args[0])
+
+    for key, value in options:
+        if key in ("-h", "--help"):
+            print(__doc__)
+            sys.exit(0)
+        elif key == "--delay":
+            lo, _, hi = value.partition(":")
+            opts["delay_min"] = float(lo)
+            opts["delay_max"] = float(hi or lo)
+        elif key == "--keep":
+            opts["keep"] = True
+        elif key == "--replay":
+            opts["replay"] = True
+        elif key in ("--daemons", "--packages", "--runs", "--seed"):
+            opts[key[2:]] = int(value)
+        elif key == "--timeout":
+            opts["timeout"] = float(value)
+        else:
+            opts[key[2:].replace("-", "_")] = value
+
+    if not opts["schema"]:
+        opts["schema"] = find_schema()
+    return opts
+
+
+def main(argv):
+    opts = {"keep": False, "replay_dir": None}
+    try:
+        opts = parse_options(argv)
+        if opts["replay"]:
+            opts["replay_dir"] = tempfile.mkdtemp(
+                prefix="sysd-boot-bench-replay.")
+        rng = random.Random(opts["seed"])
+        runs = []
+        for i in range(opts["runs"]):
+            runs.append(one_run(opts, rng, i))
+            sys.stderr.write("run %d: %s\n" % (i, ", ".join(
+                "%s=%s" % (m, "-" if runs[-1][m] is None
+                           else "%.1fms" % (runs[-1][m] * 1000))
+                for m in MILESTONES)))
+    except (BenchError, OSError, subprocess.CalledProcessError) as e:
+        sys.stderr.write("%s: %s\n" % (argv[0], e))
+        return 1
+    finally:
+        if opts["replay_dir"] and not opts["keep"]:
+            shutil.rmtree(opts["replay_dir"], ignore_errors=True)
+
+    summary = summarize(runs)
+    print("%-16s %5s %10s %10s %10s %10s %10s"
+          % ("milestone (ms)", "n", "min", "p50", "p90", "p99", "max"))
+    for m in MILESTONES:
+        if m in summary:
+            s = summary[m]
+            print("%-16s %5d %10.1f %10.1f %10.1f %10.1f %10.1f"
+                  % (m, s["n"], s["min"] * 1000, s["p50"] * 1000,
+                     s["p90"] * 1000, s["p99"] * 1000, s["max"] * 1000))
+
+    if opts["json"]:
+        with open(opts["json"], "w") as f:
+            json.dump({"options": dict((k, v) for k, v in opts.items()),
+                       "runs": runs, "summary": summary}, f, indent=2,
+                      sort_keys=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,207 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Microbenchmark for rendering "show system" as text and as JSON.
+ *
+ * The subsystem is built in a transaction on an IDL that never connects,
+ * which is enough to populate the row structs the renderers read.  The
+ * text path is timed without the CLI's section cache, i.e. as rendered
+ * after every section changed.  The JSON document is passed to a writer
+ * that only counts bytes.
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <dynamic-string.h>
+#include <ovsdb-idl.h>
+#include <smap.h>
+#include <util.h>
+#include <vswitch-idl.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_ctx.h"
+#include "system_show.h"
+#include "bench.h"
+
+static const int bench_sensors[] = { 16, 1000 };
+
+#define BENCH_N_FANS 8
+#define BENCH_N_LEDS 4
+#define BENCH_N_PSUS 2
+
+static void
+bench_count_bytes(const char *s OVS_UNUSED, size_t n, void *aux)
+{
+    size_t *total = aux;
+
+    *total += n;
+}
+
+static const struct ovsrec_subsystem *
+bench_subsystem(struct ovsdb_idl_txn *txn, int n_sensors)
+{
+    struct ovsrec_subsystem *sys = ovsrec_subsystem_insert(txn);
+    struct ovsrec_fan *fans[BENCH_N_FANS];
+    struct ovsrec_led *leds[BENCH_N_LEDS];
+    struct ovsrec_power_supply *psus[BENCH_N_PSUS];
+    struct ovsrec_temp_sensor **sensors;
+    struct smap other_info;
+    int i;
+
+    smap_init(&other_info);
+    smap_add(&other_info, "Product Name", "bench");
+    smap_add(&other_info, "vendor", "bench");
+    smap_add(&other_info, "platform_name", "x86_64-bench-r0");
+    smap_add(&other_info, "interface_count", "54");
+    smap_add(&other_info, "max_interface_speed", "40000");
+    ovsrec_subsystem_set_name(sys, "base");
+    ovsrec_subsystem_set_other_info(sys, &other_info);
+    smap_destroy(&other_info);
+
+    /* Insert in reverse order so that the renderers have to sort. */
+    for (i = 0; i < BENCH_N_FANS; i++) {
+        char *name = xasprintf("base-%dL", BENCH_N_FANS - i);
+
+        fans[i] = ovsrec_fan_insert(txn);
+        ovsrec_fan_set_name(fans[i], name);
+        ovsrec_fan_set_speed(fans[i], "normal");
+        ovsrec_fan_set_status(fans[i], "ok");
+        free(name);
+    }
+    for (i = 0; i < BENCH_N_LEDS; i++) {
+        char *name = xasprintf("base-%d", BENCH_N_LEDS - i);
+
+        leds[i] = ovsrec_led_insert(txn);
+        ovsrec_led_set_id(leds[i], name);
+        ovsrec_led_set_state(leds[i], "on");
+        ovsrec_led_set_status(leds[i], "ok");
+        free(name);
+    }
+    for (i = 0; i < BENCH_N_PSUS; i++) {
+        char *name = xasprintf("base-%d", BENCH_N_PSUS - i);
+
+        psus[i] = ovsrec_power_supply_insert(txn);
+        ovsrec_power_supply_set_name(psus[i], name);
+        ovsrec_power_supply_set_status(psus[i], "ok");
+        free(name);
+    }
+
+    sensors = xmalloc(n_sensors * sizeof *sensors);
+    for (i = 0; i < n_sensors; i++) {
+        char *name = xasprintf("base-%d", n_sensors - i);
+
+        sensors[i] = ovsrec_temp_sensor_insert(txn);
+        ovsrec_temp_sensor_set_name(sensors[i], name);
+        ovsrec_temp_sensor_set_location(sensors[i], "Bench sensor location");
+        ovsrec_temp_sensor_set_temperature(sensors[i], 30000 + i);
+        free(name);
+    }
+
+    ovsrec_subsystem_set_fans(sys, fans, BENCH_N_FANS);
+    ovsrec_subsystem_set_leds(sys, leds, BENCH_N_LEDS);
+    ovsrec_subsystem_set_power_supplies(sys, psus, BENCH_N_PSUS);
+    ovsrec_subsystem_set_temp_sensors(sys, sensors, n_sensors);
+    free(sensors);
+
+    return sys;
+}
+
+struct bench_show {
+    const struct ovsrec_subsystem *sys;
+    const struct ovsrec_system *vswitch;
+    struct ds text;
+};
+
+static void
+bench_show_text_op(void *b_)
+{
+    struct bench_show *b = b_;
+    const struct ovsrec_fan **fans = NULL;
+    const struct ovsrec_led **leds = NULL;
+    const struct ovsrec_power_supply **psus = NULL;
+    const struct ovsrec_temp_sensor **sensors = NULL;
+    size_t n_fans, n_leds, n_psus, n_temp;
+
+    ds_clear(&b->text);
+    system_show_format_info(&b->text, "\n", b->sys, b->vswitch);
+    system_show_sort_fans(b->sys, &fans, &n_fans);
+    system_show_format_fans(&b->text, "\n", fans, n_fans);
+    system_show_sort_leds(b->sys, &leds, &n_leds);
+    system_show_format_leds(&b->text, "\n", leds, n_leds);
+    system_show_sort_psus(b->sys, &psus, &n_psus);
+    system_show_format_psus(&b->text, "\n", psus, n_psus);
+    system_show_sort_temp_sensors(b->sys, &sensors, &n_temp);
+    system_show_format_temp_sensors(&b->text, "\n", sensors, n_temp);
+
+    free(fans);
+    free(leds);
+    free(psus);
+    free(sensors);
+}
+
+static void
+bench_show_json_op(void *b_)
+{
+    struct bench_show *b = b_;
+    size_t n = 0;
+
+    system_show_json(b->sys, b->vswitch, bench_count_bytes, &n);
+}
+
+void
+bench_system_show(void)
+{
+    size_t i;
+
+    for (i = 0; i < ARRAY_SIZE(bench_sensors); i++) {
+        struct ovsdb_idl_txn *txn;
+        struct ovsrec_system *vswitch;
+        struct bench_show b;
+        char text_name[64], json_name[64];
+        size_t json_bytes = 0;
+
+        snprintf(text_name, sizeof text_name, "system_show/text/sensors=%d",
+                 bench_sensors[i]);
+        snprintf(json_name, sizeof json_name, "system_show/json/sensors=%d",
+                 bench_sensors[i]);
+        if (!bench_selected(text_name) && !bench_selected(json_name)) {
+            continue;
+        }
+
+        txn = ovsdb_idl_txn_create(bench_ctx->idl);
+        b.sys = bench_subsystem(txn, bench_sensors[i]);
+        vswitch = ovsrec_system_insert(txn);
+        ovsrec_system_set_switch_version(vswitch, "0.4.0");
+        b.vswitch = vswitch;
+        ds_init(&b.text);
+
+        bench_show_text_op(&b);
+        bench_run(text_name, bench_show_text_op, &b, 0, b.text.length);
+
+        system_show_json(b.sys, b.vswitch, bench_count_bytes, &json_bytes);
+        bench_run(json_name, bench_show_json_op, &b, 0, json_bytes);
+
+        ds_destroy(&b.text);
+        ovsdb_idl_txn_destroy(txn);
+    }
+}
@@ -0,0 +1,131 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the sysd context, the state of one instance of libsysdcore.
+ *
+ * Everything sysd learns about a platform and writes to a database hangs
+ * off a struct sysd_ctx: the IDL and its transaction queue, the hardware
+ * description and config-yaml handle, the subsystems, the daemon model
+ * read from image.manifest and the readiness levels published so far.
+ * ops-sysd creates one; sysd-bench and tests may create several.
+ *
+ * Thread safety: a context is not synchronized.  Each one must be used by
+ * one thread at a time, but different contexts may be used from different
+ * threads at once.  The statistics of its transactions, column writes,
+ * metrics counters and main loop belong to the context.  Only sysd_mem,
+ * which is locked, and the lock-free sysd_trace ring are shared by every
+ * context.  The metrics socket and the unixctl commands
+ * belong to the driver and must only be used from the thread running its
+ * main loop.
+ */
+
+#ifndef __SYSD_CTX_H__
+#define __SYSD_CTX_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <hmap.h>
+#include <sset.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_util.h"
+#include "sysd_loop_stats.h"
+#include "sysd_metrics.h"
+#include "sysd_ovsdb_if.h"
+#include "sysd_replay.h"
+#include "sysd_txn.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+struct ovsdb_idl;
+struct qos_defaults;
+
+struct sysd_ctx {
+    /* Database, from sysd_ovsdb_conn_init(). */
+    struct ovsdb_idl        *idl;
+    uint32_t                idl_seqno;
+    struct sysd_txn_queue   txns;
+    struct sysd_replay      replay;     /* From sysd_replay_open(). */
+
+    /* Hardware description, from sysd_create_link_to_hwdesc_files() and
+     * sysd_cfg_yaml_init(). */
+    char                    *hw_desc_dir;
+    char                    *hw_desc_link;
+    YamlConfigHandle        cfg_yaml;
+    const YamlDevice        *fru_dev;
+    const struct qos_defaults *qos_compiled;    /* Matching compiled-in
+                                                 * defaults, or NULL. */
+    struct qos_defaults     *qos_yaml;          /* Read from qos.yaml when
+                                                 * nothing matched. */
+
+    /* Subsystems, from sysd_get_subsystem_info(). */
+    int                     num_subsystems;
+    sysd_subsystem_t        **subsystems;
+
+    /* image.manifest, from sysd_read_manifest_file(). */
+    daemon_info_t           **daemons;
+    daemon_info_t           *daemon_table;      /* What daemons[] points to. */
+    struct hmap             daemon_index;       /* daemon_info_t by name. */
+    int                     num_daemons;
+    int                     num_hw_daemons;
+    int                     num_hw_levels;
+    int                     manifest_unknown_sections;
+                                        /* Top level sections not
+                                         * recognized. */
+    mgmt_intf_info_t        *mgmt_intf;
+    int                     manifest_watch_fd;  /* inotify fd, or -1. */
+
+    /* What has been written to the database. */
+    bool                    hw_init_done_set;
+    int                     hw_level_set;       /* Last System:cur_hw. */
+    int                     next_hw_set;        /* Last System:next_hw. */
+    struct sset             daemons_to_delete;  /* Daemons a manifest reload
+                                                 * dropped whose rows are not
+                                                 * deleted yet. */
+    bool                    qos_defaults_reconciled;
+    struct sysd_boot_times  boot_times;
+
+    /* Statistics, from sysd_metric_add() and the driver's main loop. */
+    unsigned long long int  metrics[SYSD_METRIC_N_COUNTERS];
+    struct sysd_loop        loop;
+};
+
+/* Returns a new, empty context.  Its boot times start now. */
+struct sysd_ctx *sysd_ctx_create(void);
+
+/* Aborts the context's queued writes, closes its IDL and frees everything
+ * it holds.  Null is ignored. */
+void sysd_ctx_destroy(struct sysd_ctx *);
+
+/* Enumerate the subsystems and their interfaces into the context, from the
+ * FRU EEPROM and the hardware description read by sysd_cfg_yaml_init().
+ * Return 0 on success, -1 on failure. */
+int sysd_get_subsystem_info(struct sysd_ctx *);
+int sysd_get_interface_info(struct sysd_ctx *);
+
+/* Like sysd_get_subsystem_info(), but for a box that is not the one running:
+ * the FRU EEPROM is not read, its strings are SYSD_PER_BOX_PLACEHOLDER and
+ * no MACs are allocated. */
+int sysd_get_placeholder_subsystem_info(struct sysd_ctx *);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_CTX_H__ */
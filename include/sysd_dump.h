@@ -0,0 +1,66 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd diagnostic dump.
+ */
+
+#ifndef __SYSD_DUMP_H__
+#define __SYSD_DUMP_H__
+
+#include <dynamic-string.h>
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Sections of the diagnostic dump, in output order. */
+enum sysd_dump_section {
+    SYSD_DUMP_DAEMONS,
+    SYSD_DUMP_SUBSYSTEMS,
+    SYSD_DUMP_INTERFACES,
+    SYSD_DUMP_MACS,
+    SYSD_DUMP_QOS,
+    SYSD_DUMP_TIMINGS,
+    SYSD_DUMP_MEMORY,
+    SYSD_DUMP_N_SECTIONS
+};
+
+#define SYSD_DUMP_ALL_SECTIONS ((1u << SYSD_DUMP_N_SECTIONS) - 1)
+
+enum sysd_dump_format {
+    SYSD_DUMP_TEXT,
+    SYSD_DUMP_JSON
+};
+
+struct sysd_ctx;
+
+/* Appends the sections in the 'sections' bitmap (1u << SYSD_DUMP_*) of
+ * 'ctx' to 'ds'.  The output is not truncated.  Must run in the thread that
+ * owns 'ctx'. */
+void sysd_dump(struct sysd_ctx *ctx, struct ds *ds, unsigned int sections,
+               enum sysd_dump_format format);
+
+/* Parses "[--json] [SECTION...]" into a section bitmap and format.  With no
+ * SECTION, all sections are selected.  Returns NULL on success, otherwise a
+ * malloc()'d error message. */
+char *sysd_dump_parse_args(int argc, const char *argv[],
+                           unsigned int *sections,
+                           enum sysd_dump_format *format);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_DUMP_H__ */
@@ -0,0 +1,41 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd offline build of the initial configuration.
+ */
+
+#ifndef __SYSD_EMIT_H__
+#define __SYSD_EMIT_H__
+
+/** @ingroup ops-sysd
+ * @{ */
+
+struct sysd_ctx;
+
+/* Builds the initial configuration for the hardware description in
+ * 'hw_desc_dir' and the image.manifest of this image, without reading the
+ * FRU EEPROM or connecting to a database, and writes it to 'file' ("-" for
+ * stdout) as the parameters of an OVSDB "transact" request.  The FRU data
+ * and MACs are left as SYSD_PER_BOX_PLACEHOLDER, for sysd to patch at boot.
+ * 'ctx' must be freshly created.  Returns 0 on success, -1 on failure. */
+int sysd_emit_db(struct sysd_ctx *ctx, const char *hw_desc_dir,
+                 const char *file);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_EMIT_H__ */
@@ -26,6 +26,7 @@
 /** @ingroup ops-sysd
  * @{ */
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #define SUPPORTED_OCP_FRU_EEPROM_VERSION    0x01
@@ -86,7 +87,18 @@ typedef struct fru_tlv {
     char            value[255];
 } fru_tlv_t;
 
-int sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom);
+struct sysd_ctx;
+
+/* Reads the FRU EEPROM described by the hardware description of 'ctx', or
+ * its YAML stand-in, into 'fru_eeprom'.  Not safe to call concurrently for
+ * one context. */
+int sysd_read_fru_eeprom(struct sysd_ctx *ctx, fru_eeprom_t *fru_eeprom);
+
+/* Parses the 'len' bytes of TLVs that follow the header in 'buf' into
+ * 'fru_eeprom'.  Returns false on an invalid TLV or CRC.  Uses no shared
+ * state, so it is safe to call from any thread. */
+bool sysd_process_eeprom(unsigned char *buf, fru_eeprom_t *fru_eeprom,
+                         int len);
 
 /** @} end of group ops-sysd */
 #endif /* __SYSD_FRU_H__ */
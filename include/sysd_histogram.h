@@ -0,0 +1,48 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the log2-bucketed histograms used by ops-sysd statistics.
+ */
+
+#ifndef __SYSD_HISTOGRAM_H__
+#define __SYSD_HISTOGRAM_H__
+
+#include <dynamic-string.h>
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Bucket 0 counts values under 2 and bucket i > 0 counts [2^i, 2^(i+1));
+ * the last bucket is open ended. */
+#define SYSD_HIST_BUCKETS 26
+
+struct sysd_histogram {
+    unsigned long long int count;
+    unsigned long long int total;
+    unsigned long long int max;
+    unsigned long long int buckets[SYSD_HIST_BUCKETS];
+};
+
+void sysd_histogram_add(struct sysd_histogram *, unsigned long long int value);
+
+/* Appends the non-empty buckets as " [low,high):count". */
+void sysd_histogram_format(const struct sysd_histogram *, struct ds *);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_HISTOGRAM_H__ */
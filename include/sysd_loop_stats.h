@@ -0,0 +1,85 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd main loop timing and stall detection.
+ */
+
+#ifndef __SYSD_LOOP_STATS_H__
+#define __SYSD_LOOP_STATS_H__
+
+#include <stdbool.h>
+
+#include <dynamic-string.h>
+#include "sysd_histogram.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Stages of one main loop iteration, in the order they run. */
+enum sysd_loop_stage {
+    SYSD_LOOP_RUN,              /* sysd_run(). */
+    SYSD_LOOP_UNIXCTL,          /* unixctl_server_run(). */
+    SYSD_LOOP_WAIT,             /* sysd_wait(), unixctl_server_wait(). */
+    SYSD_LOOP_POLL,             /* poll_block(). */
+    SYSD_LOOP_N_STAGES
+};
+
+struct sysd_loop_stats {
+    struct sysd_histogram stages[SYSD_LOOP_N_STAGES];   /* In us. */
+    struct sysd_histogram busy;     /* Per iteration, excluding poll. In us. */
+
+    unsigned long long int stalls;
+    enum sysd_loop_stage last_stall_stage;
+    unsigned long long int last_stall_usec;
+    unsigned long long int max_stall_usec;
+};
+
+/* Default for the time an iteration may spend outside poll_block() before
+ * it is reported as a stall. */
+#define SYSD_LOOP_STALL_MSEC_DEFAULT 1000
+
+/* The timing of the main loop that drives one context. */
+struct sysd_loop {
+    struct sysd_loop_stats stats;
+    unsigned int stall_msec;
+
+    /* State of the current iteration. */
+    long long int iteration_start;  /* time_usec() at sysd_loop_begin(). */
+    long long int stage_start;      /* time_usec() at the last mark. */
+    long long int busy_usec;        /* Busy time so far. */
+    bool stalled;                   /* Stall already logged. */
+};
+
+void sysd_loop_init(struct sysd_loop *);
+
+/* Marks the start of a main loop iteration. */
+void sysd_loop_begin(struct sysd_loop *);
+
+/* Records the time since the previous mark as spent in 'stage', and logs a
+ * stall if the iteration overran the threshold during 'stage'. */
+void sysd_loop_stage_done(struct sysd_loop *, enum sysd_loop_stage stage);
+
+void sysd_loop_set_stall_threshold(struct sysd_loop *, unsigned int msec);
+const char *sysd_loop_stage_name(enum sysd_loop_stage);
+
+void sysd_loop_stats_format(const struct sysd_loop *, struct ds *ds);
+void sysd_loop_stats_reset(struct sysd_loop *);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_LOOP_STATS_H__ */
@@ -0,0 +1,72 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd memory accounting.
+ */
+
+#ifndef __SYSD_MEM_H__
+#define __SYSD_MEM_H__
+
+#include <stddef.h>
+#include <dynamic-string.h>
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* What a sysd allocation is for. */
+enum sysd_mem_category {
+    SYSD_MEM_FRU,               /* FRU EEPROM strings and read buffer. */
+    SYSD_MEM_SUBSYSTEMS,        /* subsystems[] and its entries. */
+    SYSD_MEM_INTERFACES,        /* Per-subsystem interface pointer arrays. */
+    SYSD_MEM_DAEMONS,           /* daemons[] and its entries. */
+    SYSD_MEM_MANIFEST,          /* Other image.manifest data. */
+    SYSD_MEM_PATHS,             /* Hardware description paths. */
+    SYSD_MEM_QOS,               /* QoS defaults read from qos.yaml. */
+    SYSD_MEM_TRACE,             /* Trace ring buffer. */
+    SYSD_MEM_N_CATEGORIES
+};
+
+struct sysd_mem_stats {
+    unsigned long long int cur_bytes;
+    unsigned long long int peak_bytes;
+    unsigned long long int cur_blocks;
+    unsigned long long int allocs;      /* Allocations ever made. */
+};
+
+/* Allocators that account the block against a category.  Like xmalloc()
+ * and friends they abort on failure instead of returning NULL.  A block
+ * must be released with sysd_mem_free(), never with free().  The accounts
+ * are process-wide and locked, so any thread may allocate. */
+void *sysd_mem_alloc(enum sysd_mem_category, size_t size);
+void *sysd_mem_calloc(enum sysd_mem_category, size_t n, size_t size);
+void *sysd_mem_realloc(enum sysd_mem_category, void *p, size_t size);
+char *sysd_mem_strdup(enum sysd_mem_category, const char *s);
+void sysd_mem_free(void *p);
+
+/* Returns the live statistics of a category.  They are read without the
+ * lock, so a field may be stale while another thread allocates. */
+const struct sysd_mem_stats *sysd_mem_get(enum sysd_mem_category);
+const char *sysd_mem_category_name(enum sysd_mem_category);
+
+/* Formats current and peak bytes, live blocks and allocations per
+ * category. */
+void sysd_mem_format(struct ds *ds);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_MEM_H__ */
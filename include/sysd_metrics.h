@@ -0,0 +1,68 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd metrics registry and its OpenMetrics exposition.
+ */
+
+#ifndef __SYSD_METRICS_H__
+#define __SYSD_METRICS_H__
+
+#include <dynamic-string.h>
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Counters bumped on sysd's hot paths, kept per context in
+ * sysd_ctx.metrics.  Gauges and histograms are read from the modules that
+ * own them when the metrics are rendered. */
+enum sysd_metric_counter {
+    SYSD_METRIC_IDL_SEQNO_CHANGES,  /* sysd_run() saw a new IDL seqno. */
+    SYSD_METRIC_SW_INFO_REFRESHES,  /* sysd_update_sw_info() calls. */
+    SYSD_METRIC_PACKAGE_INFO_ROWS,  /* Package_Info rows inserted. */
+    SYSD_METRIC_HW_READY_TIMEOUTS,  /* H/w daemons past their deadline. */
+    SYSD_METRIC_N_COUNTERS
+};
+
+struct sysd_ctx;
+
+void sysd_metric_add(struct sysd_ctx *, enum sysd_metric_counter,
+                     unsigned long long int n);
+
+static inline void
+sysd_metric_inc(struct sysd_ctx *ctx, enum sysd_metric_counter counter)
+{
+    sysd_metric_add(ctx, counter, 1);
+}
+
+/* Appends every metric of 'ctx' to 'ds' in the OpenMetrics text format,
+ * terminated by "# EOF". */
+void sysd_metrics_render(const struct sysd_ctx *ctx, struct ds *ds);
+
+/* Serves metrics on the Unix socket 'path': each client that connects
+ * receives the rendering of the context passed to sysd_metrics_run() and is
+ * then disconnected.  Returns 0 or a positive errno value.
+ *
+ * There is one socket per process.  These functions must only be called
+ * from the thread running the main loop. */
+int sysd_metrics_socket_open(const char *path);
+void sysd_metrics_run(const struct sysd_ctx *ctx);
+void sysd_metrics_wait(const struct sysd_ctx *ctx);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_METRICS_H__ */
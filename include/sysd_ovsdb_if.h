@@ -23,6 +23,9 @@
 #ifndef __SYSD_OVSDB_IF_H__
 #define __SYSD_OVSDB_IF_H__
 
+#include <stddef.h>
+#include "sysd_util.h"
+
 /** @ingroup ops-sysd
  * @{ */
 
@@ -31,9 +34,68 @@
 #define SYSD_OVS_PTR_CALLOC(OVS_STR, count)		\
 			(struct  OVS_STR *) calloc(sizeof(struct OVS_STR), count)
 
-void sysd_dump(char* buf, int buflen);
-void sysd_run(void);
-void sysd_wait(void);
+/* Startup milestones, in time_msec() terms; 0 until reached. */
+struct sysd_boot_times {
+    long long int start;            /* Process start. */
+    long long int initial_config;   /* Initial configuration committed. */
+    bool initial_config_replayed;   /* ...by replaying an earlier boot's. */
+    long long int hw_init_done;     /* All h/w daemons reported cur_hw. */
+    long long int hw_levels[SYSD_MAX_HW_LEVELS + 1];
+                                    /* System:cur_hw reached each level. */
+};
+
+struct ds;
+struct ovsdb_idl_txn;
+struct sysd_ctx;
+struct unixctl_conn;
+
+/* The functions below act on one context and must run in the thread that
+ * owns it; see sysd_ctx.h. */
+
+/* Connects 'ctx' to the database at 'remote'. */
+void sysd_ovsdb_conn_init(struct sysd_ctx *ctx, const char *remote);
+
+void sysd_run(struct sysd_ctx *ctx);
+void sysd_wait(struct sysd_ctx *ctx);
+
+/* Inserts the System row and everything hanging off it, built from the
+ * subsystems, daemons and QoS defaults of 'ctx', into 'txn'. */
+void sysd_initial_configure(struct sysd_ctx *ctx, struct ovsdb_idl_txn *txn);
+
+/* Re-reads image.manifest and queues a transaction that applies the daemons
+ * it adds, removes or changes to the Daemon table.  Replies with a summary
+ * on 'conn', if nonnull, once the transaction completes. */
+void sysd_reload_manifest(struct sysd_ctx *ctx, struct unixctl_conn *conn);
+
+/* One Package_Info row, as read from version_detail.yaml. */
+struct sysd_pkg_info {
+    char *name;
+    char *version;          /* NULL if not given. */
+    char *src_url;          /* NULL if not given. */
+    char *src_type;         /* NULL if not given. */
+};
+
+/* Package_Info rows committed in one transaction. */
+struct sysd_pkg_batch {
+    struct sysd_pkg_info *rows;
+    size_t n;
+    size_t allocated;
+    struct sysd_ctx *ctx;       /* Set when the batch is submitted. */
+};
+
+typedef void sysd_pkg_batch_func(struct sysd_pkg_batch *, void *aux);
+
+/* Reads the version_detail.yaml file at 'path' and passes its records to
+ * 'cb' in batches, which 'cb' then owns.  Returns the number of records,
+ * or -1 if the file could not be read.  Holds no state, so it may run in
+ * any thread. */
+int sysd_read_package_info(const char *path, sysd_pkg_batch_func *cb,
+                           void *aux);
+void sysd_pkg_batch_destroy(struct sysd_pkg_batch *);
+
+/* Formats an estimate of the memory held by the IDL replica of 'ctx', per
+ * table, and by the config-yaml port data it points to. */
+void sysd_ovsdb_memory_format(const struct sysd_ctx *ctx, struct ds *ds);
 
 /** @} end of group ops-sysd */
 #endif /* __SYSD_OVSDB_IF_H__ */
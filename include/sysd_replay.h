@@ -0,0 +1,101 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd record and replay of the initial configuration.
+ */
+
+#ifndef __SYSD_REPLAY_H__
+#define __SYSD_REPLAY_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "sysd_txn_stats.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Format of the record file.  Bump it whenever sysd_initial_configure()
+ * builds different rows from the same inputs, so that a file recorded by an
+ * older sysd is not replayed. */
+#define SYSD_REPLAY_VERSION 1
+
+struct json;
+struct jsonrpc_session;
+struct ovsdb_idl;
+struct sysd_ctx;
+
+/* The initial configuration recorded on an earlier boot, and its replay.
+ * Owned by one sysd_ctx and used from the thread that runs it. */
+struct sysd_replay {
+    char *path;                     /* Record file, or NULL if disabled. */
+    char *remote;                   /* Database the IDL connects to. */
+    struct json *key;               /* Hashes of what the rows derive from. */
+    struct json *ops;               /* Operations to replay, or NULL. */
+    struct json *recorded;          /* Operations of the initial
+                                     * configuration being committed. */
+
+    /* The replay in flight. */
+    struct jsonrpc_session *session;
+    struct json *request_id;        /* NULL until the request is sent. */
+    struct sysd_txn_sample sample;
+};
+
+enum sysd_replay_status {
+    SYSD_REPLAY_IDLE,               /* No replay in flight. */
+    SYSD_REPLAY_PENDING,            /* Waiting for the database. */
+    SYSD_REPLAY_SUCCESS,            /* The recorded rows were inserted. */
+    SYSD_REPLAY_FAILED              /* Nothing was inserted.  Unless the
+                                     * database was no longer empty, the
+                                     * record is not replayed again. */
+};
+
+void sysd_replay_init(struct sysd_replay *);
+void sysd_replay_destroy(struct sysd_replay *);
+
+/* Enables recording to 'path' and loads the operations recorded there if
+ * they were recorded for the same hardware description, FRU data,
+ * image.manifest, os-release and schema as 'ctx' now has.  Call once the subsystems and their
+ * interfaces are known. */
+void sysd_replay_open(struct sysd_ctx *ctx, const char *path,
+                      const char *remote);
+
+/* Returns the rows the open transaction on 'idl' inserts as a JSON array of
+ * OVSDB "insert" operations, which refer to each other by "named-uuid".
+ * Returns NULL if the transaction also modifies rows it did not insert, or
+ * refers to them, since such a transaction depends on what is already in
+ * the database. */
+struct json *sysd_replay_txn_ops(const struct ovsdb_idl *idl);
+
+/* Keeps the operations of the initial configuration in the open
+ * transaction on 'idl', to be written by sysd_replay_save() once it
+ * commits.  Does nothing if recording is disabled. */
+void sysd_replay_capture(struct sysd_replay *, const struct ovsdb_idl *idl);
+void sysd_replay_save(struct sysd_replay *);
+
+/* Sends the loaded operations to the database, as a single "transact"
+ * request that only inserts them while the System table is empty.  Returns
+ * true if a replay is in flight, false if there is nothing to replay.  The
+ * outcome is recorded in 'stats' as SYSD_TXN_INITIAL_REPLAY. */
+bool sysd_replay_start(struct sysd_replay *);
+enum sysd_replay_status sysd_replay_run(struct sysd_replay *,
+                                        struct sysd_txn_stats *stats);
+void sysd_replay_wait(struct sysd_replay *);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_REPLAY_H__ */
@@ -0,0 +1,109 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd trace ring buffer.
+ */
+
+#ifndef __SYSD_TRACE_H__
+#define __SYSD_TRACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <dynamic-string.h>
+#include <ovs-atomic.h>
+#include <util.h>
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Tracepoints.  The meaning of 'arg' and 'arg2' is given per event. */
+enum sysd_trace_event {
+    SYSD_TRACE_IDL_RUN,         /* Span around ovsdb_idl_run(). */
+    SYSD_TRACE_SEQNO_CHANGE,    /* Instant; arg: new IDL seqno. */
+    SYSD_TRACE_STARTUP_STAGE,   /* Span; arg: enum sysd_trace_stage. */
+    SYSD_TRACE_I2C,             /* Span around a FRU EEPROM read; arg: bytes,
+                                 * arg2 (end): nonzero on failure. */
+    SYSD_TRACE_COMMIT,          /* Span; arg: enum sysd_txn_site,
+                                 * arg2 (end): enum ovsdb_idl_txn_status. */
+    SYSD_TRACE_CUR_HW,          /* Instant; arg: index into daemons[],
+                                 * arg2: new Daemon:cur_hw. */
+    SYSD_TRACE_N_EVENTS
+};
+
+/* Startup stages run from main() before the first loop iteration. */
+enum sysd_trace_stage {
+    SYSD_TRACE_STAGE_MANIFEST,
+    SYSD_TRACE_STAGE_HW_DESC,
+    SYSD_TRACE_STAGE_CFG_YAML,
+    SYSD_TRACE_STAGE_SUBSYSTEMS,
+    SYSD_TRACE_STAGE_INTERFACES,
+    SYSD_TRACE_N_STAGES
+};
+
+/* Phases use the Chrome trace-event letters. */
+enum sysd_trace_phase {
+    SYSD_TRACE_BEGIN = 'B',
+    SYSD_TRACE_END = 'E',
+    SYSD_TRACE_INSTANT = 'i'
+};
+
+/* One record of the ring, also the on-disk record format. */
+struct sysd_trace_record {
+    uint64_t usec;              /* time_usec(). */
+    uint16_t event;             /* enum sysd_trace_event. */
+    uint8_t  phase;             /* enum sysd_trace_phase. */
+    uint8_t  pad;
+    uint32_t arg;
+    uint64_t arg2;
+};
+
+extern atomic_bool sysd_trace_enabled;
+
+void sysd_trace_record_(enum sysd_trace_event, enum sysd_trace_phase,
+                        uint32_t arg, uint64_t arg2);
+
+/* Records a tracepoint.  When tracing is off this costs a relaxed load of
+ * a global flag and one predicted branch. */
+#define SYSD_TRACE(EVENT, PHASE, ARG, ARG2)                         \
+    do {                                                            \
+        bool sysd_trace_on__;                                       \
+                                                                    \
+        atomic_read_relaxed(&sysd_trace_enabled, &sysd_trace_on__); \
+        if (OVS_UNLIKELY(sysd_trace_on__)) {                        \
+            sysd_trace_record_(EVENT, PHASE, ARG, ARG2);            \
+        }                                                           \
+    } while (0)
+
+void sysd_trace_enable(bool enable);
+void sysd_trace_format(struct ds *ds);
+
+struct sysd_ctx;
+
+/* Writes the ring, oldest record first, to 'file_name' in the format read
+ * by tools/sysd_trace_decode.py, naming daemon indexes after the daemons of
+ * 'ctx'.  Returns 0 or a positive errno value.
+ *
+ * There is one ring per process, shared by every context.  It takes no
+ * lock: a tracepoint claims its slot with an atomic increment, so
+ * tracepoints may fire from any thread.  A record still being written when
+ * the ring is saved is left out of the file. */
+int sysd_trace_save(const struct sysd_ctx *ctx, const char *file_name);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_TRACE_H__ */
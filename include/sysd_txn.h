@@ -0,0 +1,102 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for the ops-sysd OVSDB transaction manager.
+ */
+
+#ifndef __SYSD_TXN_H__
+#define __SYSD_TXN_H__
+
+#include <stddef.h>
+#include <dynamic-string.h>
+#include <list.h>
+#include <ovsdb-idl.h>
+#include "sysd_txn_stats.h"
+#include "sysd_write.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Adds a write to 'txn'.  It is called when the write reaches the head of
+ * the queue and again for every retry, so it must work from the current
+ * contents of the IDL.  Returns the number of rows it changed; when every
+ * write in a transaction returns 0 nothing is committed and the writes
+ * complete with TXN_UNCHANGED. */
+typedef size_t sysd_txn_build_func(struct ovsdb_idl_txn *txn, void *aux);
+
+/* Reports the outcome of a write: the final transaction status and the row
+ * count its last build returned.  May be NULL. */
+typedef void sysd_txn_done_func(enum ovsdb_idl_txn_status status,
+                                size_t n_changed, void *aux);
+
+/* The writes queued against one IDL, the transaction in flight and the
+ * statistics of those committed.  A queue is owned by a single thread;
+ * different queues share nothing. */
+struct sysd_txn_queue {
+    struct ovs_list queue;              /* Waiting "struct sysd_txn_req"s. */
+    long long int retry_at;             /* Head of 'queue' waits until. */
+
+    /* The transaction being committed and the writes in it. */
+    struct ovs_list inflight;
+    struct ovsdb_idl_txn *txn;
+    enum sysd_txn_site site;
+    struct sysd_txn_sample sample;
+
+    struct {
+        unsigned long long int submitted;
+        unsigned long long int dropped;     /* Duplicates of a queued write. */
+        unsigned long long int batched;     /* Committed with another write. */
+        unsigned long long int retries;
+        unsigned long long int unchanged;   /* Built to nothing; not sent. */
+    } counters;
+
+    struct sysd_txn_stats stats;        /* Per call site. */
+    struct sysd_write_stats writes;     /* Of the build functions. */
+};
+
+void sysd_txn_queue_init(struct sysd_txn_queue *);
+
+/* Aborts the transaction in flight, if any, and completes every write with
+ * TXN_ABORTED so their owners can free 'aux'. */
+void sysd_txn_queue_destroy(struct sysd_txn_queue *);
+
+/* Queues a write.  A write with the same functions and 'aux' as one still
+ * waiting in the queue is dropped, since the queued one will see the same
+ * state when it is built. */
+void sysd_txn_submit(struct sysd_txn_queue *, enum sysd_txn_site,
+                     sysd_txn_build_func *, sysd_txn_done_func *, void *aux);
+
+/* True if a write with this build function and 'aux' is queued or being
+ * committed. */
+bool sysd_txn_is_pending(const struct sysd_txn_queue *,
+                         sysd_txn_build_func *, const void *aux);
+
+/* True if any write from 'site' is queued or being committed. */
+bool sysd_txn_site_is_pending(const struct sysd_txn_queue *,
+                              enum sysd_txn_site);
+
+/* Builds and commits queued writes and collects the outcome of the one in
+ * flight.  Call after ovsdb_idl_run(), while holding the database lock. */
+void sysd_txn_run(struct sysd_txn_queue *, struct ovsdb_idl *idl);
+void sysd_txn_wait(const struct sysd_txn_queue *);
+
+void sysd_txn_format(const struct sysd_txn_queue *, struct ds *ds);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_TXN_H__ */
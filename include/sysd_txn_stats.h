@@ -0,0 +1,92 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd OVSDB transaction statistics.
+ */
+
+#ifndef __SYSD_TXN_STATS_H__
+#define __SYSD_TXN_STATS_H__
+
+#include <dynamic-string.h>
+#include <ovsdb-idl.h>
+#include "sysd_histogram.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Places sysd commits transactions from.  Statistics are kept per site. */
+enum sysd_txn_site {
+    SYSD_TXN_INITIAL_CONFIG,    /* sysd_run(): initial configuration. */
+    SYSD_TXN_PACKAGE_INFO,      /* sysd_add_package_info(). */
+    SYSD_TXN_SW_INFO,           /* sysd_update_sw_info(). */
+    SYSD_TXN_HW_DONE,           /* sysd_set_hw_level(). */
+    SYSD_TXN_HW_EXPIRED,        /* sysd_chk_if_hw_daemons_done(). */
+    SYSD_TXN_MANIFEST_RELOAD,   /* sysd_reload_manifest(). */
+    SYSD_TXN_QOS_RECONCILE,     /* sysd_reconcile_qos_defaults(). */
+    SYSD_TXN_QOS_RESTORE,       /* ops-sysd/qos-restore-defaults. */
+    SYSD_TXN_INITIAL_REPLAY,    /* sysd_replay_start(): recorded initial
+                                 * configuration. */
+    SYSD_TXN_PER_BOX,           /* sysd_run(): per-box values of an emitted
+                                 * configuration. */
+    SYSD_TXN_N_SITES
+};
+
+struct sysd_txn_site_stats {
+    unsigned long long int commits;
+    unsigned long long int failures;    /* Not TXN_SUCCESS or TXN_UNCHANGED. */
+    enum ovsdb_idl_txn_status last_status;
+
+    struct sysd_histogram usec;         /* Commit latency in us. */
+
+    unsigned long long int total_rows;
+    unsigned long long int max_rows;
+    unsigned long long int total_bytes;
+    unsigned long long int max_bytes;
+};
+
+/* The statistics of one sysd_txn_queue, per call site. */
+struct sysd_txn_stats {
+    struct sysd_txn_site_stats sites[SYSD_TXN_N_SITES];
+};
+
+/* What is known of a transaction between its first commit attempt and its
+ * outcome.  The caller fills in 'rows' and 'bytes'. */
+struct sysd_txn_sample {
+    unsigned long long int rows;        /* As counted by the build. */
+    unsigned long long int bytes;       /* Estimated request size. */
+    long long int start_usec;
+};
+
+/* Starts timing a transaction against 'site'.  Call just before the first
+ * ovsdb_idl_txn_commit(). */
+void sysd_txn_stats_begin(enum sysd_txn_site, struct sysd_txn_sample *);
+
+/* Records in 'stats' the latency from sysd_txn_stats_begin() to the
+ * outcome, the size and the status of a transaction against 'site'. */
+void sysd_txn_stats_end(struct sysd_txn_stats *stats, enum sysd_txn_site,
+                        const struct sysd_txn_sample *,
+                        enum ovsdb_idl_txn_status);
+
+const char *sysd_txn_site_name(enum sysd_txn_site);
+
+void sysd_txn_stats_format(const struct sysd_txn_stats *, struct ds *ds);
+void sysd_txn_stats_reset(struct sysd_txn_stats *);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_TXN_STATS_H__ */
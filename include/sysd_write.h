@@ -0,0 +1,77 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Header for ops-sysd's compare-before-write OVSDB column setters.
+ */
+
+#ifndef __SYSD_WRITE_H__
+#define __SYSD_WRITE_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <dynamic-string.h>
+#include <hmap.h>
+#include <ovsdb-idl.h>
+#include <smap.h>
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* The writes made and dropped through the functions below, per column.
+ * Each sysd_txn_queue keeps one for the transactions it builds. */
+struct sysd_write_stats {
+    struct hmap columns;                /* "struct sysd_write_column"s. */
+
+    /* Sums over every column; not cleared by sysd_write_reset(). */
+    unsigned long long int written;
+    unsigned long long int elided;
+    unsigned long long int bytes;       /* Estimated size of 'written'. */
+};
+
+void sysd_write_stats_init(struct sysd_write_stats *);
+void sysd_write_stats_destroy(struct sysd_write_stats *);
+
+/* Each function writes one column of 'row' in the open transaction, unless
+ * the replica (or an earlier write in the same transaction) already holds
+ * the value, and returns true if it wrote.  Writes made and dropped are
+ * counted in 'stats'.  Pass the generated column, e.g.
+ * &ovsrec_system_col_cur_hw, and the row's 'header_'. */
+bool sysd_write_integer(struct sysd_write_stats *stats,
+                        const struct ovsdb_idl_row *,
+                        const struct ovsdb_idl_column *, int64_t value);
+bool sysd_write_integers(struct sysd_write_stats *stats,
+                         const struct ovsdb_idl_row *,
+                         const struct ovsdb_idl_column *,
+                         const int64_t *values, size_t n);
+bool sysd_write_bool(struct sysd_write_stats *stats,
+                     const struct ovsdb_idl_row *,
+                     const struct ovsdb_idl_column *, bool value);
+bool sysd_write_string(struct sysd_write_stats *stats,
+                       const struct ovsdb_idl_row *,
+                       const struct ovsdb_idl_column *, const char *value);
+bool sysd_write_smap(struct sysd_write_stats *stats,
+                     const struct ovsdb_idl_row *,
+                     const struct ovsdb_idl_column *, const struct smap *);
+
+void sysd_write_format(const struct sysd_write_stats *, struct ds *ds);
+void sysd_write_reset(struct sysd_write_stats *);
+
+/** @} end of group ops-sysd */
+#endif /* __SYSD_WRITE_H__ */
@@ -37,6 +37,7 @@ typedef enum
 }cli_subsystem;
 
 int cli_system_get_all();
+int cli_system_get_all_json();
 
 void cli_pre_init(void);
 void cli_post_init(void);
@@ -0,0 +1,579 @@
+/* Rendering of the "show system" output.
+ *
+ * Copyright (C) 2015-2016 Hewlett Packard Enterprise Development LP
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * File: system_show.c
+ *
+ * Purpose: Format "show system" as text or JSON from IDL rows.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "system_show.h"
+#include "dynamic-string.h"
+#include "smap.h"
+#include "util.h"
+#include "vswitch-idl.h"
+#include "openswitch-idl.h"
+
+/* The JSON document is handed to the writer whenever this much of it has
+ * been buffered, so memory use does not grow with the number of rows. */
+#define SYSTEM_SHOW_JSON_CHUNK 4096
+
+const char *psu_state_string[] = {
+    "Absent",
+    "Input Fault",
+    "Output Fault",
+    "OK",
+    "Unknown"
+};
+
+/* IDL columns read by "show system". Every vtysh session replicates
+ * whatever the plugins register, so only list columns a command reads. */
+const struct ovsdb_idl_column *const system_show_columns[] = {
+    &ovsrec_system_col_switch_version,
+
+    &ovsrec_subsystem_col_other_info,
+    &ovsrec_subsystem_col_fans,
+    &ovsrec_subsystem_col_leds,
+    &ovsrec_subsystem_col_power_supplies,
+    &ovsrec_subsystem_col_temp_sensors,
+
+    &ovsrec_fan_col_name,
+    &ovsrec_fan_col_speed,
+    &ovsrec_fan_col_status,
+
+    &ovsrec_led_col_id,
+    &ovsrec_led_col_state,
+    &ovsrec_led_col_status,
+
+    &ovsrec_power_supply_col_name,
+    &ovsrec_power_supply_col_status,
+
+    &ovsrec_temp_sensor_col_name,
+    &ovsrec_temp_sensor_col_location,
+    &ovsrec_temp_sensor_col_temperature,
+};
+const size_t system_show_n_columns = ARRAY_SIZE(system_show_columns);
+
+/* IDL columns read by "show system json", in addition to
+ * system_show_columns. */
+const struct ovsdb_idl_column *const system_show_json_columns[] = {
+    &ovsrec_fan_col_direction,
+    &ovsrec_fan_col_rpm,
+};
+const size_t system_show_json_n_columns =
+    ARRAY_SIZE(system_show_json_columns);
+
+/* Subsystem other_info keys shown by "show system", with the member names
+ * used for them in the JSON document. */
+static const struct {
+    const char *json_name;
+    const char *key;
+} system_info_keys[] = {
+    { "product_name",        "Product Name" },
+    { "vendor",              "vendor" },
+    { "platform",            "platform_name" },
+    { "manufacturer",        "manufacturer" },
+    { "manufacture_date",    "manufacture_date" },
+    { "serial_number",       "serial_number" },
+    { "label_revision",      "label_revision" },
+    { "onie_version",        "onie_version" },
+    { "diag_version",        "diag_version" },
+    { "base_mac_address",    "base_mac_address" },
+    { "number_of_macs",      "number_of_macs" },
+    { "interface_count",     "interface_count" },
+    { "max_interface_speed", "max_interface_speed" },
+};
+
+/*
+ * Function        : format_psu_string
+ * Resposibility     : Change status string in OVSDB to more
+ *        readable string
+ * Parameters
+ *      status  : Pointer to status string
+ * Return      : Pointer to formatted status string
+ */
+static const char*
+format_psu_string (char* status)
+{
+    if (!status)
+        return NULL;
+
+    if (0 == strcmp (status,OVSREC_POWER_SUPPLY_STATUS_FAULT_ABSENT))
+        return psu_state_string[POWER_SUPPLY_STATUS_FAULT_ABSENT];
+    else if (0 == strcmp (status,OVSREC_POWER_SUPPLY_STATUS_FAULT_INPUT))
+        return psu_state_string[POWER_SUPPLY_STATUS_FAULT_INPUT];
+    else if (0 == strcmp (status,OVSREC_POWER_SUPPLY_STATUS_FAULT_OUTPUT))
+        return psu_state_string[POWER_SUPPLY_STATUS_FAULT_OUTPUT];
+
+    return NULL;
+}
+
+/*
+ * Function        : other_info_get
+ * Resposibility     : Look up a subsystem other_info value for display
+ * Parameters
+ *  pSys    : Pointer to ovsrec_subsystem structure
+ *  key     : other_info key
+ * Return      : the value, or " " if there is none
+ */
+static const char*
+other_info_get (const struct ovsrec_subsystem* pSys, const char* key)
+{
+    const char* buf = smap_get (&pSys->other_info, key);
+
+    return buf ? buf : " ";
+}
+
+static int
+compare_fan (const void* a, const void* b)
+{
+    const struct ovsrec_fan* const* s1 = a;
+    const struct ovsrec_fan* const* s2 = b;
+
+    return strcmp((*s1)->name, (*s2)->name);
+}
+
+static int
+compare_led (const void* a, const void* b)
+{
+    const struct ovsrec_led* const* s1 = a;
+    const struct ovsrec_led* const* s2 = b;
+
+    return strcmp((*s1)->id, (*s2)->id);
+}
+
+static int
+compare_psu (const void* a, const void* b)
+{
+    const struct ovsrec_power_supply* const* s1 = a;
+    const struct ovsrec_power_supply* const* s2 = b;
+
+    return strcmp((*s1)->name, (*s2)->name);
+}
+
+static int
+compare_temp_sensor (const void* a, const void* b)
+{
+    const struct ovsrec_temp_sensor* const* s1 = a;
+    const struct ovsrec_temp_sensor* const* s2 = b;
+
+    return strcmp((*s1)->name, (*s2)->name);
+}
+
+/*
+ * Function        : sort_rows
+ * Resposibility     : Rebuild a sorted index of a subsystem's rows
+ * Parameters
+ *  index   : Pointer to the index array, reallocated to fit
+ *  n_index : Set to the number of rows
+ *  rows    : The subsystem's row pointers
+ *  n_rows  : Number of rows
+ *  compare : qsort() comparison function
+ */
+static void
+sort_rows (const void*** index, size_t* n_index,
+           void* const* rows, size_t n_rows,
+           int (*compare)(const void*, const void*))
+{
+    *index = xrealloc(*index, (n_rows ? n_rows : 1) * sizeof **index);
+    memcpy(*index, rows, n_rows * sizeof **index);
+    *n_index = n_rows;
+    qsort(*index, n_rows, sizeof **index, compare);
+}
+
+void
+system_show_sort_fans (const struct ovsrec_subsystem* pSys,
+                       const struct ovsrec_fan*** index, size_t* n)
+{
+    sort_rows((const void***) index, n, (void* const*) pSys->fans,
+              pSys->n_fans, compare_fan);
+}
+
+void
+system_show_sort_leds (const struct ovsrec_subsystem* pSys,
+                       const struct ovsrec_led*** index, size_t* n)
+{
+    sort_rows((const void***) index, n, (void* const*) pSys->leds,
+              pSys->n_leds, compare_led);
+}
+
+void
+system_show_sort_psus (const struct ovsrec_subsystem* pSys,
+                       const struct ovsrec_power_supply*** index, size_t* n)
+{
+    sort_rows((const void***) index, n, (void* const*) pSys->power_supplies,
+              pSys->n_power_supplies, compare_psu);
+}
+
+void
+system_show_sort_temp_sensors (const struct ovsrec_subsystem* pSys,
+                               const struct ovsrec_temp_sensor*** index,
+                               size_t* n)
+{
+    sort_rows((const void***) index, n, (void* const*) pSys->temp_sensors,
+              pSys->n_temp_sensors, compare_temp_sensor);
+}
+
+/*
+ * Function        : system_show_format_info
+ * Resposibility     : Format output for system info
+ * Parameters
+ *      ds  : Buffer the output is appended to
+ *      nl  : Line terminator of the vty the output is for
+ *  pSys    : Pointer to ovsrec_subsystem structure
+ *  pVswitch: Pointer to ovsrec_system structure
+ */
+void
+system_show_format_info (struct ds* ds, const char* nl,
+                         const struct ovsrec_subsystem* pSys,
+                         const struct ovsrec_system* pVswitch)
+{
+    ds_put_format(ds, "%-20s%s%-30s%s", "OpenSwitch Version", ": ",
+                 (pVswitch->switch_version) ? pVswitch->switch_version : " ",
+                 nl);
+    ds_put_format(ds, "%-20s%s%-30s%s%s", "Product Name", ": ",
+                  other_info_get(pSys, "Product Name"), nl, nl);
+    ds_put_format(ds, "%-20s%s%-30s%s", "Vendor", ": ",
+                  other_info_get(pSys, "vendor"), nl);
+    ds_put_format(ds, "%-20s%s%-30s%s", "Platform", ": ",
+                  other_info_get(pSys, "platform_name"), nl);
+    ds_put_format(ds, "%-20s%s%-20s%s", "Manufacturer", ": ",
+                  other_info_get(pSys, "manufacturer"), nl);
+    ds_put_format(ds, "%-20s%s%-20s%s%s", "Manufacturer Date", ": ",
+                  other_info_get(pSys, "manufacture_date"), nl, nl);
+
+    ds_put_format(ds, "%-20s%s%-20s", "Serial Number", ": ",
+                  other_info_get(pSys, "serial_number"));
+    ds_put_format(ds, "%-20s%s%-10s%s%s", "Label Revision", ": ",
+                  other_info_get(pSys, "label_revision"), nl, nl);
+
+    ds_put_format(ds, "%-20s%s%-20s", "ONIE Version", ": ",
+                  other_info_get(pSys, "onie_version"));
+    ds_put_format(ds, "%-20s%s%-10s%s", "DIAG Version", ": ",
+                  other_info_get(pSys, "diag_version"), nl);
+
+    ds_put_format(ds, "%-20s%s%-20s", "Base MAC Address", ": ",
+                  other_info_get(pSys, "base_mac_address"));
+    ds_put_format(ds, "%-20s%s%-5s%s", "Number of MACs", ": ",
+                  other_info_get(pSys, "number_of_macs"), nl);
+
+    ds_put_format(ds, "%-20s%s%-20s", "Interface Count", ": ",
+                  other_info_get(pSys, "interface_count"));
+    ds_put_format(ds, "%-20s%s%-6sMbps%s", "Max Interface Speed", ": ",
+                  other_info_get(pSys, "max_interface_speed"), nl);
+}
+
+void
+system_show_format_fans (struct ds* ds, const char* nl,
+                         const struct ovsrec_fan** fans, size_t n)
+{
+    size_t i;
+
+    ds_put_format(ds, "%sFan details:%s%s", nl, nl, nl);
+    ds_put_format(ds, "%-15s%-10s%-10s%s", "Name", "Speed", "Status", nl);
+    ds_put_format(ds, "%s%s", "--------------------------------", nl);
+    for (i = 0; i < n; i++) {
+        ds_put_format(ds, "%-15s%-10s%-10s%s", fans[i]->name,
+                      fans[i]->speed, fans[i]->status, nl);
+    }
+}
+
+void
+system_show_format_leds (struct ds* ds, const char* nl,
+                         const struct ovsrec_led** leds, size_t n)
+{
+    size_t i;
+
+    ds_put_format(ds, "%sLED details:%s%s", nl, nl, nl);
+    ds_put_format(ds, "%-10s%-10s%-8s%s", "Name", "State", "Status", nl);
+    ds_put_format(ds, "%s%s", "-------------------------", nl);
+    for (i = 0; i < n; i++) {
+        ds_put_format(ds, "%-10s%-10s%-8s%s", leds[i]->id,
+                      leds[i]->state, leds[i]->status, nl);
+    }
+}
+
+void
+system_show_format_psus (struct ds* ds, const char* nl,
+                         const struct ovsrec_power_supply** psus, size_t n)
+{
+    size_t i;
+
+    ds_put_format(ds, "%sPower supply details:%s%s", nl, nl, nl);
+    ds_put_format(ds, "%-10s%-10s%s", "Name", "Status", nl);
+    ds_put_format(ds, "%s%s", "-----------------------", nl);
+    for (i = 0; i < n; i++) {
+        ds_put_format(ds, "%-10s%-10s%s", psus[i]->name,
+                      format_psu_string(psus[i]->status), nl);
+    }
+}
+
+void
+system_show_format_temp_sensors (struct ds* ds, const char* nl,
+                                 const struct ovsrec_temp_sensor** sensors,
+                                 size_t n)
+{
+    size_t i;
+
+    ds_put_format(ds, "%sTemperature Sensors:%s%s", nl, nl, nl);
+    if (0 != n) {
+        ds_put_format(ds, "%-50s%-10s%-18s%s", "Location", "Name",
+                      "Reading(celsius)", nl);
+        ds_put_format(ds, "%s%s",
+                "---------------------------------------------------------------------------",
+                nl);
+        for (i = 0; i < n; i++) {
+            const struct ovsrec_temp_sensor* pTempSen = sensors[i];
+
+            ds_put_format(ds, "%-50s%-10s%3.2f%s", pTempSen->location,
+                          pTempSen->name,
+                          (double)((pTempSen->temperature)/1000), nl);
+        }
+    } else {
+        ds_put_format(ds, "%-10s%-10s%-18s%s", "Location", "Name",
+                      "Reading(celsius)", nl);
+        ds_put_format(ds, "%s%s", "------------------------------------", nl);
+    }
+}
+
+/* Streams a JSON document to a system_show_write_func in chunks of about
+ * SYSTEM_SHOW_JSON_CHUNK bytes. */
+struct json_stream {
+    struct ds buf;
+    system_show_write_func *write;
+    void *aux;
+    bool first;                 /* Nothing in the current object/array yet. */
+};
+
+static void
+json_stream_flush (struct json_stream* js)
+{
+    if (js->buf.length) {
+        js->write(ds_cstr(&js->buf), js->buf.length, js->aux);
+        ds_clear(&js->buf);
+    }
+}
+
+static void
+json_stream_put_string (struct json_stream* js, const char* s)
+{
+    struct ds* ds = &js->buf;
+
+    if (!s) {
+        ds_put_cstr(ds, "null");
+        return;
+    }
+
+    ds_put_char(ds, '"');
+    for (; *s; s++) {
+        unsigned char c = *s;
+
+        switch (c) {
+        case '"':
+            ds_put_cstr(ds, "\\\"");
+            break;
+        case '\\':
+            ds_put_cstr(ds, "\\\\");
+            break;
+        case '\n':
+            ds_put_cstr(ds, "\\n");
+            break;
+        case '\r':
+            ds_put_cstr(ds, "\\r");
+            break;
+        case '\t':
+            ds_put_cstr(ds, "\\t");
+            break;
+        default:
+            if (c < 0x20) {
+                ds_put_format(ds, "\\u%04x", c);
+            } else {
+                ds_put_char(ds, c);
+            }
+            break;
+        }
+    }
+    ds_put_char(ds, '"');
+}
+
+/* Starts a new member of the current object, or a new element of the
+ * current array if 'name' is NULL. */
+static void
+json_stream_next (struct json_stream* js, const char* name)
+{
+    if (!js->first) {
+        ds_put_char(&js->buf, ',');
+    }
+    js->first = false;
+    if (name) {
+        json_stream_put_string(js, name);
+        ds_put_char(&js->buf, ':');
+    }
+}
+
+static void
+json_stream_open (struct json_stream* js, const char* name, char c)
+{
+    json_stream_next(js, name);
+    ds_put_char(&js->buf, c);
+    js->first = true;
+}
+
+static void
+json_stream_close (struct json_stream* js, char c)
+{
+    ds_put_char(&js->buf, c);
+    js->first = false;
+    if (js->buf.length >= SYSTEM_SHOW_JSON_CHUNK) {
+        json_stream_flush(js);
+    }
+}
+
+static void
+json_stream_string (struct json_stream* js, const char* name, const char* s)
+{
+    json_stream_next(js, name);
+    json_stream_put_string(js, s);
+}
+
+static void
+json_stream_integer (struct json_stream* js, const char* name,
+                     const int64_t* value)
+{
+    json_stream_next(js, name);
+    if (value) {
+        ds_put_format(&js->buf, "%"PRId64, *value);
+    } else {
+        ds_put_cstr(&js->buf, "null");
+    }
+}
+
+/*
+ * Function        : system_show_json
+ * Resposibility     : Stream "show system" as a JSON document
+ * Parameters
+ *  pSys    : Pointer to ovsrec_subsystem structure
+ *  pVswitch: Pointer to ovsrec_system structure
+ *  write   : Called with each piece of the document, in order
+ *  aux     : Passed to 'write'
+ *
+ * The document is a single object:
+ *
+ *   "version"        SYSTEM_SHOW_JSON_VERSION.
+ *   "system"         Object with "openswitch_version" and the members of
+ *                    system_info_keys[]; each is a string, or null if the
+ *                    subsystem does not provide it.
+ *   "fans"           Array of {"name", "speed", "status", "direction",
+ *                    "rpm"}, sorted by name.  "rpm" is an integer or null.
+ *   "leds"           Array of {"id", "state", "status"}, sorted by id.
+ *   "power_supplies" Array of {"name", "status"}, sorted by name.  "status"
+ *                    is the OVSDB value, e.g. "ok" or "fault_absent".
+ *   "temp_sensors"   Array of {"name", "location", "temperature"}, sorted
+ *                    by name.  "temperature" is in millidegrees Celsius.
+ *
+ * Only the small sorted row indices are allocated; the document itself is
+ * handed to 'write' in chunks as it is produced.
+ */
+void
+system_show_json (const struct ovsrec_subsystem* pSys,
+                  const struct ovsrec_system* pVswitch,
+                  system_show_write_func* write, void* aux)
+{
+    const struct ovsrec_fan** fans = NULL;
+    const struct ovsrec_led** leds = NULL;
+    const struct ovsrec_power_supply** psus = NULL;
+    const struct ovsrec_temp_sensor** sensors = NULL;
+    size_t n_fans, n_leds, n_psus, n_sensors;
+    struct json_stream js;
+    size_t i;
+
+    ds_init(&js.buf);
+    js.write = write;
+    js.aux = aux;
+    js.first = true;
+
+    json_stream_open(&js, NULL, '{');
+    json_stream_integer(&js, "version",
+                        &(int64_t) { SYSTEM_SHOW_JSON_VERSION });
+
+    json_stream_open(&js, "system", '{');
+    json_stream_string(&js, "openswitch_version", pVswitch->switch_version);
+    for (i = 0; i < ARRAY_SIZE(system_info_keys); i++) {
+        json_stream_string(&js, system_info_keys[i].json_name,
+                           smap_get(&pSys->other_info,
+                                    system_info_keys[i].key));
+    }
+    json_stream_close(&js, '}');
+
+    system_show_sort_fans(pSys, &fans, &n_fans);
+    json_stream_open(&js, "fans", '[');
+    for (i = 0; i < n_fans; i++) {
+        json_stream_open(&js, NULL, '{');
+        json_stream_string(&js, "name", fans[i]->name);
+        json_stream_string(&js, "speed", fans[i]->speed);
+        json_stream_string(&js, "status", fans[i]->status);
+        json_stream_string(&js, "direction", fans[i]->direction);
+        json_stream_integer(&js, "rpm",
+                            fans[i]->n_rpm ? fans[i]->rpm : NULL);
+        json_stream_close(&js, '}');
+    }
+    json_stream_close(&js, ']');
+    free(fans);
+
+    system_show_sort_leds(pSys, &leds, &n_leds);
+    json_stream_open(&js, "leds", '[');
+    for (i = 0; i < n_leds; i++) {
+        json_stream_open(&js, NULL, '{');
+        json_stream_string(&js, "id", leds[i]->id);
+        json_stream_string(&js, "state", leds[i]->state);
+        json_stream_string(&js, "status", leds[i]->status);
+        json_stream_close(&js, '}');
+    }
+    json_stream_close(&js, ']');
+    free(leds);
+
+    system_show_sort_psus(pSys, &psus, &n_psus);
+    json_stream_open(&js, "power_supplies", '[');
+    for (i = 0; i < n_psus; i++) {
+        json_stream_open(&js, NULL, '{');
+        json_stream_string(&js, "name", psus[i]->name);
+        json_stream_string(&js, "status", psus[i]->status);
+        json_stream_close(&js, '}');
+    }
+    json_stream_close(&js, ']');
+    free(psus);
+
+    system_show_sort_temp_sensors(pSys, &sensors, &n_sensors);
+    json_stream_open(&js, "temp_sensors", '[');
+    for (i = 0; i < n_sensors; i++) {
+        json_stream_open(&js, NULL, '{');
+        json_stream_string(&js, "name", sensors[i]->name);
+        json_stream_string(&js, "location", sensors[i]->location);
+        json_stream_integer(&js, "temperature", &sensors[i]->temperature);
+        json_stream_close(&js, '}');
+    }
+    json_stream_close(&js, ']');
+    free(sensors);
+
+    json_stream_close(&js, '}');
+    json_stream_flush(&js);
+    ds_destroy(&js.buf);
+}
@@ -0,0 +1,79 @@
+/* Rendering of the "show system" output.
+ *
+ * Copyright (C) 2016 Hewlett Packard Enterprise Development LP
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * File: system_show.h
+ *
+ * Purpose: Format "show system" as text or JSON from IDL rows. Nothing
+ *          here depends on vtysh, so the formatting can also be driven
+ *          from the benchmarks.
+ */
+
+#ifndef _SYSTEM_SHOW_H
+#define _SYSTEM_SHOW_H
+
+#include <stddef.h>
+#include "dynamic-string.h"
+#include "vswitch-idl.h"
+
+/* Version of the "show system json" document. Bump it whenever a member
+ * is renamed, removed or changes type; adding members keeps the version. */
+#define SYSTEM_SHOW_JSON_VERSION 1
+
+/* IDL columns read by "show system", and the ones "show system json" reads
+ * in addition.  The CLI plugin registers exactly these. */
+extern const struct ovsdb_idl_column *const system_show_columns[];
+extern const size_t system_show_n_columns;
+extern const struct ovsdb_idl_column *const system_show_json_columns[];
+extern const size_t system_show_json_n_columns;
+
+/* Rebuild '*index' as the subsystem's rows sorted by name (LEDs by id).
+ * '*index' is reallocated as needed and may be NULL initially. */
+void system_show_sort_fans(const struct ovsrec_subsystem *,
+                           const struct ovsrec_fan ***index, size_t *n);
+void system_show_sort_leds(const struct ovsrec_subsystem *,
+                           const struct ovsrec_led ***index, size_t *n);
+void system_show_sort_psus(const struct ovsrec_subsystem *,
+                           const struct ovsrec_power_supply ***index,
+                           size_t *n);
+void system_show_sort_temp_sensors(const struct ovsrec_subsystem *,
+                                   const struct ovsrec_temp_sensor ***index,
+                                   size_t *n);
+
+/* Text sections of "show system", appended to 'ds' with line terminator
+ * 'nl'.  The row arrays are expected in display order. */
+void system_show_format_info(struct ds *, const char *nl,
+                             const struct ovsrec_subsystem *,
+                             const struct ovsrec_system *);
+void system_show_format_fans(struct ds *, const char *nl,
+                             const struct ovsrec_fan **, size_t n);
+void system_show_format_leds(struct ds *, const char *nl,
+                             const struct ovsrec_led **, size_t n);
+void system_show_format_psus(struct ds *, const char *nl,
+                             const struct ovsrec_power_supply **, size_t n);
+void system_show_format_temp_sensors(struct ds *, const char *nl,
+                                     const struct ovsrec_temp_sensor **,
+                                     size_t n);
+
+/* Receives the JSON document in pieces, in order. */
+typedef void system_show_write_func(const char *s, size_t n, void *aux);
+
+void system_show_json(const struct ovsrec_subsystem *,
+                      const struct ovsrec_system *,
+                      system_show_write_func *, void *aux);
+
+#endif //_SYSTEM_SHOW_H
@@ -27,9 +27,14 @@
 #include "vtysh/vtysh.h"
 #include "vtysh/vtysh_user.h"
 #include "system_vty.h"
+#include "system_show.h"
 #include "vswitch-idl.h"
 #include "ovsdb-idl.h"
 #include "smap.h"
+#include "dynamic-string.h"
+#include "hmap.h"
+#include "util.h"
+#include "uuid.h"
 #include "vtysh/memory.h"
 #include "openvswitch/vlog.h"
 #include "openswitch-idl.h"
@@ -40,138 +45,201 @@ VLOG_DEFINE_THIS_MODULE(vtysh_system_cli);
 
 extern struct ovsdb_idl *idl;
 
-const char *psu_state_string[] = {
-    "Absent",
-    "Input Fault",
-    "Output Fault",
-    "OK",
-    "Unknown"
+/*
+ * "show system" is rendered per subsystem in independent sections, each
+ * cached as text together with the IDL table seqnos it was rendered from.
+ * A section is rendered again only when one of those tables changed, so
+ * repeated polling of an unchanged system costs a few seqno comparisons.
+ */
+enum system_view_section {
+    SYSTEM_VIEW_INFO,
+    SYSTEM_VIEW_FANS,
+    SYSTEM_VIEW_LEDS,
+    SYSTEM_VIEW_PSUS,
+    SYSTEM_VIEW_TEMP_SENSORS,
+    SYSTEM_VIEW_N_SECTIONS
+};
+
+/* Every section depends on the Subsystem table and one other table. */
+#define SYSTEM_VIEW_N_SEQNOS 2
+
+struct system_view_cache {
+    bool valid;
+    unsigned int seqnos[SYSTEM_VIEW_N_SEQNOS];
+    struct ds text;
 };
 
+/* Cached view of one subsystem. The sorted row indices are rebuilt along
+ * with their section, and are only used while that section is valid. */
+struct system_view {
+    struct hmap_node hmap_node;         /* In system_views. */
+    struct uuid subsystem_uuid;
+    char nl[3];                         /* VTY_NEWLINE rendered with. */
+    struct system_view_cache sections[SYSTEM_VIEW_N_SECTIONS];
+
+    const struct ovsrec_fan **fans;
+    size_t n_fans;
+    const struct ovsrec_led **leds;
+    size_t n_leds;
+    const struct ovsrec_power_supply **psus;
+    size_t n_psus;
+    const struct ovsrec_temp_sensor **temp_sensors;
+    size_t n_temp_sensors;
+};
+
+/* Contains "struct system_view"s, by subsystem UUID. */
+static struct hmap system_views = HMAP_INITIALIZER(&system_views);
+
+/* Subsystem table seqno system_views was last pruned at. */
+static unsigned int system_views_subsystem_seqno;
+
 /*
- * Function        : compare_fan
- * Resposibility     : Fan sort function for qsort
- * Parameters
- *  a   : Pointer to 1st element in the array
- *  b   : Pointer to next element in the array
- * Return      : comparative difference between names.
+ * Function        : system_view_seqnos
+ * Resposibility     : Get the seqnos of the IDL tables a section is
+ *        rendered from
  */
-static inline int
-compare_fan (const void* a,const void* b)
+static void
+system_view_seqnos (enum system_view_section section,
+                    unsigned int seqnos[SYSTEM_VIEW_N_SEQNOS])
 {
-    struct ovsrec_fan* s1 = (struct ovsrec_fan*)a;
-    struct ovsrec_fan* s2 = (struct ovsrec_fan*)b;
+    seqnos[0] = ovsrec_subsystem_get_seqno(idl);
+    switch (section) {
+    case SYSTEM_VIEW_INFO:
+        seqnos[1] = ovsrec_system_get_seqno(idl);
+        break;
+    case SYSTEM_VIEW_FANS:
+        seqnos[1] = ovsrec_fan_get_seqno(idl);
+        break;
+    case SYSTEM_VIEW_LEDS:
+        seqnos[1] = ovsrec_led_get_seqno(idl);
+        break;
+    case SYSTEM_VIEW_PSUS:
+        seqnos[1] = ovsrec_power_supply_get_seqno(idl);
+        break;
+    case SYSTEM_VIEW_TEMP_SENSORS:
+    default:
+        seqnos[1] = ovsrec_temp_sensor_get_seqno(idl);
+        break;
+    }
+}
+
+static void
+system_view_destroy (struct system_view* view)
+{
+    int i;
 
-    return (strcmp(s1->name,s2->name));
+    for (i = 0; i < SYSTEM_VIEW_N_SECTIONS; i++) {
+        ds_destroy(&view->sections[i].text);
+    }
+    free(view->fans);
+    free(view->leds);
+    free(view->psus);
+    free(view->temp_sensors);
+    free(view);
 }
 
 /*
- * Function        : format_psu_string
- * Resposibility     : Change status string in OVSDB to more
- *        readable string
- * Parameters
- *      status  : Pointer to status string
- * Return      : Pointer to formatted status string
+ * Function        : system_view_get
+ * Resposibility     : Find or create the cached view of a subsystem, and
+ *        drop the views of subsystems that no longer exist
  */
-static const char*
-format_psu_string (char* status)
+static struct system_view*
+system_view_get (const struct ovsrec_subsystem* pSys)
 {
-    if (!status)
-        return NULL;
+    const struct uuid* uuid = &pSys->header_.uuid;
+    unsigned int seqno = ovsrec_subsystem_get_seqno(idl);
+    struct system_view* view;
+    struct system_view* next;
+    int i;
+
+    if (seqno != system_views_subsystem_seqno) {
+        HMAP_FOR_EACH_SAFE (view, next, hmap_node, &system_views) {
+            if (!ovsrec_subsystem_get_for_uuid(idl, &view->subsystem_uuid)) {
+                hmap_remove(&system_views, &view->hmap_node);
+                system_view_destroy(view);
+            }
+        }
+        system_views_subsystem_seqno = seqno;
+    }
 
-    if (0 == strcmp (status,OVSREC_POWER_SUPPLY_STATUS_FAULT_ABSENT))
-        return psu_state_string[POWER_SUPPLY_STATUS_FAULT_ABSENT];
-    else if (0 == strcmp (status,OVSREC_POWER_SUPPLY_STATUS_FAULT_INPUT))
-        return psu_state_string[POWER_SUPPLY_STATUS_FAULT_INPUT];
-    else if (0 == strcmp (status,OVSREC_POWER_SUPPLY_STATUS_FAULT_OUTPUT))
-        return psu_state_string[POWER_SUPPLY_STATUS_FAULT_OUTPUT];
+    HMAP_FOR_EACH_WITH_HASH (view, hmap_node, uuid_hash(uuid),
+                             &system_views) {
+        if (uuid_equals(&view->subsystem_uuid, uuid)) {
+            return view;
+        }
+    }
+
+    view = xzalloc(sizeof *view);
+    view->subsystem_uuid = *uuid;
+    for (i = 0; i < SYSTEM_VIEW_N_SECTIONS; i++) {
+        ds_init(&view->sections[i].text);
+    }
+    hmap_insert(&system_views, &view->hmap_node, uuid_hash(uuid));
 
-    return NULL;
+    return view;
 }
 
 /*
- * Function        : format_sys_output
- * Resposibility     : Format and Print output for system info
- * Parameters
- *      vty : Pointer to vty structure
- *  pSys    : Pointer to ovsrec_subsystem structure
- *  pVswitch: Pointer to ovsrec_system structure
+ * Function        : system_view_update
+ * Resposibility     : Re-render the sections of a view whose tables
+ *        changed since they were last rendered
  */
 static void
-format_sys_output (struct vty* vty,
-                const struct ovsrec_subsystem* pSys,
-                const struct ovsrec_system* pVswitch)
+system_view_update (struct system_view* view,
+                    const struct ovsrec_subsystem* pSys,
+                    const struct ovsrec_system* pVswitch,
+                    const char* nl)
 {
-    const char* buf = NULL;
-    vty_out(vty, "%-20s%s%-30s%s", "OpenSwitch Version", ": ",
-                 (pVswitch->switch_version) ? pVswitch->switch_version : " ",
-                 VTY_NEWLINE);
-
-    buf = smap_get (&pSys->other_info,"Product Name");
-    (buf) ? vty_out(vty,"%-20s%s%-30s%s%s",
-            "Product Name",": ",buf,VTY_NEWLINE,VTY_NEWLINE):\
-        vty_out(vty,"%-20s%s%-30s%s%s",
-                "Product Name",": "," ",VTY_NEWLINE,VTY_NEWLINE);
-
-    buf = smap_get (&pSys->other_info,"vendor");
-    (buf) ? vty_out(vty,"%-20s%s%-30s%s","Vendor",": ", buf, VTY_NEWLINE):\
-        vty_out(vty,"%-20s%s%-30s%s","Vendor",": "," ", VTY_NEWLINE);
-
-    buf = smap_get (&pSys->other_info,"platform_name");
-    (buf) ? vty_out(vty,"%-20s%s%-30s%s","Platform",": ", buf, VTY_NEWLINE):\
-        vty_out(vty,"%-20s%s%-30s%s","Platform",": "," ", VTY_NEWLINE);
-
-    buf = smap_get (&pSys->other_info,"manufacturer");
-    (buf) ? vty_out(vty,"%-20s%s%-20s%s","Manufacturer",": ",buf,VTY_NEWLINE):\
-        vty_out(vty,"%-20s%s%-20s%s","Manufacturer",": "," ", VTY_NEWLINE);
-
-    buf = smap_get (&pSys->other_info,"manufacture_date");
-    (buf) ? vty_out(vty,"%-20s%s%-20s%s%s",
-            "Manufacturer Date",": ", buf, VTY_NEWLINE, VTY_NEWLINE):\
-        vty_out(vty,"%-20s%s%-20s%s%s",
-                "Manufacturer Date",": "," ", VTY_NEWLINE, VTY_NEWLINE);
-
-
-    buf = smap_get (&pSys->other_info,"serial_number");
-    (buf) ? vty_out(vty,"%-20s%s%-20s","Serial Number",": ", buf):\
-        vty_out(vty,"%-20s%s%-20s","Serial Number",": "," ");
-
-    buf = smap_get (&pSys->other_info,"label_revision");
-    (buf) ? vty_out(vty,"%-20s%s%-10s%s%s",
-            "Label Revision",": ", buf, VTY_NEWLINE,VTY_NEWLINE):\
-        vty_out(vty,"%-20s%s%-10s%s%s",
-                "Label Revision",": "," ", VTY_NEWLINE,VTY_NEWLINE);
-
-
-    buf = smap_get (&pSys->other_info,"onie_version");
-    (buf) ? vty_out(vty,"%-20s%s%-20s","ONIE Version",": ", buf):\
-        vty_out(vty,"%-20s%s%-20s","ONIE Version",": "," ");
-
-    buf = smap_get (&pSys->other_info,"diag_version");
-    (buf) ? vty_out(vty,"%-20s%s%-10s%s",
-            "DIAG Version",": ", buf, VTY_NEWLINE):\
-        vty_out(vty,"%-20s%s%-10s%s","DIAG Version",": "," ", VTY_NEWLINE);
-
-    buf = smap_get (&pSys->other_info,"base_mac_address");
-    (buf) ? vty_out(vty, "%-20s%s%-20s","Base MAC Address",": ", buf):\
-        vty_out(vty,"%-20s%s%-20s","Base MAC Address",": "," ");
-
-    buf = smap_get (&pSys->other_info,"number_of_macs");
-    (buf) ? vty_out(vty, "%-20s%s%-5s%s",
-            "Number of MACs",": ", buf, VTY_NEWLINE):\
-        vty_out(vty, "%-20s%s%-5s%s","Number of MACs",": "," ", VTY_NEWLINE);
-
-    buf = smap_get (&pSys->other_info,"interface_count");
-    (buf) ? vty_out(vty, "%-20s%s%-20s","Interface Count",": ", buf):\
-        vty_out(vty, "%-20s%s%-20s","Interface Count",": "," ");
-
-    buf = smap_get (&pSys->other_info,"max_interface_speed");
-    (buf) ? vty_out(vty, "%-20s%s%-6sMbps%s",
-            "Max Interface Speed",": ", buf, VTY_NEWLINE):\
-        vty_out(vty, "%-20s%s%-6sMbps%s",
-                "Max Interface Speed",": "," ", VTY_NEWLINE);
-}
+    unsigned int seqnos[SYSTEM_VIEW_N_SEQNOS];
+    int i;
+
+    if (strcmp(view->nl, nl)) {
+        ovs_strlcpy(view->nl, nl, sizeof view->nl);
+        for (i = 0; i < SYSTEM_VIEW_N_SECTIONS; i++) {
+            view->sections[i].valid = false;
+        }
+    }
+
+    for (i = 0; i < SYSTEM_VIEW_N_SECTIONS; i++) {
+        struct system_view_cache* cache = &view->sections[i];
+
+        system_view_seqnos(i, seqnos);
+        if (cache->valid && !memcmp(cache->seqnos, seqnos, sizeof seqnos)) {
+            continue;
+        }
 
+        ds_clear(&cache->text);
+        switch (i) {
+        case SYSTEM_VIEW_INFO:
+            system_show_format_info(&cache->text, view->nl, pSys, pVswitch);
+            break;
+        case SYSTEM_VIEW_FANS:
+            system_show_sort_fans(pSys, &view->fans, &view->n_fans);
+            system_show_format_fans(&cache->text, view->nl,
+                                    view->fans, view->n_fans);
+            break;
+        case SYSTEM_VIEW_LEDS:
+            system_show_sort_leds(pSys, &view->leds, &view->n_leds);
+            system_show_format_leds(&cache->text, view->nl,
+                                    view->leds, view->n_leds);
+            break;
+        case SYSTEM_VIEW_PSUS:
+            system_show_sort_psus(pSys, &view->psus, &view->n_psus);
+            system_show_format_psus(&cache->text, view->nl,
+                                    view->psus, view->n_psus);
+            break;
+        case SYSTEM_VIEW_TEMP_SENSORS:
+            system_show_sort_temp_sensors(pSys, &view->temp_sensors,
+                                          &view->n_temp_sensors);
+            system_show_format_temp_sensors(&cache->text, view->nl,
+                                            view->temp_sensors,
+                                            view->n_temp_sensors);
+            break;
+        }
+        memcpy(cache->seqnos, seqnos, sizeof seqnos);
+        cache->valid = true;
+    }
+}
 
 /*
  * Function        : cli_system_get_all
@@ -183,111 +251,55 @@ cli_system_get_all()
 {
     const struct ovsrec_subsystem* pSys = NULL;
     const struct ovsrec_system* pVswitch = NULL;
-    const struct ovsrec_fan* pFan = NULL;
-    struct ovsrec_fan* pFanSort = NULL;
-    const struct ovsrec_led* pLed = NULL;
-    const struct ovsrec_power_supply* pPSU = NULL;
-    const struct ovsrec_temp_sensor* pTempSen = NULL;
-    int n = 0, i = 0;
+    struct system_view* view = NULL;
+    int i;
 
     pSys = ovsrec_subsystem_first(idl);
     pVswitch = ovsrec_system_first(idl);
 
-    if (pSys && pVswitch) {
-        format_sys_output(vty, pSys,pVswitch);
-    }
-    else {
+    if (!pSys || !pVswitch) {
         VLOG_ERR("Unable to retrieve data\n");
+        return CMD_OVSDB_FAILURE;
     }
 
+    view = system_view_get(pSys);
+    system_view_update(view, pSys, pVswitch, VTY_NEWLINE);
 
-    vty_out(vty,"%sFan details:%s%s",VTY_NEWLINE,VTY_NEWLINE, VTY_NEWLINE);
-    vty_out(vty,"%-15s%-10s%-10s%s","Name","Speed","Status",VTY_NEWLINE);
-    vty_out(vty,"%s%s","--------------------------------",VTY_NEWLINE);
-    n = pSys->n_fans;
-    if (0 != n)
-    {
-        pFanSort = (struct ovsrec_fan*)calloc (n,sizeof(struct ovsrec_fan));
-
-        OVSREC_FAN_FOR_EACH (pFan,idl)
-        {
-            memcpy (pFanSort+i,pFan,sizeof(struct ovsrec_fan));
-            i++;
-        }
-
-        qsort((void*)pFanSort,n,sizeof(struct ovsrec_fan),compare_fan);
-
-        for (i = 0; i < n ; i++)
-        {
-            vty_out(vty,"%-15s",(pFanSort+i)->name);
-            vty_out(vty,"%-10s",(pFanSort+i)->speed);
-            vty_out(vty,"%-10s",(pFanSort+i)->status);
-            vty_out(vty,"%s",VTY_NEWLINE);
-        }
+    for (i = 0; i < SYSTEM_VIEW_N_SECTIONS; i++) {
+        vty_out(vty, "%s", ds_cstr(&view->sections[i].text));
     }
 
-    if (pFanSort)
-    {
-        free(pFanSort);
-        pFanSort = NULL;
-    }
+    return CMD_SUCCESS;
+}
 
-    vty_out(vty,"%sLED details:%s%s",VTY_NEWLINE,VTY_NEWLINE, VTY_NEWLINE);
-    vty_out(vty,"%-10s%-10s%-8s%s","Name","State","Status",VTY_NEWLINE);
-    vty_out(vty,"%s%s","-------------------------",VTY_NEWLINE);
+static void
+system_json_vty_write (const char* s, size_t n OVS_UNUSED, void* aux OVS_UNUSED)
+{
+    vty_out(vty, "%s", s);
+}
 
-    n = pSys->n_leds;
-    if (0 != n)
-    {
+/*
+ * Function        : cli_system_get_all_json
+ * Resposibility     : Stream System overview information from OVSDB
+ *        as a JSON document
+ * Return      : 0 on success 1 otherwise
+ */
+int
+cli_system_get_all_json()
+{
+    const struct ovsrec_subsystem* pSys = NULL;
+    const struct ovsrec_system* pVswitch = NULL;
 
-        OVSREC_LED_FOR_EACH (pLed,idl)
-        {
-            vty_out(vty,"%-10s",pLed->id);
-            vty_out(vty,"%-10s",pLed->state);
-            vty_out(vty,"%-8s",pLed->status);
-            vty_out(vty,"%s",VTY_NEWLINE);
-        }
-    }
+    pSys = ovsrec_subsystem_first(idl);
+    pVswitch = ovsrec_system_first(idl);
 
-    vty_out(vty,"%sPower supply details:%s%s",VTY_NEWLINE,VTY_NEWLINE,
-            VTY_NEWLINE);
-    vty_out(vty,"%-10s%-10s%s","Name","Status",VTY_NEWLINE);
-    vty_out(vty,"%s%s","-----------------------",VTY_NEWLINE);
-    n = pSys->n_power_supplies;
-    if (0 != n)
-    {
-        OVSREC_POWER_SUPPLY_FOR_EACH (pPSU,idl)
-        {
-            vty_out(vty,"%-10s",pPSU->name);
-            vty_out(vty,"%-10s",format_psu_string(pPSU->status));
-            vty_out(vty,"%s",VTY_NEWLINE);
-        }
+    if (!pSys || !pVswitch) {
+        VLOG_ERR("Unable to retrieve data\n");
+        return CMD_OVSDB_FAILURE;
     }
 
-    vty_out(vty,"%sTemperature Sensors:%s%s",VTY_NEWLINE,VTY_NEWLINE,
-            VTY_NEWLINE);
-    n = pSys->n_temp_sensors;
-    if ( 0 !=  n)
-    {
-
-        vty_out(vty,"%-50s%-10s%-18s%s","Location","Name",
-                "Reading(celsius)",VTY_NEWLINE);
-        vty_out(vty,"%s%s",
-                "---------------------------------------------------------------------------",VTY_NEWLINE);
-        OVSREC_TEMP_SENSOR_FOR_EACH (pTempSen,idl)
-        {
-            vty_out(vty,"%-50s",pTempSen->location);
-            vty_out(vty,"%-10s",pTempSen->name);
-            vty_out(vty,"%3.2f",(double)((pTempSen->temperature)/1000));
-            vty_out(vty,"%s",VTY_NEWLINE);
-        }
-    }
-    else
-    {
-        vty_out(vty,"%-10s%-10s%-18s%s","Location","Name",
-                "Reading(celsius)",VTY_NEWLINE);
-        vty_out(vty,"%s%s","------------------------------------",VTY_NEWLINE);
-    }
+    system_show_json(pSys, pVswitch, system_json_vty_write, NULL);
+    vty_out(vty, "%s", VTY_NEWLINE);
 
     return CMD_SUCCESS;
 }
@@ -302,50 +314,45 @@ DEFUN (cli_platform_show_system,
     return cli_system_get_all();
 }
 
+DEFUN (cli_platform_show_system_json,
+        cli_platform_show_system_json_cmd,
+        "show system json",
+        SHOW_STR
+        SYS_STR
+        "Display output in JSON format\n")
+{
+    return cli_system_get_all_json();
+}
+
+static void
+system_ovsdb_add_columns (const struct ovsdb_idl_column *const columns[],
+                          size_t n)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        ovsdb_idl_add_column(idl, columns[i]);
+    }
+}
+
 /*******************************************************************
  * @func        : system_ovsdb_init
- * @detail      : Add system related table & columns to ops-cli
- *                idl cache
+ * @detail      : Add the columns read by the system commands to
+ *                ops-cli idl cache
  *******************************************************************/
 static void
 system_ovsdb_init()
 {
     /* Add Platform Related Tables. */
+    ovsdb_idl_add_table(idl, &ovsrec_table_subsystem);
     ovsdb_idl_add_table(idl, &ovsrec_table_fan);
     ovsdb_idl_add_table(idl, &ovsrec_table_led);
-    ovsdb_idl_add_table(idl, &ovsrec_table_subsystem);
-
-    /* Add Columns for System Related Tables. */
-
-    /* LED. */
-    ovsdb_idl_add_column(idl, &ovsrec_led_col_id);
-    ovsdb_idl_add_column(idl, &ovsrec_led_col_state);
-    ovsdb_idl_add_column(idl, &ovsrec_led_col_status);
-    ovsdb_idl_add_column(idl, &ovsrec_led_col_other_config);
-    ovsdb_idl_add_column(idl, &ovsrec_led_col_external_ids);
-
-    /* Subsystem .*/
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_interfaces);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_leds);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_fans);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_asset_tag_number);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_name);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_type);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_hw_desc_dir);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_other_info);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_other_config);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_external_ids);
-
-    /* Fan. */
-    ovsdb_idl_add_column(idl, &ovsrec_fan_col_status);
-    ovsdb_idl_add_column(idl, &ovsrec_fan_col_direction);
-    ovsdb_idl_add_column(idl, &ovsrec_fan_col_name);
-    ovsdb_idl_add_column(idl, &ovsrec_fan_col_rpm);
-    ovsdb_idl_add_column(idl, &ovsrec_fan_col_other_config);
-    ovsdb_idl_add_column(idl, &ovsrec_fan_col_hw_config);
-    ovsdb_idl_add_column(idl, &ovsrec_fan_col_external_ids);
-    ovsdb_idl_add_column(idl, &ovsrec_fan_col_speed);
+    ovsdb_idl_add_table(idl, &ovsrec_table_power_supply);
+    ovsdb_idl_add_table(idl, &ovsrec_table_temp_sensor);
 
+    system_ovsdb_add_columns(system_show_columns, system_show_n_columns);
+    system_ovsdb_add_columns(system_show_json_columns,
+                             system_show_json_n_columns);
 }
 
 
@@ -364,4 +371,6 @@ cli_post_init(void)
 {
     install_element (ENABLE_NODE, &cli_platform_show_system_cmd);
     install_element (VIEW_NODE, &cli_platform_show_system_cmd);
+    install_element (ENABLE_NODE, &cli_platform_show_system_json_cmd);
+    install_element (VIEW_NODE, &cli_platform_show_system_json_cmd);
 }
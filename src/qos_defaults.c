@@ -0,0 +1,208 @@
+/****************************************************************************
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+
+#include <config.h>
+
+#include "qos_defaults.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sysd_cfg_yaml.h"
+#include "sysd_ctx.h"
+#include "sysd_mem.h"
+#include "sha1.h"
+#include "util.h"
+#include "openvswitch/vlog.h"
+
+VLOG_DEFINE_THIS_MODULE(qos_defaults);
+
+/**
+ * Reads the whole of 'path' and returns its SHA-1 in 'hex'.  Returns 0 on
+ * success, otherwise an errno value.
+ */
+static int
+qos_yaml_file_sha1(const char *path, char hex[SHA1_HEX_DIGEST_LEN + 1])
+{
+    uint8_t digest[SHA1_DIGEST_SIZE];
+    unsigned char buf[4096];
+    struct sha1_ctx sha;
+    size_t n;
+    FILE *fp;
+    int error;
+
+    fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return errno;
+    }
+
+    sha1_init(&sha);
+    while ((n = fread(buf, 1, sizeof buf, fp)) > 0) {
+        sha1_update(&sha, buf, n);
+    }
+    error = ferror(fp) ? EIO : 0;
+    fclose(fp);
+
+    sha1_final(&sha, digest);
+    sha1_to_hex(digest, hex);
+    return error;
+}
+
+bool
+qos_defaults_load_compiled(struct sysd_ctx *ctx)
+{
+    char sha1[SHA1_HEX_DIGEST_LEN + 1];
+    size_t i;
+    char *path;
+    int error;
+
+    ctx->qos_compiled = NULL;
+    if (qos_defaults_table_size == 0) {
+        return false;
+    }
+
+    path = xasprintf("%s/%s", ctx->hw_desc_dir, QOS_YAML_FILE_NAME);
+    error = qos_yaml_file_sha1(path, sha1);
+    if (error) {
+        VLOG_DBG("Unable to read %s (%s).", path, ovs_strerror(error));
+        free(path);
+        return false;
+    }
+
+    for (i = 0; i < qos_defaults_table_size; i++) {
+        const struct qos_defaults *defaults = &qos_defaults_table[i];
+
+        if (!strcmp(defaults->sha1, sha1)) {
+            VLOG_INFO("Using compiled-in QoS defaults for %s.",
+                      defaults->platform);
+            ctx->qos_compiled = defaults;
+            free(path);
+            return true;
+        }
+    }
+
+    VLOG_INFO("%s does not match any compiled-in QoS defaults; "
+              "parsing it.", path);
+    free(path);
+    return false;
+}
+
+/**
+ * Copies the parsed qos.yaml entries into ctx->qos_yaml.  The strings stay
+ * owned by the context's config-yaml handle, which outlives them.
+ */
+static const struct qos_defaults *
+qos_defaults_from_yaml(struct sysd_ctx *ctx)
+{
+    struct qos_defaults *yaml_defaults;
+    YamlCosMapEntry *cos_map;
+    YamlDscpMapEntry *dscp_map;
+    YamlQueueProfileEntry *queue_profile;
+    YamlScheduleProfileEntry *schedule_profile;
+    YamlQosInfo *qos_info;
+    int count;
+    int ii;
+
+    if (ctx->qos_yaml) {
+        return ctx->qos_yaml;
+    }
+
+    qos_info = sysd_cfg_yaml_get_qos_info(ctx);
+    if (qos_info == NULL) {
+        return NULL;
+    }
+
+    yaml_defaults = sysd_mem_calloc(SYSD_MEM_QOS, 1, sizeof *yaml_defaults);
+    yaml_defaults->platform = "";
+    yaml_defaults->info = *qos_info;
+
+    /* Entry pointers could be NULL only if YAML init has failed. */
+    count = sysd_cfg_yaml_get_cos_map_entry_count(ctx);
+    cos_map = sysd_mem_calloc(SYSD_MEM_QOS, MAX(count, 1),
+                              sizeof *cos_map);
+    for (ii = 0; ii < count; ii++) {
+        const YamlCosMapEntry *entry =
+            sysd_cfg_yaml_get_cos_map_entry(ctx, ii);
+        if (entry) {
+            cos_map[yaml_defaults->n_cos_map++] = *entry;
+        }
+    }
+    yaml_defaults->cos_map = cos_map;
+
+    count = sysd_cfg_yaml_get_dscp_map_entry_count(ctx);
+    dscp_map = sysd_mem_calloc(SYSD_MEM_QOS, MAX(count, 1),
+                               sizeof *dscp_map);
+    for (ii = 0; ii < count; ii++) {
+        const YamlDscpMapEntry *entry =
+            sysd_cfg_yaml_get_dscp_map_entry(ctx, ii);
+        if (entry) {
+            dscp_map[yaml_defaults->n_dscp_map++] = *entry;
+        }
+    }
+    yaml_defaults->dscp_map = dscp_map;
+
+    count = sysd_cfg_yaml_get_queue_profile_entry_count(ctx);
+    queue_profile = sysd_mem_calloc(SYSD_MEM_QOS, MAX(count, 1),
+                                    sizeof *queue_profile);
+    for (ii = 0; ii < count; ii++) {
+        const YamlQueueProfileEntry *entry =
+            sysd_cfg_yaml_get_queue_profile_entry(ctx, ii);
+        if (entry) {
+            queue_profile[yaml_defaults->n_queue_profile++] = *entry;
+        }
+    }
+    yaml_defaults->queue_profile = queue_profile;
+
+    count = sysd_cfg_yaml_get_schedule_profile_entry_count(ctx);
+    schedule_profile = sysd_mem_calloc(SYSD_MEM_QOS, MAX(count, 1),
+                                       sizeof *schedule_profile);
+    for (ii = 0; ii < count; ii++) {
+        const YamlScheduleProfileEntry *entry =
+            sysd_cfg_yaml_get_schedule_profile_entry(ctx, ii);
+        if (entry) {
+            schedule_profile[yaml_defaults->n_schedule_profile++] = *entry;
+        }
+    }
+    yaml_defaults->schedule_profile = schedule_profile;
+
+    ctx->qos_yaml = yaml_defaults;
+    return yaml_defaults;
+}
+
+const struct qos_defaults *
+qos_defaults_get(struct sysd_ctx *ctx)
+{
+    if (ctx->qos_compiled) {
+        return ctx->qos_compiled;
+    }
+    return qos_defaults_from_yaml(ctx);
+}
+
+void
+qos_defaults_destroy(struct sysd_ctx *ctx)
+{
+    if (ctx->qos_yaml) {
+        sysd_mem_free((void *) ctx->qos_yaml->cos_map);
+        sysd_mem_free((void *) ctx->qos_yaml->dscp_map);
+        sysd_mem_free((void *) ctx->qos_yaml->queue_profile);
+        sysd_mem_free((void *) ctx->qos_yaml->schedule_profile);
+        sysd_mem_free(ctx->qos_yaml);
+        ctx->qos_yaml = NULL;
+    }
+    ctx->qos_compiled = NULL;
+}
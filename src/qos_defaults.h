@@ -0,0 +1,79 @@
+/****************************************************************************
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+
+#ifndef _QOS_DEFAULTS_H_
+#define _QOS_DEFAULTS_H_
+
+#include <config-yaml.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define QOS_YAML_FILE_NAME "qos.yaml"
+
+/**
+ * Factory QoS defaults of one platform, as described by its qos.yaml.
+ */
+struct qos_defaults {
+    const char *platform;       /* "<manufacturer> <product_name>". */
+    const char *sha1;           /* SHA-1 of the qos.yaml file contents, as
+                                 * 40 lowercase hex digits. */
+
+    YamlQosInfo info;
+
+    const YamlCosMapEntry *cos_map;
+    size_t n_cos_map;
+    const YamlDscpMapEntry *dscp_map;
+    size_t n_dscp_map;
+    const YamlQueueProfileEntry *queue_profile;
+    size_t n_queue_profile;
+    const YamlScheduleProfileEntry *schedule_profile;
+    size_t n_schedule_profile;
+};
+
+/**
+ * The qos_defaults_table_size defaults compiled in at build time from the
+ * platform qos.yaml files named by the QOS_YAML_FILES CMake option.
+ * Generated by tools/qos_defaults_gen.py; NULL when there are none.
+ */
+extern const struct qos_defaults *const qos_defaults_table;
+extern const size_t qos_defaults_table_size;
+
+struct sysd_ctx;
+
+/**
+ * Selects the compiled-in defaults whose qos.yaml is identical to the one in
+ * the hardware description directory of ctx.  Returns false if there is
+ * none, in which case the caller must parse qos.yaml so that
+ * qos_defaults_get() can fall back to it.
+ */
+bool qos_defaults_load_compiled(struct sysd_ctx *ctx);
+
+/**
+ * Returns the factory QoS defaults for the platform of ctx, or NULL if
+ * qos.yaml could not be parsed.  The first call after a fallback to
+ * qos.yaml copies its entries into ctx, so calls for one context must not
+ * run concurrently.
+ */
+const struct qos_defaults *qos_defaults_get(struct sysd_ctx *ctx);
+
+/**
+ * Frees the defaults qos_defaults_get() copied from qos.yaml.
+ */
+void qos_defaults_destroy(struct sysd_ctx *ctx);
+
+#endif /* _QOS_DEFAULTS_H_ */
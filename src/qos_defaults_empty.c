@@ -0,0 +1,27 @@
+/****************************************************************************
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+
+/* Compiled-in QoS defaults when QOS_YAML_FILES is empty, so that building
+ * ops-sysd does not need tools/qos_defaults_gen.py or its Python
+ * dependencies.  Every qos.yaml is then parsed at run time. */
+
+#include <config.h>
+
+#include "qos_defaults.h"
+
+const struct qos_defaults *const qos_defaults_table = NULL;
+const size_t qos_defaults_table_size = 0;
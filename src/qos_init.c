@@ -24,8 +24,11 @@
 #include <sys/types.h>
 
 #include "config-yaml.h"
-#include "sysd_cfg_yaml.h"
+#include "qos_defaults.h"
 #include "sysd_qos_utils.h"
+#include "sysd_write.h"
+#include "hash.h"
+#include "hmap.h"
 #include "smap.h"
 #include "util.h"
 #include "vswitch-idl.h"
@@ -38,35 +41,81 @@ VLOG_DEFINE_THIS_MODULE(qos_init);
  */
 #define QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
 
-struct ovsdb_idl *idl;
+/**
+ * One queue of a queue profile, assembled locally before it is written.
+ */
+struct qos_queue_profile_queue {
+    struct hmap_node hmap_node;     /* In qos_queue_profile's 'queues'. */
+    int64_t queue;
+    int64_t *local_priorities;
+    size_t n_local_priorities;
+    size_t allocated_local_priorities;
+    const char *description;
+};
 
 /**
- * Returns true if the givien queue_row contains the local_priority.
+ * A queue profile, keyed by name in qos_profile_builder's 'queue_profiles'.
  */
-static bool
-has_local_priority(struct ovsrec_q_profile_entry *queue_row,
-                   int64_t local_priority)
+struct qos_queue_profile {
+    struct hmap_node hmap_node;     /* In qos_profile_builder. */
+    char *name;
+    bool hw_default;
+    struct hmap queues;             /* Contains "struct qos_queue_profile_queue"s. */
+    struct ovsrec_q_profile *row;   /* Set by qos_profile_builder_commit(). */
+};
+
+/**
+ * One queue of a schedule profile, assembled locally before it is written.
+ */
+struct qos_schedule_profile_queue {
+    struct hmap_node hmap_node;     /* In qos_schedule_profile's 'queues'. */
+    int64_t queue;
+    const char *algorithm;
+    int64_t weight;
+};
+
+/**
+ * A schedule profile, keyed by name in qos_profile_builder's
+ * 'schedule_profiles'.
+ */
+struct qos_schedule_profile {
+    struct hmap_node hmap_node;     /* In qos_profile_builder. */
+    char *name;
+    bool hw_default;
+    struct hmap queues;             /* Contains "struct qos_schedule_profile_queue"s. */
+    struct ovsrec_qos *row;         /* Set by qos_profile_builder_commit(). */
+};
+
+static uint32_t
+qos_queue_hash(int64_t queue_num)
 {
-    int i;
-    for (i = 0; i < queue_row->n_local_priorities; i++) {
-        if (queue_row->local_priorities[i] == local_priority) {
-            return true;
-        }
-    }
+    return hash_uint64(queue_num);
+}
 
-    return false;
+/**
+ * Returns true if a queue scheduled with algorithm carries a weight.
+ */
+static bool
+qos_algorithm_has_weight(const char *algorithm)
+{
+    /* TODO: can "strict" have weight set to 0? */
+    return (algorithm == NULL
+            || strcmp(algorithm, OVSREC_QUEUE_ALGORITHM_STRICT));
 }
 
 /**
- * Returns the queue_profile_row for the given profile_name.
+ * Returns the queue_profile for the given profile_name, or NULL.
  */
-static struct ovsrec_q_profile *
-qos_get_queue_profile_row(const char *profile_name)
+static struct qos_queue_profile *
+qos_builder_find_queue_profile(struct qos_profile_builder *builder,
+                               const char *profile_name)
 {
-    const struct ovsrec_q_profile *profile_row;
-    OVSREC_Q_PROFILE_FOR_EACH(profile_row, idl) {
-        if (strcmp(profile_row->name, profile_name) == 0) {
-            return (struct ovsrec_q_profile *)profile_row;
+    struct qos_queue_profile *profile;
+
+    HMAP_FOR_EACH_WITH_HASH (profile, hmap_node, hash_string(profile_name, 0),
+                             &builder->queue_profiles) {
+        if (strcmp(profile->name, profile_name) == 0) {
+            return profile;
         }
     }
 
@@ -74,362 +123,487 @@ qos_get_queue_profile_row(const char *profile_name)
 }
 
 /**
- * Returns the queue_profile_entry_row for the given profile_row and
- * queue_num.
+ * Returns the queue_profile for the given profile_name, creating it if
+ * it does not exist yet.
  */
-static struct ovsrec_q_profile_entry *
-qos_get_queue_profile_entry_row(struct ovsrec_q_profile *profile_row,
-                                int64_t queue_num)
+static struct qos_queue_profile *
+qos_builder_queue_profile(struct qos_profile_builder *builder,
+                          const char *profile_name)
 {
-    int i;
-    for (i = 0; i < profile_row->n_q_profile_entries; i++) {
-        if (profile_row->key_q_profile_entries[i] == queue_num) {
-            return profile_row->value_q_profile_entries[i];
-        }
+    struct qos_queue_profile *profile;
+
+    profile = qos_builder_find_queue_profile(builder, profile_name);
+    if (profile) {
+        return profile;
     }
 
-    return NULL;
+    profile = xzalloc(sizeof *profile);
+    profile->name = xstrdup(profile_name);
+    hmap_init(&profile->queues);
+    hmap_insert(&builder->queue_profiles, &profile->hmap_node,
+                hash_string(profile_name, 0));
+
+    return profile;
 }
 
 /**
- * Inserts into the database and returns a new queue_profile_entry_row
- * for the given profile_row, queue_num, and txn.
+ * Returns the queue of the given queue_profile for queue_num, or NULL.
  */
-static struct ovsrec_q_profile_entry *
-insert_queue_profile_queue_row(struct ovsrec_q_profile *profile_row,
-                               int64_t queue_num,
-                               struct ovsdb_idl_txn *txn)
+static struct qos_queue_profile_queue *
+qos_queue_profile_find_queue(struct qos_queue_profile *profile,
+                             int64_t queue_num)
 {
-    /* Create the queue row. */
-    struct ovsrec_q_profile_entry *queue_row =
-        ovsrec_q_profile_entry_insert(txn);
-
-    /* Update the profile row. */
-    int64_t *key_list =
-        xmalloc(sizeof(int64_t) *
-                (profile_row->n_q_profile_entries + 1));
-    struct ovsrec_q_profile_entry **value_list =
-        xmalloc(sizeof*profile_row->value_q_profile_entries *
-                (profile_row->n_q_profile_entries + 1));
+    struct qos_queue_profile_queue *queue;
 
-    int i;
-    for (i = 0; i < profile_row->n_q_profile_entries; i++) {
-        key_list[i] = profile_row->key_q_profile_entries[i];
-        value_list[i] = profile_row->value_q_profile_entries[i];
-    }
-    key_list[profile_row->n_q_profile_entries] = queue_num;
-    value_list[profile_row->n_q_profile_entries] = queue_row;
-    ovsrec_q_profile_set_q_profile_entries(profile_row, key_list,
-            value_list, profile_row->n_q_profile_entries + 1);
-    free(key_list);
-    free(value_list);
+    HMAP_FOR_EACH_WITH_HASH (queue, hmap_node, qos_queue_hash(queue_num),
+                             &profile->queues) {
+        if (queue->queue == queue_num) {
+            return queue;
+        }
+    }
 
-    return queue_row;
+    return NULL;
 }
 
 /**
- * Creates a queue_profile row in Q_Profile for the txn and profile_name.
+ * Returns the queue of the given queue_profile for queue_num, creating it
+ * if it does not exist yet.
  */
-void
-qos_queue_profile_command(struct ovsdb_idl_txn *txn,
-                          const char *profile_name)
+static struct qos_queue_profile_queue *
+qos_queue_profile_queue(struct qos_queue_profile *profile, int64_t queue_num)
 {
-    /* Retrieve the row. */
-    struct ovsrec_q_profile *profile_row =
-        qos_get_queue_profile_row(profile_name);
-    if (profile_row == NULL) {
-        /* Create a new row. */
-        profile_row = ovsrec_q_profile_insert(txn);
-        ovsrec_q_profile_set_name(profile_row, profile_name);
+    struct qos_queue_profile_queue *queue;
+
+    queue = qos_queue_profile_find_queue(profile, queue_num);
+    if (queue) {
+        return queue;
     }
 
-    return;
+    queue = xzalloc(sizeof *queue);
+    queue->queue = queue_num;
+    hmap_insert(&profile->queues, &queue->hmap_node,
+                qos_queue_hash(queue_num));
+
+    return queue;
 }
 
 /**
- * Adds the given local_priority to the queue_row.
+ * Adds the given local_priority to the queue, unless it is already there.
+ * A queue holds at most QOS_LOCAL_PRIORITY_COUNT priorities, so the
+ * duplicate check stays a short scan.
  */
 static void
-add_local_priority(struct ovsrec_q_profile_entry *queue_row,
+add_local_priority(struct qos_queue_profile_queue *queue,
                    int64_t local_priority)
 {
-    if (has_local_priority(queue_row, local_priority)) {
-        return;
+    size_t i;
+
+    for (i = 0; i < queue->n_local_priorities; i++) {
+        if (queue->local_priorities[i] == local_priority) {
+            return;
+        }
     }
 
-    /* local_priority was not found, so add it. */
-    int64_t *value_list =
-        xmalloc(sizeof(int64_t) *
-                (queue_row->n_local_priorities + 1));
-    int i;
-    for (i = 0; i < queue_row->n_local_priorities; i++) {
-        value_list[i] = queue_row->local_priorities[i];
+    if (queue->n_local_priorities >= queue->allocated_local_priorities) {
+        queue->local_priorities =
+            x2nrealloc(queue->local_priorities,
+                       &queue->allocated_local_priorities,
+                       sizeof *queue->local_priorities);
     }
-    value_list[queue_row->n_local_priorities] = local_priority;
-    ovsrec_q_profile_entry_set_local_priorities(
-        queue_row, value_list, queue_row->n_local_priorities + 1);
-    free(value_list);
+    queue->local_priorities[queue->n_local_priorities++] = local_priority;
 }
 
 /**
- * Executes the queue_profile_map_command for the given txn, profile_name,
- * queue_num, and local_priority. Returns false if an error occurred.
+ * Returns the schedule_profile for the given profile_name, or NULL.
  */
-static bool
-qos_queue_profile_row_command(struct ovsdb_idl_txn *txn,
-                              const char *profile_name,
-                              int64_t queue_num, int64_t local_priority,
-                              const char *description)
+static struct qos_schedule_profile *
+qos_builder_find_schedule_profile(struct qos_profile_builder *builder,
+                                  const char *profile_name)
 {
-    /* Retrieve the profile row. */
-    struct ovsrec_q_profile *profile_row =
-        qos_get_queue_profile_row(profile_name);
-    if (profile_row == NULL) {
-        VLOG_ERR("Profile %s does not exist.",
-                 profile_name);
-        return false;
+    struct qos_schedule_profile *profile;
+
+    HMAP_FOR_EACH_WITH_HASH (profile, hmap_node, hash_string(profile_name, 0),
+                             &builder->schedule_profiles) {
+        if (strcmp(profile->name, profile_name) == 0) {
+            return profile;
+        }
     }
 
-    /* Retrieve the existing queue row. */
-    struct ovsrec_q_profile_entry *queue_row =
-        qos_get_queue_profile_entry_row(profile_row, queue_num);
+    return NULL;
+}
 
-    /* If no existing row, then insert a new queue row. */
-    if (queue_row == NULL) {
-        queue_row = insert_queue_profile_queue_row(
-                profile_row, queue_num, txn);
-    }
+/**
+ * Returns the schedule_profile for the given profile_name, creating it if
+ * it does not exist yet.
+ */
+static struct qos_schedule_profile *
+qos_builder_schedule_profile(struct qos_profile_builder *builder,
+                             const char *profile_name)
+{
+    struct qos_schedule_profile *profile;
 
-    /* Update the queue row. */
-    VLOG_INFO(".... updating %p", queue_row);
-    add_local_priority(queue_row, local_priority);
-    if (description != NULL) {
-        ovsrec_q_profile_entry_set_description(queue_row, description);
+    profile = qos_builder_find_schedule_profile(builder, profile_name);
+    if (profile) {
+        return profile;
     }
 
-    return true;
+    profile = xzalloc(sizeof *profile);
+    profile->name = xstrdup(profile_name);
+    hmap_init(&profile->queues);
+    hmap_insert(&builder->schedule_profiles, &profile->hmap_node,
+                hash_string(profile_name, 0));
+
+    return profile;
 }
 
 /**
- * Creates the factory default queue profile for the given txn and
- * default_name.
+ * Returns the queue of the given schedule_profile for queue_num, or NULL.
  */
-static void
-qos_queue_profile_create_factory_default(struct ovsdb_idl_txn *txn,
-                                         const char *default_name)
+static struct qos_schedule_profile_queue *
+qos_schedule_profile_find_queue(struct qos_schedule_profile *profile,
+                                int64_t queue_num)
 {
-    unsigned int ii;
-    const YamlQueueProfileEntry *yaml_queue_profile_entry;
-    int count;
-
-    qos_queue_profile_command(txn, default_name);
+    struct qos_schedule_profile_queue *queue;
 
-    count = sysd_cfg_yaml_get_queue_profile_entry_count();
-    VLOG_DBG("THERE ARE %d QUEUE_PROFILE ENTRIES", count);
-    for (ii = 0; ii < count; ii++) {
-        /* pointer could be NULL only if YAML init has failed. */
-        yaml_queue_profile_entry = sysd_cfg_yaml_get_queue_profile_entry(ii);
-        if (yaml_queue_profile_entry) {
-            VLOG_INFO(".. queue %d pri %d", yaml_queue_profile_entry->queue,
-                      yaml_queue_profile_entry->local_priority);
-            qos_queue_profile_row_command(txn, default_name,
-                    yaml_queue_profile_entry->queue,
-                    yaml_queue_profile_entry->local_priority,
-                    yaml_queue_profile_entry->description);
+    HMAP_FOR_EACH_WITH_HASH (queue, hmap_node, qos_queue_hash(queue_num),
+                             &profile->queues) {
+        if (queue->queue == queue_num) {
+            return queue;
         }
     }
+
+    return NULL;
 }
 
 /**
- * Returns the schedule_profile_row for the given profile_name.
+ * Returns the queue of the given schedule_profile for queue_num, creating
+ * it if it does not exist yet.
  */
-static struct ovsrec_qos *
-qos_get_schedule_profile_row(const char *profile_name)
+static struct qos_schedule_profile_queue *
+qos_schedule_profile_queue(struct qos_schedule_profile *profile,
+                           int64_t queue_num)
 {
-    const struct ovsrec_qos *profile_row;
-    OVSREC_QOS_FOR_EACH(profile_row, idl) {
-        if (strcmp(profile_row->name, profile_name) == 0) {
-            return (struct ovsrec_qos *)profile_row;
-        }
+    struct qos_schedule_profile_queue *queue;
+
+    queue = qos_schedule_profile_find_queue(profile, queue_num);
+    if (queue) {
+        return queue;
     }
 
-    return NULL;
+    queue = xzalloc(sizeof *queue);
+    queue->queue = queue_num;
+    hmap_insert(&profile->queues, &queue->hmap_node,
+                qos_queue_hash(queue_num));
+
+    return queue;
 }
 
 /**
- * Returns the schedule_profile_entry_row for the given profile_row and
- * queue_num.
+ * Initializes an empty profile builder.
  */
-static struct ovsrec_queue *
-qos_get_schedule_profile_entry_row(struct ovsrec_qos *profile_row,
-                                   int64_t queue_num)
+void
+qos_profile_builder_init(struct qos_profile_builder *builder)
 {
-    int i;
-    for (i = 0; i < profile_row->n_queues; i++) {
-        if (profile_row->key_queues[i] == queue_num) {
-            return profile_row->value_queues[i];
+    hmap_init(&builder->queue_profiles);
+    hmap_init(&builder->schedule_profiles);
+}
+
+/**
+ * Frees everything held by the builder. Rows written by
+ * qos_profile_builder_commit() belong to the transaction and are not
+ * affected.
+ */
+void
+qos_profile_builder_destroy(struct qos_profile_builder *builder)
+{
+    struct qos_queue_profile *q_profile, *next_q_profile;
+    struct qos_schedule_profile *s_profile, *next_s_profile;
+
+    HMAP_FOR_EACH_SAFE (q_profile, next_q_profile, hmap_node,
+                        &builder->queue_profiles) {
+        struct qos_queue_profile_queue *queue, *next_queue;
+
+        HMAP_FOR_EACH_SAFE (queue, next_queue, hmap_node, &q_profile->queues) {
+            hmap_remove(&q_profile->queues, &queue->hmap_node);
+            free(queue->local_priorities);
+            free(queue);
         }
+        hmap_destroy(&q_profile->queues);
+        hmap_remove(&builder->queue_profiles, &q_profile->hmap_node);
+        free(q_profile->name);
+        free(q_profile);
     }
+    hmap_destroy(&builder->queue_profiles);
 
-    return NULL;
+    HMAP_FOR_EACH_SAFE (s_profile, next_s_profile, hmap_node,
+                        &builder->schedule_profiles) {
+        struct qos_schedule_profile_queue *queue, *next_queue;
+
+        HMAP_FOR_EACH_SAFE (queue, next_queue, hmap_node, &s_profile->queues) {
+            hmap_remove(&s_profile->queues, &queue->hmap_node);
+            free(queue);
+        }
+        hmap_destroy(&s_profile->queues);
+        hmap_remove(&builder->schedule_profiles, &s_profile->hmap_node);
+        free(s_profile->name);
+        free(s_profile);
+    }
+    hmap_destroy(&builder->schedule_profiles);
 }
 
 /**
- * Inserts into the database and returns the schedule_profile_row for the
- * given profile_row, queue_num, and txn.
+ * Adds local_priority to queue_num of the queue profile named profile_name.
+ * A non-NULL description replaces the one already set for the queue.
+ * Strings are not copied and must outlive the builder.
  */
-static struct ovsrec_queue *
-insert_schedule_profile_queue_row(struct ovsrec_qos *profile_row,
-                                  int64_t queue_num,
-                                  struct ovsdb_idl_txn *txn)
+void
+qos_profile_builder_add_queue(struct qos_profile_builder *builder,
+                              const char *profile_name,
+                              int64_t queue_num, int64_t local_priority,
+                              const char *description)
 {
-    /* Create the queue row. */
-    struct ovsrec_queue *queue_row =
-        ovsrec_queue_insert(txn);
+    struct qos_queue_profile_queue *queue = qos_queue_profile_queue(
+            qos_builder_queue_profile(builder, profile_name), queue_num);
 
-    /* Update the profile row. */
-    int64_t *key_list =
-        xmalloc(sizeof(int64_t) *
-                (profile_row->n_queues + 1));
-    struct ovsrec_queue **value_list =
-        xmalloc(sizeof*profile_row->value_queues *
-                (profile_row->n_queues + 1));
+    add_local_priority(queue, local_priority);
+    if (description != NULL) {
+        queue->description = description;
+    }
+}
 
-    int i;
-    for (i = 0; i < profile_row->n_queues; i++) {
-        key_list[i] = profile_row->key_queues[i];
-        value_list[i] = profile_row->value_queues[i];
-    }
-    key_list[profile_row->n_queues] = queue_num;
-    value_list[profile_row->n_queues] = queue_row;
-    ovsrec_qos_set_queues(profile_row, key_list,
-                          value_list, profile_row->n_queues + 1);
-    free(key_list);
-    free(value_list);
+/**
+ * Sets algorithm and weight for queue_num of the schedule profile named
+ * profile_name. A later entry for the same queue replaces an earlier one.
+ * Strings are not copied and must outlive the builder.
+ */
+void
+qos_profile_builder_add_schedule(struct qos_profile_builder *builder,
+                                 const char *profile_name,
+                                 int64_t queue_num, const char *algorithm,
+                                 int64_t weight)
+{
+    struct qos_schedule_profile_queue *queue = qos_schedule_profile_queue(
+            qos_builder_schedule_profile(builder, profile_name), queue_num);
 
-    return queue_row;
+    queue->algorithm = algorithm;
+    queue->weight = weight;
 }
 
 /**
- * Executes the schedule_profile_command for the given txn, and profile_name.
+ * Makes sure a queue profile named profile_name exists, even one without
+ * entries. If hw_default is true, the profile and all of its entries are
+ * marked as hardware defaults.
  */
 void
-qos_schedule_profile_command(struct ovsdb_idl_txn *txn,
-                             const char *profile_name)
+qos_profile_builder_add_queue_profile(struct qos_profile_builder *builder,
+                                      const char *profile_name,
+                                      bool hw_default)
 {
-    /* Retrieve the row. */
-    struct ovsrec_qos *profile_row =
-        qos_get_schedule_profile_row(profile_name);
-    if (profile_row == NULL) {
-        /* Create a new row. */
-        profile_row = ovsrec_qos_insert(txn);
-        ovsrec_qos_set_name(profile_row, profile_name);
-    }
+    struct qos_queue_profile *profile =
+        qos_builder_queue_profile(builder, profile_name);
 
-    return;
+    profile->hw_default |= hw_default;
 }
 
 /**
- * Creates a schedule-profile row for the given txn, profile_name,
- * queue_num, algorithm and weight. Returns false if an error occurred.
+ * Makes sure a schedule profile named profile_name exists, even one without
+ * entries. If hw_default is true, the profile and all of its entries are
+ * marked as hardware defaults.
  */
-static bool
-qos_schedule_profile_row_command(struct ovsdb_idl_txn *txn,
-                                 const char *profile_name,
-                                 int64_t queue_num,
-                                 char * algorithm,
-                                 int64_t weight)
+void
+qos_profile_builder_add_schedule_profile(struct qos_profile_builder *builder,
+                                         const char *profile_name,
+                                         bool hw_default)
 {
-    /* Retrieve the profile row. */
-    struct ovsrec_qos *profile_row =
-        qos_get_schedule_profile_row(profile_name);
-    if (profile_row == NULL) {
-        VLOG_ERR("Profile %s does not exist.",
-                 profile_name);
-        return false;
-    }
+    struct qos_schedule_profile *profile =
+        qos_builder_schedule_profile(builder, profile_name);
 
-    /* Retrieve the existing queue row. */
-    struct ovsrec_queue *queue_row =
-        qos_get_schedule_profile_entry_row(profile_row, queue_num);
+    profile->hw_default |= hw_default;
+}
 
-    /* If no existing row, then insert a new queue row. */
-    if (queue_row == NULL) {
-        queue_row = insert_schedule_profile_queue_row(
-                profile_row, queue_num, txn);
-    }
+/**
+ * Inserts the given queue profile and its entries, writing every column
+ * exactly once.
+ */
+static void
+qos_queue_profile_commit(struct ovsdb_idl_txn *txn,
+                         struct qos_queue_profile *profile)
+{
+    struct qos_queue_profile_queue *queue;
+    size_t n_queues = hmap_count(&profile->queues);
+    int64_t *key_list = xmalloc(n_queues * sizeof *key_list);
+    struct ovsrec_q_profile_entry **value_list =
+        xmalloc(n_queues * sizeof *value_list);
+    bool hw_default = true;
+    size_t i = 0;
 
-    ovsrec_queue_set_algorithm(queue_row, algorithm);
-    /* TODO: can "strict" have weight set to 0? */
-    if ( ! strcmp(algorithm, OVSREC_QUEUE_ALGORITHM_STRICT)) {
-        ovsrec_queue_set_weight(queue_row, NULL, 0);
+    profile->row = ovsrec_q_profile_insert(txn);
+    ovsrec_q_profile_set_name(profile->row, profile->name);
+    if (profile->hw_default) {
+        ovsrec_q_profile_set_hw_default(profile->row, &hw_default, 1);
     }
-    else {
-        ovsrec_queue_set_weight(queue_row, &weight, 1);
+
+    HMAP_FOR_EACH (queue, hmap_node, &profile->queues) {
+        struct ovsrec_q_profile_entry *queue_row =
+            ovsrec_q_profile_entry_insert(txn);
+
+        ovsrec_q_profile_entry_set_local_priorities(
+                queue_row, queue->local_priorities,
+                queue->n_local_priorities);
+        if (queue->description != NULL) {
+            ovsrec_q_profile_entry_set_description(queue_row,
+                                                   queue->description);
+        }
+        if (profile->hw_default) {
+            ovsrec_q_profile_entry_set_hw_default(queue_row, &hw_default, 1);
+        }
+
+        key_list[i] = queue->queue;
+        value_list[i] = queue_row;
+        i++;
     }
 
-    return true;
+    ovsrec_q_profile_set_q_profile_entries(profile->row, key_list,
+                                           value_list, n_queues);
+    free(key_list);
+    free(value_list);
 }
 
 /**
- * Creates the factory default schedule profile for the given txn and
- * default_name.
+ * Inserts the given schedule profile and its entries, writing every column
+ * exactly once.
  */
 static void
-qos_schedule_profile_create_factory_default(struct ovsdb_idl_txn *txn,
-                                            const char *default_name)
+qos_schedule_profile_commit(struct ovsdb_idl_txn *txn,
+                            struct qos_schedule_profile *profile)
 {
-    struct ovsrec_qos *profile_row;
-    int count = sysd_cfg_yaml_get_schedule_profile_entry_count();
-    const YamlScheduleProfileEntry *yaml_schedule_profile_entry;
-
-    VLOG_DBG("THERE ARE %d SCHEDULE_PROFILE ENTRIES", count);
+    struct qos_schedule_profile_queue *queue;
+    size_t n_queues = hmap_count(&profile->queues);
+    int64_t *key_list = xmalloc(n_queues * sizeof *key_list);
+    struct ovsrec_queue **value_list = xmalloc(n_queues * sizeof *value_list);
+    bool hw_default = true;
+    size_t i = 0;
 
-    qos_schedule_profile_command(txn, default_name);
+    profile->row = ovsrec_qos_insert(txn);
+    ovsrec_qos_set_name(profile->row, profile->name);
+    if (profile->hw_default) {
+        ovsrec_qos_set_hw_default(profile->row, &hw_default, 1);
+    }
 
-    /* Delete all queue rows. */
-    profile_row = qos_get_schedule_profile_row(default_name);
-    ovsrec_qos_set_queues(profile_row, NULL, NULL, 0);
+    HMAP_FOR_EACH (queue, hmap_node, &profile->queues) {
+        struct ovsrec_queue *queue_row = ovsrec_queue_insert(txn);
 
-    /* Create all queue rows. */
-    for (int ii = 0; ii < count; ii++) {
-        yaml_schedule_profile_entry =
-            sysd_cfg_yaml_get_schedule_profile_entry(ii);
-        /* pointer could be NULL only if YAML init has failed. */
-        if (yaml_schedule_profile_entry) {
-            qos_schedule_profile_row_command(txn, default_name,
-                    yaml_schedule_profile_entry->queue,
-                    yaml_schedule_profile_entry->algorithm,
-                    yaml_schedule_profile_entry->weight);
+        ovsrec_queue_set_algorithm(queue_row, queue->algorithm);
+        if (qos_algorithm_has_weight(queue->algorithm)) {
+            ovsrec_queue_set_weight(queue_row, &queue->weight, 1);
+        }
+        if (profile->hw_default) {
+            ovsrec_queue_set_hw_default(queue_row, &hw_default, 1);
         }
+
+        key_list[i] = queue->queue;
+        value_list[i] = queue_row;
+        i++;
+    }
+
+    ovsrec_qos_set_queues(profile->row, key_list, value_list, n_queues);
+    free(key_list);
+    free(value_list);
+}
+
+/**
+ * Writes every profile assembled in the builder into txn.
+ */
+void
+qos_profile_builder_commit(struct qos_profile_builder *builder,
+                           struct ovsdb_idl_txn *txn)
+{
+    struct qos_queue_profile *q_profile;
+    struct qos_schedule_profile *s_profile;
+
+    HMAP_FOR_EACH (q_profile, hmap_node, &builder->queue_profiles) {
+        qos_queue_profile_commit(txn, q_profile);
     }
+    HMAP_FOR_EACH (s_profile, hmap_node, &builder->schedule_profiles) {
+        qos_schedule_profile_commit(txn, s_profile);
+    }
+}
+
+/**
+ * Returns the Q_Profile row committed for profile_name, or NULL.
+ */
+struct ovsrec_q_profile *
+qos_profile_builder_get_queue_profile_row(struct qos_profile_builder *builder,
+                                          const char *profile_name)
+{
+    struct qos_queue_profile *profile =
+        qos_builder_find_queue_profile(builder, profile_name);
+
+    return profile ? profile->row : NULL;
+}
+
+/**
+ * Returns the QoS row committed for profile_name, or NULL.
+ */
+struct ovsrec_qos *
+qos_profile_builder_get_schedule_profile_row(
+        struct qos_profile_builder *builder, const char *profile_name)
+{
+    struct qos_schedule_profile *profile =
+        qos_builder_find_schedule_profile(builder, profile_name);
+
+    return profile ? profile->row : NULL;
 }
 
 /**
  * Initializes qos trust for the given txn and system_row.
  */
 void
-qos_init_trust(struct ovsdb_idl_txn *txn,
+qos_init_trust(struct sysd_write_stats *writes,
+               const struct qos_defaults *defaults,
+               struct ovsdb_idl_txn *txn,
                struct ovsrec_system *system_row)
 {
-    YamlQosInfo *qos_info;
     struct smap smap;
 
-    qos_info = sysd_cfg_yaml_get_qos_info();
-    if (qos_info == NULL) {
+    if (defaults == NULL) {
         return;
     }
 
     /* trust pointer could be NULL only if YAML init has failed. */
-    if (qos_info->trust) {
+    if (defaults->info.trust) {
         smap_clone(&smap, &system_row->qos_config);
-        smap_replace(&smap, QOS_TRUST_KEY, qos_info->trust);
-        ovsrec_system_set_qos_config(system_row, &smap);
+        smap_replace(&smap, QOS_TRUST_KEY, defaults->info.trust);
+        sysd_write_smap(writes, &system_row->header_,
+                        &ovsrec_system_col_qos_config, &smap);
         smap_destroy(&smap);
     }
     return;
 }
 
+/**
+ * Initializes smap with the factory defaults of a cos map entry, in the
+ * form they are saved in its hw_defaults column.
+ */
+static void
+cos_map_entry_hw_defaults(struct smap *smap,
+                          int64_t code_point, int64_t local_priority,
+                          const char *color, const char *description)
+{
+    char code_point_buffer[QOS_CLI_STRING_BUFFER_SIZE];
+    snprintf(code_point_buffer, QOS_CLI_STRING_BUFFER_SIZE,
+             "%" PRId64, code_point);
+    char local_priority_buffer[QOS_CLI_STRING_BUFFER_SIZE];
+    snprintf(local_priority_buffer, QOS_CLI_STRING_BUFFER_SIZE,
+             "%" PRId64, local_priority);
+
+    smap_init(smap);
+    smap_add(smap, QOS_DEFAULT_CODE_POINT_KEY, code_point_buffer);
+    smap_add(smap, QOS_DEFAULT_LOCAL_PRIORITY_KEY, local_priority_buffer);
+    smap_add(smap, QOS_DEFAULT_COLOR_KEY, color);
+    smap_add(smap, QOS_DEFAULT_DESCRIPTION_KEY, description);
+}
+
 /**
  * Sets the given cos_map_entry, code_point, local_priority, color, and
  * description for the given cos_map_entry.
@@ -439,26 +613,18 @@ set_cos_map_entry(struct ovsrec_qos_cos_map_entry *cos_map_entry,
                   int64_t code_point, int64_t local_priority,
                   char *color, char *description)
 {
-    /* Initialize the actual config. */
+    struct smap smap;
+
+    /* Initialize the actual config.  The row was just inserted, so there
+     * is no replica value for sysd_write_*() to compare against. */
     ovsrec_qos_cos_map_entry_set_code_point(cos_map_entry, code_point);
     ovsrec_qos_cos_map_entry_set_local_priority(cos_map_entry, local_priority);
     ovsrec_qos_cos_map_entry_set_color(cos_map_entry, color);
     ovsrec_qos_cos_map_entry_set_description(cos_map_entry, description);
 
-    char code_point_buffer[QOS_CLI_STRING_BUFFER_SIZE];
-    snprintf(code_point_buffer, QOS_CLI_STRING_BUFFER_SIZE,
-             "%" PRId64, code_point);
-    char local_priority_buffer[QOS_CLI_STRING_BUFFER_SIZE];
-    snprintf(local_priority_buffer, QOS_CLI_STRING_BUFFER_SIZE,
-             "%" PRId64, local_priority);
-
     /* Save the factory defaults so they can be restored later. */
-    struct smap smap;
-    smap_clone(&smap, &cos_map_entry->hw_defaults);
-    smap_replace(&smap, QOS_DEFAULT_CODE_POINT_KEY, code_point_buffer);
-    smap_replace(&smap, QOS_DEFAULT_LOCAL_PRIORITY_KEY, local_priority_buffer);
-    smap_replace(&smap, QOS_DEFAULT_COLOR_KEY, color);
-    smap_replace(&smap, QOS_DEFAULT_DESCRIPTION_KEY, description);
+    cos_map_entry_hw_defaults(&smap, code_point, local_priority,
+                              color, description);
     ovsrec_qos_cos_map_entry_set_hw_defaults(cos_map_entry, &smap);
     smap_destroy(&smap);
 }
@@ -467,18 +633,24 @@ set_cos_map_entry(struct ovsrec_qos_cos_map_entry *cos_map_entry,
  * Initializes the given default cos_map.
  */
 static void
-qos_init_default_cos_map(struct ovsrec_qos_cos_map_entry **cos_map)
+qos_init_default_cos_map(const struct qos_defaults *defaults,
+                         struct ovsrec_qos_cos_map_entry **cos_map)
 {
     const YamlCosMapEntry *yaml_cos_map_entry;
-    int count;
-
-    count = sysd_cfg_yaml_get_cos_map_entry_count();
-    VLOG_DBG("THERE ARE %d COS MAP ENTRIES", count);
+    size_t count;
+
+    count = defaults->n_cos_map;
+    VLOG_DBG("THERE ARE %"PRIuSIZE" COS MAP ENTRIES", count);
+    if (count > QOS_COS_MAP_ENTRY_COUNT) {
+        VLOG_ERR("Ignoring %"PRIuSIZE" cos map entries beyond %d.",
+                 count - QOS_COS_MAP_ENTRY_COUNT, QOS_COS_MAP_ENTRY_COUNT);
+        count = QOS_COS_MAP_ENTRY_COUNT;
+    }
 
     /* Initialize the cos-map entry data. */
-    unsigned int ii;
+    size_t ii;
     for (ii = 0; ii < count; ii++) {
-        yaml_cos_map_entry = sysd_cfg_yaml_get_cos_map_entry(ii);
+        yaml_cos_map_entry = &defaults->cos_map[ii];
         set_cos_map_entry(cos_map[ii],
                           yaml_cos_map_entry->code_point,
                           yaml_cos_map_entry->local_priority,
@@ -492,12 +664,11 @@ qos_init_default_cos_map(struct ovsrec_qos_cos_map_entry **cos_map)
  * system_row.
  */
 void
-qos_init_cos_map(struct ovsdb_idl_txn *txn,
+qos_init_cos_map(const struct qos_defaults *defaults,
+                 struct ovsdb_idl_txn *txn,
                  struct ovsrec_system *system_row)
 {
-    const YamlCosMapEntry *yaml_cos_map_entry =
-            sysd_cfg_yaml_get_cos_map_entry(0);
-    if (yaml_cos_map_entry == NULL) {
+    if (defaults == NULL || defaults->n_cos_map == 0) {
         return;
     }
 
@@ -511,18 +682,52 @@ qos_init_cos_map(struct ovsdb_idl_txn *txn,
     }
 
     /* Update the cos-map rows. */
-    qos_init_default_cos_map(cos_map_rows);
+    qos_init_default_cos_map(defaults, cos_map_rows);
 
     /* Update the system row. */
-    struct ovsrec_qos_cos_map_entry **value_list = xmalloc(
-        sizeof*system_row->qos_cos_map_entries *
-        QOS_COS_MAP_ENTRY_COUNT);
-    for (i = 0; i < QOS_COS_MAP_ENTRY_COUNT; i++) {
-        value_list[i] = cos_map_rows[i];
-    }
-    ovsrec_system_set_qos_cos_map_entries(system_row, value_list,
+    ovsrec_system_set_qos_cos_map_entries(system_row, cos_map_rows,
                                           QOS_COS_MAP_ENTRY_COUNT);
-    free(value_list);
+}
+
+/**
+ * Initializes smap with the factory defaults of a dscp map entry, in the
+ * form they are saved in its hw_defaults column.
+ */
+static void
+dscp_map_entry_hw_defaults(struct smap *smap,
+                           int64_t code_point, int64_t local_priority,
+#ifdef QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
+    /* Disabled for dill. */
+#else
+                           int64_t priority_code_point,
+#endif
+                           const char *color, const char *description)
+{
+    char code_point_buffer[QOS_CLI_STRING_BUFFER_SIZE];
+    snprintf(code_point_buffer, QOS_CLI_STRING_BUFFER_SIZE,
+             "%" PRId64, code_point);
+    char local_priority_buffer[QOS_CLI_STRING_BUFFER_SIZE];
+    snprintf(local_priority_buffer, QOS_CLI_STRING_BUFFER_SIZE,
+             "%" PRId64, local_priority);
+#ifdef QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
+    /* Disabled for dill. */
+#else
+    char priority_code_point_buffer[QOS_CLI_STRING_BUFFER_SIZE];
+    snprintf(priority_code_point_buffer, QOS_CLI_STRING_BUFFER_SIZE,
+             "%" PRId64, priority_code_point);
+#endif
+
+    smap_init(smap);
+    smap_add(smap, QOS_DEFAULT_CODE_POINT_KEY, code_point_buffer);
+    smap_add(smap, QOS_DEFAULT_LOCAL_PRIORITY_KEY, local_priority_buffer);
+#ifdef QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
+    /* Disabled for dill. */
+#else
+    smap_add(smap, QOS_DEFAULT_PRIORITY_CODE_POINT_KEY,
+             priority_code_point_buffer);
+#endif
+    smap_add(smap, QOS_DEFAULT_COLOR_KEY, color);
+    smap_add(smap, QOS_DEFAULT_DESCRIPTION_KEY, description);
 }
 
 /**
@@ -539,7 +744,10 @@ set_dscp_map_entry(struct ovsrec_qos_dscp_map_entry *dscp_map_entry,
 #endif
                    char *color, char *description)
 {
-    /* Initialize the actual config. */
+    struct smap smap;
+
+    /* Initialize the actual config.  The row was just inserted, so there
+     * is no replica value for sysd_write_*() to compare against. */
     ovsrec_qos_dscp_map_entry_set_code_point(dscp_map_entry, code_point);
     ovsrec_qos_dscp_map_entry_set_local_priority(dscp_map_entry,
                                                  local_priority);
@@ -552,34 +760,14 @@ set_dscp_map_entry(struct ovsrec_qos_dscp_map_entry *dscp_map_entry,
     ovsrec_qos_dscp_map_entry_set_color(dscp_map_entry, color);
     ovsrec_qos_dscp_map_entry_set_description(dscp_map_entry, description);
 
-    char code_point_buffer[QOS_CLI_STRING_BUFFER_SIZE];
-    snprintf(code_point_buffer, QOS_CLI_STRING_BUFFER_SIZE,
-             "%" PRId64, code_point);
-    char local_priority_buffer[QOS_CLI_STRING_BUFFER_SIZE];
-    snprintf(local_priority_buffer, QOS_CLI_STRING_BUFFER_SIZE,
-             "%" PRId64, local_priority);
-#ifdef QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
-    /* Disabled for dill. */
-#else
-    char priority_code_point_buffer[QOS_CLI_STRING_BUFFER_SIZE];
-    snprintf(priority_code_point_buffer, QOS_CLI_STRING_BUFFER_SIZE,
-             "%" PRId64, priority_code_point);
-#endif
-
     /* Save the factory defaults so they can be restored later. */
-    struct smap smap;
-    smap_clone(&smap, &dscp_map_entry->hw_defaults);
-    smap_replace(&smap, QOS_DEFAULT_CODE_POINT_KEY, code_point_buffer);
-    smap_replace(&smap, QOS_DEFAULT_LOCAL_PRIORITY_KEY,
-                 local_priority_buffer);
+    dscp_map_entry_hw_defaults(&smap, code_point, local_priority,
 #ifdef QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
     /* Disabled for dill. */
 #else
-    smap_replace(&smap, QOS_DEFAULT_PRIORITY_CODE_POINT_KEY,
-                 priority_code_point_buffer);
+                               priority_code_point,
 #endif
-    smap_replace(&smap, QOS_DEFAULT_COLOR_KEY, color);
-    smap_replace(&smap, QOS_DEFAULT_DESCRIPTION_KEY, description);
+                               color, description);
     ovsrec_qos_dscp_map_entry_set_hw_defaults(dscp_map_entry, &smap);
     smap_destroy(&smap);
 }
@@ -588,19 +776,24 @@ set_dscp_map_entry(struct ovsrec_qos_dscp_map_entry *dscp_map_entry,
  * Initializes the given default dscp_map.
  */
 static void
-qos_init_default_dscp_map(
-        struct ovsrec_qos_dscp_map_entry **dscp_map)
+qos_init_default_dscp_map(const struct qos_defaults *defaults,
+                          struct ovsrec_qos_dscp_map_entry **dscp_map)
 {
     const YamlDscpMapEntry *yaml_dscp_map_entry;
-    int count;
-
-    count = sysd_cfg_yaml_get_dscp_map_entry_count();
-    VLOG_DBG("THERE ARE %d DSCP MAP ENTRIES", count);
+    size_t count;
+
+    count = defaults->n_dscp_map;
+    VLOG_DBG("THERE ARE %"PRIuSIZE" DSCP MAP ENTRIES", count);
+    if (count > QOS_DSCP_MAP_ENTRY_COUNT) {
+        VLOG_ERR("Ignoring %"PRIuSIZE" dscp map entries beyond %d.",
+                 count - QOS_DSCP_MAP_ENTRY_COUNT, QOS_DSCP_MAP_ENTRY_COUNT);
+        count = QOS_DSCP_MAP_ENTRY_COUNT;
+    }
 
     /* Initialize the dscp-map entry data. */
-    unsigned int ii;
+    size_t ii;
     for (ii = 0; ii < count; ii++) {
-        yaml_dscp_map_entry = sysd_cfg_yaml_get_dscp_map_entry(ii);
+        yaml_dscp_map_entry = &defaults->dscp_map[ii];
         set_dscp_map_entry(dscp_map[ii],
                            yaml_dscp_map_entry->code_point,
                            yaml_dscp_map_entry->local_priority,
@@ -619,12 +812,11 @@ qos_init_default_dscp_map(
  * system_row.
  */
 void
-qos_init_dscp_map(struct ovsdb_idl_txn *txn,
+qos_init_dscp_map(const struct qos_defaults *defaults,
+                  struct ovsdb_idl_txn *txn,
                   struct ovsrec_system *system_row)
 {
-    const YamlDscpMapEntry *yaml_dscp_map_entry =
-            sysd_cfg_yaml_get_dscp_map_entry(0);
-    if (yaml_dscp_map_entry == NULL) {
+    if (defaults == NULL || defaults->n_dscp_map == 0) {
         return;
     }
 
@@ -638,114 +830,1154 @@ qos_init_dscp_map(struct ovsdb_idl_txn *txn,
     }
 
     /* Update the dscp-map rows. */
-    qos_init_default_dscp_map(dscp_map_rows);
+    qos_init_default_dscp_map(defaults, dscp_map_rows);
 
     /* Update the system row. */
-    struct ovsrec_qos_dscp_map_entry **value_list = xmalloc(
-        sizeof*system_row->qos_dscp_map_entries *
-        QOS_DSCP_MAP_ENTRY_COUNT);
-    for (i = 0; i < QOS_DSCP_MAP_ENTRY_COUNT; i++) {
-        value_list[i] = dscp_map_rows[i];
-    }
-    ovsrec_system_set_qos_dscp_map_entries(system_row, value_list,
+    ovsrec_system_set_qos_dscp_map_entries(system_row, dscp_map_rows,
                                            QOS_DSCP_MAP_ENTRY_COUNT);
-    free(value_list);
+}
+
+/**
+ * Adds the factory default queue profile entries to the queue profile
+ * named profile_name.
+ */
+static void
+add_default_queue_profile(struct qos_profile_builder *builder,
+                          const struct qos_defaults *defaults,
+                          const char *profile_name)
+{
+    const YamlQueueProfileEntry *yaml_queue_profile_entry;
+    size_t ii;
+
+    for (ii = 0; ii < defaults->n_queue_profile; ii++) {
+        yaml_queue_profile_entry = &defaults->queue_profile[ii];
+        VLOG_DBG(".. queue %d pri %d", yaml_queue_profile_entry->queue,
+                 yaml_queue_profile_entry->local_priority);
+        qos_profile_builder_add_queue(builder, profile_name,
+                yaml_queue_profile_entry->queue,
+                yaml_queue_profile_entry->local_priority,
+                yaml_queue_profile_entry->description);
+    }
+}
+
+/**
+ * Adds the factory default schedule profile entries to the schedule
+ * profile named profile_name.
+ */
+static void
+add_default_schedule_profile(struct qos_profile_builder *builder,
+                             const struct qos_defaults *defaults,
+                             const char *profile_name)
+{
+    const YamlScheduleProfileEntry *yaml_schedule_profile_entry;
+    size_t ii;
+
+    for (ii = 0; ii < defaults->n_schedule_profile; ii++) {
+        yaml_schedule_profile_entry = &defaults->schedule_profile[ii];
+        qos_profile_builder_add_schedule(builder, profile_name,
+                yaml_schedule_profile_entry->queue,
+                yaml_schedule_profile_entry->algorithm,
+                yaml_schedule_profile_entry->weight);
+    }
 }
 
 /**
  * Initializes the queue_profile for the given txn and system_row.
  */
 void
-qos_init_queue_profile(struct ovsdb_idl_txn *txn,
+qos_init_queue_profile(const struct qos_defaults *defaults,
+                       struct ovsdb_idl_txn *txn,
                        struct ovsrec_system *system_row)
 {
-    YamlQosInfo *qos_info = sysd_cfg_yaml_get_qos_info();
-    if (qos_info == NULL) {
+    const YamlQosInfo *qos_info;
+    struct qos_profile_builder builder;
+    struct ovsrec_q_profile *default_profile;
+
+    if (defaults == NULL) {
         return;
     }
+    qos_info = &defaults->info;
 
-    /* Create the default profile. */
-    qos_queue_profile_create_factory_default(txn, qos_info->default_name);
+    qos_profile_builder_init(&builder);
 
-    struct ovsrec_q_profile *default_profile =
-                    qos_get_queue_profile_row(qos_info->default_name);
-    if (default_profile == NULL) {
-        VLOG_ERR("Profile cannot be NULL.");
-        return;
-    }
+    /* The default profile and the immutable factory default profile
+     * start out with the same entries. */
+    VLOG_DBG("THERE ARE %"PRIuSIZE" QUEUE_PROFILE ENTRIES",
+             defaults->n_queue_profile);
+    add_default_queue_profile(&builder, defaults, qos_info->default_name);
+    add_default_queue_profile(&builder, defaults,
+                              qos_info->factory_default_name);
+    qos_profile_builder_add_queue_profile(&builder, qos_info->default_name,
+                                          false);
+    qos_profile_builder_add_queue_profile(&builder,
+                                          qos_info->factory_default_name,
+                                          true);
+
+    qos_profile_builder_commit(&builder, txn);
 
     /* Update the system row to point to the default profile. */
+    default_profile = qos_profile_builder_get_queue_profile_row(
+            &builder, qos_info->default_name);
     ovsrec_system_set_q_profile(system_row, default_profile);
 
-    /* Also, create a profile named factory default that is immutable. */
-    qos_queue_profile_create_factory_default(txn,
-                                             qos_info->factory_default_name);
+    qos_profile_builder_destroy(&builder);
+}
+
+/**
+ * Initializes the schedule_profile for the given txn and system_row.
+ */
+void
+qos_init_schedule_profile(const struct qos_defaults *defaults,
+                          struct ovsdb_idl_txn *txn,
+                          struct ovsrec_system *system_row)
+{
+    const YamlQosInfo *qos_info;
+    struct qos_profile_builder builder;
+    struct ovsrec_qos *default_profile;
 
-    struct ovsrec_q_profile *factory_default_profile =
-                    qos_get_queue_profile_row(qos_info->factory_default_name);
-    if (factory_default_profile == NULL) {
-        VLOG_ERR("Profile cannot be NULL.");
+    if (defaults == NULL) {
         return;
     }
+    qos_info = &defaults->info;
 
-    /* Set hw_default for profile row. */
-    bool hw_default = true;
-    ovsrec_q_profile_set_hw_default(factory_default_profile, &hw_default, 1);
+    qos_profile_builder_init(&builder);
 
-    /* Set hw_default for profile entry rows. */
-    int i;
-    for (i = 0; i < factory_default_profile->n_q_profile_entries; i++) {
-        struct ovsrec_q_profile_entry *entry =
-            factory_default_profile->value_q_profile_entries[i];
-        ovsrec_q_profile_entry_set_hw_default(entry, &hw_default, 1);
+    /* The default profile and the immutable factory default profile
+     * start out with the same entries. */
+    VLOG_DBG("THERE ARE %"PRIuSIZE" SCHEDULE_PROFILE ENTRIES",
+             defaults->n_schedule_profile);
+    add_default_schedule_profile(&builder, defaults, qos_info->default_name);
+    add_default_schedule_profile(&builder, defaults,
+                                 qos_info->factory_default_name);
+    qos_profile_builder_add_schedule_profile(&builder,
+                                             qos_info->default_name, false);
+    qos_profile_builder_add_schedule_profile(&builder,
+                                             qos_info->factory_default_name,
+                                             true);
+
+    qos_profile_builder_commit(&builder, txn);
+
+    /* Update the system row to point to the default profile. */
+    default_profile = qos_profile_builder_get_schedule_profile_row(
+            &builder, qos_info->default_name);
+    ovsrec_system_set_qos(system_row, default_profile);
+
+    qos_profile_builder_destroy(&builder);
+}
+
+/**
+ * Returns true if the live value of the hw_defaults field named key should
+ * follow a changed factory default, that is, if the default changed and the
+ * live value still equals the old default. A live value that differs from
+ * the old default was set by the user and is left alone.
+ */
+static bool
+qos_live_follows_default(const struct smap *old_defaults,
+                         const struct smap *new_defaults,
+                         const char *key, const char *live)
+{
+    const char *old_value = smap_get(old_defaults, key);
+    const char *new_value = smap_get(new_defaults, key);
+
+    return (old_value && new_value && live
+            && strcmp(old_value, new_value)
+            && !strcmp(old_value, live));
+}
+
+/**
+ * Brings one cos map entry in line with its new factory defaults. Returns
+ * true if the row was rewritten.
+ */
+static bool
+qos_reconcile_cos_map_entry(struct sysd_write_stats *writes,
+                            const struct ovsrec_qos_cos_map_entry *row,
+                            const YamlCosMapEntry *entry)
+{
+    char local_priority[QOS_CLI_STRING_BUFFER_SIZE];
+    struct smap hw_defaults;
+
+    cos_map_entry_hw_defaults(&hw_defaults, entry->code_point,
+                              entry->local_priority, entry->color,
+                              entry->description);
+    if (smap_equal(&row->hw_defaults, &hw_defaults)) {
+        smap_destroy(&hw_defaults);
+        return false;
+    }
+
+    snprintf(local_priority, QOS_CLI_STRING_BUFFER_SIZE,
+             "%" PRId64, row->local_priority);
+    if (qos_live_follows_default(&row->hw_defaults, &hw_defaults,
+                                 QOS_DEFAULT_LOCAL_PRIORITY_KEY,
+                                 local_priority)) {
+        sysd_write_integer(writes, &row->header_,
+                           &ovsrec_qos_cos_map_entry_col_local_priority,
+                           entry->local_priority);
+    }
+    if (qos_live_follows_default(&row->hw_defaults, &hw_defaults,
+                                 QOS_DEFAULT_COLOR_KEY, row->color)) {
+        sysd_write_string(writes, &row->header_,
+                          &ovsrec_qos_cos_map_entry_col_color, entry->color);
+    }
+    if (qos_live_follows_default(&row->hw_defaults, &hw_defaults,
+                                 QOS_DEFAULT_DESCRIPTION_KEY,
+                                 row->description)) {
+        sysd_write_string(writes, &row->header_,
+                          &ovsrec_qos_cos_map_entry_col_description,
+                          entry->description);
     }
+    sysd_write_smap(writes, &row->header_,
+                    &ovsrec_qos_cos_map_entry_col_hw_defaults, &hw_defaults);
+    smap_destroy(&hw_defaults);
+
+    return true;
 }
 
 /**
- * Initializes the schedule_profile for the given txn and system_row.
+ * Reconciles the cos map of system_row. Returns the number of rows
+ * rewritten.
  */
-void
-qos_init_schedule_profile(struct ovsdb_idl_txn *txn,
-                           struct ovsrec_system *system_row)
+static size_t
+qos_reconcile_cos_map(struct sysd_write_stats *writes,
+                      const struct qos_defaults *defaults,
+                      const struct ovsrec_system *system_row)
 {
-    YamlQosInfo *qos_info = sysd_cfg_yaml_get_qos_info();
-    if (qos_info == NULL) {
-        return;
+    const YamlCosMapEntry *entries[QOS_COS_MAP_ENTRY_COUNT] = { NULL };
+    size_t n_changed = 0;
+    size_t i;
+
+    for (i = 0; i < defaults->n_cos_map; i++) {
+        int code_point = defaults->cos_map[i].code_point;
+
+        if (code_point >= 0 && code_point < QOS_COS_MAP_ENTRY_COUNT) {
+            entries[code_point] = &defaults->cos_map[i];
+        }
     }
 
-    /* Create the default profile. */
-    qos_schedule_profile_create_factory_default(txn, qos_info->default_name);
+    for (i = 0; i < system_row->n_qos_cos_map_entries; i++) {
+        const struct ovsrec_qos_cos_map_entry *row =
+            system_row->qos_cos_map_entries[i];
 
-    struct ovsrec_qos *default_profile =
-        qos_get_schedule_profile_row(qos_info->default_name);
-    if (default_profile == NULL) {
-        VLOG_ERR("Profile cannot be NULL.");
-        return;
+        if (row->code_point >= 0 && row->code_point < QOS_COS_MAP_ENTRY_COUNT
+            && entries[row->code_point]
+            && qos_reconcile_cos_map_entry(writes, row,
+                                           entries[row->code_point])) {
+            n_changed++;
+        }
     }
 
-    /* Update the system row to point to the default profile. */
-    ovsrec_system_set_qos(system_row, default_profile);
+    return n_changed;
+}
 
-    /* Also, create a profile named factory default that is immutable. */
-    qos_schedule_profile_create_factory_default(txn,
-            qos_info->factory_default_name);
+/**
+ * Brings one dscp map entry in line with its new factory defaults. Returns
+ * true if the row was rewritten.
+ */
+static bool
+qos_reconcile_dscp_map_entry(struct sysd_write_stats *writes,
+                             const struct ovsrec_qos_dscp_map_entry *row,
+                             const YamlDscpMapEntry *entry)
+{
+    char local_priority[QOS_CLI_STRING_BUFFER_SIZE];
+    struct smap hw_defaults;
 
-    struct ovsrec_qos *factory_default_profile =
-        qos_get_schedule_profile_row(qos_info->factory_default_name);
-    if (factory_default_profile == NULL) {
-        VLOG_ERR("Profile cannot be NULL.");
-        return;
+    dscp_map_entry_hw_defaults(&hw_defaults, entry->code_point,
+                               entry->local_priority,
+#ifdef QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
+    /* Disabled for dill. */
+#else
+                               entry->priority_code_point,
+#endif
+                               entry->color, entry->description);
+    if (smap_equal(&row->hw_defaults, &hw_defaults)) {
+        smap_destroy(&hw_defaults);
+        return false;
     }
 
-    /* Set hw_default for profile row. */
-    bool hw_default = true;
-    ovsrec_qos_set_hw_default(factory_default_profile, &hw_default, 1);
+    snprintf(local_priority, QOS_CLI_STRING_BUFFER_SIZE,
+             "%" PRId64, row->local_priority);
+    if (qos_live_follows_default(&row->hw_defaults, &hw_defaults,
+                                 QOS_DEFAULT_LOCAL_PRIORITY_KEY,
+                                 local_priority)) {
+        sysd_write_integer(writes, &row->header_,
+                           &ovsrec_qos_dscp_map_entry_col_local_priority,
+                           entry->local_priority);
+    }
+#ifdef QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
+    /* Disabled for dill. */
+#else
+    if (row->n_priority_code_point) {
+        char priority_code_point[QOS_CLI_STRING_BUFFER_SIZE];
+        int64_t new_priority_code_point = entry->priority_code_point;
+
+        snprintf(priority_code_point, QOS_CLI_STRING_BUFFER_SIZE,
+                 "%" PRId64, row->priority_code_point[0]);
+        if (qos_live_follows_default(&row->hw_defaults, &hw_defaults,
+                                     QOS_DEFAULT_PRIORITY_CODE_POINT_KEY,
+                                     priority_code_point)) {
+            sysd_write_integers(
+                    writes, &row->header_,
+                    &ovsrec_qos_dscp_map_entry_col_priority_code_point,
+                    &new_priority_code_point, 1);
+        }
+    }
+#endif
+    if (qos_live_follows_default(&row->hw_defaults, &hw_defaults,
+                                 QOS_DEFAULT_COLOR_KEY, row->color)) {
+        sysd_write_string(writes, &row->header_,
+                          &ovsrec_qos_dscp_map_entry_col_color, entry->color);
+    }
+    if (qos_live_follows_default(&row->hw_defaults, &hw_defaults,
+                                 QOS_DEFAULT_DESCRIPTION_KEY,
+                                 row->description)) {
+        sysd_write_string(writes, &row->header_,
+                          &ovsrec_qos_dscp_map_entry_col_description,
+                          entry->description);
+    }
+    sysd_write_smap(writes, &row->header_,
+                    &ovsrec_qos_dscp_map_entry_col_hw_defaults, &hw_defaults);
+    smap_destroy(&hw_defaults);
 
-    /* Set hw_default for profile entry rows. */
-    int i;
-    for (i = 0; i < factory_default_profile->n_queues; i++) {
-        struct ovsrec_queue *entry =
-            factory_default_profile->value_queues[i];
-        ovsrec_queue_set_hw_default(entry, &hw_default, 1);
+    return true;
+}
+
+/**
+ * Reconciles the dscp map of system_row. Returns the number of rows
+ * rewritten.
+ */
+static size_t
+qos_reconcile_dscp_map(struct sysd_write_stats *writes,
+                       const struct qos_defaults *defaults,
+                       const struct ovsrec_system *system_row)
+{
+    const YamlDscpMapEntry *entries[QOS_DSCP_MAP_ENTRY_COUNT] = { NULL };
+    size_t n_changed = 0;
+    size_t i;
+
+    for (i = 0; i < defaults->n_dscp_map; i++) {
+        int code_point = defaults->dscp_map[i].code_point;
+
+        if (code_point >= 0 && code_point < QOS_DSCP_MAP_ENTRY_COUNT) {
+            entries[code_point] = &defaults->dscp_map[i];
+        }
+    }
+
+    for (i = 0; i < system_row->n_qos_dscp_map_entries; i++) {
+        const struct ovsrec_qos_dscp_map_entry *row =
+            system_row->qos_dscp_map_entries[i];
+
+        if (row->code_point >= 0 && row->code_point < QOS_DSCP_MAP_ENTRY_COUNT
+            && entries[row->code_point]
+            && qos_reconcile_dscp_map_entry(writes, row,
+                                            entries[row->code_point])) {
+            n_changed++;
+        }
+    }
+
+    return n_changed;
+}
+
+/**
+ * Returns the Q_Profile row named name, or NULL.
+ */
+static const struct ovsrec_q_profile *
+qos_find_queue_profile_row(struct ovsdb_idl *idl, const char *name)
+{
+    const struct ovsrec_q_profile *row;
+
+    OVSREC_Q_PROFILE_FOR_EACH (row, idl) {
+        if (strcmp(row->name, name) == 0) {
+            return row;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Returns true if the Q_Profile_Entry row holds the same local priorities
+ * and description as queue.
+ */
+static bool
+qos_queue_profile_entry_matches(const struct ovsrec_q_profile_entry *row,
+                                const struct qos_queue_profile_queue *queue)
+{
+    size_t i, j;
+
+    if (row->n_local_priorities != queue->n_local_priorities
+        || !nullable_string_is_equal(row->description, queue->description)) {
+        return false;
+    }
+
+    /* Both are sets of at most QOS_LOCAL_PRIORITY_COUNT priorities. */
+    for (i = 0; i < queue->n_local_priorities; i++) {
+        for (j = 0; j < row->n_local_priorities; j++) {
+            if (row->local_priorities[j] == queue->local_priorities[i]) {
+                break;
+            }
+        }
+        if (j == row->n_local_priorities) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Returns true if the Q_Profile row holds exactly the queues of profile.
+ */
+static bool
+qos_queue_profile_row_matches(const struct ovsrec_q_profile *row,
+                              struct qos_queue_profile *profile)
+{
+    size_t i;
+
+    if (row->n_q_profile_entries != hmap_count(&profile->queues)) {
+        return false;
+    }
+
+    for (i = 0; i < row->n_q_profile_entries; i++) {
+        struct qos_queue_profile_queue *queue =
+            qos_queue_profile_find_queue(profile,
+                                         row->key_q_profile_entries[i]);
+
+        if (queue == NULL
+            || !qos_queue_profile_entry_matches(
+                    row->value_q_profile_entries[i], queue)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Loads the queues of the Q_Profile row into the builder profile named
+ * profile_name, and returns that profile.
+ */
+static struct qos_queue_profile *
+qos_builder_load_queue_profile(struct qos_profile_builder *builder,
+                               const char *profile_name,
+                               const struct ovsrec_q_profile *row)
+{
+    struct qos_queue_profile *profile =
+        qos_builder_queue_profile(builder, profile_name);
+    size_t i, j;
+
+    for (i = 0; i < row->n_q_profile_entries; i++) {
+        const struct ovsrec_q_profile_entry *entry =
+            row->value_q_profile_entries[i];
+        struct qos_queue_profile_queue *queue =
+            qos_queue_profile_queue(profile, row->key_q_profile_entries[i]);
+
+        for (j = 0; j < entry->n_local_priorities; j++) {
+            add_local_priority(queue, entry->local_priorities[j]);
+        }
+        queue->description = entry->description;
+    }
+
+    return profile;
+}
+
+/**
+ * Rewrites the Q_Profile row so that it holds exactly the queues of
+ * profile, touching only the entries that differ. Returns the number of
+ * rows written: each Q_Profile_Entry rewritten or added, plus the Q_Profile
+ * row itself if its map of entries changed.
+ */
+static size_t
+qos_update_queue_profile_row(struct ovsdb_idl_txn *txn,
+                             const struct ovsrec_q_profile *row,
+                             struct qos_queue_profile *profile)
+{
+    struct qos_queue_profile_queue *queue;
+    size_t n_queues = hmap_count(&profile->queues);
+    int64_t *key_list = xmalloc(n_queues * sizeof *key_list);
+    struct ovsrec_q_profile_entry **value_list =
+        xmalloc(n_queues * sizeof *value_list);
+    bool keys_changed = row->n_q_profile_entries != n_queues;
+    bool hw_default = row->n_hw_default && row->hw_default[0];
+    size_t n_changed = 0;
+    size_t i = 0, j;
+
+    HMAP_FOR_EACH (queue, hmap_node, &profile->queues) {
+        struct ovsrec_q_profile_entry *entry = NULL;
+        bool rewrite;
+
+        for (j = 0; j < row->n_q_profile_entries; j++) {
+            if (row->key_q_profile_entries[j] == queue->queue) {
+                entry = row->value_q_profile_entries[j];
+                break;
+            }
+        }
+
+        if (entry == NULL) {
+            entry = ovsrec_q_profile_entry_insert(txn);
+            if (hw_default) {
+                ovsrec_q_profile_entry_set_hw_default(entry, &hw_default, 1);
+            }
+            keys_changed = true;
+            rewrite = true;
+        } else {
+            rewrite = !qos_queue_profile_entry_matches(entry, queue);
+        }
+
+        if (rewrite) {
+            ovsrec_q_profile_entry_set_local_priorities(
+                    entry, queue->local_priorities, queue->n_local_priorities);
+            ovsrec_q_profile_entry_set_description(entry, queue->description);
+            n_changed++;
+        }
+
+        key_list[i] = queue->queue;
+        value_list[i] = entry;
+        i++;
+    }
+
+    if (keys_changed) {
+        ovsrec_q_profile_set_q_profile_entries(row, key_list, value_list,
+                                               n_queues);
+        n_changed++;
+    }
+    free(key_list);
+    free(value_list);
+
+    return n_changed;
+}
+
+/**
+ * Reconciles the factory default queue profile and, if the user never
+ * changed it, the default queue profile. Returns the number of rows
+ * written.
+ */
+static size_t
+qos_reconcile_queue_profiles(struct ovsdb_idl *idl, struct ovsdb_idl_txn *txn,
+                             const struct qos_defaults *defaults)
+{
+    const char *factory_name = defaults->info.factory_default_name;
+    const char *default_name = defaults->info.default_name;
+    const struct ovsrec_q_profile *factory_row, *default_row;
+    struct qos_profile_builder builder, old_builder;
+    struct qos_queue_profile *factory, *old_factory;
+    size_t n_changed = 0;
+
+    factory_row = qos_find_queue_profile_row(idl, factory_name);
+    if (factory_row == NULL) {
+        VLOG_WARN("No queue profile named %s to reconcile.", factory_name);
+        return 0;
+    }
+
+    qos_profile_builder_init(&builder);
+    add_default_queue_profile(&builder, defaults, factory_name);
+    factory = qos_builder_queue_profile(&builder, factory_name);
+
+    if (!qos_queue_profile_row_matches(factory_row, factory)) {
+        qos_profile_builder_init(&old_builder);
+        old_factory = qos_builder_load_queue_profile(&old_builder,
+                                                     factory_name,
+                                                     factory_row);
+
+        default_row = qos_find_queue_profile_row(idl, default_name);
+        if (default_row
+            && qos_queue_profile_row_matches(default_row, old_factory)) {
+            n_changed += qos_update_queue_profile_row(txn, default_row,
+                                                      factory);
+        } else if (default_row) {
+            VLOG_INFO("Queue profile %s was changed by the user; "
+                      "not applying new factory defaults to it.",
+                      default_name);
+        }
+        n_changed += qos_update_queue_profile_row(txn, factory_row, factory);
+
+        qos_profile_builder_destroy(&old_builder);
+    }
+
+    qos_profile_builder_destroy(&builder);
+    return n_changed;
+}
+
+/**
+ * Returns the QoS row named name, or NULL.
+ */
+static const struct ovsrec_qos *
+qos_find_schedule_profile_row(struct ovsdb_idl *idl, const char *name)
+{
+    const struct ovsrec_qos *row;
+
+    OVSREC_QOS_FOR_EACH (row, idl) {
+        if (strcmp(row->name, name) == 0) {
+            return row;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Returns true if the Queue row holds the same algorithm and weight as
+ * queue.
+ */
+static bool
+qos_schedule_profile_entry_matches(
+        const struct ovsrec_queue *row,
+        const struct qos_schedule_profile_queue *queue)
+{
+    if (!nullable_string_is_equal(row->algorithm, queue->algorithm)) {
+        return false;
+    }
+
+    if (qos_algorithm_has_weight(queue->algorithm)) {
+        return row->n_weight == 1 && row->weight[0] == queue->weight;
+    }
+    return row->n_weight == 0;
+}
+
+/**
+ * Returns true if the QoS row holds exactly the queues of profile.
+ */
+static bool
+qos_schedule_profile_row_matches(const struct ovsrec_qos *row,
+                                 struct qos_schedule_profile *profile)
+{
+    size_t i;
+
+    if (row->n_queues != hmap_count(&profile->queues)) {
+        return false;
+    }
+
+    for (i = 0; i < row->n_queues; i++) {
+        struct qos_schedule_profile_queue *queue =
+            qos_schedule_profile_find_queue(profile, row->key_queues[i]);
+
+        if (queue == NULL
+            || !qos_schedule_profile_entry_matches(row->value_queues[i],
+                                                   queue)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Loads the queues of the QoS row into the builder profile named
+ * profile_name, and returns that profile.
+ */
+static struct qos_schedule_profile *
+qos_builder_load_schedule_profile(struct qos_profile_builder *builder,
+                                  const char *profile_name,
+                                  const struct ovsrec_qos *row)
+{
+    struct qos_schedule_profile *profile =
+        qos_builder_schedule_profile(builder, profile_name);
+    size_t i;
+
+    for (i = 0; i < row->n_queues; i++) {
+        const struct ovsrec_queue *entry = row->value_queues[i];
+        struct qos_schedule_profile_queue *queue =
+            qos_schedule_profile_queue(profile, row->key_queues[i]);
+
+        queue->algorithm = entry->algorithm;
+        queue->weight = entry->n_weight ? entry->weight[0] : 0;
+    }
+
+    return profile;
+}
+
+/**
+ * Rewrites the QoS row so that it holds exactly the queues of profile,
+ * touching only the entries that differ. Returns the number of rows
+ * written: each Queue rewritten or added, plus the QoS row itself if its
+ * map of queues changed.
+ */
+static size_t
+qos_update_schedule_profile_row(struct ovsdb_idl_txn *txn,
+                                const struct ovsrec_qos *row,
+                                struct qos_schedule_profile *profile)
+{
+    struct qos_schedule_profile_queue *queue;
+    size_t n_queues = hmap_count(&profile->queues);
+    int64_t *key_list = xmalloc(n_queues * sizeof *key_list);
+    struct ovsrec_queue **value_list = xmalloc(n_queues * sizeof *value_list);
+    bool keys_changed = row->n_queues != n_queues;
+    bool hw_default = row->n_hw_default && row->hw_default[0];
+    size_t n_changed = 0;
+    size_t i = 0, j;
+
+    HMAP_FOR_EACH (queue, hmap_node, &profile->queues) {
+        struct ovsrec_queue *entry = NULL;
+        bool rewrite;
+
+        for (j = 0; j < row->n_queues; j++) {
+            if (row->key_queues[j] == queue->queue) {
+                entry = row->value_queues[j];
+                break;
+            }
+        }
+
+        if (entry == NULL) {
+            entry = ovsrec_queue_insert(txn);
+            if (hw_default) {
+                ovsrec_queue_set_hw_default(entry, &hw_default, 1);
+            }
+            keys_changed = true;
+            rewrite = true;
+        } else {
+            rewrite = !qos_schedule_profile_entry_matches(entry, queue);
+        }
+
+        if (rewrite) {
+            ovsrec_queue_set_algorithm(entry, queue->algorithm);
+            if (qos_algorithm_has_weight(queue->algorithm)) {
+                ovsrec_queue_set_weight(entry, &queue->weight, 1);
+            } else {
+                ovsrec_queue_set_weight(entry, NULL, 0);
+            }
+            n_changed++;
+        }
+
+        key_list[i] = queue->queue;
+        value_list[i] = entry;
+        i++;
+    }
+
+    if (keys_changed) {
+        ovsrec_qos_set_queues(row, key_list, value_list, n_queues);
+        n_changed++;
+    }
+    free(key_list);
+    free(value_list);
+
+    return n_changed;
+}
+
+/**
+ * Reconciles the factory default schedule profile and, if the user never
+ * changed it, the default schedule profile. Returns the number of rows
+ * written.
+ */
+static size_t
+qos_reconcile_schedule_profiles(struct ovsdb_idl *idl,
+                                struct ovsdb_idl_txn *txn,
+                                const struct qos_defaults *defaults)
+{
+    const char *factory_name = defaults->info.factory_default_name;
+    const char *default_name = defaults->info.default_name;
+    const struct ovsrec_qos *factory_row, *default_row;
+    struct qos_profile_builder builder, old_builder;
+    struct qos_schedule_profile *factory, *old_factory;
+    size_t n_changed = 0;
+
+    factory_row = qos_find_schedule_profile_row(idl, factory_name);
+    if (factory_row == NULL) {
+        VLOG_WARN("No schedule profile named %s to reconcile.",
+                  factory_name);
+        return 0;
+    }
+
+    qos_profile_builder_init(&builder);
+    add_default_schedule_profile(&builder, defaults, factory_name);
+    factory = qos_builder_schedule_profile(&builder, factory_name);
+
+    if (!qos_schedule_profile_row_matches(factory_row, factory)) {
+        qos_profile_builder_init(&old_builder);
+        old_factory = qos_builder_load_schedule_profile(&old_builder,
+                                                        factory_name,
+                                                        factory_row);
+
+        default_row = qos_find_schedule_profile_row(idl, default_name);
+        if (default_row
+            && qos_schedule_profile_row_matches(default_row, old_factory)) {
+            n_changed += qos_update_schedule_profile_row(txn, default_row,
+                                                         factory);
+        } else if (default_row) {
+            VLOG_INFO("Schedule profile %s was changed by the user; "
+                      "not applying new factory defaults to it.",
+                      default_name);
+        }
+        n_changed += qos_update_schedule_profile_row(txn, factory_row,
+                                                     factory);
+
+        qos_profile_builder_destroy(&old_builder);
+    }
+
+    qos_profile_builder_destroy(&builder);
+    return n_changed;
+}
+
+/**
+ * Brings the QoS rows of an existing database in line with the current
+ * factory defaults, for example after an image upgrade changed qos.yaml.
+ *
+ * For cos and dscp map entries, the defaults saved in hw_defaults are
+ * compared with the new ones; only entries whose defaults changed are
+ * rewritten, and a live value is only updated if it still equals its old
+ * default. The factory default profiles are rewritten entry by entry, and
+ * the default profiles follow them only if they still match the old
+ * factory default profiles.
+ *
+ * Returns the number of rows rewritten in txn.
+ */
+size_t
+qos_reconcile_defaults(struct sysd_write_stats *writes,
+                       struct ovsdb_idl *idl,
+                       const struct qos_defaults *defaults,
+                       struct ovsdb_idl_txn *txn,
+                       const struct ovsrec_system *system_row)
+{
+    size_t n_changed = 0;
+
+    if (defaults == NULL) {
+        return 0;
+    }
+
+    n_changed += qos_reconcile_cos_map(writes, defaults, system_row);
+    n_changed += qos_reconcile_dscp_map(writes, defaults, system_row);
+    n_changed += qos_reconcile_queue_profiles(idl, txn, defaults);
+    n_changed += qos_reconcile_schedule_profiles(idl, txn, defaults);
+
+    return n_changed;
+}
+
+/**
+ * Returns the name of the profiles that start out as copies of the factory
+ * default profiles.
+ */
+static const char *
+qos_default_profile_name(const struct qos_defaults *defaults)
+{
+    return defaults ? defaults->info.default_name : QOS_DEFAULT_NAME;
+}
+
+/**
+ * Sets the qos trust of system_row back to its factory default. Returns the
+ * number of rows rewritten.
+ */
+static size_t
+qos_restore_trust(struct sysd_write_stats *writes,
+                  const struct qos_defaults *defaults,
+                  const struct ovsrec_system *system_row)
+{
+    struct smap smap;
+    bool changed;
+
+    if (defaults == NULL || defaults->info.trust == NULL) {
+        return 0;
+    }
+
+    smap_clone(&smap, &system_row->qos_config);
+    smap_replace(&smap, QOS_TRUST_KEY, defaults->info.trust);
+    changed = sysd_write_smap(writes, &system_row->header_,
+                              &ovsrec_system_col_qos_config, &smap);
+    smap_destroy(&smap);
+
+    return changed;
+}
+
+/**
+ * Parses the integer saved under key in hw_defaults into *value. Returns
+ * false if there is none.
+ */
+static bool
+qos_hw_default_int(const struct smap *hw_defaults, const char *key,
+                   int64_t *value)
+{
+    const char *s = smap_get(hw_defaults, key);
+    long long int ll;
+
+    if (s == NULL || !str_to_llong(s, 10, &ll)) {
+        return false;
+    }
+    *value = ll;
+    return true;
+}
+
+/**
+ * Sets the live values of a cos map entry back to those saved in its
+ * hw_defaults. Returns true if the row was rewritten.
+ */
+static bool
+qos_restore_cos_map_entry(struct sysd_write_stats *writes,
+                          const struct ovsrec_qos_cos_map_entry *row)
+{
+    const char *color = smap_get(&row->hw_defaults, QOS_DEFAULT_COLOR_KEY);
+    const char *description = smap_get(&row->hw_defaults,
+                                        QOS_DEFAULT_DESCRIPTION_KEY);
+    int64_t local_priority;
+    bool changed = false;
+
+    if (qos_hw_default_int(&row->hw_defaults, QOS_DEFAULT_LOCAL_PRIORITY_KEY,
+                           &local_priority)) {
+        changed |= sysd_write_integer(
+                writes, &row->header_,
+                &ovsrec_qos_cos_map_entry_col_local_priority,
+                local_priority);
     }
+    if (color) {
+        changed |= sysd_write_string(writes, &row->header_,
+                                     &ovsrec_qos_cos_map_entry_col_color,
+                                     color);
+    }
+    if (description) {
+        changed |= sysd_write_string(
+                writes, &row->header_,
+                &ovsrec_qos_cos_map_entry_col_description,
+                description);
+    }
+
+    return changed;
+}
+
+/**
+ * Sets the live values of a dscp map entry back to those saved in its
+ * hw_defaults. Returns true if the row was rewritten.
+ */
+static bool
+qos_restore_dscp_map_entry(struct sysd_write_stats *writes,
+                           const struct ovsrec_qos_dscp_map_entry *row)
+{
+    const char *color = smap_get(&row->hw_defaults, QOS_DEFAULT_COLOR_KEY);
+    const char *description = smap_get(&row->hw_defaults,
+                                        QOS_DEFAULT_DESCRIPTION_KEY);
+    int64_t local_priority;
+    bool changed = false;
+
+    if (qos_hw_default_int(&row->hw_defaults, QOS_DEFAULT_LOCAL_PRIORITY_KEY,
+                           &local_priority)) {
+        changed |= sysd_write_integer(
+                writes, &row->header_,
+                &ovsrec_qos_dscp_map_entry_col_local_priority,
+                local_priority);
+    }
+#ifdef QOS_CAPABILITY_DSCP_MAP_COS_REMARK_DISABLED
+    /* Disabled for dill. */
+#else
+    int64_t priority_code_point;
+
+    if (qos_hw_default_int(&row->hw_defaults,
+                           QOS_DEFAULT_PRIORITY_CODE_POINT_KEY,
+                           &priority_code_point)) {
+        changed |= sysd_write_integers(
+                writes, &row->header_,
+                &ovsrec_qos_dscp_map_entry_col_priority_code_point,
+                &priority_code_point, 1);
+    }
+#endif
+    if (color) {
+        changed |= sysd_write_string(writes, &row->header_,
+                                     &ovsrec_qos_dscp_map_entry_col_color,
+                                     color);
+    }
+    if (description) {
+        changed |= sysd_write_string(
+                writes, &row->header_,
+                &ovsrec_qos_dscp_map_entry_col_description,
+                description);
+    }
+
+    return changed;
+}
+
+/**
+ * Returns the queue profile marked as the hardware default, or NULL.
+ */
+static const struct ovsrec_q_profile *
+qos_find_hw_default_queue_profile_row(struct ovsdb_idl *idl)
+{
+    const struct ovsrec_q_profile *row;
+
+    OVSREC_Q_PROFILE_FOR_EACH (row, idl) {
+        if (row->n_hw_default && row->hw_default[0]) {
+            return row;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Returns the schedule profile marked as the hardware default, or NULL.
+ */
+static const struct ovsrec_qos *
+qos_find_hw_default_schedule_profile_row(struct ovsdb_idl *idl)
+{
+    const struct ovsrec_qos *row;
+
+    OVSREC_QOS_FOR_EACH (row, idl) {
+        if (row->n_hw_default && row->hw_default[0]) {
+            return row;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Makes the queue profile named profile_name a copy of the hardware default
+ * queue profile again. Returns NULL and adds the number of rows rewritten
+ * to *n_changed on success, otherwise a malloc()'d error message.
+ */
+static char *
+qos_restore_queue_profile(struct ovsdb_idl *idl, struct ovsdb_idl_txn *txn,
+                          const char *profile_name, size_t *n_changed)
+{
+    const struct ovsrec_q_profile *factory_row, *row;
+    struct qos_profile_builder builder;
+    struct qos_queue_profile *factory;
+
+    factory_row = qos_find_hw_default_queue_profile_row(idl);
+    if (factory_row == NULL) {
+        return xstrdup("no hardware default queue profile");
+    }
+    row = qos_find_queue_profile_row(idl, profile_name);
+    if (row == NULL) {
+        return xasprintf("no queue profile named %s", profile_name);
+    }
+    if (row == factory_row) {
+        return NULL;
+    }
+
+    qos_profile_builder_init(&builder);
+    factory = qos_builder_load_queue_profile(&builder, factory_row->name,
+                                             factory_row);
+    *n_changed += qos_update_queue_profile_row(txn, row, factory);
+    qos_profile_builder_destroy(&builder);
+
+    return NULL;
+}
+
+/**
+ * Makes the schedule profile named profile_name a copy of the hardware
+ * default schedule profile again. Returns NULL and adds the number of rows
+ * rewritten to *n_changed on success, otherwise a malloc()'d error message.
+ */
+static char *
+qos_restore_schedule_profile(struct ovsdb_idl *idl, struct ovsdb_idl_txn *txn,
+                             const char *profile_name, size_t *n_changed)
+{
+    const struct ovsrec_qos *factory_row, *row;
+    struct qos_profile_builder builder;
+    struct qos_schedule_profile *factory;
+
+    factory_row = qos_find_hw_default_schedule_profile_row(idl);
+    if (factory_row == NULL) {
+        return xstrdup("no hardware default schedule profile");
+    }
+    row = qos_find_schedule_profile_row(idl, profile_name);
+    if (row == NULL) {
+        return xasprintf("no schedule profile named %s", profile_name);
+    }
+    if (row == factory_row) {
+        return NULL;
+    }
+
+    qos_profile_builder_init(&builder);
+    factory = qos_builder_load_schedule_profile(&builder, factory_row->name,
+                                                factory_row);
+    *n_changed += qos_update_schedule_profile_row(txn, row, factory);
+    qos_profile_builder_destroy(&builder);
+
+    return NULL;
+}
+
+/**
+ * Points system_row back at the default queue and schedule profiles.
+ * Returns the number of rows rewritten.
+ */
+static size_t
+qos_restore_system_profiles(struct ovsdb_idl *idl,
+                            const struct qos_defaults *defaults,
+                            const struct ovsrec_system *system_row)
+{
+    const char *name = qos_default_profile_name(defaults);
+    const struct ovsrec_q_profile *q_profile;
+    const struct ovsrec_qos *qos;
+    bool changed = false;
+
+    q_profile = qos_find_queue_profile_row(idl, name);
+    if (q_profile && system_row->q_profile != q_profile) {
+        ovsrec_system_set_q_profile(system_row, q_profile);
+        changed = true;
+    }
+    qos = qos_find_schedule_profile_row(idl, name);
+    if (qos && system_row->qos != qos) {
+        ovsrec_system_set_qos(system_row, qos);
+        changed = true;
+    }
+
+    return changed;
+}
+
+/**
+ * Restores QoS state to factory defaults in txn, writing only rows whose
+ * values differ. target is one of:
+ *
+ *   "trust"            - System qos trust.
+ *   "cos-map"          - every cos map entry, from its hw_defaults.
+ *   "dscp-map"         - every dscp map entry, from its hw_defaults.
+ *   "queue-profile"    - the queue profile named profile_name (the default
+ *                        profile if NULL), from the hw_default profile.
+ *   "schedule-profile" - likewise for the schedule profile.
+ *   "all"              - all of the above for the default profiles, and
+ *                        System pointed back at the default profiles.
+ *
+ * Returns NULL and stores the number of rows rewritten in *n_changed on
+ * success, otherwise a malloc()'d error message.
+ */
+char *
+qos_restore_defaults(struct sysd_write_stats *writes,
+                     struct ovsdb_idl *idl,
+                     const struct qos_defaults *defaults,
+                     struct ovsdb_idl_txn *txn,
+                     const struct ovsrec_system *system_row,
+                     const char *target, const char *profile_name,
+                     size_t *n_changed)
+{
+    bool all = !strcmp(target, "all");
+    char *error = NULL;
+    size_t i;
+
+    *n_changed = 0;
+
+    if (!all && strcmp(target, "trust") && strcmp(target, "cos-map")
+        && strcmp(target, "dscp-map") && strcmp(target, "queue-profile")
+        && strcmp(target, "schedule-profile")) {
+        return xasprintf("unknown target %s", target);
+    }
+    if (profile_name == NULL || all) {
+        profile_name = qos_default_profile_name(defaults);
+    }
+
+    if (all || !strcmp(target, "trust")) {
+        *n_changed += qos_restore_trust(writes, defaults, system_row);
+    }
+
+    if (all || !strcmp(target, "cos-map")) {
+        for (i = 0; i < system_row->n_qos_cos_map_entries; i++) {
+            if (qos_restore_cos_map_entry(
+                    writes, system_row->qos_cos_map_entries[i])) {
+                (*n_changed)++;
+            }
+        }
+    }
+    if (all || !strcmp(target, "dscp-map")) {
+        for (i = 0; i < system_row->n_qos_dscp_map_entries; i++) {
+            if (qos_restore_dscp_map_entry(
+                    writes, system_row->qos_dscp_map_entries[i])) {
+                (*n_changed)++;
+            }
+        }
+    }
+    if (all || !strcmp(target, "queue-profile")) {
+        error = qos_restore_queue_profile(idl, txn, profile_name, n_changed);
+    }
+    if (!error && (all || !strcmp(target, "schedule-profile"))) {
+        error = qos_restore_schedule_profile(idl, txn, profile_name,
+                                             n_changed);
+    }
+    if (!error && all) {
+        *n_changed += qos_restore_system_profiles(idl, defaults, system_row);
+    }
+
+    return error;
 }
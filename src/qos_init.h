@@ -23,38 +23,101 @@
 #include <stdlib.h>
 #include <sys/types.h>
 
+#include <hmap.h>
 #include <smap.h>
 #include <util.h>
 #include <vswitch-idl.h>
 
+struct qos_defaults;
+struct sysd_write_stats;
+
+/**
+ * Assembles queue and schedule profiles in local hash maps, keyed by profile
+ * name and then by queue number, so that every IDL column is written exactly
+ * once when the profiles are committed.
+ */
+struct qos_profile_builder {
+    struct hmap queue_profiles;     /* Contains "struct qos_queue_profile"s. */
+    struct hmap schedule_profiles;  /* Contains "struct qos_schedule_profile"s. */
+};
+
+void qos_profile_builder_init(struct qos_profile_builder *builder);
+void qos_profile_builder_destroy(struct qos_profile_builder *builder);
+
+void qos_profile_builder_add_queue_profile(struct qos_profile_builder *builder,
+        const char *profile_name, bool hw_default);
+void qos_profile_builder_add_queue(struct qos_profile_builder *builder,
+        const char *profile_name, int64_t queue_num, int64_t local_priority,
+        const char *description);
+
+void qos_profile_builder_add_schedule_profile(
+        struct qos_profile_builder *builder, const char *profile_name,
+        bool hw_default);
+void qos_profile_builder_add_schedule(struct qos_profile_builder *builder,
+        const char *profile_name, int64_t queue_num, const char *algorithm,
+        int64_t weight);
+
+/**
+ * Inserts all assembled profiles and their entries into txn.
+ */
+void qos_profile_builder_commit(struct qos_profile_builder *builder,
+        struct ovsdb_idl_txn *txn);
+
+struct ovsrec_q_profile *qos_profile_builder_get_queue_profile_row(
+        struct qos_profile_builder *builder, const char *profile_name);
+struct ovsrec_qos *qos_profile_builder_get_schedule_profile_row(
+        struct qos_profile_builder *builder, const char *profile_name);
+
 /**
- * Initializes factory default qos trust settings in ovsdb.
+ * Initializes factory default qos trust settings in ovsdb.  The qos_init_*()
+ * functions take the defaults from qos_defaults_get() and do nothing if they
+ * are NULL.  Those that go through sysd_write_*() count their writes in
+ * writes.
  */
-void qos_init_trust(struct ovsdb_idl_txn *txn,
+void qos_init_trust(struct sysd_write_stats *writes,
+        const struct qos_defaults *defaults, struct ovsdb_idl_txn *txn,
         struct ovsrec_system *system_row);
 
 /**
  * Initializes factory default qos cos map settings in ovsdb.
  */
-void qos_init_cos_map(struct ovsdb_idl_txn *txn,
-        struct ovsrec_system *system_row);
+void qos_init_cos_map(const struct qos_defaults *defaults,
+        struct ovsdb_idl_txn *txn, struct ovsrec_system *system_row);
 
 /**
  * Initializes factory default qos dscp map settings in ovsdb.
  */
-void qos_init_dscp_map(struct ovsdb_idl_txn *txn,
-        struct ovsrec_system *system_row);
+void qos_init_dscp_map(const struct qos_defaults *defaults,
+        struct ovsdb_idl_txn *txn, struct ovsrec_system *system_row);
 
 /**
  * Initializes factory default qos queue profile settings in ovsdb.
  */
-void qos_init_queue_profile(struct ovsdb_idl_txn *txn,
-        struct ovsrec_system *system_row);
+void qos_init_queue_profile(const struct qos_defaults *defaults,
+        struct ovsdb_idl_txn *txn, struct ovsrec_system *system_row);
 
 /**
  * Initializes factory default qos schedule profile settings in ovsdb.
  */
-void qos_init_schedule_profile(struct ovsdb_idl_txn *txn,
-        struct ovsrec_system *system_row);
+void qos_init_schedule_profile(const struct qos_defaults *defaults,
+        struct ovsdb_idl_txn *txn, struct ovsrec_system *system_row);
+
+/**
+ * Applies changed factory defaults to the qos rows of an existing database,
+ * keeping user changes. Returns the number of rows rewritten.
+ */
+size_t qos_reconcile_defaults(struct sysd_write_stats *writes,
+        struct ovsdb_idl *idl, const struct qos_defaults *defaults,
+        struct ovsdb_idl_txn *txn, const struct ovsrec_system *system_row);
+
+/**
+ * Restores "all" QoS state, or just the "trust", "cos-map", "dscp-map",
+ * "queue-profile" or "schedule-profile" target, to factory defaults in
+ * txn. Returns NULL on success, otherwise a malloc()'d error message.
+ */
+char *qos_restore_defaults(struct sysd_write_stats *writes,
+        struct ovsdb_idl *idl, const struct qos_defaults *defaults,
+        struct ovsdb_idl_txn *txn, const struct ovsrec_system *system_row,
+        const char *target, const char *profile_name, size_t *n_changed);
 
 #endif /* _QOS_INIT_H_ */
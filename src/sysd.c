@@ -36,208 +36,351 @@
 #include <daemon.h>
 #include <fatal-signal.h>
 #include <dynamic-string.h>
+#include <timeval.h>
 
 #include <ops-utils.h>
 #include <config-yaml.h>
 #include "sysd_cfg_yaml.h"
 #include "sysd.h"
+#include "sysd_ctx.h"
 #include "sysd_util.h"
 #include "sysd_ovsdb_if.h"
+#include "sysd_dump.h"
+#include "sysd_emit.h"
+#include "sysd_replay.h"
+#include "sysd_txn.h"
+#include "sysd_txn_stats.h"
+#include "sysd_write.h"
+#include "sysd_loop_stats.h"
+#include "sysd_metrics.h"
+#include "sysd_trace.h"
+#include "sysd_mem.h"
+#include "qos_defaults.h"
+#include "qos_init.h"
 
 #include "eventlog.h"
-#include "diag_dump.h"
 
 VLOG_DEFINE_THIS_MODULE(ops_sysd);
 
 /** @ingroup ops-sysd
  * @{ */
 
-#define BUF_LEN 16000
-#define MAX_ERR_STR_LEN 255
-
-/* OVSDB IDL used to obtain configuration. */
-struct ovsdb_idl *idl;
-uint32_t         idl_seqno = 0;
-int              num_subsystems = 0;
-sysd_subsystem_t **subsystems = NULL;
-
-char *g_hw_desc_dir = "/";
-char *g_hw_desc_link = "/";
-
-daemon_info_t **daemons = NULL;
-int num_daemons = 0;
-int num_hw_daemons = 0;
-
-/* Structure to store management info read */
-mgmt_intf_info_t *mgmt_intf = NULL;
+/* The appctl command diag-dump runs to collect sysd's basic dump.
+ * INIT_DIAG_DUMP_BASIC() would register it with a callback that gets no
+ * aux, so sysd registers it itself with the context as aux. */
+#define SYSD_DIAG_DUMP_BASIC_CMD "diag-dump/basic"
 
 /*
- * Function       : sysd_diag_dump_basic_cb
- * Responsibility : callback handler function for diagnostic dump basic
- *                  it allocates memory as per requirment and populates data.
- *                  INIT_DIAG_DUMP_BASIC will free allocated memory.
- * Parameters     : feature name string, buffer ptr
+ * Function       : sysd_unixctl_diag_dump_basic
+ * Responsibility : replies with the basic diagnostic dump of the context
+ * Parameters     : [feature name]
  * Returns        : void
  */
-
 static void
-sysd_diag_dump_basic_cb(const char *feature , char **buf)
+sysd_unixctl_diag_dump_basic(struct unixctl_conn *conn, int argc,
+                             const char *argv[], void *ctx_)
 {
-    if (!buf)
-        return;
-    *buf =  xcalloc(1, BUF_LEN);
-    if (*buf) {
-        /* populate basic diagnostic data to buffer  */
-        sysd_dump(*buf, BUF_LEN);
-        VLOG_DBG("basic diag-dump data populated for feature %s",
-                feature);
-    } else{
-        VLOG_ERR("Memory allocation failed for feature %s, %d bytes",
-                feature, BUF_LEN);
-    }
-}
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    /* populate basic diagnostic data to buffer  */
+    sysd_dump(ctx_, &ds, SYSD_DUMP_ALL_SECTIONS, SYSD_DUMP_TEXT);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
+    VLOG_DBG("basic diag-dump data populated for feature %s",
+             argc > 1 ? argv[1] : "sysd");
+
+} /* sysd_unixctl_diag_dump_basic */
 
 /* Dumps debug data for entire daemon */
 static void
-sysd_unixctl_dump(struct unixctl_conn *conn, int argc OVS_UNUSED,
-                          const char *argv[] OVS_UNUSED, void *aux OVS_UNUSED)
+sysd_unixctl_dump(struct unixctl_conn *conn, int argc,
+                          const char *argv[], void *ctx_)
 {
-    char err_str[MAX_ERR_STR_LEN];
-    char *buf = xcalloc(1, BUF_LEN);
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    enum sysd_dump_format format;
+    unsigned int sections;
+    char *error;
+
+    error = sysd_dump_parse_args(argc, argv, &sections, &format);
+    if (error) {
+        unixctl_command_reply_error(conn, error);
+        free(error);
+        return;
+    }
 
     /* Dump the daemon info */
-    if (buf){
-        strcpy(buf, "Support Dump for Platform SYS Daemon (ops-sysd)\n\n");
-        sysd_dump(buf, BUF_LEN);
-        unixctl_command_reply(conn, buf);
-        free(buf);
-    } else {
-        snprintf(err_str, sizeof(err_str),
-                "sysd daemon failed to allocate %d bytes\n", BUF_LEN);
-        unixctl_command_reply(conn, err_str);
+    if (format == SYSD_DUMP_TEXT) {
+        ds_put_cstr(&ds, "Support Dump for Platform SYS Daemon (ops-sysd)\n\n");
     }
+    sysd_dump(ctx_, &ds, sections, format);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
 } /* sysd_unixctl_dump */
 
-static int
-sysd_get_subsystem_info(void)
+/* A QoS restore waiting for its transaction. */
+struct sysd_qos_restore {
+    struct sysd_ctx *ctx;
+    struct unixctl_conn *conn;
+    char *target;
+    char *profile_name;
+    char *error;                /* From the last build. */
+};
+
+static size_t
+sysd_qos_restore_build(struct ovsdb_idl_txn *txn, void *restore_)
 {
-    int       i = 0;
-    int       rc = 0;
-
-    sysd_subsystem_t    *ptr;
-
-    /* OPS_TODO: Will need to implement mechanism to locate
-     *           the hardware description files for this system
-     *           and all defined subsystems for this system.
-     *           For now, just assume pizza box. */
+    struct sysd_qos_restore *restore = restore_;
+    struct sysd_ctx *ctx = restore->ctx;
+    const struct ovsrec_system *sys = ovsrec_system_first(ctx->idl);
+    size_t n_changed = 0;
+
+    free(restore->error);
+    restore->error = NULL;
+    if (sys == NULL) {
+        restore->error = xstrdup("System row is not available yet");
+        return 0;
+    }
 
-    num_subsystems = 1;
+    restore->error = qos_restore_defaults(&ctx->txns.writes, ctx->idl,
+                                          qos_defaults_get(ctx), txn, sys,
+                                          restore->target,
+                                          restore->profile_name, &n_changed);
+    return restore->error ? 0 : n_changed;
+}
 
-    subsystems = (sysd_subsystem_t **) calloc(num_subsystems, sizeof(sysd_subsystem_t *));
-    if (subsystems == (sysd_subsystem_t **)NULL) {
-        VLOG_ERR("Unable to allocate memory for subsystems, terminating");
-        return -1;
+static void
+sysd_qos_restore_done(enum ovsdb_idl_txn_status status, size_t n_changed,
+                      void *restore_)
+{
+    struct sysd_qos_restore *restore = restore_;
+    char *reply = NULL;
+
+    if (restore->error) {
+        unixctl_command_reply_error(restore->conn, restore->error);
+    } else if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        reply = xasprintf("Failed to restore QoS factory defaults (%s)",
+                          ovsdb_idl_txn_status_to_string(status));
+        unixctl_command_reply_error(restore->conn, reply);
+    } else {
+        const char *rows = n_changed == 1 ? "row" : "rows";
+
+        VLOG_INFO("Restored QoS factory defaults (%s), %"PRIuSIZE" %s",
+                  restore->target, n_changed, rows);
+        reply = xasprintf("Restored factory defaults for %s: "
+                          "%"PRIuSIZE" %s updated\n", restore->target,
+                          n_changed, rows);
+        unixctl_command_reply(restore->conn, reply);
     }
+    free(reply);
+    free(restore->target);
+    free(restore->profile_name);
+    free(restore->error);
+    free(restore);
+}
 
-    for (i = 0; i < num_subsystems; i++) {
-        subsystems[i] = (sysd_subsystem_t *) calloc(1, sizeof(sysd_subsystem_t));
-        if (subsystems[i] == (sysd_subsystem_t *)NULL) {
-            VLOG_ERR("Unable to allocate memory for subsystems, terminating");
-            return -1;
-        }
-    }
+/*
+ * Function       : sysd_unixctl_qos_restore_defaults
+ * Responsibility : restores all QoS state, or one map or profile, to the
+ *                  factory defaults in a single transaction that touches
+ *                  only the rows that differ.  Replies once the
+ *                  transaction completes.
+ * Parameters     : [all|trust|cos-map|dscp-map|queue-profile [NAME]|
+ *                  schedule-profile [NAME]]
+ * Returns        : void
+ */
+static void
+sysd_unixctl_qos_restore_defaults(struct unixctl_conn *conn, int argc,
+                                  const char *argv[], void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+    struct sysd_qos_restore *restore = NULL;
 
-    rc = sysd_read_fru_eeprom(&(subsystems[0]->fru_eeprom));
-    if (rc) {
-        VLOG_ERR("Failed to read FRU data from base system.");
-        log_event("SYS_FRU_DATA_READ_FAILURE", NULL);
-        return -1;
+    if (ovsrec_system_first(ctx->idl) == NULL) {
+        unixctl_command_reply_error(conn, "System row is not available yet");
+        return;
     }
 
-    /* Store information about BASE subsystem. */
-    ptr = subsystems[0];
-    strncpy(ptr->name, SYSD_BASE_SUBSYSTEM, MAX_SUBSYSTEM_NAME_LEN);
-    ptr->type = SYSD_SUBSYSTEM_TYPE_SYSTEM;
+    restore = xzalloc(sizeof *restore);
+    restore->ctx = ctx;
+    restore->conn = conn;
+    restore->target = xstrdup(argc > 1 ? argv[1] : "all");
+    restore->profile_name = argc > 2 ? xstrdup(argv[2]) : NULL;
+    sysd_txn_submit(&ctx->txns, SYSD_TXN_QOS_RESTORE, sysd_qos_restore_build,
+                    sysd_qos_restore_done, restore);
 
-    ptr->num_free_macs = ptr->fru_eeprom.num_macs;
-    ptr->nxt_mac_addr = ops_char_array_to_ulong_long(ptr->fru_eeprom.base_mac_address, ETH_ALEN);
+} /* sysd_unixctl_qos_restore_defaults */
 
-    if (ptr->num_free_macs > 0) {
-        /* Save first MAC as the mgmt i/f MAC for the system */
-        ptr->mgmt_mac_addr = ptr->nxt_mac_addr;
-        ptr->num_free_macs--;
-        ptr->nxt_mac_addr++;
-    }
+/*
+ * Function       : sysd_unixctl_txn_stats
+ * Responsibility : reports OVSDB commit latency, size and failure
+ *                  statistics per call site, optionally resetting them
+ * Parameters     : [reset]
+ * Returns        : void
+ */
+static void
+sysd_unixctl_txn_stats(struct unixctl_conn *conn, int argc,
+                       const char *argv[], void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+    struct ds ds = DS_EMPTY_INITIALIZER;
 
-    if (ptr->num_free_macs > 0) {
-        /* Save second MAC as the system MAC */
-        ptr->system_mac_addr = ptr->nxt_mac_addr;
-        ptr->num_free_macs--;
-        ptr->nxt_mac_addr++;
+    if (argc > 1 && strcmp(argv[1], "reset")) {
+        unixctl_command_reply_error(conn, "Usage: ops-sysd/txn-stats [reset]");
+        return;
     }
 
-    return 0;
+    sysd_txn_stats_format(&ctx->txns.stats, &ds);
+    ds_put_char(&ds, '\n');
+    sysd_txn_format(&ctx->txns, &ds);
+    ds_put_char(&ds, '\n');
+    sysd_write_format(&ctx->txns.writes, &ds);
+    if (argc > 1) {
+        sysd_txn_stats_reset(&ctx->txns.stats);
+        sysd_write_reset(&ctx->txns.writes);
+        ds_put_cstr(&ds, "\nStatistics reset.\n");
+    }
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
 
-} /* sysd_get_subsystem_info() */
+} /* sysd_unixctl_txn_stats */
 
-static int
-sysd_get_interface_info(void)
+/*
+ * Function       : sysd_unixctl_loop_stats
+ * Responsibility : reports main loop stage timings and stalls, optionally
+ *                  resetting them or changing the stall threshold
+ * Parameters     : [reset|stall-threshold MSEC]
+ * Returns        : void
+ */
+static void
+sysd_unixctl_loop_stats(struct unixctl_conn *conn, int argc,
+                        const char *argv[], void *ctx_)
 {
-    int         idx = 0;
-    int         intf_count = 0;
+    struct sysd_ctx *ctx = ctx_;
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    int msec;
+
+    if (argc == 3 && !strcmp(argv[1], "stall-threshold")) {
+        if (!str_to_int(argv[2], 10, &msec) || msec <= 0) {
+            unixctl_command_reply_error(conn, "Invalid stall threshold");
+            return;
+        }
+        sysd_loop_set_stall_threshold(&ctx->loop, msec);
+        ds_put_format(&ds, "Stall threshold set to %d ms\n", msec);
+    } else if (argc == 2 && !strcmp(argv[1], "reset")) {
+        sysd_loop_stats_format(&ctx->loop, &ds);
+        sysd_loop_stats_reset(&ctx->loop);
+        ds_put_cstr(&ds, "\nStatistics reset.\n");
+    } else if (argc == 1) {
+        sysd_loop_stats_format(&ctx->loop, &ds);
+    } else {
+        unixctl_command_reply_error(conn, "Usage: ops-sysd/loop-stats "
+                                    "[reset|stall-threshold MSEC]");
+        return;
+    }
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
 
-    sysd_intf_info_t            **interfaces = NULL;
-    sysd_intf_cmn_info_t        *intf_cmn_info = NULL;
-    sysd_subsystem_t            *ptr;
+} /* sysd_unixctl_loop_stats */
 
-    /* Get interface related global info. */
-    intf_cmn_info = sysd_cfg_yaml_get_port_subsys_info();
-    if (intf_cmn_info == (sysd_intf_cmn_info_t *)NULL) {
-        VLOG_ERR("Failed to get interface sub-system info.");
-        return -1;
-    }
+/*
+ * Function       : sysd_unixctl_metrics
+ * Responsibility : reports sysd's metrics in the OpenMetrics text format
+ * Parameters     : none
+ * Returns        : void
+ */
+static void
+sysd_unixctl_metrics(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                     const char *argv[] OVS_UNUSED, void *ctx_)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
 
-    intf_count = sysd_cfg_yaml_get_port_count();
-    if (intf_count <= 0) {
-        VLOG_ERR("Unable to get interface count from YAML files.");
-        return -1;
-    }
+    sysd_metrics_render(ctx_, &ds);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
 
-    /* Allocate memory for 'intf_count' number of sysd_intf_info_t pointers. */
-    interfaces = (sysd_intf_info_t **) calloc(intf_count, sizeof(sysd_intf_info_t *));
-    if (interfaces == (sysd_intf_info_t **)NULL) {
-        VLOG_ERR("Failed to allocate memory for interface strcture.");
-        log_event("SYS_ALLOCATE_MEMORY_FAILURE", EV_KV("value",
-            "%s", "interface structure"));
-        return -1;
-    }
+} /* sysd_unixctl_metrics */
 
-    /* Get info for each interface. */
-    for (idx = 0 ; idx < intf_count; idx++) {
-        interfaces[idx] = sysd_cfg_yaml_get_port_info(idx);
-        if (NULL == interfaces[idx]) {
-            VLOG_ERR("Unable to get interface info for interface index %d", idx);
-            return -1;
+/*
+ * Function       : sysd_unixctl_trace
+ * Responsibility : turns the trace ring on or off, saves it to a file, or
+ *                  reports its state
+ * Parameters     : [on|off|save FILE]
+ * Returns        : void
+ */
+static void
+sysd_unixctl_trace(struct unixctl_conn *conn, int argc,
+                   const char *argv[], void *ctx_)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+    int error;
+
+    if (argc == 3 && !strcmp(argv[1], "save")) {
+        error = sysd_trace_save(ctx_, argv[2]);
+        if (error) {
+            ds_put_format(&ds, "%s: %s", argv[2], ovs_strerror(error));
+            unixctl_command_reply_error(conn, ds_cstr(&ds));
+            ds_destroy(&ds);
+            return;
         }
+        ds_put_format(&ds, "Trace saved to %s\n", argv[2]);
+    } else if (argc == 2 && !strcmp(argv[1], "on")) {
+        sysd_trace_enable(true);
+    } else if (argc == 2 && !strcmp(argv[1], "off")) {
+        sysd_trace_enable(false);
+    } else if (argc != 1) {
+        unixctl_command_reply_error(conn, "Usage: ops-sysd/trace "
+                                    "[on|off|save FILE]");
+        return;
     }
+    sysd_trace_format(&ds);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
 
-    /* OPS_TODO: Enhance the code to support multiple subsystems. */
-    ptr = subsystems[0];
-    ptr->intf_count = intf_count;
-    ptr->intf_cmn_info = intf_cmn_info;
-    ptr->interfaces = interfaces;
+} /* sysd_unixctl_trace */
 
-    return 0;
+/*
+ * Function       : sysd_unixctl_reload_manifest
+ * Responsibility : re-reads image.manifest and updates the Daemon table
+ * Parameters     : none
+ * Returns        : void
+ */
+static void
+sysd_unixctl_reload_manifest(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                             const char *argv[] OVS_UNUSED, void *ctx_)
+{
+    /* Replies once the transaction completes. */
+    sysd_reload_manifest(ctx_, conn);
+
+} /* sysd_unixctl_reload_manifest */
+
+/*
+ * Function       : sysd_unixctl_memory
+ * Responsibility : reports sysd's own allocations per category and the
+ *                  estimated size of the IDL replica
+ * Parameters     : none
+ * Returns        : void
+ */
+static void
+sysd_unixctl_memory(struct unixctl_conn *conn, int argc OVS_UNUSED,
+                    const char *argv[] OVS_UNUSED, void *ctx_)
+{
+    struct ds ds = DS_EMPTY_INITIALIZER;
+
+    sysd_mem_format(&ds);
+    ds_put_char(&ds, '\n');
+    sysd_ovsdb_memory_format(ctx_, &ds);
+    unixctl_command_reply(conn, ds_cstr(&ds));
+    ds_destroy(&ds);
 
-} /* sysd_get_interface_info */
+} /* sysd_unixctl_memory */
 
 static int
-sysd_find_hw_desc_files(void)
+sysd_find_hw_desc_files(struct sysd_ctx *ctx)
 {
     int rc = 0;
 
     /* Locate manufacturer/product_name */
-    rc = sysd_create_link_to_hwdesc_files();
+    rc = sysd_create_link_to_hwdesc_files(ctx);
     if (rc) {
         VLOG_ERR("Unable to determine manufacturer/product_name"
                  "for this platform");
@@ -247,75 +390,6 @@ sysd_find_hw_desc_files(void)
 
 } /* sysd_find_hw_desc_files() */
 
-void
-sysd_ovsdb_conn_init(char *remote)
-{
-    /* Create connection to database. */
-    idl = ovsdb_idl_create(remote, &ovsrec_idl_class, false, true);
-    idl_seqno = ovsdb_idl_get_seqno(idl);
-    ovsdb_idl_set_lock(idl, "ops_sysd");
-
-    ovsdb_idl_add_table(idl, &ovsrec_table_system);
-    ovsdb_idl_add_column(idl, &ovsrec_system_col_subsystems);
-    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_subsystems);
-    ovsdb_idl_add_column(idl, &ovsrec_system_col_cur_hw);
-    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_cur_hw);
-    ovsdb_idl_add_column(idl, &ovsrec_system_col_next_hw);
-    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_next_hw);
-    ovsdb_idl_add_column(idl, &ovsrec_system_col_software_info);
-    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_software_info);
-    ovsdb_idl_add_column(idl, &ovsrec_system_col_switch_version);
-    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_switch_version);
-
-    ovsdb_idl_add_table(idl, &ovsrec_table_subsystem);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_name);
-    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_name);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_asset_tag_number);
-    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_asset_tag_number);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_hw_desc_dir);
-    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_hw_desc_dir);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_other_config);
-    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_other_config);
-    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_interfaces);
-    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_interfaces);
-
-    ovsdb_idl_add_table(idl, &ovsrec_table_interface);
-    ovsdb_idl_add_column(idl, &ovsrec_interface_col_name);
-    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_name);
-    ovsdb_idl_add_column(idl, &ovsrec_interface_col_hw_intf_info);
-    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_hw_intf_info);
-    ovsdb_idl_add_column(idl, &ovsrec_interface_col_type);
-    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_type);
-    ovsdb_idl_add_column(idl, &ovsrec_interface_col_user_config);
-    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_user_config);
-
-    /* Daemon Table */
-    ovsdb_idl_add_table(idl, &ovsrec_table_daemon);
-    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_name);
-    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_cur_hw);
-    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_is_hw_handler);
-    ovsdb_idl_omit_alert(idl, &ovsrec_daemon_col_is_hw_handler);
-
-    /* Management Interface Column*/
-    ovsdb_idl_add_column(idl, &ovsrec_system_col_mgmt_intf);
-
-    /* Package_Info Table */
-    ovsdb_idl_add_table(idl, &ovsrec_table_package_info);
-    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_name);
-    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_name);
-    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_src_type);
-    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_src_type);
-    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_src_url);
-    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_src_url);
-    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_version);
-    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_version);
-
-    INIT_DIAG_DUMP_BASIC(sysd_diag_dump_basic_cb);
-
-    return;
-
-} /* sysd_ovsdb_conn_init */
-
 static void
 usage(void)
 {
@@ -328,17 +402,39 @@ usage(void)
     vlog_usage();
     printf("\nOther options:\n"
            "  --unixctl=SOCKET        override default control socket name\n"
-           "  -h, --help              display this help message\n");
+           "  --metrics-socket=PATH   serve OpenMetrics text on Unix socket PATH\n"
+           "  --trace                 record tracepoints from startup\n"
+           "  --watch-manifest        reload image.manifest when it changes\n"
+           "  --initial-txn-file=FILE record and replay the initial\n"
+           "                          configuration in FILE (default: %s)\n"
+           "  --no-initial-txn-file   always build the initial configuration\n"
+           "  --emit-db=FILE          write the initial configuration for\n"
+           "                          --hw-desc-dir to FILE as an OVSDB\n"
+           "                          transaction, with per-box values left\n"
+           "                          as placeholders, and exit\n"
+           "  --hw-desc-dir=DIR       hardware description for --emit-db\n"
+           "  -h, --help              display this help message\n",
+           INITIAL_TXN_FILE_PATH);
     exit(EXIT_SUCCESS);
 
 } /* usage */
 
 static char *
-parse_options(int argc, char *argv[], char **unixctl_pathp)
+parse_options(int argc, char *argv[], char **unixctl_pathp,
+              char **metrics_pathp, bool *watch_manifestp,
+              char **initial_txn_pathp, bool *no_initial_txnp,
+              char **emit_db_pathp, char **hw_desc_dirp)
 {
     enum {
         OPT_PEER_CA_CERT = UCHAR_MAX + 1,
         OPT_UNIXCTL,
+        OPT_METRICS_SOCKET,
+        OPT_TRACE,
+        OPT_WATCH_MANIFEST,
+        OPT_INITIAL_TXN_FILE,
+        OPT_NO_INITIAL_TXN_FILE,
+        OPT_EMIT_DB,
+        OPT_HW_DESC_DIR,
         VLOG_OPTION_ENUMS,
         OPT_BOOTSTRAP_CA_CERT,
         OPT_ENABLE_DUMMY,
@@ -349,6 +445,13 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
     static const struct option long_options[] = {
         {"help",        no_argument, NULL, 'h'},
         {"unixctl",     required_argument, NULL, OPT_UNIXCTL},
+        {"metrics-socket", required_argument, NULL, OPT_METRICS_SOCKET},
+        {"trace",       no_argument, NULL, OPT_TRACE},
+        {"watch-manifest", no_argument, NULL, OPT_WATCH_MANIFEST},
+        {"initial-txn-file", required_argument, NULL, OPT_INITIAL_TXN_FILE},
+        {"no-initial-txn-file", no_argument, NULL, OPT_NO_INITIAL_TXN_FILE},
+        {"emit-db",     required_argument, NULL, OPT_EMIT_DB},
+        {"hw-desc-dir", required_argument, NULL, OPT_HW_DESC_DIR},
         DAEMON_LONG_OPTIONS,
         VLOG_LONG_OPTIONS,
         {NULL, 0, NULL, 0},
@@ -371,6 +474,34 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
             *unixctl_pathp = optarg;
             break;
 
+        case OPT_METRICS_SOCKET:
+            *metrics_pathp = optarg;
+            break;
+
+        case OPT_TRACE:
+            sysd_trace_enable(true);
+            break;
+
+        case OPT_WATCH_MANIFEST:
+            *watch_manifestp = true;
+            break;
+
+        case OPT_INITIAL_TXN_FILE:
+            *initial_txn_pathp = optarg;
+            break;
+
+        case OPT_NO_INITIAL_TXN_FILE:
+            *no_initial_txnp = true;
+            break;
+
+        case OPT_EMIT_DB:
+            *emit_db_pathp = optarg;
+            break;
+
+        case OPT_HW_DESC_DIR:
+            *hw_desc_dirp = optarg;
+            break;
+
         VLOG_OPTION_HANDLERS
         DAEMON_OPTION_HANDLERS
 
@@ -383,6 +514,10 @@ parse_options(int argc, char *argv[], char **unixctl_pathp)
     }
     free(short_options);
 
+    if (*emit_db_pathp && !*hw_desc_dirp) {
+        VLOG_FATAL("--emit-db requires --hw-desc-dir; use --help for usage");
+    }
+
     argc -= optind;
     argv += optind;
 
@@ -413,22 +548,42 @@ int
 main(int argc, char *argv[])
 {
     char    *appctl_path = NULL;
+    char    *metrics_path = NULL;
     char    *ovsdb_sock = NULL;
+    bool    watch_manifest = false;
+    char    *initial_txn_path = NULL;
+    bool    no_initial_txn = false;
+    char    default_txn_path[1024];
+    char    *emit_db_path = NULL;
+    char    *hw_desc_dir = NULL;
     int     rc = 0;
     int     exiting = 0;
     int     retval;
 
     struct unixctl_server   *appctl = NULL;
+    struct sysd_ctx         *ctx;
 
     set_program_name(argv[0]);
     fatal_ignore_sigpipe();
+    ctx = sysd_ctx_create();
 
     /* Parse commandline args and get the name of the OVSDB socket. */
-    ovsdb_sock = parse_options(argc, argv, &appctl_path);
+    ovsdb_sock = parse_options(argc, argv, &appctl_path, &metrics_path,
+                               &watch_manifest, &initial_txn_path,
+                               &no_initial_txn, &emit_db_path,
+                               &hw_desc_dir);
 
     /* Initialize OVSDB metadata. */
     ovsrec_init();
 
+    /* Offline, at image build time: no daemon, no database. */
+    if (emit_db_path) {
+        rc = sysd_emit_db(ctx, hw_desc_dir, emit_db_path);
+        sysd_ctx_destroy(ctx);
+        free(ovsdb_sock);
+        exit(rc ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
     /* Fork and return in child process; but don't notify parent of
      * startup completion yet. */
     daemonize_start();
@@ -445,24 +600,62 @@ main(int argc, char *argv[])
     }
 
     /* Register ovs-appctl commands for this daemon. */
-    unixctl_command_register("ops-sysd/dump", "", 0, 0, sysd_unixctl_dump, NULL);
+    unixctl_command_register("ops-sysd/dump",
+                             "[--json] [daemons|subsystems|interfaces|macs|"
+                             "qos|timings|memory]...",
+                             0, SYSD_DUMP_N_SECTIONS + 1,
+                             sysd_unixctl_dump, ctx);
+    unixctl_command_register("ops-sysd/qos-restore-defaults",
+                             "[all|trust|cos-map|dscp-map|"
+                             "queue-profile [NAME]|schedule-profile [NAME]]",
+                             0, 2, sysd_unixctl_qos_restore_defaults, ctx);
+    unixctl_command_register("ops-sysd/txn-stats", "[reset]", 0, 1,
+                             sysd_unixctl_txn_stats, ctx);
+    unixctl_command_register("ops-sysd/loop-stats",
+                             "[reset|stall-threshold MSEC]", 0, 2,
+                             sysd_unixctl_loop_stats, ctx);
+    unixctl_command_register("ops-sysd/metrics", "", 0, 0,
+                             sysd_unixctl_metrics, ctx);
+    unixctl_command_register("ops-sysd/trace", "[on|off|save FILE]", 0, 2,
+                             sysd_unixctl_trace, ctx);
+    unixctl_command_register("ops-sysd/memory", "", 0, 0,
+                             sysd_unixctl_memory, ctx);
+    unixctl_command_register("ops-sysd/reload-manifest", "", 0, 0,
+                             sysd_unixctl_reload_manifest, ctx);
+
+    /* A scraper that cannot be served is not a reason to stop booting. */
+    if (metrics_path) {
+        sysd_metrics_socket_open(metrics_path);
+    }
 
     /* Register the ovs-appctl "exit" command for this daemon. */
     unixctl_command_register("exit", "", 0, 0, sysd_exit, &exiting);
 
-    sysd_ovsdb_conn_init(ovsdb_sock);
-    free(ovsdb_sock);
+    sysd_ovsdb_conn_init(ctx, ovsdb_sock);
+    unixctl_command_register(SYSD_DIAG_DUMP_BASIC_CMD, "[FEATURE]", 0, 1,
+                             sysd_unixctl_diag_dump_basic, ctx);
 
     /* Process the manifest file */
-    rc = sysd_read_manifest_file();
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_BEGIN,
+               SYSD_TRACE_STAGE_MANIFEST, 0);
+    rc = sysd_read_manifest_file(ctx);
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_END,
+               SYSD_TRACE_STAGE_MANIFEST, rc);
     if (rc) {
         VLOG_ERR("Unable to process image.manifest file.");
         exit(-1);
     }
+    if (watch_manifest) {
+        sysd_manifest_watch_open(ctx);
+    }
 
     /* Determine the platform we are on and
      * locate H/W desc files. */
-    rc = sysd_find_hw_desc_files();
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_BEGIN,
+               SYSD_TRACE_STAGE_HW_DESC, 0);
+    rc = sysd_find_hw_desc_files(ctx);
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_END,
+               SYSD_TRACE_STAGE_HW_DESC, rc);
     if (rc) {
         VLOG_ERR("Unable to find HW descriptor files.");
         exit(-1);
@@ -472,37 +665,74 @@ main(int argc, char *argv[])
      * is not available. Can do this when adding subsystem support. */
 
     /* Initialize and parse needed yaml files. */
-    rc = sysd_cfg_yaml_init(g_hw_desc_dir);
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_BEGIN,
+               SYSD_TRACE_STAGE_CFG_YAML, 0);
+    rc = sysd_cfg_yaml_init(ctx);
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_END,
+               SYSD_TRACE_STAGE_CFG_YAML, rc);
     if (!rc) {
         VLOG_ERR("Unable to initialize YAML config files.");
         exit(-1);
     }
 
-    rc = sysd_get_subsystem_info();
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_BEGIN,
+               SYSD_TRACE_STAGE_SUBSYSTEMS, 0);
+    rc = sysd_get_subsystem_info(ctx);
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_END,
+               SYSD_TRACE_STAGE_SUBSYSTEMS, rc);
     if (rc) {
         VLOG_ERR("Unable to enumerate subsystems in the system.");
         exit(-1);
     }
 
-    rc = sysd_get_interface_info();
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_BEGIN,
+               SYSD_TRACE_STAGE_INTERFACES, 0);
+    rc = sysd_get_interface_info(ctx);
+    SYSD_TRACE(SYSD_TRACE_STARTUP_STAGE, SYSD_TRACE_END,
+               SYSD_TRACE_STAGE_INTERFACES, rc);
     if (rc) {
         VLOG_ERR("Unable to enumerate interfaces in the system.");
         exit(-1);
     }
 
+    /* Replay the initial configuration recorded on an earlier boot if it
+     * was built from the same files, or record it once it is built. */
+    if (!no_initial_txn) {
+        if (!initial_txn_path) {
+            sysd_data_path(default_txn_path, sizeof default_txn_path,
+                           INITIAL_TXN_FILE_PATH);
+            initial_txn_path = default_txn_path;
+        }
+        sysd_replay_open(ctx, initial_txn_path, ovsdb_sock);
+    }
+    free(ovsdb_sock);
+
     while (!exiting) {
-        sysd_run();
+        sysd_loop_begin(&ctx->loop);
+        sysd_run(ctx);
+        sysd_loop_stage_done(&ctx->loop, SYSD_LOOP_RUN);
         unixctl_server_run(appctl);
+        sysd_metrics_run(ctx);
+        if (sysd_manifest_watch_run(ctx)) {
+            VLOG_INFO("image.manifest changed; reloading");
+            sysd_reload_manifest(ctx, NULL);
+        }
+        sysd_loop_stage_done(&ctx->loop, SYSD_LOOP_UNIXCTL);
 
-        sysd_wait();
+        sysd_wait(ctx);
         unixctl_server_wait(appctl);
+        sysd_metrics_wait(ctx);
+        sysd_manifest_watch_wait(ctx);
+        sysd_loop_stage_done(&ctx->loop, SYSD_LOOP_WAIT);
         if (exiting) {
             poll_immediate_wake();
         } else {
             poll_block();
         }
+        sysd_loop_stage_done(&ctx->loop, SYSD_LOOP_POLL);
     }
 
+    sysd_ctx_destroy(ctx);
     return 0;
 
 } /* main */
@@ -33,6 +33,8 @@
 #include <config-yaml.h>
 #include "sysd.h"
 #include "sysd_cfg_yaml.h"
+#include "sysd_ctx.h"
+#include "qos_defaults.h"
 #include "string.h"
 #include "eventlog.h"
 
@@ -43,18 +45,14 @@ VLOG_DEFINE_THIS_MODULE(cfg_yaml);
 
 #define FRU_EEPROM_NAME "fru_eeprom"
 
-static YamlConfigHandle cfg_yaml_handle = (YamlConfigHandle *)NULL;
-static const YamlDevice *fru_dev = NULL;
-
-
-bool
-sysd_cfg_yaml_open(char *hw_desc_dir)
+static bool
+sysd_cfg_yaml_open(struct sysd_ctx *ctx)
 {
     int rc = 0;
 
-    cfg_yaml_handle = yaml_new_config_handle();
+    ctx->cfg_yaml = yaml_new_config_handle();
 
-    rc = yaml_add_subsystem(cfg_yaml_handle, BASE_SUBSYSTEM, hw_desc_dir);
+    rc = yaml_add_subsystem(ctx->cfg_yaml, BASE_SUBSYSTEM, ctx->hw_desc_dir);
     if (rc) {
         VLOG_ERR("Unable to create '%s' subsystem (yaml parsing).", BASE_SUBSYSTEM);
         return(false);
@@ -63,48 +61,73 @@ sysd_cfg_yaml_open(char *hw_desc_dir)
     return(true);
 } /* sysd_cfg_yaml_open */
 
+/*
+ * Function       : sysd_cfg_yaml_load
+ * Responsibility : parses the hardware description files without touching
+ *                  the devices they describe
+ * Parameters     : ctx
+ * Returns        : true on success
+ */
 bool
-sysd_cfg_yaml_init(char *hw_desc_dir)
+sysd_cfg_yaml_load(struct sysd_ctx *ctx)
 {
     int rc = 0;
 
-    if (!sysd_cfg_yaml_open(hw_desc_dir)) {
+    if (!sysd_cfg_yaml_open(ctx)) {
         return(false);
     }
 
-    rc = yaml_parse_devices(cfg_yaml_handle, BASE_SUBSYSTEM);
+    rc = yaml_parse_devices(ctx->cfg_yaml, BASE_SUBSYSTEM);
     if (0 > rc) {
         VLOG_ERR("Unable to parse devices yaml config file.");
         return (false);
     }
 
-    rc = yaml_parse_ports(cfg_yaml_handle, BASE_SUBSYSTEM);
+    rc = yaml_parse_ports(ctx->cfg_yaml, BASE_SUBSYSTEM);
     if (0 > rc) {
         VLOG_ERR("Unable to parse ports yaml config file.");
         return (false);
     }
 
 #if defined(USE_SW_FRU) || defined(PLATFORM_SIMULATION)
-    rc = yaml_parse_fru(cfg_yaml_handle, BASE_SUBSYSTEM);
+    rc = yaml_parse_fru(ctx->cfg_yaml, BASE_SUBSYSTEM);
     if (0 > rc) {
         VLOG_ERR("Failed to parse fru yaml config file");
         return (false);
     }
 #endif
 
-    rc = yaml_parse_qos(cfg_yaml_handle, BASE_SUBSYSTEM);
-    if (0 > rc) {
-        VLOG_ERR("Unable to parse qos yaml config file.");
+    /* qos.yaml only needs parsing if it differs from the factory
+     * defaults compiled into ops-sysd. */
+    if (!qos_defaults_load_compiled(ctx)) {
+        rc = yaml_parse_qos(ctx->cfg_yaml, BASE_SUBSYSTEM);
+        if (0 > rc) {
+            VLOG_ERR("Unable to parse qos yaml config file.");
+        }
+    }
+
+    return (true);
+
+} /* sysd_cfg_yaml_load */
+
+bool
+sysd_cfg_yaml_init(struct sysd_ctx *ctx)
+{
+    int rc = 0;
+
+    if (!sysd_cfg_yaml_load(ctx)) {
+        return(false);
     }
 
-    rc = yaml_init_devices(cfg_yaml_handle, BASE_SUBSYSTEM);
+    rc = yaml_init_devices(ctx->cfg_yaml, BASE_SUBSYSTEM);
     if (0 > rc) {
         VLOG_ERR("Failed to intialize devices");
         log_event("SYS_INITIALIZE_DEVICE_FAILURE", NULL);
         return (false);
     }
-    fru_dev = yaml_find_device(cfg_yaml_handle, BASE_SUBSYSTEM, FRU_EEPROM_NAME);
-    if (fru_dev == (YamlDevice *)NULL) {
+    ctx->fru_dev = yaml_find_device(ctx->cfg_yaml, BASE_SUBSYSTEM,
+                                    FRU_EEPROM_NAME);
+    if (ctx->fru_dev == (YamlDevice *)NULL) {
         VLOG_ERR("unable to find device %s in YAML description.", FRU_EEPROM_NAME);
         return (false);
     }
@@ -114,31 +137,32 @@ sysd_cfg_yaml_init(char *hw_desc_dir)
 } /* sysd_cfg_yaml_init */
 
 int
-sysd_cfg_yaml_get_port_count(void)
+sysd_cfg_yaml_get_port_count(struct sysd_ctx *ctx)
 {
-    return (int) yaml_get_port_count(cfg_yaml_handle, BASE_SUBSYSTEM);
+    return (int) yaml_get_port_count(ctx->cfg_yaml, BASE_SUBSYSTEM);
 
 } /* sysd_cfg_yaml_get_port_count */
 
 YamlPort *
-sysd_cfg_yaml_get_port_info(int index)
+sysd_cfg_yaml_get_port_info(struct sysd_ctx *ctx, int index)
 {
-    return (YamlPort *) yaml_get_port(cfg_yaml_handle, BASE_SUBSYSTEM, index);
+    return (YamlPort *) yaml_get_port(ctx->cfg_yaml, BASE_SUBSYSTEM, index);
 
 } /* sysd_cfg_yaml_get_port_info */
 
 YamlPortInfo *
-sysd_cfg_yaml_get_port_subsys_info(void)
+sysd_cfg_yaml_get_port_subsys_info(struct sysd_ctx *ctx)
 {
-    return yaml_get_port_info(cfg_yaml_handle, BASE_SUBSYSTEM);
+    return yaml_get_port_info(ctx->cfg_yaml, BASE_SUBSYSTEM);
 
 } /* sysd_cfg_yaml_get_port_subsys_info */
 
 #if defined(USE_SW_FRU) || defined(PLATFORM_SIMULATION)
 int
-sysd_cfg_yaml_get_fru_info(fru_eeprom_t *fru_eeprom)
+sysd_cfg_yaml_get_fru_info(struct sysd_ctx *ctx, fru_eeprom_t *fru_eeprom)
 {
-    const YamlFruInfo *fru_info = yaml_get_fru_info(cfg_yaml_handle, BASE_SUBSYSTEM);
+    const YamlFruInfo *fru_info = yaml_get_fru_info(ctx->cfg_yaml,
+                                                    BASE_SUBSYSTEM);
     if (!fru_info) {
        return -1;
     }
@@ -183,14 +207,15 @@ sysd_cfg_yaml_get_fru_info(fru_eeprom_t *fru_eeprom)
 #endif /* defined(USE_SW_FRU) || defined(PLATFORM_SIMULATION) */
 
 bool
-sysd_cfg_yaml_fru_read(unsigned char *fru_hdr, int hdr_len)
+sysd_cfg_yaml_fru_read(struct sysd_ctx *ctx, unsigned char *fru_hdr,
+                       int hdr_len)
 {
     int         rc;
     i2c_op      op;
     i2c_op      *cmds[2];
 
     op.direction        = READ;
-    op.device           = fru_dev->name;
+    op.device           = ctx->fru_dev->name;
     op.register_address = 0;
     op.byte_count       = hdr_len;
     op.data             = fru_hdr;
@@ -200,7 +225,7 @@ sysd_cfg_yaml_fru_read(unsigned char *fru_hdr, int hdr_len)
     cmds[0] = &op;
     cmds[1] = (i2c_op *) NULL;
 
-    rc = i2c_execute(cfg_yaml_handle, BASE_SUBSYSTEM, fru_dev, cmds);
+    rc = i2c_execute(ctx->cfg_yaml, BASE_SUBSYSTEM, ctx->fru_dev, cmds);
     if (0 != rc) {
         VLOG_ERR("Failed to read FRU header.");
         log_event("SYS_FRU_HEADER_READ_FAILURE", NULL);
@@ -212,57 +237,61 @@ sysd_cfg_yaml_fru_read(unsigned char *fru_hdr, int hdr_len)
 } /* sysd_cfg_yaml_fru_read */
 
 YamlQosInfo *
-sysd_cfg_yaml_get_qos_info(void)
+sysd_cfg_yaml_get_qos_info(struct sysd_ctx *ctx)
 {
-    return yaml_get_qos_info(cfg_yaml_handle, BASE_SUBSYSTEM);
+    return yaml_get_qos_info(ctx->cfg_yaml, BASE_SUBSYSTEM);
 }
 
 int
-sysd_cfg_yaml_get_cos_map_entry_count(void)
+sysd_cfg_yaml_get_cos_map_entry_count(struct sysd_ctx *ctx)
 {
-    return yaml_get_cos_map_entry_count(cfg_yaml_handle, BASE_SUBSYSTEM);
+    return yaml_get_cos_map_entry_count(ctx->cfg_yaml, BASE_SUBSYSTEM);
 }
 
 const YamlCosMapEntry *
-sysd_cfg_yaml_get_cos_map_entry(unsigned int idx)
+sysd_cfg_yaml_get_cos_map_entry(struct sysd_ctx *ctx, unsigned int idx)
 {
-    return yaml_get_cos_map_entry(cfg_yaml_handle, BASE_SUBSYSTEM, idx);
+    return yaml_get_cos_map_entry(ctx->cfg_yaml, BASE_SUBSYSTEM, idx);
 }
 
 int
-sysd_cfg_yaml_get_dscp_map_entry_count(void)
+sysd_cfg_yaml_get_dscp_map_entry_count(struct sysd_ctx *ctx)
 {
-    return yaml_get_dscp_map_entry_count(cfg_yaml_handle, BASE_SUBSYSTEM);
+    return yaml_get_dscp_map_entry_count(ctx->cfg_yaml, BASE_SUBSYSTEM);
 }
 
 const YamlDscpMapEntry *
-sysd_cfg_yaml_get_dscp_map_entry(unsigned int idx)
+sysd_cfg_yaml_get_dscp_map_entry(struct sysd_ctx *ctx, unsigned int idx)
 {
-    return yaml_get_dscp_map_entry(cfg_yaml_handle, BASE_SUBSYSTEM, idx);
+    return yaml_get_dscp_map_entry(ctx->cfg_yaml, BASE_SUBSYSTEM, idx);
 }
 
 int
-sysd_cfg_yaml_get_schedule_profile_entry_count(void)
+sysd_cfg_yaml_get_schedule_profile_entry_count(struct sysd_ctx *ctx)
 {
-    return yaml_get_schedule_profile_entry_count(cfg_yaml_handle, BASE_SUBSYSTEM);
+    return yaml_get_schedule_profile_entry_count(ctx->cfg_yaml,
+                                                 BASE_SUBSYSTEM);
 }
 
 const YamlScheduleProfileEntry *
-sysd_cfg_yaml_get_schedule_profile_entry(unsigned int idx)
+sysd_cfg_yaml_get_schedule_profile_entry(struct sysd_ctx *ctx,
+                                         unsigned int idx)
 {
-    return yaml_get_schedule_profile_entry(cfg_yaml_handle, BASE_SUBSYSTEM, idx);
+    return yaml_get_schedule_profile_entry(ctx->cfg_yaml, BASE_SUBSYSTEM,
+                                           idx);
 }
 
 int
-sysd_cfg_yaml_get_queue_profile_entry_count(void)
+sysd_cfg_yaml_get_queue_profile_entry_count(struct sysd_ctx *ctx)
 {
-    return yaml_get_queue_profile_entry_count(cfg_yaml_handle, BASE_SUBSYSTEM);
+    return yaml_get_queue_profile_entry_count(ctx->cfg_yaml, BASE_SUBSYSTEM);
 }
 
 const YamlQueueProfileEntry *
-sysd_cfg_yaml_get_queue_profile_entry(unsigned int idx)
+sysd_cfg_yaml_get_queue_profile_entry(struct sysd_ctx *ctx,
+                                      unsigned int idx)
 {
-    return yaml_get_queue_profile_entry(cfg_yaml_handle, BASE_SUBSYSTEM, idx);
+    return yaml_get_queue_profile_entry(ctx->cfg_yaml, BASE_SUBSYSTEM, idx);
 }
 
 /** @} end of group sysd */
@@ -0,0 +1,336 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the sysd context: its lifetime and the subsystem and interface
+ * enumeration that fills it in from the hardware description.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <hmap.h>
+#include <ovsdb-idl.h>
+#include <sset.h>
+#include <timeval.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include <ops-utils.h>
+#include <config-yaml.h>
+#include "qos_defaults.h"
+#include "sysd.h"
+#include "sysd_cfg_yaml.h"
+#include "sysd_ctx.h"
+#include "sysd_fru.h"
+#include "sysd_loop_stats.h"
+#include "sysd_mem.h"
+#include "sysd_replay.h"
+#include "sysd_txn.h"
+#include "sysd_util.h"
+#include "eventlog.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_ctx);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/*
+ * Function       : sysd_ctx_create
+ * Responsibility : allocates an empty context
+ * Parameters     : none
+ * Returns        : the new context
+ */
+struct sysd_ctx *
+sysd_ctx_create(void)
+{
+    struct sysd_ctx *ctx = xzalloc(sizeof *ctx);
+
+    sysd_txn_queue_init(&ctx->txns);
+    sysd_replay_init(&ctx->replay);
+    hmap_init(&ctx->daemon_index);
+    ctx->num_hw_levels = 1;
+    ctx->manifest_watch_fd = -1;
+    sset_init(&ctx->daemons_to_delete);
+    ctx->boot_times.start = time_msec();
+    sysd_loop_init(&ctx->loop);
+
+    return ctx;
+
+} /* sysd_ctx_create */
+
+/* Frees the FRU strings and the interface array of 'subsys'.  The
+ * interfaces themselves belong to the config-yaml handle. */
+static void
+sysd_subsystem_destroy(sysd_subsystem_t *subsys)
+{
+    fru_eeprom_t *fru = &subsys->fru_eeprom;
+
+    sysd_mem_free(fru->diag_version);
+    sysd_mem_free(fru->label_revision);
+    sysd_mem_free(fru->manufacturer);
+    sysd_mem_free(fru->onie_version);
+    sysd_mem_free(fru->part_number);
+    sysd_mem_free(fru->platform_name);
+    sysd_mem_free(fru->product_name);
+    sysd_mem_free(fru->serial_number);
+    sysd_mem_free(fru->service_tag);
+    sysd_mem_free(fru->vendor);
+    sysd_mem_free(subsys->interfaces);
+    sysd_mem_free(subsys);
+}
+
+/*
+ * Function       : sysd_ctx_destroy
+ * Responsibility : completes the context's queued writes as aborted, closes
+ *                  its database connection and frees everything it holds
+ * Parameters     : ctx, or NULL
+ * Returns        : void
+ */
+void
+sysd_ctx_destroy(struct sysd_ctx *ctx)
+{
+    int i;
+
+    if (!ctx) {
+        return;
+    }
+
+    /* The done callbacks may still look at the context. */
+    sysd_txn_queue_destroy(&ctx->txns);
+    if (ctx->idl) {
+        ovsdb_idl_destroy(ctx->idl);
+    }
+    sysd_replay_destroy(&ctx->replay);
+
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        if (ctx->subsystems[i]) {
+            sysd_subsystem_destroy(ctx->subsystems[i]);
+        }
+    }
+    sysd_mem_free(ctx->subsystems);
+
+    qos_defaults_destroy(ctx);
+    if (ctx->cfg_yaml) {
+        yaml_free_config_handle(ctx->cfg_yaml);
+    }
+    sysd_mem_free(ctx->hw_desc_dir);
+    sysd_mem_free(ctx->hw_desc_link);
+
+    sysd_free_manifest_info(ctx);
+    hmap_destroy(&ctx->daemon_index);
+    if (ctx->manifest_watch_fd >= 0) {
+        close(ctx->manifest_watch_fd);
+    }
+    sset_destroy(&ctx->daemons_to_delete);
+
+    free(ctx);
+
+} /* sysd_ctx_destroy */
+
+/*
+ * Function       : sysd_subsystems_alloc
+ * Responsibility : allocates the subsystems of the platform and names the
+ *                  base one
+ * Parameters     : ctx
+ * Returns        : void
+ */
+static void
+sysd_subsystems_alloc(struct sysd_ctx *ctx)
+{
+    int       i = 0;
+
+    sysd_subsystem_t    *ptr;
+
+    /* OPS_TODO: Will need to implement mechanism to locate
+     *           the hardware description files for this system
+     *           and all defined subsystems for this system.
+     *           For now, just assume pizza box. */
+
+    ctx->num_subsystems = 1;
+
+    ctx->subsystems = sysd_mem_calloc(SYSD_MEM_SUBSYSTEMS,
+                                      ctx->num_subsystems,
+                                      sizeof(sysd_subsystem_t *));
+
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        ctx->subsystems[i] = sysd_mem_calloc(SYSD_MEM_SUBSYSTEMS, 1,
+                                             sizeof(sysd_subsystem_t));
+    }
+
+    /* Store information about BASE subsystem. */
+    ptr = ctx->subsystems[0];
+    strncpy(ptr->name, SYSD_BASE_SUBSYSTEM, MAX_SUBSYSTEM_NAME_LEN);
+    ptr->type = SYSD_SUBSYSTEM_TYPE_SYSTEM;
+
+} /* sysd_subsystems_alloc */
+
+/*
+ * Function       : sysd_subsystem_alloc_macs
+ * Responsibility : sets aside the management and system MACs of a subsystem
+ *                  from the pool its FRU EEPROM describes
+ * Parameters     : ptr - subsystem
+ * Returns        : void
+ */
+static void
+sysd_subsystem_alloc_macs(sysd_subsystem_t *ptr)
+{
+    ptr->num_free_macs = ptr->fru_eeprom.num_macs;
+    ptr->nxt_mac_addr = ops_char_array_to_ulong_long(ptr->fru_eeprom.base_mac_address, ETH_ALEN);
+
+    if (ptr->num_free_macs > 0) {
+        /* Save first MAC as the mgmt i/f MAC for the system */
+        ptr->mgmt_mac_addr = ptr->nxt_mac_addr;
+        ptr->num_free_macs--;
+        ptr->nxt_mac_addr++;
+    }
+
+    if (ptr->num_free_macs > 0) {
+        /* Save second MAC as the system MAC */
+        ptr->system_mac_addr = ptr->nxt_mac_addr;
+        ptr->num_free_macs--;
+        ptr->nxt_mac_addr++;
+    }
+
+} /* sysd_subsystem_alloc_macs */
+
+/*
+ * Function       : sysd_get_subsystem_info
+ * Responsibility : enumerates the subsystems of the platform and reads the
+ *                  FRU EEPROM and MAC pool of each
+ * Parameters     : ctx
+ * Returns        : 0 on success, -1 on failure
+ */
+int
+sysd_get_subsystem_info(struct sysd_ctx *ctx)
+{
+    int       rc = 0;
+
+    sysd_subsystems_alloc(ctx);
+
+    rc = sysd_read_fru_eeprom(ctx, &(ctx->subsystems[0]->fru_eeprom));
+    if (rc) {
+        VLOG_ERR("Failed to read FRU data from base system.");
+        log_event("SYS_FRU_DATA_READ_FAILURE", NULL);
+        return -1;
+    }
+
+    sysd_subsystem_alloc_macs(ctx->subsystems[0]);
+
+    return 0;
+
+} /* sysd_get_subsystem_info() */
+
+/*
+ * Function       : sysd_get_placeholder_subsystem_info
+ * Responsibility : enumerates the subsystems of the platform without reading
+ *                  their FRU EEPROMs, leaving SYSD_PER_BOX_PLACEHOLDER in
+ *                  the FRU strings and no MACs
+ * Parameters     : ctx
+ * Returns        : 0
+ */
+int
+sysd_get_placeholder_subsystem_info(struct sysd_ctx *ctx)
+{
+    int       i = 0;
+
+    sysd_subsystems_alloc(ctx);
+
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        sysd_subsystem_t *ptr = ctx->subsystems[i];
+        fru_eeprom_t *fru = &ptr->fru_eeprom;
+
+        fru->diag_version = sysd_mem_strdup(SYSD_MEM_FRU,
+                                            SYSD_PER_BOX_PLACEHOLDER);
+        fru->label_revision = sysd_mem_strdup(SYSD_MEM_FRU,
+                                              SYSD_PER_BOX_PLACEHOLDER);
+        fru->manufacturer = sysd_mem_strdup(SYSD_MEM_FRU,
+                                            SYSD_PER_BOX_PLACEHOLDER);
+        fru->onie_version = sysd_mem_strdup(SYSD_MEM_FRU,
+                                            SYSD_PER_BOX_PLACEHOLDER);
+        fru->part_number = sysd_mem_strdup(SYSD_MEM_FRU,
+                                           SYSD_PER_BOX_PLACEHOLDER);
+        fru->platform_name = sysd_mem_strdup(SYSD_MEM_FRU,
+                                             SYSD_PER_BOX_PLACEHOLDER);
+        fru->product_name = sysd_mem_strdup(SYSD_MEM_FRU,
+                                            SYSD_PER_BOX_PLACEHOLDER);
+        fru->serial_number = sysd_mem_strdup(SYSD_MEM_FRU,
+                                             SYSD_PER_BOX_PLACEHOLDER);
+        fru->vendor = sysd_mem_strdup(SYSD_MEM_FRU, SYSD_PER_BOX_PLACEHOLDER);
+        ptr->placeholders = true;
+    }
+
+    return 0;
+
+} /* sysd_get_placeholder_subsystem_info */
+
+/*
+ * Function       : sysd_get_interface_info
+ * Responsibility : points the base subsystem at its interfaces in the
+ *                  hardware description
+ * Parameters     : ctx
+ * Returns        : 0 on success, -1 on failure
+ */
+int
+sysd_get_interface_info(struct sysd_ctx *ctx)
+{
+    int         idx = 0;
+    int         intf_count = 0;
+
+    sysd_intf_info_t            **interfaces = NULL;
+    sysd_intf_cmn_info_t        *intf_cmn_info = NULL;
+    sysd_subsystem_t            *ptr;
+
+    /* Get interface related global info. */
+    intf_cmn_info = sysd_cfg_yaml_get_port_subsys_info(ctx);
+    if (intf_cmn_info == (sysd_intf_cmn_info_t *)NULL) {
+        VLOG_ERR("Failed to get interface sub-system info.");
+        return -1;
+    }
+
+    intf_count = sysd_cfg_yaml_get_port_count(ctx);
+    if (intf_count <= 0) {
+        VLOG_ERR("Unable to get interface count from YAML files.");
+        return -1;
+    }
+
+    /* Allocate memory for 'intf_count' number of sysd_intf_info_t pointers. */
+    interfaces = sysd_mem_calloc(SYSD_MEM_INTERFACES, intf_count,
+                                 sizeof(sysd_intf_info_t *));
+
+    /* Get info for each interface. */
+    for (idx = 0 ; idx < intf_count; idx++) {
+        interfaces[idx] = sysd_cfg_yaml_get_port_info(ctx, idx);
+        if (NULL == interfaces[idx]) {
+            VLOG_ERR("Unable to get interface info for interface index %d", idx);
+            sysd_mem_free(interfaces);
+            return -1;
+        }
+    }
+
+    /* OPS_TODO: Enhance the code to support multiple subsystems. */
+    ptr = ctx->subsystems[0];
+    ptr->intf_count = intf_count;
+    ptr->intf_cmn_info = intf_cmn_info;
+    ptr->interfaces = interfaces;
+
+    return 0;
+
+} /* sysd_get_interface_info */
+/** @} end of group ops-sysd */
@@ -0,0 +1,469 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the ops-sysd diagnostic dump used by ops-sysd/dump and
+ * diag-dump.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <dynamic-string.h>
+#include <json.h>
+#include <timeval.h>
+#include <util.h>
+
+#include <config-yaml.h>
+#include "qos_defaults.h"
+#include "sysd.h"
+#include "sysd_ctx.h"
+#include "sysd_util.h"
+#include "sysd_ovsdb_if.h"
+#include "sysd_dump.h"
+#include "sysd_mem.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+static const struct {
+    const char *name;           /* Argument and JSON member name. */
+    const char *title;          /* Text output section header. */
+} sysd_dump_sections[SYSD_DUMP_N_SECTIONS] = {
+    [SYSD_DUMP_DAEMONS]    = { "daemons",    "Daemon Info" },
+    [SYSD_DUMP_SUBSYSTEMS] = { "subsystems", "Subsystem Info" },
+    [SYSD_DUMP_INTERFACES] = { "interfaces", "Interface Info" },
+    [SYSD_DUMP_MACS]       = { "macs",       "MAC Pool Info" },
+    [SYSD_DUMP_QOS]        = { "qos",        "QoS Defaults Info" },
+    [SYSD_DUMP_TIMINGS]    = { "timings",    "Timing Info" },
+    [SYSD_DUMP_MEMORY]     = { "memory",     "Memory Info" },
+};
+
+/* Writes the same dump as text or JSON.  In text, each section's scalar
+ * members are "key: value" lines and each list element is one line of
+ * "key=value" pairs.  JSON is built as a tree and formatted at the end. */
+struct dump_writer {
+    struct sysd_ctx *ctx;       /* What to dump. */
+    enum sysd_dump_format format;
+
+    /* SYSD_DUMP_TEXT. */
+    struct ds *ds;
+    bool first;                 /* Nothing yet in the current list element. */
+    bool in_item;               /* Inside a list element. */
+
+    /* SYSD_DUMP_JSON. */
+    struct json *section;       /* Object of the current section. */
+    struct json *object;        /* Section or list element being filled. */
+    struct json *list;          /* List being filled. */
+};
+
+/* Starts text member 'key'. */
+static void
+dump_member(struct dump_writer *w, const char *key)
+{
+    if (w->in_item) {
+        ds_put_format(w->ds, "%s%s=", w->first ? "" : ", ", key);
+        w->first = false;
+    } else {
+        ds_put_format(w->ds, "%-24s: ", key);
+    }
+}
+
+static void
+dump_member_end(struct dump_writer *w)
+{
+    if (!w->in_item) {
+        ds_put_char(w->ds, '\n');
+    }
+}
+
+static void
+dump_string(struct dump_writer *w, const char *key, const char *value)
+{
+    if (w->format == SYSD_DUMP_JSON) {
+        json_object_put(w->object, key, (value ? json_string_create(value)
+                                         : json_null_create()));
+    } else {
+        dump_member(w, key);
+        ds_put_cstr(w->ds, value ? value : "");
+        dump_member_end(w);
+    }
+}
+
+static void
+dump_int(struct dump_writer *w, const char *key, long long int value)
+{
+    if (w->format == SYSD_DUMP_JSON) {
+        json_object_put(w->object, key, json_integer_create(value));
+    } else {
+        dump_member(w, key);
+        ds_put_format(w->ds, "%lld", value);
+        dump_member_end(w);
+    }
+}
+
+static void
+dump_bool(struct dump_writer *w, const char *key, bool value)
+{
+    if (w->format == SYSD_DUMP_JSON) {
+        json_object_put(w->object, key, json_boolean_create(value));
+    } else {
+        dump_member(w, key);
+        ds_put_cstr(w->ds, value ? "true" : "false");
+        dump_member_end(w);
+    }
+}
+
+static void
+dump_mac(struct dump_writer *w, const char *key, uint64_t mac)
+{
+    char buf[sizeof "00:00:00:00:00:00"];
+
+    snprintf(buf, sizeof buf, "%02x:%02x:%02x:%02x:%02x:%02x",
+             (unsigned int) (mac >> 40) & 0xff,
+             (unsigned int) (mac >> 32) & 0xff,
+             (unsigned int) (mac >> 24) & 0xff,
+             (unsigned int) (mac >> 16) & 0xff,
+             (unsigned int) (mac >> 8) & 0xff,
+             (unsigned int) mac & 0xff);
+    dump_string(w, key, buf);
+}
+
+static void
+dump_list_begin(struct dump_writer *w, const char *key)
+{
+    if (w->format == SYSD_DUMP_JSON) {
+        w->list = json_array_create_empty();
+        json_object_put(w->section, key, w->list);
+    } else {
+        ds_put_format(w->ds, "%s:\n", key);
+    }
+}
+
+static void
+dump_list_end(struct dump_writer *w)
+{
+    w->list = NULL;
+}
+
+static void
+dump_item_begin(struct dump_writer *w)
+{
+    if (w->format == SYSD_DUMP_JSON) {
+        w->object = json_object_create();
+        json_array_add(w->list, w->object);
+    } else {
+        ds_put_cstr(w->ds, "  ");
+        w->first = true;
+        w->in_item = true;
+    }
+}
+
+static void
+dump_item_end(struct dump_writer *w)
+{
+    if (w->format == SYSD_DUMP_JSON) {
+        w->object = w->section;
+    } else {
+        ds_put_char(w->ds, '\n');
+        w->in_item = false;
+    }
+}
+
+static void
+dump_daemons(struct dump_writer *w)
+{
+    const struct sysd_ctx *ctx = w->ctx;
+    int i;
+
+    dump_int(w, "count", ctx->num_daemons);
+    dump_int(w, "hw_handlers", ctx->num_hw_daemons);
+    dump_int(w, "hw_levels", ctx->num_hw_levels);
+    dump_int(w, "unknown_manifest_sections", ctx->manifest_unknown_sections);
+    dump_list_begin(w, "daemons");
+    for (i = 0; i < ctx->num_daemons; i++) {
+        const daemon_info_t *daemon = ctx->daemons[i];
+
+        dump_item_begin(w);
+        dump_string(w, "name", daemon->name);
+        dump_bool(w, "is_hw_handler", daemon->is_hw_handler);
+        dump_int(w, "cur_hw", daemon->cur_hw);
+        dump_int(w, "hw_level", daemon->hw_level);
+        if (daemon->is_hw_handler) {
+            long long int until = (daemon->ready_msec ? daemon->ready_msec
+                                   : time_msec());
+
+            dump_int(w, "ready_timeout_ms", daemon->ready_timeout_ms);
+            dump_string(w, "on_timeout",
+                        sysd_ready_policy_name(daemon->on_timeout));
+            dump_bool(w, "expired", daemon->expired_msec != 0);
+            dump_int(w, "wait_ms", until - daemon->listed_msec);
+            dump_int(w, "generation", daemon->generation);
+            dump_bool(w, "reinitializing", daemon->reinit_msec != 0);
+            dump_int(w, "last_reinit_ms", daemon->last_reinit_ms);
+        }
+        dump_item_end(w);
+    }
+    dump_list_end(w);
+}
+
+static void
+dump_subsystems(struct dump_writer *w)
+{
+    const struct sysd_ctx *ctx = w->ctx;
+    int i;
+
+    dump_list_begin(w, "subsystems");
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        const sysd_subsystem_t *ptr = ctx->subsystems[i];
+
+        dump_item_begin(w);
+        dump_string(w, "name", ptr->name);
+        dump_string(w, "type", ptr->type);
+        dump_int(w, "interfaces", ptr->intf_count);
+        dump_string(w, "manufacturer", ptr->fru_eeprom.manufacturer);
+        dump_string(w, "product_name", ptr->fru_eeprom.product_name);
+        dump_string(w, "platform_name", ptr->fru_eeprom.platform_name);
+        dump_string(w, "part_number", ptr->fru_eeprom.part_number);
+        dump_string(w, "serial_number", ptr->fru_eeprom.serial_number);
+        dump_string(w, "onie_version", ptr->fru_eeprom.onie_version);
+        dump_item_end(w);
+    }
+    dump_list_end(w);
+}
+
+static void
+dump_interfaces(struct dump_writer *w)
+{
+    const struct sysd_ctx *ctx = w->ctx;
+    int i, j;
+
+    dump_string(w, "management_interface",
+                ctx->mgmt_intf ? ctx->mgmt_intf->name : NULL);
+    dump_list_begin(w, "interfaces");
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        const sysd_subsystem_t *ptr = ctx->subsystems[i];
+
+        for (j = 0; j < ptr->intf_count && ptr->interfaces; j++) {
+            const sysd_intf_info_t *intf = ptr->interfaces[j];
+
+            dump_item_begin(w);
+            dump_string(w, "subsystem", ptr->name);
+            dump_string(w, "name", intf->name);
+            dump_int(w, "max_speed", intf->max_speed);
+            dump_string(w, "connector", intf->connector);
+            dump_bool(w, "pluggable", intf->pluggable);
+            dump_string(w, "parent", intf->parent_port);
+            dump_item_end(w);
+        }
+    }
+    dump_list_end(w);
+}
+
+static void
+dump_macs(struct dump_writer *w)
+{
+    const struct sysd_ctx *ctx = w->ctx;
+    int i;
+
+    dump_list_begin(w, "subsystems");
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        const sysd_subsystem_t *ptr = ctx->subsystems[i];
+
+        dump_item_begin(w);
+        dump_string(w, "name", ptr->name);
+        dump_int(w, "num_macs", ptr->fru_eeprom.num_macs);
+        dump_int(w, "free_macs", ptr->num_free_macs);
+        dump_mac(w, "next_mac", ptr->nxt_mac_addr);
+        dump_mac(w, "mgmt_mac", ptr->mgmt_mac_addr);
+        dump_mac(w, "system_mac", ptr->system_mac_addr);
+        dump_item_end(w);
+    }
+    dump_list_end(w);
+}
+
+static void
+dump_qos(struct dump_writer *w)
+{
+    const struct qos_defaults *defaults = qos_defaults_get(w->ctx);
+
+    dump_bool(w, "loaded", defaults != NULL);
+    if (!defaults) {
+        return;
+    }
+
+    dump_string(w, "source", defaults->platform[0] ? "compiled" : "yaml");
+    if (defaults->platform[0]) {
+        dump_string(w, "platform", defaults->platform);
+        dump_string(w, "sha1", defaults->sha1);
+    }
+    dump_string(w, "trust", defaults->info.trust);
+    dump_string(w, "default_name", defaults->info.default_name);
+    dump_string(w, "factory_default_name",
+                defaults->info.factory_default_name);
+    dump_int(w, "cos_map_entries", defaults->n_cos_map);
+    dump_int(w, "dscp_map_entries", defaults->n_dscp_map);
+    dump_int(w, "queue_profile_entries", defaults->n_queue_profile);
+    dump_int(w, "schedule_profile_entries", defaults->n_schedule_profile);
+}
+
+/* Dumps 'msec' relative to startup, or -1 if the milestone was not yet
+ * reached. */
+static void
+dump_boot_time(struct dump_writer *w, const char *key, long long int msec)
+{
+    dump_int(w, key, msec ? msec - w->ctx->boot_times.start : -1);
+}
+
+static void
+dump_timings(struct dump_writer *w)
+{
+    const struct sysd_boot_times *times = &w->ctx->boot_times;
+    int i;
+
+    dump_int(w, "uptime_ms", time_msec() - times->start);
+    dump_boot_time(w, "initial_config_ms", times->initial_config);
+    dump_bool(w, "initial_config_replayed", times->initial_config_replayed);
+    dump_boot_time(w, "hw_init_done_ms", times->hw_init_done);
+    for (i = 1; i <= w->ctx->num_hw_levels; i++) {
+        char *key = xasprintf("hw_level_%d_ms", i);
+
+        dump_boot_time(w, key, times->hw_levels[i]);
+        free(key);
+    }
+}
+
+static void
+dump_memory(struct dump_writer *w)
+{
+    struct rusage usage;
+    int i;
+
+    if (!getrusage(RUSAGE_SELF, &usage)) {
+        dump_int(w, "max_rss_kb", usage.ru_maxrss);
+    }
+
+    for (i = 0; i < SYSD_MEM_N_CATEGORIES; i++) {
+        char *key = xasprintf("%s_bytes", sysd_mem_category_name(i));
+
+        dump_int(w, key, sysd_mem_get(i)->cur_bytes);
+        free(key);
+    }
+}
+
+static void (*const sysd_dump_funcs[SYSD_DUMP_N_SECTIONS])(
+    struct dump_writer *) = {
+    [SYSD_DUMP_DAEMONS]    = dump_daemons,
+    [SYSD_DUMP_SUBSYSTEMS] = dump_subsystems,
+    [SYSD_DUMP_INTERFACES] = dump_interfaces,
+    [SYSD_DUMP_MACS]       = dump_macs,
+    [SYSD_DUMP_QOS]        = dump_qos,
+    [SYSD_DUMP_TIMINGS]    = dump_timings,
+    [SYSD_DUMP_MEMORY]     = dump_memory,
+};
+
+/*
+ * Function       : sysd_dump
+ * Responsibility : appends the selected diagnostic sections to a dynamic
+ *                  string, as text or as a single JSON object with one
+ *                  member per section
+ * Parameters     : ctx, ds, sections bitmap, format
+ * Returns        : void
+ */
+void
+sysd_dump(struct sysd_ctx *ctx, struct ds *ds, unsigned int sections,
+          enum sysd_dump_format format)
+{
+    struct dump_writer w = {
+        .ctx = ctx,
+        .format = format,
+        .ds = ds,
+    };
+    struct json *json = NULL;
+    int i;
+
+    if (format == SYSD_DUMP_JSON) {
+        json = json_object_create();
+    }
+
+    for (i = 0; i < SYSD_DUMP_N_SECTIONS; i++) {
+        if (!(sections & (1u << i))) {
+            continue;
+        }
+
+        if (format == SYSD_DUMP_JSON) {
+            w.section = w.object = json_object_create();
+            json_object_put(json, sysd_dump_sections[i].name, w.section);
+            sysd_dump_funcs[i](&w);
+        } else {
+            ds_put_format(ds, "=============== %s ===============\n",
+                          sysd_dump_sections[i].title);
+            sysd_dump_funcs[i](&w);
+            ds_put_char(ds, '\n');
+        }
+    }
+
+    if (json) {
+        json_to_ds(json, JSSF_SORT, ds);
+        ds_put_char(ds, '\n');
+        json_destroy(json);
+    }
+
+} /* sysd_dump */
+
+/*
+ * Function       : sysd_dump_parse_args
+ * Responsibility : parses ops-sysd/dump arguments
+ * Parameters     : unixctl argc/argv, returned sections bitmap and format
+ * Returns        : NULL on success, otherwise a malloc()'d error message
+ */
+char *
+sysd_dump_parse_args(int argc, const char *argv[], unsigned int *sections,
+                     enum sysd_dump_format *format)
+{
+    int i, j;
+
+    *sections = 0;
+    *format = SYSD_DUMP_TEXT;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) {
+            *format = SYSD_DUMP_JSON;
+            continue;
+        }
+
+        for (j = 0; j < SYSD_DUMP_N_SECTIONS; j++) {
+            if (!strcmp(argv[i], sysd_dump_sections[j].name)) {
+                *sections |= 1u << j;
+                break;
+            }
+        }
+        if (j == SYSD_DUMP_N_SECTIONS) {
+            return xasprintf("Unknown dump section \"%s\"", argv[i]);
+        }
+    }
+
+    if (!*sections) {
+        *sections = SYSD_DUMP_ALL_SECTIONS;
+    }
+    return NULL;
+
+} /* sysd_dump_parse_args */
+/** @} end of group ops-sysd */
@@ -0,0 +1,169 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the ops-sysd offline build of the initial configuration.
+ *
+ * Everything sysd_initial_configure() writes derives from files shipped in
+ * the image, except the FRU data and the MACs.  "ops-sysd --emit-db" builds
+ * the rows at image build time with those left as placeholders, so that an
+ * image can ship a pre-seeded database and sysd only patches the per-box
+ * columns at boot.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <json.h>
+#include <ovsdb-idl.h>
+#include <util.h>
+#include <vswitch-idl.h>
+#include <openvswitch/vlog.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_cfg_yaml.h"
+#include "sysd_ctx.h"
+#include "sysd_emit.h"
+#include "sysd_mem.h"
+#include "sysd_ovsdb_if.h"
+#include "sysd_replay.h"
+#include "sysd_util.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_emit);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/*
+ * Function       : sysd_emit_build
+ * Responsibility : builds the initial configuration of 'ctx' in a
+ *                  transaction that is never committed
+ * Parameters     : ctx
+ * Returns        : the transaction's operations, or NULL
+ */
+static struct json *
+sysd_emit_build(struct sysd_ctx *ctx)
+{
+    struct ovsdb_idl_txn    *txn;
+    struct json             *ops;
+
+    /* The IDL is never run, so it never tries to reach the remote. */
+    ctx->idl = ovsdb_idl_create("unix:/nonexistent", &ovsrec_idl_class,
+                                false, false);
+
+    txn = ovsdb_idl_txn_create(ctx->idl);
+    sysd_initial_configure(ctx, txn);
+    ops = sysd_replay_txn_ops(ctx->idl);
+    ovsdb_idl_txn_abort(txn);
+    ovsdb_idl_txn_destroy(txn);
+
+    return ops;
+
+} /* sysd_emit_build */
+
+/*
+ * Function       : sysd_emit_write
+ * Responsibility : writes a JSON value to a file, or to stdout for "-"
+ * Parameters     : json, file
+ * Returns        : 0 on success, an errno value on failure
+ */
+static int
+sysd_emit_write(const struct json *json, const char *file)
+{
+    bool    to_stdout = !strcmp(file, "-");
+    char    *s;
+    FILE    *f;
+    int     error = 0;
+
+    f = to_stdout ? stdout : fopen(file, "w");
+    if (!f) {
+        return errno;
+    }
+
+    s = json_to_string(json, JSSF_PRETTY | JSSF_SORT);
+    if (fputs(s, f) == EOF || putc('\n', f) == EOF) {
+        error = errno;
+    }
+    free(s);
+
+    if (to_stdout ? fflush(f) : fclose(f)) {
+        error = error ? error : errno;
+    }
+    return error;
+
+} /* sysd_emit_write */
+
+int
+sysd_emit_db(struct sysd_ctx *ctx, const char *hw_desc_dir,
+             const char *file)
+{
+    struct json *ops;
+    struct json *params;
+    size_t      i;
+    int         error;
+
+    ctx->hw_desc_dir = sysd_mem_strdup(SYSD_MEM_PATHS, hw_desc_dir);
+
+    if (sysd_read_manifest_file(ctx)) {
+        VLOG_ERR("Unable to process image.manifest file.");
+        return -1;
+    }
+    if (!sysd_cfg_yaml_load(ctx)) {
+        VLOG_ERR("Unable to parse the YAML config files in %s.",
+                 hw_desc_dir);
+        return -1;
+    }
+    if (sysd_get_placeholder_subsystem_info(ctx)
+        || sysd_get_interface_info(ctx)) {
+        VLOG_ERR("Unable to enumerate the subsystems in %s.", hw_desc_dir);
+        return -1;
+    }
+
+    ops = sysd_emit_build(ctx);
+    if (!ops) {
+        VLOG_ERR("The initial configuration depends on an existing "
+                 "database and cannot be emitted.");
+        return -1;
+    }
+
+    /* ["OpenSwitch", op...], as "ovsdb-tool transact" takes it. */
+    params = json_array_create_1(
+        json_string_create(ovsrec_idl_class.database));
+    for (i = 0; i < ops->u.array.n; i++) {
+        json_array_add(params, json_clone(ops->u.array.elems[i]));
+    }
+    json_destroy(ops);
+
+    error = sysd_emit_write(params, file);
+    if (error) {
+        VLOG_ERR("Failed to write %s (%s)", file, ovs_strerror(error));
+    } else {
+        VLOG_INFO("Emitted the initial configuration for %s to %s "
+                  "(%"PRIuSIZE" rows)", hw_desc_dir, file,
+                  params->u.array.n - 1);
+    }
+    json_destroy(params);
+
+    return error ? -1 : 0;
+
+} /* sysd_emit_db */
+
+/** @} end of group ops-sysd */
@@ -35,6 +35,8 @@
 #include "sysd_util.h"
 #include "sysd_fru.h"
 #include "sysd_cfg_yaml.h"
+#include "sysd_mem.h"
+#include "sysd_trace.h"
 #include "sysd.h"
 
 #include "eventlog.h"
@@ -69,19 +71,19 @@ sysd_process_eeprom(unsigned char *buf, fru_eeprom_t *fru_eeprom, int len)
 
         switch(fru_tlv->code) {
             case FRU_PRODUCT_NAME_TYPE:
-                SYSD_MALLOC(fru_eeprom->product_name, tlv_len + 1);
+                fru_eeprom->product_name = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->product_name, tlv_value, tlv_len);
                 fru_eeprom->product_name[tlv_len] = '\0';
                 break;
 
             case FRU_PART_NUMBER_TYPE:
-                SYSD_MALLOC(fru_eeprom->part_number, tlv_len + 1);
+                fru_eeprom->part_number = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->part_number, tlv_value, tlv_len);
                 fru_eeprom->part_number[tlv_len] = '\0';
                 break;
 
             case FRU_SERIAL_NUMBER_TYPE:
-                SYSD_MALLOC(fru_eeprom->serial_number, tlv_len + 1);
+                fru_eeprom->serial_number = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->serial_number, tlv_value, tlv_len);
                 fru_eeprom->serial_number[tlv_len] = '\0';
                 break;
@@ -105,25 +107,25 @@ sysd_process_eeprom(unsigned char *buf, fru_eeprom_t *fru_eeprom, int len)
                 break;
 
             case FRU_LABEL_REVISION_TYPE:
-                SYSD_MALLOC(fru_eeprom->label_revision, tlv_len + 1);
+                fru_eeprom->label_revision = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->label_revision, tlv_value, tlv_len);
                 fru_eeprom->label_revision[tlv_len] = '\0';
                 break;
 
             case FRU_PLATFORM_NAME_TYPE:
-                SYSD_MALLOC(fru_eeprom->platform_name, tlv_len + 1);
+                fru_eeprom->platform_name = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->platform_name, tlv_value, tlv_len);
                 fru_eeprom->platform_name[tlv_len] = '\0';
                 break;
 
             case FRU_ONIE_VERSION_TYPE:
-                SYSD_MALLOC(fru_eeprom->onie_version, tlv_len + 1);
+                fru_eeprom->onie_version = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->onie_version, tlv_value, tlv_len);
                 fru_eeprom->onie_version[tlv_len] = '\0';
                 break;
 
             case FRU_MANUFACTURER_TYPE:
-                SYSD_MALLOC(fru_eeprom->manufacturer, tlv_len + 1);
+                fru_eeprom->manufacturer = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->manufacturer, tlv_value, tlv_len);
                 fru_eeprom->manufacturer[tlv_len] = '\0';
                 break;
@@ -134,19 +136,19 @@ sysd_process_eeprom(unsigned char *buf, fru_eeprom_t *fru_eeprom, int len)
                 break;
 
             case FRU_VENDOR_TYPE:
-                SYSD_MALLOC(fru_eeprom->vendor, tlv_len + 1);
+                fru_eeprom->vendor = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->vendor, tlv_value, tlv_len);
                 fru_eeprom->vendor[tlv_len] = '\0';
                 break;
 
             case FRU_DIAG_VERSION_TYPE:
-                SYSD_MALLOC(fru_eeprom->diag_version, tlv_len + 1);
+                fru_eeprom->diag_version = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->diag_version, tlv_value, tlv_len);
                 fru_eeprom->diag_version[tlv_len] = '\0';
                 break;
 
             case FRU_SERVICE_TAG_TYPE:
-                SYSD_MALLOC(fru_eeprom->service_tag, tlv_len + 1);
+                fru_eeprom->service_tag = sysd_mem_alloc(SYSD_MEM_FRU, tlv_len + 1);
                 strncpy(fru_eeprom->service_tag, tlv_value, tlv_len);
                 fru_eeprom->service_tag[tlv_len] = '\0';
                 break;
@@ -188,12 +190,12 @@ sysd_process_eeprom(unsigned char *buf, fru_eeprom_t *fru_eeprom, int len)
 } /* sysd_process_eeprom() */
 
 int
-sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom)
+sysd_read_fru_eeprom(struct sysd_ctx *ctx, fru_eeprom_t *fru_eeprom)
 {
     bool            rc;
 #if defined(USE_SW_FRU) || defined(PLATFORM_SIMULATION)
     /* Populate stub generic-x86 EEPROM info */
-    rc = sysd_cfg_yaml_get_fru_info(fru_eeprom);
+    rc = sysd_cfg_yaml_get_fru_info(ctx, fru_eeprom);
     if (0 > rc) {
         VLOG_ERR("Error getting yaml fru info. rc = %d.", rc);
         return -1;
@@ -208,7 +210,10 @@ sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom)
     VLOG_INFO("Getting fru info from EEPROM");
 
     /* Read header info */
-    rc = sysd_cfg_yaml_fru_read((unsigned char *) &header, sizeof(header));
+    SYSD_TRACE(SYSD_TRACE_I2C, SYSD_TRACE_BEGIN, sizeof(header), 0);
+    rc = sysd_cfg_yaml_fru_read(ctx, (unsigned char *) &header,
+                                sizeof(header));
+    SYSD_TRACE(SYSD_TRACE_I2C, SYSD_TRACE_END, sizeof(header), !rc);
     if (!rc) {
         VLOG_ERR("Error reading FRU EEPROM Header");
         log_event("SYS_FRU_EEPROM_HEADER_READ_FAILURE", NULL);
@@ -227,25 +232,24 @@ sysd_read_fru_eeprom(fru_eeprom_t *fru_eeprom)
 
     /* Using length from header, read remainder of FRU EEPROM */
     len = total_len + sizeof(fru_header_t) + 1;
-    buf = (unsigned char *) calloc(1, len);
-    if ((unsigned char *)NULL == buf) {
-        VLOG_ERR("Unable to allocate memory for eeprom read");
-        return -1;
-    }
+    buf = sysd_mem_calloc(SYSD_MEM_FRU, 1, len);
 
-    rc = sysd_cfg_yaml_fru_read(buf, len);
+    SYSD_TRACE(SYSD_TRACE_I2C, SYSD_TRACE_BEGIN, len, 0);
+    rc = sysd_cfg_yaml_fru_read(ctx, buf, len);
+    SYSD_TRACE(SYSD_TRACE_I2C, SYSD_TRACE_END, len, !rc);
     if (!rc) {
         VLOG_ERR("Error reading FRU EEPROM");
+        sysd_mem_free(buf);
         return -1;
     }
 
     /* Populate EEPROM struct */
     rc = sysd_process_eeprom(buf, fru_eeprom, total_len);
+    sysd_mem_free(buf);
     if (!rc) {
         VLOG_ERR("Error processing FRU EEPROM info");
         return -1;
     }
-    free(buf);
 #endif
 
     return 0;
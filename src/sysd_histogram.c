@@ -0,0 +1,62 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the log2-bucketed histograms used by ops-sysd statistics.
+ */
+
+#include <dynamic-string.h>
+#include <util.h>
+
+#include "sysd_histogram.h"
+
+/** @ingroup ops-sysd
+ * @{ */
+
+void
+sysd_histogram_add(struct sysd_histogram *hist, unsigned long long int value)
+{
+    int bucket = value < 2 ? 0 : log_2_floor(value);
+
+    hist->count++;
+    hist->total += value;
+    hist->max = MAX(hist->max, value);
+    hist->buckets[MIN(bucket, SYSD_HIST_BUCKETS - 1)]++;
+
+} /* sysd_histogram_add */
+
+void
+sysd_histogram_format(const struct sysd_histogram *hist, struct ds *ds)
+{
+    int i;
+
+    for (i = 0; i < SYSD_HIST_BUCKETS; i++) {
+        if (!hist->buckets[i]) {
+            continue;
+        }
+        if (i == SYSD_HIST_BUCKETS - 1) {
+            ds_put_format(ds, " [%llu,inf):%llu", 1ULL << i,
+                          hist->buckets[i]);
+        } else {
+            ds_put_format(ds, " [%llu,%llu):%llu", i ? 1ULL << i : 0,
+                          1ULL << (i + 1), hist->buckets[i]);
+        }
+    }
+
+} /* sysd_histogram_format */
+/** @} end of group ops-sysd */
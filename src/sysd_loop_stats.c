@@ -0,0 +1,178 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for ops-sysd main loop timing and stall detection.
+ *
+ * sysd runs its OVSDB processing and its appctl commands in one thread, so
+ * any blocking call (a synchronous commit, an I2C read, YAML parsing)
+ * freezes both.  Each stage of every iteration is timed into a histogram,
+ * and an iteration whose busy time (everything but poll_block()) crosses
+ * the stall threshold is logged together with the stage it was in.
+ */
+
+#include <string.h>
+
+#include <dynamic-string.h>
+#include <timeval.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_histogram.h"
+#include "sysd_loop_stats.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_loop_stats);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+static const char *sysd_loop_stage_names[SYSD_LOOP_N_STAGES] = {
+    [SYSD_LOOP_RUN]     = "sysd_run",
+    [SYSD_LOOP_UNIXCTL] = "unixctl",
+    [SYSD_LOOP_WAIT]    = "wait",
+    [SYSD_LOOP_POLL]    = "poll_block",
+};
+
+void
+sysd_loop_init(struct sysd_loop *loop)
+{
+    memset(loop, 0, sizeof *loop);
+    loop->stall_msec = SYSD_LOOP_STALL_MSEC_DEFAULT;
+
+} /* sysd_loop_init */
+
+void
+sysd_loop_begin(struct sysd_loop *loop)
+{
+    loop->iteration_start = loop->stage_start = time_usec();
+    loop->busy_usec = 0;
+    loop->stalled = false;
+
+} /* sysd_loop_begin */
+
+/*
+ * Function       : sysd_loop_stage_done
+ * Responsibility : records the time since the previous mark against a
+ *                  stage and reports the iteration as stalled the first
+ *                  time its busy time crosses the threshold
+ * Parameters     : loop, the stage that just finished
+ * Returns        : void
+ */
+void
+sysd_loop_stage_done(struct sysd_loop *loop, enum sysd_loop_stage stage)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(5, 60);
+    struct sysd_loop_stats *stats = &loop->stats;
+    long long int now = time_usec();
+    unsigned long long int usec = MAX(now - loop->stage_start, 0);
+
+    loop->stage_start = now;
+    sysd_histogram_add(&stats->stages[stage], usec);
+
+    if (stage == SYSD_LOOP_POLL) {
+        sysd_histogram_add(&stats->busy, loop->busy_usec);
+        return;
+    }
+
+    loop->busy_usec += usec;
+    if (!loop->stalled && loop->busy_usec >= loop->stall_msec * 1000LL) {
+        loop->stalled = true;
+        stats->stalls++;
+        stats->last_stall_stage = stage;
+        stats->last_stall_usec = usec;
+        stats->max_stall_usec = MAX(stats->max_stall_usec, usec);
+        VLOG_WARN_RL(&rl, "main loop stalled for %lld ms in %s "
+                     "(%llu ms in that stage, threshold %u ms)",
+                     (now - loop->iteration_start) / 1000,
+                     sysd_loop_stage_names[stage], usec / 1000,
+                     loop->stall_msec);
+    }
+
+} /* sysd_loop_stage_done */
+
+void
+sysd_loop_set_stall_threshold(struct sysd_loop *loop, unsigned int msec)
+{
+    loop->stall_msec = msec;
+
+} /* sysd_loop_set_stall_threshold */
+
+/*
+ * Function       : sysd_loop_stats_format
+ * Responsibility : formats the stage histograms and stall counters for
+ *                  ops-sysd/loop-stats
+ * Parameters     : loop, ds
+ * Returns        : void
+ */
+void
+sysd_loop_stats_format(const struct sysd_loop *loop, struct ds *ds)
+{
+    const struct sysd_loop_stats *stats = &loop->stats;
+    int i;
+
+    ds_put_format(ds, "Iterations: %llu\n", stats->busy.count);
+    ds_put_format(ds, "Stall threshold: %u ms\n", loop->stall_msec);
+    ds_put_format(ds, "Stalls: %llu", stats->stalls);
+    if (stats->stalls) {
+        ds_put_format(ds, " (last in %s for %llu ms, longest stage %llu ms)",
+                      sysd_loop_stage_names[stats->last_stall_stage],
+                      stats->last_stall_usec / 1000,
+                      stats->max_stall_usec / 1000);
+    }
+    ds_put_cstr(ds, "\n\n");
+
+    ds_put_format(ds, "%-12s %10s %10s %12s\n",
+                  "stage", "count", "avg_us", "max_us");
+    for (i = 0; i < SYSD_LOOP_N_STAGES; i++) {
+        const struct sysd_histogram *hist = &stats->stages[i];
+
+        ds_put_format(ds, "%-12s %10llu %10llu %12llu\n",
+                      sysd_loop_stage_names[i], hist->count,
+                      hist->total / MAX(hist->count, 1), hist->max);
+    }
+    ds_put_format(ds, "%-12s %10llu %10llu %12llu\n", "busy",
+                  stats->busy.count,
+                  stats->busy.total / MAX(stats->busy.count, 1),
+                  stats->busy.max);
+
+    ds_put_cstr(ds, "\nHistograms (us):\n");
+    for (i = 0; i < SYSD_LOOP_N_STAGES; i++) {
+        ds_put_format(ds, "%s:", sysd_loop_stage_names[i]);
+        sysd_histogram_format(&stats->stages[i], ds);
+        ds_put_char(ds, '\n');
+    }
+    ds_put_cstr(ds, "busy:");
+    sysd_histogram_format(&stats->busy, ds);
+    ds_put_char(ds, '\n');
+
+} /* sysd_loop_stats_format */
+
+const char *
+sysd_loop_stage_name(enum sysd_loop_stage stage)
+{
+    return sysd_loop_stage_names[stage];
+
+} /* sysd_loop_stage_name */
+
+void
+sysd_loop_stats_reset(struct sysd_loop *loop)
+{
+    memset(&loop->stats, 0, sizeof loop->stats);
+
+} /* sysd_loop_stats_reset */
+/** @} end of group ops-sysd */
@@ -0,0 +1,212 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for ops-sysd memory accounting.
+ *
+ * Each accounted block carries a small header with its size and category,
+ * so it can be released without the caller knowing either.  The statistics
+ * are shared by every sysd context in the process and guarded by a mutex,
+ * so allocations may be made from any thread.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dynamic-string.h>
+#include <ovs-thread.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_mem.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_mem);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Precedes every accounted block.  The union keeps the block that follows
+ * as aligned as malloc() would. */
+union sysd_mem_header {
+    struct {
+        size_t size;
+        enum sysd_mem_category category;
+    } s;
+    uint64_t align[2];
+};
+
+static const char *sysd_mem_category_names[SYSD_MEM_N_CATEGORIES] = {
+    [SYSD_MEM_FRU]        = "fru",
+    [SYSD_MEM_SUBSYSTEMS] = "subsystems",
+    [SYSD_MEM_INTERFACES] = "interfaces",
+    [SYSD_MEM_DAEMONS]    = "daemons",
+    [SYSD_MEM_MANIFEST]   = "manifest",
+    [SYSD_MEM_PATHS]      = "paths",
+    [SYSD_MEM_QOS]        = "qos",
+    [SYSD_MEM_TRACE]      = "trace",
+};
+
+static struct ovs_mutex sysd_mem_mutex = OVS_MUTEX_INITIALIZER;
+static struct sysd_mem_stats sysd_mem_stats[SYSD_MEM_N_CATEGORIES];
+
+static void *
+sysd_mem_account(union sysd_mem_header *hdr,
+                 enum sysd_mem_category category, size_t size)
+{
+    struct sysd_mem_stats *stats = &sysd_mem_stats[category];
+
+    if (!hdr) {
+        out_of_memory();
+    }
+    hdr->s.size = size;
+    hdr->s.category = category;
+
+    ovs_mutex_lock(&sysd_mem_mutex);
+    stats->cur_bytes += size;
+    stats->peak_bytes = MAX(stats->peak_bytes, stats->cur_bytes);
+    stats->cur_blocks++;
+    stats->allocs++;
+    ovs_mutex_unlock(&sysd_mem_mutex);
+
+    return hdr + 1;
+}
+
+/* Releases the block 'hdr' from its category.  A realloc() is not a new
+ * allocation, so it also takes back the count its account will add. */
+static void
+sysd_mem_unaccount(const union sysd_mem_header *hdr, bool resized)
+{
+    struct sysd_mem_stats *stats = &sysd_mem_stats[hdr->s.category];
+
+    ovs_mutex_lock(&sysd_mem_mutex);
+    stats->cur_bytes -= hdr->s.size;
+    stats->cur_blocks--;
+    if (resized) {
+        stats->allocs--;
+    }
+    ovs_mutex_unlock(&sysd_mem_mutex);
+}
+
+void *
+sysd_mem_alloc(enum sysd_mem_category category, size_t size)
+{
+    return sysd_mem_account(malloc(sizeof(union sysd_mem_header) + size),
+                            category, size);
+
+} /* sysd_mem_alloc */
+
+void *
+sysd_mem_calloc(enum sysd_mem_category category, size_t n, size_t size)
+{
+    size_t total;
+
+    if (size && n > (SIZE_MAX - sizeof(union sysd_mem_header)) / size) {
+        out_of_memory();
+    }
+    total = n * size;
+    return sysd_mem_account(calloc(1, sizeof(union sysd_mem_header) + total),
+                            category, total);
+
+} /* sysd_mem_calloc */
+
+void *
+sysd_mem_realloc(enum sysd_mem_category category, void *p, size_t size)
+{
+    union sysd_mem_header *hdr;
+
+    if (!p) {
+        return sysd_mem_alloc(category, size);
+    }
+
+    hdr = (union sysd_mem_header *) p - 1;
+    ovs_assert(hdr->s.category == category);
+    sysd_mem_unaccount(hdr, true);
+
+    return sysd_mem_account(realloc(hdr, sizeof *hdr + size),
+                            category, size);
+
+} /* sysd_mem_realloc */
+
+char *
+sysd_mem_strdup(enum sysd_mem_category category, const char *s)
+{
+    size_t size = strlen(s) + 1;
+
+    return memcpy(sysd_mem_alloc(category, size), s, size);
+
+} /* sysd_mem_strdup */
+
+void
+sysd_mem_free(void *p)
+{
+    if (p) {
+        union sysd_mem_header *hdr = (union sysd_mem_header *) p - 1;
+
+        sysd_mem_unaccount(hdr, false);
+        free(hdr);
+    }
+
+} /* sysd_mem_free */
+
+const struct sysd_mem_stats *
+sysd_mem_get(enum sysd_mem_category category)
+{
+    return &sysd_mem_stats[category];
+}
+
+const char *
+sysd_mem_category_name(enum sysd_mem_category category)
+{
+    return sysd_mem_category_names[category];
+}
+
+/*
+ * Function       : sysd_mem_format
+ * Responsibility : formats current and peak bytes per category for
+ *                  ops-sysd/memory
+ * Parameters     : ds
+ * Returns        : void
+ */
+void
+sysd_mem_format(struct ds *ds)
+{
+    unsigned long long int cur = 0, peak = 0;
+    int i;
+
+    ds_put_format(ds, "%-12s %12s %12s %8s %8s\n",
+                  "category", "cur_bytes", "peak_bytes", "blocks", "allocs");
+    for (i = 0; i < SYSD_MEM_N_CATEGORIES; i++) {
+        struct sysd_mem_stats stats;
+
+        ovs_mutex_lock(&sysd_mem_mutex);
+        stats = sysd_mem_stats[i];
+        ovs_mutex_unlock(&sysd_mem_mutex);
+
+        ds_put_format(ds, "%-12s %12llu %12llu %8llu %8llu\n",
+                      sysd_mem_category_names[i], stats.cur_bytes,
+                      stats.peak_bytes, stats.cur_blocks, stats.allocs);
+        cur += stats.cur_bytes;
+        peak += stats.peak_bytes;
+    }
+    /* The sum of per category peaks bounds the overall peak from above. */
+    ds_put_format(ds, "%-12s %12llu %12llu\n", "total", cur, peak);
+
+} /* sysd_mem_format */
+/** @} end of group ops-sysd */
@@ -0,0 +1,450 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the ops-sysd metrics registry.
+ *
+ * The metrics are rendered in the OpenMetrics text format for
+ * ops-sysd/metrics and for the optional metrics socket.  A scraper
+ * connects to the socket and reads until EOF, so no ovs-appctl process
+ * has to be spawned per scrape.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <dynamic-string.h>
+#include <stream.h>
+#include <timeval.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_ctx.h"
+#include "sysd_util.h"
+#include "sysd_ovsdb_if.h"
+#include "sysd_histogram.h"
+#include "sysd_txn_stats.h"
+#include "sysd_write.h"
+#include "sysd_loop_stats.h"
+#include "sysd_metrics.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_metrics);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Clients served at once on the metrics socket. */
+#define SYSD_METRICS_MAX_CONNS 4
+
+static const struct {
+    const char *name;
+    const char *help;
+} sysd_metric_counters[SYSD_METRIC_N_COUNTERS] = {
+    [SYSD_METRIC_IDL_SEQNO_CHANGES] = {
+        "sysd_idl_seqno_changes", "Database changes processed by sysd."
+    },
+    [SYSD_METRIC_SW_INFO_REFRESHES] = {
+        "sysd_sw_info_refreshes", "Software information refreshes."
+    },
+    [SYSD_METRIC_PACKAGE_INFO_ROWS] = {
+        "sysd_package_info_rows", "Package_Info rows inserted."
+    },
+    [SYSD_METRIC_HW_READY_TIMEOUTS] = {
+        "sysd_hw_ready_timeouts",
+        "Hardware daemons that missed their readiness deadline."
+    },
+};
+
+struct sysd_metrics_conn {
+    struct stream *stream;
+    struct ds out;              /* Rendering sent to this client. */
+    size_t sent;                /* Bytes of 'out' sent so far. */
+};
+
+static struct pstream *metrics_pstream;
+static struct sysd_metrics_conn metrics_conns[SYSD_METRICS_MAX_CONNS];
+static size_t n_metrics_conns;
+
+void
+sysd_metric_add(struct sysd_ctx *ctx, enum sysd_metric_counter counter,
+                unsigned long long int n)
+{
+    ctx->metrics[counter] += n;
+
+} /* sysd_metric_add */
+
+static void
+metrics_put_header(struct ds *ds, const char *name, const char *type,
+                   const char *help)
+{
+    ds_put_format(ds, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+/* Appends 'value' as an OpenMetrics label value. */
+static void
+metrics_put_label_value(struct ds *ds, const char *value)
+{
+    ds_put_char(ds, '"');
+    for (; *value; value++) {
+        if (*value == '"' || *value == '\\') {
+            ds_put_char(ds, '\\');
+            ds_put_char(ds, *value);
+        } else if (*value == '\n') {
+            ds_put_cstr(ds, "\\n");
+        } else {
+            ds_put_char(ds, *value);
+        }
+    }
+    ds_put_char(ds, '"');
+}
+
+static void
+metrics_put_seconds(struct ds *ds, const char *name, const char *label,
+                    const char *value, long long int msec)
+{
+    ds_put_format(ds, "%s{%s=", name, label);
+    metrics_put_label_value(ds, value);
+    ds_put_format(ds, "} %.3f\n", msec / 1000.0);
+}
+
+/* Appends the samples of histogram 'name' for 'hist', which holds whole
+ * microseconds, in seconds.  sysd_histogram bucket i holds values up to
+ * and including 2^(i+1) - 1 us, which is its "le" bound.  Whole
+ * microseconds print exactly with six decimals. */
+static void
+metrics_put_histogram(struct ds *ds, const char *name, const char *label,
+                      const char *value, const struct sysd_histogram *hist)
+{
+    unsigned long long int cumulative = 0;
+    int i;
+
+    for (i = 0; i < SYSD_HIST_BUCKETS; i++) {
+        cumulative += hist->buckets[i];
+        ds_put_format(ds, "%s_bucket{%s=", name, label);
+        metrics_put_label_value(ds, value);
+        if (i == SYSD_HIST_BUCKETS - 1) {
+            ds_put_format(ds, ",le=\"+Inf\"} %llu\n", cumulative);
+        } else {
+            ds_put_format(ds, ",le=\"%.6f\"} %llu\n",
+                          ((1ULL << (i + 1)) - 1) / 1e6, cumulative);
+        }
+    }
+    ds_put_format(ds, "%s_count{%s=", name, label);
+    metrics_put_label_value(ds, value);
+    ds_put_format(ds, "} %llu\n", hist->count);
+    ds_put_format(ds, "%s_sum{%s=", name, label);
+    metrics_put_label_value(ds, value);
+    ds_put_format(ds, "} %.6f\n", hist->total / 1e6);
+}
+
+static void
+metrics_render_boot(const struct sysd_ctx *ctx, struct ds *ds)
+{
+    const struct sysd_boot_times *times = &ctx->boot_times;
+    long long int start = times->start;
+    int i;
+
+    metrics_put_header(ds, "sysd_uptime_seconds", "gauge",
+                       "Time since sysd started.");
+    ds_put_format(ds, "sysd_uptime_seconds %.3f\n",
+                  (time_msec() - start) / 1000.0);
+
+    metrics_put_header(ds, "sysd_boot_stage_seconds", "gauge",
+                       "Time from sysd start to each startup milestone.");
+    if (times->initial_config) {
+        metrics_put_seconds(ds, "sysd_boot_stage_seconds", "stage",
+                            "initial_config",
+                            times->initial_config - start);
+    }
+    if (times->hw_init_done) {
+        metrics_put_seconds(ds, "sysd_boot_stage_seconds", "stage",
+                            "hw_init_done",
+                            times->hw_init_done - start);
+    }
+    for (i = 1; i <= ctx->num_hw_levels; i++) {
+        if (times->hw_levels[i]) {
+            char *level = xasprintf("hw_level_%d", i);
+
+            metrics_put_seconds(ds, "sysd_boot_stage_seconds", "stage",
+                                level, times->hw_levels[i] - start);
+            free(level);
+        }
+    }
+
+    metrics_put_header(ds, "sysd_daemon_ready_seconds", "gauge",
+                       "Time from sysd start until a hardware daemon "
+                       "reported cur_hw.");
+    for (i = 0; i < ctx->num_daemons; i++) {
+        const daemon_info_t *daemon = ctx->daemons[i];
+
+        if (daemon->is_hw_handler && daemon->ready_msec) {
+            metrics_put_seconds(ds, "sysd_daemon_ready_seconds", "daemon",
+                                daemon->name, daemon->ready_msec - start);
+        }
+    }
+
+    metrics_put_header(ds, "sysd_daemon_generation", "gauge",
+                       "Times a hardware daemon has reported cur_hw, "
+                       "restarts included.");
+    for (i = 0; i < ctx->num_daemons; i++) {
+        const daemon_info_t *daemon = ctx->daemons[i];
+
+        if (daemon->is_hw_handler) {
+            ds_put_cstr(ds, "sysd_daemon_generation{daemon=");
+            metrics_put_label_value(ds, daemon->name);
+            ds_put_format(ds, "} %u\n", daemon->generation);
+        }
+    }
+
+    metrics_put_header(ds, "sysd_daemon_reinit_seconds", "gauge",
+                       "Time a restarted hardware daemon last took to "
+                       "report cur_hw again.");
+    for (i = 0; i < ctx->num_daemons; i++) {
+        const daemon_info_t *daemon = ctx->daemons[i];
+
+        if (daemon->is_hw_handler && daemon->last_reinit_ms) {
+            metrics_put_seconds(ds, "sysd_daemon_reinit_seconds", "daemon",
+                                daemon->name, daemon->last_reinit_ms);
+        }
+    }
+}
+
+static void
+metrics_render_txns(const struct sysd_ctx *ctx, struct ds *ds)
+{
+    const struct sysd_txn_site_stats *stats = ctx->txns.stats.sites;
+    const struct sysd_write_stats *writes = &ctx->txns.writes;
+    int i;
+
+    metrics_put_header(ds, "sysd_txn_commits", "counter",
+                       "OVSDB transactions committed.");
+    for (i = 0; i < SYSD_TXN_N_SITES; i++) {
+        ds_put_cstr(ds, "sysd_txn_commits_total{site=");
+        metrics_put_label_value(ds, sysd_txn_site_name(i));
+        ds_put_format(ds, "} %llu\n", stats[i].commits);
+    }
+
+    metrics_put_header(ds, "sysd_txn_failures", "counter",
+                       "OVSDB transactions that did not succeed.");
+    for (i = 0; i < SYSD_TXN_N_SITES; i++) {
+        ds_put_cstr(ds, "sysd_txn_failures_total{site=");
+        metrics_put_label_value(ds, sysd_txn_site_name(i));
+        ds_put_format(ds, "} %llu\n", stats[i].failures);
+    }
+
+    metrics_put_header(ds, "sysd_txn_rows", "counter",
+                       "Rows inserted or modified by OVSDB transactions.");
+    for (i = 0; i < SYSD_TXN_N_SITES; i++) {
+        ds_put_cstr(ds, "sysd_txn_rows_total{site=");
+        metrics_put_label_value(ds, sysd_txn_site_name(i));
+        ds_put_format(ds, "} %llu\n", stats[i].total_rows);
+    }
+
+    metrics_put_header(ds, "sysd_txn_commit_seconds", "histogram",
+                       "OVSDB transaction commit latency.");
+    for (i = 0; i < SYSD_TXN_N_SITES; i++) {
+        metrics_put_histogram(ds, "sysd_txn_commit_seconds", "site",
+                              sysd_txn_site_name(i),
+                              &stats[i].usec);
+    }
+
+    metrics_put_header(ds, "sysd_column_writes", "counter",
+                       "OVSDB column writes sent by sysd.");
+    ds_put_format(ds, "sysd_column_writes_total %llu\n", writes->written);
+    metrics_put_header(ds, "sysd_column_writes_elided", "counter",
+                       "OVSDB column writes dropped because the column "
+                       "already held the value.");
+    ds_put_format(ds, "sysd_column_writes_elided_total %llu\n",
+                  writes->elided);
+}
+
+static void
+metrics_render_loop(const struct sysd_ctx *ctx, struct ds *ds)
+{
+    const struct sysd_loop_stats *stats = &ctx->loop.stats;
+    int i;
+
+    metrics_put_header(ds, "sysd_loop_stalls", "counter",
+                       "Main loop iterations over the stall threshold.");
+    ds_put_format(ds, "sysd_loop_stalls_total %llu\n", stats->stalls);
+
+    metrics_put_header(ds, "sysd_loop_stage_seconds", "histogram",
+                       "Time spent per main loop iteration in each stage.");
+    for (i = 0; i < SYSD_LOOP_N_STAGES; i++) {
+        metrics_put_histogram(ds, "sysd_loop_stage_seconds", "stage",
+                              sysd_loop_stage_name(i), &stats->stages[i]);
+    }
+}
+
+static void
+metrics_render_macs(const struct sysd_ctx *ctx, struct ds *ds)
+{
+    int i;
+
+    metrics_put_header(ds, "sysd_mac_pool_size", "gauge",
+                       "MAC addresses in the subsystem's FRU EEPROM pool.");
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        ds_put_cstr(ds, "sysd_mac_pool_size{subsystem=");
+        metrics_put_label_value(ds, ctx->subsystems[i]->name);
+        ds_put_format(ds, "} %d\n", ctx->subsystems[i]->fru_eeprom.num_macs);
+    }
+
+    metrics_put_header(ds, "sysd_mac_pool_free", "gauge",
+                       "MAC addresses not yet assigned.");
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        ds_put_cstr(ds, "sysd_mac_pool_free{subsystem=");
+        metrics_put_label_value(ds, ctx->subsystems[i]->name);
+        ds_put_format(ds, "} %d\n", ctx->subsystems[i]->num_free_macs);
+    }
+}
+
+/*
+ * Function       : sysd_metrics_render
+ * Responsibility : renders every sysd metric in the OpenMetrics text format
+ * Parameters     : ctx, ds
+ * Returns        : void
+ */
+void
+sysd_metrics_render(const struct sysd_ctx *ctx, struct ds *ds)
+{
+    int i;
+
+    for (i = 0; i < SYSD_METRIC_N_COUNTERS; i++) {
+        metrics_put_header(ds, sysd_metric_counters[i].name, "counter",
+                           sysd_metric_counters[i].help);
+        ds_put_format(ds, "%s_total %llu\n", sysd_metric_counters[i].name,
+                      ctx->metrics[i]);
+    }
+
+    metrics_render_boot(ctx, ds);
+    metrics_render_txns(ctx, ds);
+    metrics_render_loop(ctx, ds);
+    metrics_render_macs(ctx, ds);
+
+    ds_put_cstr(ds, "# EOF\n");
+
+} /* sysd_metrics_render */
+
+/*
+ * Function       : sysd_metrics_socket_open
+ * Responsibility : starts listening for metrics scrapers on a Unix socket
+ * Parameters     : socket path
+ * Returns        : 0 on success, otherwise a positive errno value
+ */
+int
+sysd_metrics_socket_open(const char *path)
+{
+    char *name = xasprintf("punix:%s", path);
+    int error;
+
+    error = pstream_open(name, &metrics_pstream, DSCP_DEFAULT);
+    if (error) {
+        VLOG_ERR("Unable to listen for metrics on %s (%s)",
+                 path, ovs_strerror(error));
+        metrics_pstream = NULL;
+    }
+    free(name);
+    return error;
+
+} /* sysd_metrics_socket_open */
+
+static void
+metrics_conn_close(size_t idx)
+{
+    struct sysd_metrics_conn *conn = &metrics_conns[idx];
+
+    stream_close(conn->stream);
+    ds_destroy(&conn->out);
+    metrics_conns[idx] = metrics_conns[--n_metrics_conns];
+}
+
+void
+sysd_metrics_run(const struct sysd_ctx *ctx)
+{
+    static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 5);
+    size_t i;
+
+    if (!metrics_pstream) {
+        return;
+    }
+
+    while (n_metrics_conns < SYSD_METRICS_MAX_CONNS) {
+        struct sysd_metrics_conn *conn;
+        struct stream *stream;
+        int error;
+
+        error = pstream_accept(metrics_pstream, &stream);
+        if (error) {
+            if (error != EAGAIN) {
+                VLOG_WARN_RL(&rl, "metrics socket accept failed (%s)",
+                             ovs_strerror(error));
+            }
+            break;
+        }
+
+        conn = &metrics_conns[n_metrics_conns++];
+        conn->stream = stream;
+        conn->sent = 0;
+        ds_init(&conn->out);
+        sysd_metrics_render(ctx, &conn->out);
+    }
+
+    for (i = 0; i < n_metrics_conns; ) {
+        struct sysd_metrics_conn *conn = &metrics_conns[i];
+        int retval;
+
+        stream_run(conn->stream);
+        retval = stream_send(conn->stream, conn->out.string + conn->sent,
+                             conn->out.length - conn->sent);
+        if (retval > 0) {
+            conn->sent += retval;
+        }
+
+        if ((retval < 0 && retval != -EAGAIN)
+            || conn->sent == conn->out.length) {
+            metrics_conn_close(i);
+        } else {
+            i++;
+        }
+    }
+
+} /* sysd_metrics_run */
+
+void
+sysd_metrics_wait(const struct sysd_ctx *ctx OVS_UNUSED)
+{
+    size_t i;
+
+    if (!metrics_pstream) {
+        return;
+    }
+
+    if (n_metrics_conns < SYSD_METRICS_MAX_CONNS) {
+        pstream_wait(metrics_pstream);
+    }
+    for (i = 0; i < n_metrics_conns; i++) {
+        stream_run_wait(metrics_conns[i].stream);
+        stream_send_wait(metrics_conns[i].stream);
+    }
+
+} /* sysd_metrics_wait */
+/** @} end of group ops-sysd */
@@ -22,6 +22,7 @@
  * Source for sysd OVSDB access interface.
  */
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
@@ -33,8 +34,14 @@
 #include <dirs.h>
 #include <smap.h>
 #include <shash.h>
+#include <sset.h>
 #include <poll-loop.h>
+#include <timeval.h>
+#include <dynamic-string.h>
+#include <unixctl.h>
+#include <ovsdb-data.h>
 #include <ovsdb-idl.h>
+#include <ovsdb-idl-provider.h>
 #include <openswitch-idl.h>
 #include <vswitch-idl.h>
 #include <openvswitch/vlog.h>
@@ -42,10 +49,18 @@
 #include <ops-utils.h>
 #include <config-yaml.h>
 #include <yaml.h>
+#include "qos_defaults.h"
 #include "qos_init.h"
 #include "sysd.h"
+#include "sysd_ctx.h"
 #include "sysd_util.h"
 #include "sysd_ovsdb_if.h"
+#include "sysd_replay.h"
+#include "sysd_txn.h"
+#include "sysd_txn_stats.h"
+#include "sysd_write.h"
+#include "sysd_metrics.h"
+#include "sysd_trace.h"
 #include "eventlog.h"
 
 VLOG_DEFINE_THIS_MODULE(ovsdb_if);
@@ -53,7 +68,6 @@ VLOG_DEFINE_THIS_MODULE(ovsdb_if);
 /** @ingroup sysd
  * @{ */
 #define PKG_INFO_ENTRIES_PER_COMMIT 2000
-#define REM_BUF_LEN (buflen - 1 - strlen(buf))
 
 enum {
     VALUE,
@@ -74,9 +88,10 @@ const char * keystr_pkg_info[MAX_NUM_KEYS] = {
     "TYPE",
 };
 
-extern char *g_hw_desc_dir;
-
-static bool hw_init_done_set = false;
+/* Daemon:cur_hw sysd writes for a h/w daemon that missed its readiness
+ * deadline.  Anything that waits for cur_hw > 0 keeps waiting, and the
+ * daemon overwrites it when it does finish. */
+#define SYSD_DAEMON_CUR_HW_EXPIRED -1
 
 void
 sysd_get_speeds_string(char *speed_str, int len, int **speeds)
@@ -252,8 +267,43 @@ sysd_initial_daemon_add(struct ovsdb_idl_txn *txn, daemon_info_t *daemon_ptr)
 
 } /* sysd_initial_daemon_add */
 
+/*
+ * Function       : sysd_fru_other_info
+ * Responsibility : sets the Subsystem:other_info keys read from the FRU
+ *                  EEPROM, replacing any already in 'other_info'
+ * Parameters     : other_info, fru
+ * Returns        : void
+ */
+static void
+sysd_fru_other_info(struct smap *other_info, const fru_eeprom_t *fru)
+{
+    char    buf[32];
+
+    smap_replace(other_info, "country_code", fru->country_code);
+    snprintf(buf, sizeof(buf), "%c", fru->device_version);
+    smap_replace(other_info, "device_version", buf);
+    smap_replace(other_info, "diag_version", fru->diag_version);
+    smap_replace(other_info, "label_revision", fru->label_revision);
+    snprintf(buf, sizeof(buf), "%02x:%02x:%02x:%02x:%02x:%02x",
+             SYSD_MAC_FORMAT(fru->base_mac_address));
+    smap_replace(other_info, "base_mac_address", buf);
+    snprintf(buf, sizeof(buf), "%d", fru->num_macs);
+    smap_replace(other_info, "number_of_macs", buf);
+    smap_replace(other_info, "manufacturer", fru->manufacturer);
+    smap_replace(other_info, "manufacture_date", fru->manufacture_date);
+    smap_replace(other_info, "onie_version", fru->onie_version);
+    smap_replace(other_info, "part_number", fru->part_number);
+    smap_replace(other_info, "Product Name", fru->product_name);
+    smap_replace(other_info, "platform_name", fru->platform_name);
+    smap_replace(other_info, "serial_number", fru->serial_number);
+    smap_replace(other_info, "vendor", fru->vendor);
+
+} /* sysd_fru_other_info */
+
 struct ovsrec_subsystem *
-sysd_initial_subsystem_add(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_ptr)
+sysd_initial_subsystem_add(const struct sysd_ctx *ctx,
+                           struct ovsdb_idl_txn *txn,
+                           sysd_subsystem_t *subsys_ptr)
 {
     int                         i = 0;
     fru_eeprom_t                *fru = NULL;
@@ -270,26 +320,16 @@ sysd_initial_subsystem_add(struct ovsdb_idl_txn *txn, sysd_subsystem_t *subsys_p
 
     ovsrec_subsystem_set_name(ovs_subsys, subsys_ptr->name);
     ovsrec_subsystem_set_asset_tag_number(ovs_subsys, DFLT_ASSET_TAG);
-    ovsrec_subsystem_set_hw_desc_dir(ovs_subsys, g_hw_desc_dir);
+    ovsrec_subsystem_set_hw_desc_dir(ovs_subsys, ctx->hw_desc_dir);
 
     smap_init(&other_info);
 
-    smap_add(&other_info, "country_code", fru->country_code);
-    smap_add_format(&other_info, "device_version", "%c", fru->device_version);
-    smap_add(&other_info, "diag_version", fru->diag_version);
-    smap_add(&other_info, "label_revision", fru->label_revision);
-    smap_add_format(&other_info, "base_mac_address",
-                    "%02x:%02x:%02x:%02x:%02x:%02x",
-                    SYSD_MAC_FORMAT(fru->base_mac_address));
-    smap_add_format(&other_info, "number_of_macs", "%d", fru->num_macs);
-    smap_add(&other_info, "manufacturer", fru->manufacturer);
-    smap_add(&other_info, "manufacture_date", fru->manufacture_date);
-    smap_add(&other_info, "onie_version", fru->onie_version);
-    smap_add(&other_info, "part_number", fru->part_number);
-    smap_add(&other_info, "Product Name", fru->product_name);
-    smap_add(&other_info, "platform_name", fru->platform_name);
-    smap_add(&other_info, "serial_number", fru->serial_number);
-    smap_add(&other_info, "vendor", fru->vendor);
+    sysd_fru_other_info(&other_info, fru);
+    if (subsys_ptr->placeholders) {
+        /* Rows emitted for an image; the box patches them at boot. */
+        smap_add(&other_info, SYSD_PER_BOX_PENDING_KEY,
+                 SYSD_PER_BOX_PENDING_VALUE);
+    }
 
     smap_add_format(&other_info, "interface_count",
                     "%d", subsys_ptr->intf_cmn_info->number_ports);
@@ -427,13 +467,92 @@ package_info_mapping_check_key(const char *data)
     return VALUE;
 }
 
+static size_t
+sysd_package_info_build(struct ovsdb_idl_txn *txn, void *batch_)
+{
+    const struct sysd_pkg_batch *batch = batch_;
+    size_t i;
+
+    for (i = 0; i < batch->n; i++) {
+        const struct sysd_pkg_info *info = &batch->rows[i];
+        struct ovsrec_package_info *row = ovsrec_package_info_insert(txn);
+
+        ovsrec_package_info_set_name(row, info->name);
+        if (info->version) {
+            ovsrec_package_info_set_version(row, info->version);
+        }
+        if (info->src_url) {
+            ovsrec_package_info_set_src_url(row, info->src_url);
+        }
+        if (info->src_type) {
+            ovsrec_package_info_set_src_type(row, info->src_type);
+        }
+    }
+    return batch->n;
+}
+
+static void
+sysd_package_info_done(enum ovsdb_idl_txn_status status, size_t n_changed,
+                       void *batch_)
+{
+    struct sysd_pkg_batch *batch = batch_;
+
+    if (status == TXN_SUCCESS) {
+        VLOG_INFO("Populated Package_Info with %"PRIuSIZE" entries",
+                  n_changed);
+        sysd_metric_add(batch->ctx, SYSD_METRIC_PACKAGE_INFO_ROWS, n_changed);
+    } else {
+        VLOG_ERR("Commit failed to Package_Info. rc = %u", status);
+    }
+
+    sysd_pkg_batch_destroy(batch);
+}
+
+static void
+sysd_package_info_submit(struct sysd_pkg_batch *batch, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+
+    batch->ctx = ctx;
+    sysd_txn_submit(&ctx->txns, SYSD_TXN_PACKAGE_INFO,
+                    sysd_package_info_build, sysd_package_info_done, batch);
+}
+
+/* Replaces '*field' with a copy of 'value'. */
+static void
+sysd_package_info_set(char **field, const char *value)
+{
+    free(*field);
+    *field = xstrdup(value);
+}
+
+void
+sysd_pkg_batch_destroy(struct sysd_pkg_batch *batch)
+{
+    size_t i;
+
+    for (i = 0; i < batch->n; i++) {
+        free(batch->rows[i].name);
+        free(batch->rows[i].version);
+        free(batch->rows[i].src_url);
+        free(batch->rows[i].src_type);
+    }
+    free(batch->rows);
+    free(batch);
+
+} /* sysd_pkg_batch_destroy */
+
 /*
- * Function to populate source url, type and version of each package/daemon
- * extracted from /var/lib/version_detail.yaml file to "Package_Info"
- * table in OVSDB.
+ * Function       : sysd_read_package_info
+ * Responsibility : extracts the name, source url, type and version of each
+ *                  package/daemon from a version_detail.yaml file, in
+ *                  batches of PKG_INFO_ENTRIES_PER_COMMIT rows
+ * Parameters     : path, function that takes ownership of each batch, aux
+ * Returns        : number of records read, or -1 if the file could not be
+ *                  read
  */
-static void
-sysd_add_package_info()
+int
+sysd_read_package_info(const char *path, sysd_pkg_batch_func *cb, void *aux)
 {
     FILE * fh         = NULL;
     int event_value   = 0;
@@ -442,22 +561,21 @@ sysd_add_package_info()
     int done          = 0;
     yaml_parser_t parser;
     yaml_event_t event;
-    struct ovsrec_package_info *row  = NULL;
-    struct ovsdb_idl_txn       *txn  = NULL;
-    enum ovsdb_idl_txn_status  txn_status = TXN_ERROR;
+    struct sysd_pkg_info   *row   = NULL;
+    struct sysd_pkg_batch  *batch = NULL;
 
     /* Initialize parser */
     if (!yaml_parser_initialize(&parser)) {
         VLOG_ERR("Failed to initialize parser\n");
-        return;
+        return -1;
     }
 
-    /* Open /var/lib/version_detail.yaml file */
-    fh = fopen(VERSION_DETAIL_FILE_PATH, "r");
+    /* Open the version_detail.yaml file */
+    fh = fopen(path, "r");
     if (NULL == fh) {
-        VLOG_ERR("Failed to open file %s\n",VERSION_DETAIL_FILE_PATH);
+        VLOG_ERR("Failed to open file %s\n", path);
         yaml_parser_delete(&parser);
-        return;
+        return -1;
     }
 
     /* Set input file */
@@ -475,49 +593,53 @@ sysd_add_package_info()
         }
 
         if (event.type == YAML_SCALAR_EVENT) {
-            event_value = package_info_mapping_check_key ((const char *)
-            event.data.scalar.value);
+            const char *value = (const char *) event.data.scalar.value;
+
+            event_value = package_info_mapping_check_key(value);
             switch (event_value) {
                 case VALUE:
                 {
                     switch(current_state) {
                         case PKG:
-                            if ((record_count % PKG_INFO_ENTRIES_PER_COMMIT) == 0) {
-                                txn = ovsdb_idl_txn_create(idl);
+                            if (batch == NULL) {
+                                batch = xzalloc(sizeof *batch);
+                            } else if (batch->n
+                                       == PKG_INFO_ENTRIES_PER_COMMIT) {
+                                /* Rows without a type still count. */
+                                cb(batch, aux);
+                                batch = xzalloc(sizeof *batch);
                             }
-                            row = ovsrec_package_info_insert(txn);
-                            if (NULL == row) {
-                                VLOG_ERR("Could not insert a row into DB\n");
-                                /* Cleanup */
-                                yaml_event_delete(&event);
-                                yaml_parser_delete(&parser);
-                                fclose(fh);
-                                ovsdb_idl_txn_destroy(txn);
-                                return;
+                            if (batch->n == batch->allocated) {
+                                batch->rows = x2nrealloc(batch->rows,
+                                                         &batch->allocated,
+                                                         sizeof *batch->rows);
                             }
-                            ovsrec_package_info_set_name(row,
-                            (const char *)event.data.scalar.value);
+                            row = &batch->rows[batch->n++];
+                            memset(row, 0, sizeof *row);
+                            row->name = xstrdup(value);
                             break;
                         case PV:
-                            ovsrec_package_info_set_version(row,
-                            (const char *)event.data.scalar.value);
+                            if (row) {
+                                sysd_package_info_set(&row->version, value);
+                            }
                             break;
                         case SRCREV:
-                            if(((const char*)event.data.scalar.value != NULL)
-                            && strcmp((const char*)event.data.scalar.value,
-                            "INVALID")) {
-                                ovsrec_package_info_set_version(row,
-                                (const char *)event.data.scalar.value);
+                            if (row && value != NULL
+                                && strcmp(value, "INVALID")) {
+                                sysd_package_info_set(&row->version, value);
                             }
                             break;
                         case SRC_URL:
-                            ovsrec_package_info_set_src_url(row,
-                            (const char *)event.data.scalar.value);
+                            if (row) {
+                                sysd_package_info_set(&row->src_url, value);
+                            }
                             break;
                         case TYPE:
+                            if (row == NULL) {
+                                break;
+                            }
                             record_count++;
-                            ovsrec_package_info_set_src_type(row,
-                            (const char *)event.data.scalar.value);
+                            sysd_package_info_set(&row->src_type, value);
 
                             /*
                              * Commit the transaction for every
@@ -525,15 +647,9 @@ sysd_add_package_info()
                              */
                             if ((record_count % PKG_INFO_ENTRIES_PER_COMMIT)
                                 == 0) {
-                                txn_status = ovsdb_idl_txn_commit_block(txn);
-                                VLOG_INFO("Populating Package_Info with"
-                                          "%d entries\n", record_count);
-                                if (txn_status != TXN_SUCCESS) {
-                                    VLOG_ERR("Commit failed to Package_Info."
-                                             "rc = %u", txn_status);
-                                }
-                                ovsdb_idl_txn_destroy(txn);
-                                txn = NULL;
+                                cb(batch, aux);
+                                batch = NULL;
+                                row = NULL;
                             }
                             break;
                     }
@@ -562,28 +678,47 @@ sysd_add_package_info()
         yaml_event_delete(&event);
     }
 
-    if (txn != NULL) {
-        txn_status = ovsdb_idl_txn_commit_block(txn);
-        VLOG_INFO("Populating Package_Info with %d entries\n", record_count);
-        if (txn_status != TXN_SUCCESS) {
-            VLOG_ERR("Commit failed to Package_Info. rc = %u", txn_status);
-        }
-        ovsdb_idl_txn_destroy(txn);
-        txn = NULL;
+    if (batch != NULL) {
+        cb(batch, aux);
     }
 
     /* Cleanup */
     yaml_parser_delete(&parser);
     fclose(fh);
 
+    return record_count;
+
+} /* sysd_read_package_info */
+
+/*
+ * Function to populate source url, type and version of each package/daemon
+ * extracted from /var/lib/version_detail.yaml file, under
+ * $OPENSWITCH_INSTALL_PATH if it is set, to "Package_Info"
+ * table in OVSDB.  The rows are queued in batches of
+ * PKG_INFO_ENTRIES_PER_COMMIT, one transaction each.
+ */
+static void
+sysd_add_package_info(struct sysd_ctx *ctx)
+{
+    char path[1024];
+    int record_count;
+
+    sysd_install_path(path, sizeof path, VERSION_DETAIL_FILE_PATH);
+    record_count = sysd_read_package_info(path, sysd_package_info_submit,
+                                          ctx);
+    if (record_count >= 0) {
+        VLOG_INFO("Queued %d Package_Info entries", record_count);
+    }
+
 } /* sysd_add_package_info */
 
 /*
  * Function to update the software info, e.g. software name, switch version,
- * in the OVSDB retrieved from the Release file.
+ * in the OVSDB retrieved from the Release file.  Columns that already hold
+ * the values are not written.  Returns the number of columns written.
  */
-static void
-sysd_update_sw_info(const struct ovsrec_system *cfg)
+static size_t
+sysd_update_sw_info(struct sysd_ctx *ctx, const struct ovsrec_system *cfg)
 {
 #define NSTR  80 /* Max length of each line of /etc/os-release. */
     struct smap smap = SMAP_INITIALIZER(&smap);
@@ -595,14 +730,17 @@ sysd_update_sw_info(const struct ovsrec_system *cfg)
     char   build_id[NSTR];
     char   build_str[NSTR];
     size_t line_len = 0;
+    size_t n_changed = 0;
+    char   path[1024];
     int i;
 
     /* Open os-release file with the os version information */
-    os_ver_fp = fopen(OS_RELEASE_FILE_PATH, "r");
+    sysd_install_path(path, sizeof path, OS_RELEASE_FILE_PATH);
+    os_ver_fp = fopen(path, "r");
     if (NULL == os_ver_fp) {
         VLOG_ERR("Unable to find system OS release. File %s was not found",
-                 OS_RELEASE_FILE_PATH);
-        return;
+                 path);
+        return 0;
     }
 
     /* Initialize the version_id and build_id to avoid the ops-sysd crash */
@@ -653,7 +791,8 @@ sysd_update_sw_info(const struct ovsrec_system *cfg)
 
     /* Update the software info column. */
     if (!smap_is_empty(&smap)) {
-        ovsrec_system_set_software_info(cfg, &smap);
+        n_changed += sysd_write_smap(&ctx->txns.writes, &cfg->header_,
+                                     &ovsrec_system_col_software_info, &smap);
     }
     smap_destroy(&smap);
 
@@ -661,18 +800,30 @@ sysd_update_sw_info(const struct ovsrec_system *cfg)
     if (build_id[0] != '\0' && version_id[0] != '\0') {
         /* Building the version string */
         snprintf(build_str, NSTR, "%s (Build: %s)", version_id, build_id);
-        ovsrec_system_set_switch_version(cfg, build_str);
+        n_changed += sysd_write_string(&ctx->txns.writes, &cfg->header_,
+                                       &ovsrec_system_col_switch_version,
+                                       build_str);
     } else {
         VLOG_ERR("%s or %s was not found on %s", OS_RELEASE_VERSION_NAME,
-                 OS_RELEASE_BUILD_NAME, OS_RELEASE_FILE_PATH);
-        return;
+                 OS_RELEASE_BUILD_NAME, path);
     }
+    return n_changed;
 
 } /* sysd_update_sw_info */
 
+static size_t
+sysd_update_sw_info_build(struct ovsdb_idl_txn *txn OVS_UNUSED, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+    const struct ovsrec_system *cfg = ovsrec_system_first(ctx->idl);
+
+    return cfg ? sysd_update_sw_info(ctx, cfg) : 0;
+}
+
 void
-sysd_initial_configure(struct ovsdb_idl_txn *txn)
+sysd_initial_configure(struct sysd_ctx *ctx, struct ovsdb_idl_txn *txn)
 {
+    const struct qos_defaults *qos_defaults = qos_defaults_get(ctx);
     int     i = 0;
     char    mac_addr[32];
     char    *tmp_p;
@@ -685,7 +836,7 @@ sysd_initial_configure(struct ovsdb_idl_txn *txn)
     sys = ovsrec_system_insert(txn);
 
     /* Add the interface name to ovsdb */
-    smap_add(&smap, SYSTEM_MGMT_INTF_MAP_NAME, mgmt_intf->name);
+    smap_add(&smap, SYSTEM_MGMT_INTF_MAP_NAME, ctx->mgmt_intf->name);
 
     ovsrec_system_set_mgmt_intf(sys, &smap);
     smap_destroy(&smap);
@@ -704,17 +855,20 @@ sysd_initial_configure(struct ovsdb_idl_txn *txn)
     */
 
     memset(mac_addr, 0, sizeof(mac_addr));
-    tmp_p = ops_ether_ulong_long_to_string(mac_addr, subsystems[0]->mgmt_mac_addr);
+    tmp_p = ops_ether_ulong_long_to_string(mac_addr,
+                                           ctx->subsystems[0]->mgmt_mac_addr);
     ovsrec_system_set_management_mac(sys, tmp_p);
 
     /* Assign general use MAC */
     /* OPS_TODO: Using subsystem[0] for now */
     memset(mac_addr, 0, sizeof(mac_addr));
-    tmp_p = ops_ether_ulong_long_to_string(mac_addr, subsystems[0]->system_mac_addr);
+    tmp_p = ops_ether_ulong_long_to_string(
+                mac_addr, ctx->subsystems[0]->system_mac_addr);
     ovsrec_system_set_system_mac(sys, tmp_p);
 
     /* Add the subsystem info to OVSD */
-    ovs_subsys_l = SYSD_OVS_PTR_CALLOC(ovsrec_subsystem *, num_subsystems);
+    ovs_subsys_l = SYSD_OVS_PTR_CALLOC(ovsrec_subsystem *,
+                                       ctx->num_subsystems);
     if (ovs_subsys_l == NULL) {
         VLOG_ERR("Failed to allocate memory for OVS subsystem.");
         log_event("SYS_ALLOCATE_MEMORY_FAILURE", EV_KV("value",
@@ -722,14 +876,15 @@ sysd_initial_configure(struct ovsdb_idl_txn *txn)
         return;
     }
 
-    for (i = 0; i < num_subsystems; i++) {
-        ovs_subsys_l[i] = sysd_initial_subsystem_add(txn, subsystems[i]);
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        ovs_subsys_l[i] = sysd_initial_subsystem_add(ctx, txn,
+                                                     ctx->subsystems[i]);
     }
 
-    ovsrec_system_set_subsystems(sys, ovs_subsys_l, num_subsystems);
+    ovsrec_system_set_subsystems(sys, ovs_subsys_l, ctx->num_subsystems);
 
     /* Add the daemon info to the daemon table */
-    ovs_daemon_l = SYSD_OVS_PTR_CALLOC(ovsrec_daemon *, num_daemons);
+    ovs_daemon_l = SYSD_OVS_PTR_CALLOC(ovsrec_daemon *, ctx->num_daemons);
     if (ovs_daemon_l == NULL) {
         VLOG_ERR("Failed to allocate memory for OVS daemon table.");
         log_event("SYS_ALLOCATE_MEMORY_FAILURE", EV_KV("value",
@@ -737,60 +892,287 @@ sysd_initial_configure(struct ovsdb_idl_txn *txn)
         return;
     }
 
-    if (num_daemons > 0) {
-        for (i = 0; i < num_daemons; i++) {
-            ovs_daemon_l[i] = sysd_initial_daemon_add(txn, daemons[i]);
+    if (ctx->num_daemons > 0) {
+        for (i = 0; i < ctx->num_daemons; i++) {
+            ovs_daemon_l[i] = sysd_initial_daemon_add(txn, ctx->daemons[i]);
         }
 
-        ovsrec_system_set_daemons(sys, ovs_daemon_l, num_daemons);
+        ovsrec_system_set_daemons(sys, ovs_daemon_l, ctx->num_daemons);
     }
 
     /*
      * Update the software info, including the switch version,
      * for the new config
      */
-    sysd_update_sw_info(sys);
+    sysd_update_sw_info(ctx, sys);
+    sysd_metric_inc(ctx, SYSD_METRIC_SW_INFO_REFRESHES);
 
     /* QoS init */
-    qos_init_trust(txn, sys);
-    qos_init_dscp_map(txn, sys);
-    qos_init_cos_map(txn, sys);
-    qos_init_queue_profile(txn, sys);
-    qos_init_schedule_profile(txn, sys);
+    qos_init_trust(&ctx->txns.writes, qos_defaults, txn, sys);
+    qos_init_dscp_map(qos_defaults, txn, sys);
+    qos_init_cos_map(qos_defaults, txn, sys);
+    qos_init_queue_profile(qos_defaults, txn, sys);
+    qos_init_schedule_profile(qos_defaults, txn, sys);
 } /* sysd_initial_configure */
 
+/*
+ * Function       : sysd_set_hw_level
+ * Responsibility : publishes a readiness level: System:cur_hw is the level
+ *                  reached and System:next_hw the last level.  With a
+ *                  single level both become 1 once every h/w daemon is done.
+ *                  After boot the level only moves while a restarted h/w
+ *                  daemon re-initializes.
+ * Parameters     : ctx, level reached
+ * Returns        : void
+ */
+static size_t
+sysd_hw_level_build(struct ovsdb_idl_txn *txn OVS_UNUSED, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+    const struct ovsrec_system *sys;
+    size_t n_changed = 0;
+
+    /* Writes the latest level, however many were reached while this
+     * write was queued. */
+    OVSREC_SYSTEM_FOR_EACH(sys, ctx->idl) {
+        n_changed += sysd_write_integer(&ctx->txns.writes, &sys->header_,
+                                        &ovsrec_system_col_cur_hw,
+                                        ctx->hw_level_set);
+        n_changed += sysd_write_integer(&ctx->txns.writes, &sys->header_,
+                                        &ovsrec_system_col_next_hw,
+                                        ctx->next_hw_set);
+    }
+    return n_changed;
+}
+
 static void
-sysd_set_hw_done(void)
+sysd_hw_level_done(enum ovsdb_idl_txn_status status,
+                   size_t n_changed OVS_UNUSED, void *ctx_)
 {
-    struct ovsdb_idl_txn                *txn = NULL;
-    const struct ovsrec_system    *sys = NULL;
-    enum ovsdb_idl_txn_status           txn_status = TXN_ERROR;
+    const struct sysd_ctx *ctx = ctx_;
 
-    txn = ovsdb_idl_txn_create(idl);
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        VLOG_ERR("Failed to set cur_hw = %d, next_hw = %d. rc = %u",
+                 ctx->hw_level_set, ctx->next_hw_set, status);
+    }
+}
 
-    OVSREC_SYSTEM_FOR_EACH(sys, idl) {
-        ovsrec_system_set_cur_hw(sys, (int64_t) 1);
-        ovsrec_system_set_next_hw(sys, (int64_t) 1);
+static void
+sysd_set_hw_level(struct sysd_ctx *ctx, int level)
+{
+    sysd_txn_submit(&ctx->txns, SYSD_TXN_HW_DONE, sysd_hw_level_build,
+                    sysd_hw_level_done, ctx);
+
+    ctx->hw_level_set = level;
+    ctx->next_hw_set = ctx->num_hw_levels;
+    if (ctx->hw_init_done_set) {
+        VLOG_INFO("H/W readiness level is now %d of %d",
+                  level, ctx->num_hw_levels);
+        return;
+    }
+    if (level > 0 && !ctx->boot_times.hw_levels[level]) {
+        ctx->boot_times.hw_levels[level] = time_msec();
     }
 
-    txn_status = ovsdb_idl_txn_commit_block(txn);
-    if (txn_status != TXN_SUCCESS) {
-        VLOG_ERR("Failed to set cur_hw, next_hw = 1. rc = %u", txn_status);
+    if (level < ctx->num_hw_levels) {
+        VLOG_INFO("H/W readiness level %d of %d reached",
+                  level, ctx->num_hw_levels);
+        return;
     }
-    ovsdb_idl_txn_destroy(txn);
 
-    hw_init_done_set = true;
+    ctx->hw_init_done_set = true;
+    ctx->boot_times.hw_init_done = time_msec();
 
     VLOG_INFO("H/W description file processing completed");
 
-} /* sysd_set_hw_done() */
+} /* sysd_set_hw_level() */
+
+static size_t
+sysd_reconcile_qos_defaults_build(struct ovsdb_idl_txn *txn, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+    const struct ovsrec_system *sys = ovsrec_system_first(ctx->idl);
+
+    return (sys
+            ? qos_reconcile_defaults(&ctx->txns.writes, ctx->idl,
+                                     qos_defaults_get(ctx), txn, sys)
+            : 0);
+}
 
 static void
-sysd_chk_if_hw_daemons_done(void)
+sysd_reconcile_qos_defaults_done(enum ovsdb_idl_txn_status status,
+                                 size_t n_changed, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+
+    if (status == TXN_SUCCESS) {
+        VLOG_INFO("Applied new QoS factory defaults to %"PRIuSIZE" rows",
+                  n_changed);
+        ctx->qos_defaults_reconciled = true;
+    } else if (status == TXN_UNCHANGED) {
+        ctx->qos_defaults_reconciled = true;
+    } else {
+        VLOG_ERR("Failed to apply new QoS factory defaults. rc = %u",
+                 status);
+    }
+}
+
+/*
+ * Function       : sysd_reconcile_qos_defaults
+ * Responsibility : applies factory QoS defaults that changed since the
+ *                  database was created (e.g. a new image with a different
+ *                  qos.yaml), leaving values the user changed alone.
+ * Parameters     : ctx
+ * Returns        : void
+ */
+static void
+sysd_reconcile_qos_defaults(struct sysd_ctx *ctx)
 {
+    if (!sysd_txn_is_pending(&ctx->txns, sysd_reconcile_qos_defaults_build,
+                             ctx)) {
+        sysd_txn_submit(&ctx->txns, SYSD_TXN_QOS_RECONCILE,
+                        sysd_reconcile_qos_defaults_build,
+                        sysd_reconcile_qos_defaults_done, ctx);
+    }
+
+} /* sysd_reconcile_qos_defaults */
+
+/*
+ * Function       : sysd_next_hw_deadline
+ * Responsibility : finds the earliest readiness deadline of the h/w daemons
+ *                  that have neither reported nor expired
+ * Parameters     : ctx
+ * Returns        : the deadline in msec, or LLONG_MAX if there is none
+ */
+static long long int
+sysd_next_hw_deadline(const struct sysd_ctx *ctx)
+{
+    long long int next = LLONG_MAX;
     int i;
-    int not_set = false;
-    int num_found = 0;
+
+    for (i = 0; i < ctx->num_daemons; i++) {
+        const daemon_info_t *daemon = ctx->daemons[i];
+
+        if (daemon->is_hw_handler && daemon->ready_timeout_ms
+            && !daemon->ready_msec && !daemon->expired_msec) {
+            next = MIN(next,
+                       daemon->listed_msec + daemon->ready_timeout_ms);
+        }
+    }
+    return next;
+
+} /* sysd_next_hw_deadline() */
+
+/* Marks the Daemon rows of h/w daemons that expired before they were ever
+ * ready.  The verify turns a daemon reporting at the last moment into
+ * TXN_TRY_AGAIN, and the rebuild then leaves its row alone. */
+static size_t
+sysd_hw_expired_build(struct ovsdb_idl_txn *txn OVS_UNUSED, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+    const struct ovsrec_daemon *db_daemon;
+    size_t n_changed = 0;
+
+    OVSREC_DAEMON_FOR_EACH(db_daemon, ctx->idl) {
+        const daemon_info_t *daemon = sysd_daemon_find(ctx, db_daemon->name);
+
+        if (daemon && daemon->is_hw_handler && daemon->expired_msec
+            && !daemon->ready_msec && db_daemon->cur_hw <= 0
+            && db_daemon->cur_hw != SYSD_DAEMON_CUR_HW_EXPIRED) {
+            ovsrec_daemon_verify_cur_hw(db_daemon);
+            n_changed += sysd_write_integer(&ctx->txns.writes,
+                                            &db_daemon->header_,
+                                            &ovsrec_daemon_col_cur_hw,
+                                            SYSD_DAEMON_CUR_HW_EXPIRED);
+        }
+    }
+    return n_changed;
+}
+
+/*
+ * Function       : sysd_hw_daemon_expired
+ * Responsibility : records that a h/w daemon missed its readiness deadline
+ *                  and applies its policy.  Its Daemon:cur_hw is set to
+ *                  SYSD_DAEMON_CUR_HW_EXPIRED by a queued write, unless
+ *                  the daemon writes the row first.
+ * Parameters     : ctx, daemon, current time
+ * Returns        : void
+ */
+static void
+sysd_hw_daemon_expired(struct sysd_ctx *ctx, daemon_info_t *daemon,
+                       long long int now)
+{
+    daemon->expired_msec = now;
+    sysd_metric_inc(ctx, SYSD_METRIC_HW_READY_TIMEOUTS);
+    sysd_txn_submit(&ctx->txns, SYSD_TXN_HW_EXPIRED, sysd_hw_expired_build,
+                    NULL, ctx);
+
+    switch (daemon->on_timeout) {
+    case SYSD_READY_BLOCK:
+        VLOG_ERR("%s is not ready after %lld ms; still waiting for it",
+                 daemon->name, daemon->ready_timeout_ms);
+        break;
+
+    case SYSD_READY_ALARM:
+        log_event("SYS_HW_DAEMON_READY_TIMEOUT", EV_KV("daemon",
+            "%s", daemon->name));
+        /* Fall through. */
+    case SYSD_READY_DEGRADED:
+    default:
+        VLOG_WARN("%s is not ready after %lld ms; continuing without it",
+                  daemon->name, daemon->ready_timeout_ms);
+        break;
+    }
+
+} /* sysd_hw_daemon_expired() */
+
+/*
+ * Function       : sysd_track_cur_hw
+ * Responsibility : follows one h/w daemon's Daemon:cur_hw across restarts.
+ *                  Each time the daemon becomes ready its generation goes
+ *                  up; when a daemon that was ready drops back to 0, the
+ *                  time until it is ready again is its re-initialization
+ *                  time.
+ * Parameters     : ctx, daemon, its Daemon:cur_hw, current time
+ * Returns        : void
+ */
+static void
+sysd_track_cur_hw(const struct sysd_ctx *ctx, daemon_info_t *daemon,
+                  int64_t cur_hw, long long int now)
+{
+    if (cur_hw != daemon->seen_cur_hw) {
+        /* daemons[] points into one contiguous table. */
+        SYSD_TRACE(SYSD_TRACE_CUR_HW, SYSD_TRACE_INSTANT,
+                   daemon - ctx->daemon_table, cur_hw);
+        daemon->seen_cur_hw = cur_hw;
+    }
+
+    if (cur_hw > 0) {
+        if (!daemon->ready_msec) {
+            daemon->ready_msec = now;
+            daemon->generation = 1;
+        } else if (daemon->reinit_msec) {
+            daemon->last_reinit_ms = now - daemon->reinit_msec;
+            daemon->reinit_msec = 0;
+            daemon->generation++;
+            VLOG_INFO("%s re-initialized in %lld ms",
+                      daemon->name, daemon->last_reinit_ms);
+        }
+    } else if (daemon->ready_msec && !daemon->reinit_msec) {
+        daemon->reinit_msec = now;
+        VLOG_WARN("%s reset cur_hw; waiting for it to re-initialize",
+                  daemon->name);
+    }
+
+} /* sysd_track_cur_hw() */
+
+static void
+sysd_chk_if_hw_daemons_done(struct sysd_ctx *ctx)
+{
+    int n_ready[SYSD_MAX_HW_LEVELS + 1] = { 0 };
+    int n_pending[SYSD_MAX_HW_LEVELS + 1] = { 0 };
+    long long int now = time_msec();
+    int level;
 
     const struct ovsrec_daemon *db_daemon;
 
@@ -809,56 +1191,317 @@ sysd_chk_if_hw_daemons_done(void)
      * have completed their processing and will then update...
      *      System:{cur_hw,next_hw} = 1.
      *
+     * When the manifest declares "hw_stage"s, the h/w daemons are split
+     * into readiness levels and System:cur_hw counts the levels completed
+     * in order, up to System:next_hw.
+     *
+     * A h/w daemon may have a "ready_timeout" in the manifest.  Once it
+     * passes, the daemon either keeps holding its level back ("block", the
+     * default) or is counted as done ("degraded" and "alarm").
+     *
      * The configuration daemon waits for sysd to set System:cur_hw=1
      * before it tries to push anything into the db, to ensure that all h/w
      * processing is done before any user configuration is pushed.
+     *
+     * Sysd keeps watching after boot.  A h/w daemon that restarts sets its
+     * cur_hw back to 0, and only the levels from its own up are withdrawn
+     * until it is ready again.  Level 1 is never withdrawn after boot, so
+     * the configuration push is not repeated.
     */
 
-    if (num_hw_daemons <= 0) {
-        sysd_set_hw_done();
+    if (ctx->num_hw_daemons <= 0) {
+        if (ctx->hw_level_set != ctx->num_hw_levels
+            || ctx->next_hw_set != ctx->num_hw_levels) {
+            sysd_set_hw_level(ctx, ctx->num_hw_levels);
+        }
         return;
     }
 
-    /* See if all h/w daemons have set cur_hw > 0 */
-    for (i = 0; i < num_daemons; i++) {
-        if (daemons[i]->is_hw_handler) {
-            OVSREC_DAEMON_FOR_EACH(db_daemon, idl) {
-                if (db_daemon->is_hw_handler) {
-                    if (strncmp(daemons[i]->name, db_daemon->name,
-                                strlen(daemons[i]->name)) == 0) {
-                        if (db_daemon->cur_hw > 0) {
-                            num_found++;
-                        } else {
-                            not_set = true;
-                        }
-                        break;
-                    }
-                }
-            }
+    /* See if all h/w daemons have set cur_hw > 0.  Each Daemon row is
+     * matched to the manifest through the name index. */
+    OVSREC_DAEMON_FOR_EACH(db_daemon, ctx->idl) {
+        daemon_info_t *daemon;
+
+        if (!db_daemon->is_hw_handler) {
+            continue;
+        }
+        daemon = sysd_daemon_find(ctx, db_daemon->name);
+        if (!daemon || !daemon->is_hw_handler) {
+            continue;
         }
-        if (not_set) {
+
+        sysd_track_cur_hw(ctx, daemon, db_daemon->cur_hw, now);
+        if (db_daemon->cur_hw > 0) {
+            n_ready[daemon->hw_level]++;
+            continue;
+        }
+
+        /* The deadline only covers the first initialization. */
+        if (!daemon->ready_msec
+            && !daemon->expired_msec && daemon->ready_timeout_ms
+            && now >= daemon->listed_msec + daemon->ready_timeout_ms) {
+            sysd_hw_daemon_expired(ctx, daemon, now);
+        }
+        if (daemon->expired_msec && daemon->on_timeout != SYSD_READY_BLOCK) {
+            n_ready[daemon->hw_level]++;
+        } else {
+            n_pending[daemon->hw_level]++;
+        }
+    }
+
+    /* A level is reached once its daemons and those of every lower level
+     * are done.  Not all set, try again later. */
+    for (level = 0; level < ctx->num_hw_levels; level++) {
+        if (n_pending[level + 1] || !n_ready[level + 1]) {
             break;
         }
     }
+    if (ctx->hw_init_done_set) {
+        level = MAX(level, 1);
+    }
+    /* A manifest reload may also have changed the number of levels. */
+    if (level != ctx->hw_level_set
+        || (ctx->next_hw_set && ctx->next_hw_set != ctx->num_hw_levels)) {
+        sysd_set_hw_level(ctx, level);
+    }
 
-    /* Not all set, try again later. */
-    if (not_set || (num_found == 0)) return;
+} /* sysd_chk_if_hw_daemons_done() */
 
-    /* All are set. Now set system table cur_hw, next_hw = 1 */
-    sysd_set_hw_done();
+static size_t
+sysd_initial_config_build(struct ovsdb_idl_txn *txn, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
 
-    return;
+    if (ovsrec_system_first(ctx->idl)) {
+        return 0;
+    }
+    sysd_initial_configure(ctx, txn);
+    sysd_replay_capture(&ctx->replay, ctx->idl);
+    return 1;
+}
 
-} /* sysd_chk_if_hw_daemons_done() */
+static void
+sysd_initial_config_done(enum ovsdb_idl_txn_status status,
+                         size_t n_changed OVS_UNUSED, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+
+    if (status == TXN_SUCCESS) {
+        /* The QoS rows were just created from the current factory
+         * defaults. */
+        ctx->qos_defaults_reconciled = true;
+        ctx->boot_times.initial_config = time_msec();
+        ctx->boot_times.initial_config_replayed = false;
+        sysd_replay_save(&ctx->replay);
+    } else if (status != TXN_UNCHANGED) {
+        VLOG_ERR("Failed to commit the transaction. rc = %u", status);
+    }
+}
+
+static void
+sysd_initial_config_submit(struct sysd_ctx *ctx)
+{
+    if (!sysd_txn_is_pending(&ctx->txns, sysd_initial_config_build, ctx)) {
+        sysd_txn_submit(&ctx->txns, SYSD_TXN_INITIAL_CONFIG,
+                        sysd_initial_config_build,
+                        sysd_initial_config_done, ctx);
+    }
+}
+
+/*
+ * Function       : sysd_initial_config_start
+ * Responsibility : populates an empty database, by replaying the initial
+ *                  configuration recorded on an earlier boot if there is
+ *                  one that still matches, or else by building it
+ * Parameters     : ctx
+ * Returns        : void
+ */
+static void
+sysd_initial_config_start(struct sysd_ctx *ctx)
+{
+    if (sysd_txn_is_pending(&ctx->txns, sysd_initial_config_build, ctx)
+        || sysd_replay_start(&ctx->replay)) {
+        return;
+    }
+    sysd_initial_config_submit(ctx);
+
+} /* sysd_initial_config_start */
+
+/*
+ * Function       : sysd_per_box_patch
+ * Responsibility : writes the values of this box over the placeholders in
+ *                  a Subsystem row emitted by "ops-sysd --emit-db", its
+ *                  interfaces and, for the base subsystem, the System row
+ * Parameters     : ctx, sys, row - Subsystem row, subsys - its subsystem
+ * Returns        : number of columns written
+ */
+static size_t
+sysd_per_box_patch(struct sysd_ctx *ctx,
+                   const struct ovsrec_system *sys,
+                   const struct ovsrec_subsystem *row,
+                   const sysd_subsystem_t *subsys)
+{
+    size_t  i = 0;
+    size_t  n = 0;
+    char    mac_addr[32];
+    char    *tmp_p;
+    struct smap smap;
+
+    smap_clone(&smap, &row->other_info);
+    smap_remove(&smap, SYSD_PER_BOX_PENDING_KEY);
+    sysd_fru_other_info(&smap, &subsys->fru_eeprom);
+    n += sysd_write_smap(&ctx->txns.writes, &row->header_,
+                         &ovsrec_subsystem_col_other_info, &smap);
+    smap_destroy(&smap);
+
+    n += sysd_write_string(&ctx->txns.writes, &row->header_,
+                           &ovsrec_subsystem_col_hw_desc_dir,
+                           ctx->hw_desc_dir);
+
+    memset(mac_addr, 0, sizeof(mac_addr));
+    tmp_p = ops_ether_ulong_long_to_string(mac_addr, subsys->nxt_mac_addr);
+    n += sysd_write_string(&ctx->txns.writes, &row->header_,
+                           &ovsrec_subsystem_col_next_mac_address, tmp_p);
+    n += sysd_write_integer(&ctx->txns.writes, &row->header_,
+                            &ovsrec_subsystem_col_macs_remaining,
+                            subsys->num_free_macs);
+
+    /* Same rule as sysd_initial_interface_add(). */
+    memset(mac_addr, 0, sizeof(mac_addr));
+    tmp_p = ops_ether_ulong_long_to_string(mac_addr,
+                                           subsys->system_mac_addr);
+    for (i = 0; i < row->n_interfaces; i++) {
+        const struct ovsrec_interface *intf = row->interfaces[i];
+
+        smap_clone(&smap, &intf->hw_intf_info);
+        if (subsys->system_mac_addr) {
+            smap_replace(&smap, INTERFACE_HW_INTF_INFO_MAP_MAC_ADDR, tmp_p);
+        } else {
+            smap_remove(&smap, INTERFACE_HW_INTF_INFO_MAP_MAC_ADDR);
+        }
+        n += sysd_write_smap(&ctx->txns.writes, &intf->header_,
+                             &ovsrec_interface_col_hw_intf_info, &smap);
+        smap_destroy(&smap);
+    }
+
+    /* OPS_TODO: Using subsystem[0] for the System MACs, as
+     * sysd_initial_configure() does. */
+    if (subsys == ctx->subsystems[0]) {
+        n += sysd_write_string(&ctx->txns.writes, &sys->header_,
+                               &ovsrec_system_col_system_mac, tmp_p);
+
+        memset(mac_addr, 0, sizeof(mac_addr));
+        tmp_p = ops_ether_ulong_long_to_string(mac_addr,
+                                               subsys->mgmt_mac_addr);
+        n += sysd_write_string(&ctx->txns.writes, &sys->header_,
+                               &ovsrec_system_col_management_mac, tmp_p);
+    }
+
+    return n;
+
+} /* sysd_per_box_patch */
+
+static size_t
+sysd_per_box_build(struct ovsdb_idl_txn *txn OVS_UNUSED, void *ctx_)
+{
+    struct sysd_ctx *ctx = ctx_;
+    const struct ovsrec_system *sys = ovsrec_system_first(ctx->idl);
+    const struct ovsrec_subsystem *row;
+    size_t n = 0;
+    int i = 0;
+
+    if (!sys) {
+        return 0;
+    }
+
+    OVSREC_SUBSYSTEM_FOR_EACH (row, ctx->idl) {
+        if (!smap_get(&row->other_info, SYSD_PER_BOX_PENDING_KEY)) {
+            continue;
+        }
+        for (i = 0; i < ctx->num_subsystems; i++) {
+            if (!strcmp(ctx->subsystems[i]->name, row->name)) {
+                n += sysd_per_box_patch(ctx, sys, row, ctx->subsystems[i]);
+                break;
+            }
+        }
+        if (i == ctx->num_subsystems) {
+            VLOG_WARN("Subsystem %s was emitted for an image but is not "
+                      "present, leaving its per-box values unset",
+                      row->name);
+        }
+    }
+    return n;
+}
+
+static void
+sysd_per_box_done(enum ovsdb_idl_txn_status status, size_t n_changed,
+                  void *ctx_ OVS_UNUSED)
+{
+    if (status == TXN_SUCCESS) {
+        VLOG_INFO("Set %"PRIuSIZE" per-box columns of the emitted "
+                  "configuration", n_changed);
+    } else if (status != TXN_UNCHANGED) {
+        VLOG_ERR("Failed to set the per-box values. rc = %u", status);
+    }
+}
+
+/*
+ * Function       : sysd_per_box_check
+ * Responsibility : patches the per-box values into a database that was
+ *                  pre-seeded from "ops-sysd --emit-db", once
+ * Parameters     : ctx
+ * Returns        : void
+ */
+static void
+sysd_per_box_check(struct sysd_ctx *ctx)
+{
+    const struct ovsrec_subsystem *row;
+
+    if (sysd_txn_is_pending(&ctx->txns, sysd_per_box_build, ctx)) {
+        return;
+    }
+    OVSREC_SUBSYSTEM_FOR_EACH (row, ctx->idl) {
+        if (smap_get(&row->other_info, SYSD_PER_BOX_PENDING_KEY)) {
+            sysd_txn_submit(&ctx->txns, SYSD_TXN_PER_BOX, sysd_per_box_build,
+                            sysd_per_box_done, ctx);
+            return;
+        }
+    }
+
+} /* sysd_per_box_check */
+
+/* Collects the outcome of a replay started by sysd_initial_config_start(). */
+static void
+sysd_initial_config_replay_run(struct sysd_ctx *ctx)
+{
+    switch (sysd_replay_run(&ctx->replay, &ctx->txns.stats)) {
+    case SYSD_REPLAY_SUCCESS:
+        /* The QoS rows were recorded from the same factory defaults. */
+        ctx->qos_defaults_reconciled = true;
+        ctx->boot_times.initial_config = time_msec();
+        ctx->boot_times.initial_config_replayed = true;
+        break;
+
+    case SYSD_REPLAY_FAILED:
+        /* The build does nothing if the database is no longer empty. */
+        sysd_initial_config_submit(ctx);
+        break;
+
+    case SYSD_REPLAY_IDLE:
+    case SYSD_REPLAY_PENDING:
+        break;
+    }
+}
 
 void
-sysd_run(void)
+sysd_run(struct sysd_ctx *ctx)
 {
+    struct ovsdb_idl *idl = ctx->idl;
     uint32_t                            new_seqno = 0;
-    enum ovsdb_idl_txn_status           txn_status = TXN_ERROR;
-    struct ovsdb_idl_txn                *txn = NULL;
     const struct ovsrec_system    *cfg = NULL;
+    SYSD_TRACE(SYSD_TRACE_IDL_RUN, SYSD_TRACE_BEGIN, 0, 0);
     ovsdb_idl_run(idl);
+    SYSD_TRACE(SYSD_TRACE_IDL_RUN, SYSD_TRACE_END, 0, 0);
 
     if (ovsdb_idl_is_lock_contended(idl)) {
         static struct vlog_rate_limit rl = VLOG_RATE_LIMIT_INIT(1, 1);
@@ -872,85 +1515,479 @@ sysd_run(void)
         return;
     }
 
+    sysd_initial_config_replay_run(ctx);
+
     new_seqno = ovsdb_idl_get_seqno(idl);
-    if (new_seqno != idl_seqno) {
+    if (new_seqno != ctx->idl_seqno) {
+        sysd_metric_inc(ctx, SYSD_METRIC_IDL_SEQNO_CHANGES);
+        SYSD_TRACE(SYSD_TRACE_SEQNO_CHANGE, SYSD_TRACE_INSTANT, new_seqno, 0);
 
-        idl_seqno = ovsdb_idl_get_seqno(idl);
+        ctx->idl_seqno = ovsdb_idl_get_seqno(idl);
 
         cfg = ovsrec_system_first(idl);
 
         if (cfg == NULL) {
-            txn = ovsdb_idl_txn_create(idl);
-
-            sysd_initial_configure(txn);
-
-            txn_status = ovsdb_idl_txn_commit_block(txn);
-            if (txn_status != TXN_SUCCESS) {
-                VLOG_ERR("Failed to commit the transaction. rc = %u", txn_status);
-            }
-            ovsdb_idl_txn_destroy(txn);
+            sysd_initial_config_start(ctx);
         } else {
+            sysd_per_box_check(ctx);
+
             /* Update the software information. */
-            sysd_update_sw_info(cfg);
+            sysd_txn_submit(&ctx->txns, SYSD_TXN_SW_INFO,
+                            sysd_update_sw_info_build, NULL, ctx);
+            sysd_metric_inc(ctx, SYSD_METRIC_SW_INFO_REFRESHES);
 
-            if (!hw_init_done_set) {
-                sysd_chk_if_hw_daemons_done();
+            if (!ctx->qos_defaults_reconciled) {
+                sysd_reconcile_qos_defaults(ctx);
             }
+
+            sysd_chk_if_hw_daemons_done(ctx);
         }
 
         /* Populate source url and version of packages/daemon present in image */
-        if (ovsrec_package_info_first(idl) == NULL) {
-            sysd_add_package_info();
+        if (ovsrec_package_info_first(idl) == NULL
+            && !sysd_txn_site_is_pending(&ctx->txns, SYSD_TXN_PACKAGE_INFO)) {
+            sysd_add_package_info(ctx);
         }
     }
 
-    /* Notify parent of startup completion. */
-    daemonize_complete();
+    /* A readiness deadline may pass while the database is quiet. */
+    if (time_msec() >= sysd_next_hw_deadline(ctx)
+        && ovsrec_system_first(idl)) {
+        sysd_chk_if_hw_daemons_done(ctx);
+    }
+
+    sysd_txn_run(&ctx->txns, idl);
+
+    /* Notify parent of startup completion, once the System row exists:
+     * anything started after sysd may depend on it. */
+    if (ovsrec_system_first(idl)) {
+        daemonize_complete();
+    }
 
 } /* sysd_run */
 
+void
+sysd_wait(struct sysd_ctx *ctx)
+{
+    long long int deadline = sysd_next_hw_deadline(ctx);
+
+    ovsdb_idl_wait(ctx->idl);
+    sysd_txn_wait(&ctx->txns);
+    sysd_replay_wait(&ctx->replay);
+
+    if (deadline != LLONG_MAX) {
+        poll_timer_wait_until(deadline);
+    }
+
+} /* sysd_wait */
+
+/* A manifest reload waiting for its transaction. */
+struct sysd_reload {
+    struct sysd_ctx *ctx;
+    struct unixctl_conn *conn;      /* NULL when started by the watch. */
+    size_t n_inserted;
+    size_t n_deleted;
+    size_t n_updated;
+};
+
+static size_t
+sysd_reload_manifest_build(struct ovsdb_idl_txn *txn, void *reload_)
+{
+    struct sysd_reload *reload = reload_;
+    struct sysd_ctx *ctx = reload->ctx;
+    struct sset present = SSET_INITIALIZER(&present);
+    const struct ovsrec_system *sys;
+    const struct ovsrec_daemon *db_daemon;
+    struct ovsrec_daemon **rows;
+    size_t n_rows = 0;
+    int i;
+
+    reload->n_inserted = reload->n_deleted = reload->n_updated = 0;
+
+    sys = ovsrec_system_first(ctx->idl);
+    if (!sys) {
+        return 0;
+    }
+
+    rows = SYSD_OVS_PTR_CALLOC(ovsrec_daemon *,
+                               sys->n_daemons + ctx->num_daemons);
+    if (rows == NULL) {
+        VLOG_ERR("Failed to allocate memory for OVS daemon table.");
+        return 0;
+    }
+
+    OVSREC_DAEMON_FOR_EACH(db_daemon, ctx->idl) {
+        const daemon_info_t *daemon = sysd_daemon_find(ctx, db_daemon->name);
+
+        if (sset_contains(&ctx->daemons_to_delete, db_daemon->name)) {
+            ovsrec_daemon_delete(db_daemon);
+            reload->n_deleted++;
+            continue;
+        }
+        sset_add(&present, db_daemon->name);
+        if (daemon
+            && sysd_write_bool(&ctx->txns.writes, &db_daemon->header_,
+                               &ovsrec_daemon_col_is_hw_handler,
+                               daemon->is_hw_handler)) {
+            reload->n_updated++;
+        }
+    }
+
+    for (i = 0; i < sys->n_daemons; i++) {
+        if (!sset_contains(&ctx->daemons_to_delete, sys->daemons[i]->name)) {
+            rows[n_rows++] = sys->daemons[i];
+        }
+    }
+    for (i = 0; i < ctx->num_daemons; i++) {
+        if (!sset_contains(&present, ctx->daemons[i]->name)) {
+            rows[n_rows++] = sysd_initial_daemon_add(txn, ctx->daemons[i]);
+            reload->n_inserted++;
+        }
+    }
+
+    if (n_rows != sys->n_daemons || reload->n_inserted) {
+        ovsrec_system_verify_daemons(sys);
+        ovsrec_system_set_daemons(sys, rows, n_rows);
+    }
+
+    free(rows);
+    sset_destroy(&present);
+    return reload->n_inserted + reload->n_deleted + reload->n_updated;
+}
+
+static void
+sysd_reload_manifest_done(enum ovsdb_idl_txn_status status,
+                          size_t n_changed OVS_UNUSED, void *reload_)
+{
+    struct sysd_reload *reload = reload_;
+    struct sysd_ctx *ctx = reload->ctx;
+    char *reply;
+
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        VLOG_ERR("Failed to apply image.manifest. rc = %u", status);
+        if (reload->conn) {
+            reply = xasprintf("Failed to update the database (%s); "
+                              "reload again to retry",
+                              ovsdb_idl_txn_status_to_string(status));
+            unixctl_command_reply_error(reload->conn, reply);
+            free(reply);
+        }
+    } else {
+        reply = xasprintf("%d daemons listed: %"PRIuSIZE" rows inserted, "
+                          "%"PRIuSIZE" deleted, %"PRIuSIZE" updated",
+                          ctx->num_daemons, reload->n_inserted,
+                          reload->n_deleted, reload->n_updated);
+        VLOG_INFO("Reloaded image.manifest: %s", reply);
+        if (reload->conn) {
+            unixctl_command_reply(reload->conn, reply);
+        }
+        free(reply);
+        sset_clear(&ctx->daemons_to_delete);
+    }
+    free(reload);
+}
+
 /*
- * Function       : sysd_dump
- * Responsibility : populates buffer for unixctl reply
- * Parameters     : buffer, buffer length
+ * Function       : sysd_reload_manifest
+ * Responsibility : re-reads image.manifest and queues one transaction that
+ *                  applies the difference to the database.  Daemon rows
+ *                  are inserted for daemons that have none, deleted for
+ *                  daemons the manifest no longer lists and updated where
+ *                  is_hw_handler changed; System:daemons is only rewritten
+ *                  when rows come or go.  Before the initial configuration
+ *                  only the model changes, since that writes every row.
+ *                  Rows of dropped daemons are remembered until a commit
+ *                  deletes them, so a failed reload can be retried.
+ * Parameters     : ctx, unixctl connection to reply on once the
+ *                  transaction completes, or NULL
  * Returns        : void
  */
-
 void
-sysd_dump(char* buf, int buflen)
+sysd_reload_manifest(struct sysd_ctx *ctx, struct unixctl_conn *conn)
 {
-    char tmp_buf[100];
-    int i = 0;
+    struct sysd_reload *reload;
+    char *reply;
+    int i;
 
-    /* Loop through all daemons */
-
-    strcpy(buf, "=============== Daemon Info =========================\n");
-    strncat(buf, "Name\t\t\tis_hw_handler\t\t\tcur_hw\n", REM_BUF_LEN);
-
-    while((num_hw_daemons - 1) >= i) {
-        strncat(buf, daemons[i]->name, REM_BUF_LEN);
-        strncat(buf, "\t\t\t", REM_BUF_LEN);
-        sprintf(tmp_buf, "%d", daemons[i]->is_hw_handler);
-        strncat(buf, tmp_buf, REM_BUF_LEN);
-        strncat(buf, "\t\t\t", REM_BUF_LEN);
-        strcpy(tmp_buf, "\0");
-        sprintf(tmp_buf, "%ld", daemons[i]->cur_hw);
-        strncat(buf, tmp_buf, REM_BUF_LEN);
-        strncat(buf, "\n", REM_BUF_LEN);
-        i++;
+    if (sysd_reread_manifest_file(ctx, &ctx->daemons_to_delete)) {
+        VLOG_ERR("image.manifest is invalid; daemons are unchanged");
+        if (conn) {
+            unixctl_command_reply_error(conn, "image.manifest is invalid; "
+                                        "daemons are unchanged");
+        }
+        return;
+    }
+    for (i = 0; i < ctx->num_daemons; i++) {
+        sset_find_and_delete(&ctx->daemons_to_delete, ctx->daemons[i]->name);
+    }
+
+    if (!ovsrec_system_first(ctx->idl)) {
+        reply = xasprintf("%d daemons listed; database not configured yet",
+                          ctx->num_daemons);
+        VLOG_INFO("Reloaded image.manifest: %s", reply);
+        if (conn) {
+            unixctl_command_reply(conn, reply);
+        }
+        free(reply);
+        sset_clear(&ctx->daemons_to_delete);
+        return;
     }
 
-    /* mgmt_intf */
-    strncat(buf, "=============== Mgmt_intf Info ==========================\n",
-            REM_BUF_LEN);
-    strncat(buf, mgmt_intf->name, REM_BUF_LEN);
-    strncat(buf, "\n", REM_BUF_LEN);
+    reload = xzalloc(sizeof *reload);
+    reload->ctx = ctx;
+    reload->conn = conn;
+    sysd_txn_submit(&ctx->txns, SYSD_TXN_MANIFEST_RELOAD,
+                    sysd_reload_manifest_build, sysd_reload_manifest_done,
+                    reload);
+
+} /* sysd_reload_manifest() */
+
+/*
+ * Function       : sysd_ovsdb_conn_init
+ * Responsibility : opens the context's connection to the database and
+ *                  registers the tables and columns sysd replicates
+ * Parameters     : ctx, remote
+ * Returns        : void
+ */
+void
+sysd_ovsdb_conn_init(struct sysd_ctx *ctx, const char *remote)
+{
+    struct ovsdb_idl *idl;
+
+    /* Create connection to database. */
+    idl = ovsdb_idl_create(remote, &ovsrec_idl_class, false, true);
+    ctx->idl = idl;
+    ctx->idl_seqno = ovsdb_idl_get_seqno(idl);
+    ovsdb_idl_set_lock(idl, "ops_sysd");
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_system);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_subsystems);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_subsystems);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_cur_hw);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_cur_hw);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_next_hw);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_next_hw);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_software_info);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_software_info);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_switch_version);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_switch_version);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_daemons);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_daemons);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_management_mac);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_management_mac);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_system_mac);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_system_mac);
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_subsystem);
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_name);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_asset_tag_number);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_asset_tag_number);
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_hw_desc_dir);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_hw_desc_dir);
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_other_config);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_other_config);
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_interfaces);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_interfaces);
+    /* Per-box values, patched into an emitted configuration. */
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_other_info);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_other_info);
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_next_mac_address);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_next_mac_address);
+    ovsdb_idl_add_column(idl, &ovsrec_subsystem_col_macs_remaining);
+    ovsdb_idl_omit_alert(idl, &ovsrec_subsystem_col_macs_remaining);
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_interface);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_name);
+    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_hw_intf_info);
+    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_hw_intf_info);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_type);
+    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_type);
+    ovsdb_idl_add_column(idl, &ovsrec_interface_col_user_config);
+    ovsdb_idl_omit_alert(idl, &ovsrec_interface_col_user_config);
+
+    /* Daemon Table */
+    ovsdb_idl_add_table(idl, &ovsrec_table_daemon);
+    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_cur_hw);
+    ovsdb_idl_add_column(idl, &ovsrec_daemon_col_is_hw_handler);
+    ovsdb_idl_omit_alert(idl, &ovsrec_daemon_col_is_hw_handler);
+
+    /* Management Interface Column*/
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_mgmt_intf);
+
+    /* QoS factory defaults, reconciled when qos.yaml changes and restored
+     * by ops-sysd/qos-restore-defaults. */
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_qos_config);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_qos_config);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_q_profile);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_q_profile);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_qos);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_qos);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_qos_cos_map_entries);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_qos_cos_map_entries);
+    ovsdb_idl_add_column(idl, &ovsrec_system_col_qos_dscp_map_entries);
+    ovsdb_idl_omit_alert(idl, &ovsrec_system_col_qos_dscp_map_entries);
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_qos_cos_map_entry);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_cos_map_entry_col_code_point);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_cos_map_entry_col_code_point);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_cos_map_entry_col_local_priority);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_cos_map_entry_col_local_priority);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_cos_map_entry_col_color);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_cos_map_entry_col_color);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_cos_map_entry_col_description);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_cos_map_entry_col_description);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_cos_map_entry_col_hw_defaults);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_cos_map_entry_col_hw_defaults);
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_qos_dscp_map_entry);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_dscp_map_entry_col_code_point);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_dscp_map_entry_col_code_point);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_dscp_map_entry_col_local_priority);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_dscp_map_entry_col_local_priority);
+    ovsdb_idl_add_column(idl,
+                         &ovsrec_qos_dscp_map_entry_col_priority_code_point);
+    ovsdb_idl_omit_alert(idl,
+                         &ovsrec_qos_dscp_map_entry_col_priority_code_point);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_dscp_map_entry_col_color);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_dscp_map_entry_col_color);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_dscp_map_entry_col_description);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_dscp_map_entry_col_description);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_dscp_map_entry_col_hw_defaults);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_dscp_map_entry_col_hw_defaults);
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_q_profile);
+    ovsdb_idl_add_column(idl, &ovsrec_q_profile_col_name);
+    ovsdb_idl_omit_alert(idl, &ovsrec_q_profile_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_q_profile_col_q_profile_entries);
+    ovsdb_idl_omit_alert(idl, &ovsrec_q_profile_col_q_profile_entries);
+    ovsdb_idl_add_column(idl, &ovsrec_q_profile_col_hw_default);
+    ovsdb_idl_omit_alert(idl, &ovsrec_q_profile_col_hw_default);
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_q_profile_entry);
+    ovsdb_idl_add_column(idl, &ovsrec_q_profile_entry_col_local_priorities);
+    ovsdb_idl_omit_alert(idl, &ovsrec_q_profile_entry_col_local_priorities);
+    ovsdb_idl_add_column(idl, &ovsrec_q_profile_entry_col_description);
+    ovsdb_idl_omit_alert(idl, &ovsrec_q_profile_entry_col_description);
+    ovsdb_idl_add_column(idl, &ovsrec_q_profile_entry_col_hw_default);
+    ovsdb_idl_omit_alert(idl, &ovsrec_q_profile_entry_col_hw_default);
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_qos);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_col_name);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_col_queues);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_col_queues);
+    ovsdb_idl_add_column(idl, &ovsrec_qos_col_hw_default);
+    ovsdb_idl_omit_alert(idl, &ovsrec_qos_col_hw_default);
+
+    ovsdb_idl_add_table(idl, &ovsrec_table_queue);
+    ovsdb_idl_add_column(idl, &ovsrec_queue_col_algorithm);
+    ovsdb_idl_omit_alert(idl, &ovsrec_queue_col_algorithm);
+    ovsdb_idl_add_column(idl, &ovsrec_queue_col_weight);
+    ovsdb_idl_omit_alert(idl, &ovsrec_queue_col_weight);
+    ovsdb_idl_add_column(idl, &ovsrec_queue_col_hw_default);
+    ovsdb_idl_omit_alert(idl, &ovsrec_queue_col_hw_default);
+
+    /* Package_Info Table */
+    ovsdb_idl_add_table(idl, &ovsrec_table_package_info);
+    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_name);
+    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_name);
+    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_src_type);
+    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_src_type);
+    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_src_url);
+    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_src_url);
+    ovsdb_idl_add_column(idl, &ovsrec_package_info_col_version);
+    ovsdb_idl_omit_alert(idl, &ovsrec_package_info_col_version);
+
+} /* sysd_ovsdb_conn_init */
+
+static unsigned long long int
+sysd_ovsdb_atom_bytes(const union ovsdb_atom *atom, enum ovsdb_atomic_type type)
+{
+    return sizeof *atom
+           + (type == OVSDB_TYPE_STRING ? strlen(atom->string) + 1 : 0);
+}
+
+/* Estimates the heap bytes held by 'datum': its atom arrays and strings. */
+static unsigned long long int
+sysd_ovsdb_datum_bytes(const struct ovsdb_datum *datum,
+                     const struct ovsdb_type *type)
+{
+    unsigned long long int bytes = 0;
+    unsigned int i;
+
+    for (i = 0; i < datum->n; i++) {
+        bytes += sysd_ovsdb_atom_bytes(&datum->keys[i], type->key.type);
+        if (datum->values) {
+            bytes += sysd_ovsdb_atom_bytes(&datum->values[i], type->value.type);
+        }
+    }
+    return bytes;
 }
 
+/*
+ * Function       : sysd_ovsdb_memory_format
+ * Responsibility : estimates the memory of the IDL replica per table from
+ *                  the row allocation size, the column datum array and the
+ *                  atoms and strings of every replicated column, and the
+ *                  config-yaml port data sysd holds pointers to
+ * Parameters     : ctx, ds
+ * Returns        : void
+ */
 void
-sysd_wait(void)
+sysd_ovsdb_memory_format(const struct sysd_ctx *ctx, struct ds *ds)
 {
-    ovsdb_idl_wait(idl);
+    unsigned long long int total_rows = 0, total_bytes = 0, yaml_bytes = 0;
+    size_t i, j;
+    int k;
+
+    ds_put_format(ds, "IDL replica (estimated):\n");
+    ds_put_format(ds, "%-24s %8s %8s %12s\n",
+                  "table", "rows", "columns", "bytes");
+    for (i = 0; i < ovsrec_idl_class.n_tables; i++) {
+        const struct ovsdb_idl_table_class *tc = &ovsrec_idl_class.tables[i];
+        unsigned long long int rows = 0, columns = 0, bytes = 0;
+        const struct ovsdb_idl_row *row;
+
+        for (row = ovsdb_idl_first_row(ctx->idl, tc); row;
+             row = ovsdb_idl_next_row(row)) {
+            rows++;
+            bytes += tc->allocation_size
+                     + tc->n_columns * sizeof(struct ovsdb_datum);
+            for (j = 0; j < tc->n_columns; j++) {
+                const struct ovsdb_idl_column *column = &tc->columns[j];
+                const struct ovsdb_datum *datum = ovsdb_idl_read(row, column);
+
+                if (datum->n) {
+                    columns++;
+                    bytes += sysd_ovsdb_datum_bytes(datum, &column->type);
+                }
+            }
+        }
 
-} /* sysd_wait */
+        if (rows) {
+            ds_put_format(ds, "%-24s %8llu %8llu %12llu\n",
+                          tc->name, rows, columns, bytes);
+            total_rows += rows;
+            total_bytes += bytes;
+        }
+    }
+    ds_put_format(ds, "%-24s %8llu %8s %12llu\n",
+                  "total", total_rows, "", total_bytes);
+
+    for (k = 0; k < ctx->num_subsystems; k++) {
+        const sysd_subsystem_t *subsys = ctx->subsystems[k];
+
+        yaml_bytes += (unsigned long long int) subsys->intf_count
+                      * sizeof **subsys->interfaces;
+        if (subsys->intf_cmn_info) {
+            yaml_bytes += sizeof *subsys->intf_cmn_info;
+        }
+    }
+    ds_put_format(ds, "\nconfig-yaml port data (estimated): %llu bytes\n",
+                  yaml_bytes);
+
+} /* sysd_ovsdb_memory_format */
 /** @} end of group sysd */
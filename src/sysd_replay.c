@@ -0,0 +1,792 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the ops-sysd record and replay of the initial configuration.
+ *
+ * On a given image and switch, sysd_initial_configure() builds the same
+ * rows on every boot.  Once they commit, the rows are written to a local
+ * file as OVSDB "insert" operations, together with hashes of the hardware
+ * description, the FRU data, image.manifest, os-release and the schema sysd
+ * was built against.  When the database is empty and the hashes still
+ * match, the file is sent as one "transact"
+ * request on its own connection instead of building the rows through the
+ * IDL.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <bitmap.h>
+#include <hash.h>
+#include <hmap.h>
+#include <json.h>
+#include <jsonrpc.h>
+#include <ovsdb-data.h>
+#include <ovsdb-idl.h>
+#include <ovsdb-idl-provider.h>
+#include <poll-loop.h>
+#include <sha1.h>
+#include <sset.h>
+#include <timeval.h>
+#include <util.h>
+#include <uuid.h>
+#include <vswitch-idl.h>
+#include <openvswitch/vlog.h>
+
+#include <config-yaml.h>
+#include "sysd.h"
+#include "sysd_ctx.h"
+#include "sysd_replay.h"
+#include "sysd_trace.h"
+#include "sysd_txn_stats.h"
+#include "sysd_util.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_replay);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+void
+sysd_replay_init(struct sysd_replay *r)
+{
+    memset(r, 0, sizeof *r);
+}
+
+static void
+sysd_replay_finish(struct sysd_replay *r)
+{
+    jsonrpc_session_close(r->session);
+    r->session = NULL;
+    json_destroy(r->request_id);
+    r->request_id = NULL;
+}
+
+void
+sysd_replay_destroy(struct sysd_replay *r)
+{
+    if (r->session) {
+        sysd_replay_finish(r);
+    }
+    json_destroy(r->key);
+    json_destroy(r->ops);
+    json_destroy(r->recorded);
+    free(r->path);
+    free(r->remote);
+
+} /* sysd_replay_destroy */
+
+static void
+sysd_replay_hash_string(struct sha1_ctx *sha, const char *s)
+{
+    s = s ? s : "";
+    sha1_update(sha, s, strlen(s) + 1);
+}
+
+static bool
+sysd_replay_hash_file(struct sha1_ctx *sha, const char *path)
+{
+    char buf[4096];
+    size_t n;
+    bool ok;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if (!f) {
+        VLOG_WARN("%s: open failed (%s)", path, ovs_strerror(errno));
+        return false;
+    }
+    while ((n = fread(buf, 1, sizeof buf, f)) > 0) {
+        sha1_update(sha, buf, n);
+    }
+    ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+static struct json *
+sysd_replay_digest(struct sha1_ctx *sha)
+{
+    uint8_t digest[SHA1_DIGEST_SIZE];
+    char hex[SHA1_HEX_DIGEST_LEN + 1];
+
+    sha1_final(sha, digest);
+    sha1_to_hex(digest, hex);
+    return json_string_create(hex);
+}
+
+/*
+ * Function       : sysd_replay_hash_hw_desc
+ * Responsibility : hashes the path of the hardware description directory
+ *                  and the names and contents of the files in it, in name
+ *                  order
+ * Parameters     : directory
+ * Returns        : the hash as a hex string, or NULL on error
+ */
+static struct json *
+sysd_replay_hash_hw_desc(const char *dir)
+{
+    struct sha1_ctx sha;
+    struct dirent *de;
+    struct sset names;
+    const char **sorted;
+    bool ok = true;
+    size_t i;
+    DIR *d;
+
+    d = opendir(dir);
+    if (!d) {
+        VLOG_WARN("%s: opendir failed (%s)", dir, ovs_strerror(errno));
+        return NULL;
+    }
+    sset_init(&names);
+    while ((de = readdir(d)) != NULL) {
+        if (de->d_name[0] != '.') {
+            sset_add(&names, de->d_name);
+        }
+    }
+    closedir(d);
+
+    sha1_init(&sha);
+    sysd_replay_hash_string(&sha, dir);
+    sorted = sset_sort(&names);
+    for (i = 0; ok && i < sset_count(&names); i++) {
+        char *path = xasprintf("%s/%s", dir, sorted[i]);
+        struct stat st;
+
+        if (!stat(path, &st) && S_ISREG(st.st_mode)) {
+            sysd_replay_hash_string(&sha, sorted[i]);
+            ok = sysd_replay_hash_file(&sha, path);
+        }
+        free(path);
+    }
+    free(sorted);
+    sset_destroy(&names);
+
+    return ok ? sysd_replay_digest(&sha) : NULL;
+
+} /* sysd_replay_hash_hw_desc */
+
+/* Hashes the FRU data of each subsystem. */
+static struct json *
+sysd_replay_hash_fru(const struct sysd_ctx *ctx)
+{
+    struct sha1_ctx sha;
+    int i;
+
+    sha1_init(&sha);
+    for (i = 0; i < ctx->num_subsystems; i++) {
+        const fru_eeprom_t *fru = &ctx->subsystems[i]->fru_eeprom;
+
+        sysd_replay_hash_string(&sha, fru->country_code);
+        sha1_update(&sha, &fru->device_version, sizeof fru->device_version);
+        sysd_replay_hash_string(&sha, fru->diag_version);
+        sysd_replay_hash_string(&sha, fru->label_revision);
+        sha1_update(&sha, fru->base_mac_address,
+                    sizeof fru->base_mac_address);
+        sysd_replay_hash_string(&sha, fru->manufacture_date);
+        sysd_replay_hash_string(&sha, fru->manufacturer);
+        sha1_update(&sha, &fru->num_macs, sizeof fru->num_macs);
+        sysd_replay_hash_string(&sha, fru->onie_version);
+        sysd_replay_hash_string(&sha, fru->part_number);
+        sysd_replay_hash_string(&sha, fru->platform_name);
+        sysd_replay_hash_string(&sha, fru->product_name);
+        sysd_replay_hash_string(&sha, fru->serial_number);
+        sysd_replay_hash_string(&sha, fru->service_tag);
+        sysd_replay_hash_string(&sha, fru->vendor);
+    }
+    return sysd_replay_digest(&sha);
+}
+
+/* Hashes the tables and columns of the schema sysd was built against. */
+static struct json *
+sysd_replay_hash_schema(void)
+{
+    struct sha1_ctx sha;
+    size_t i, j;
+
+    sha1_init(&sha);
+    sysd_replay_hash_string(&sha, ovsrec_idl_class.database);
+    for (i = 0; i < ovsrec_idl_class.n_tables; i++) {
+        const struct ovsdb_idl_table_class *tc = &ovsrec_idl_class.tables[i];
+
+        sysd_replay_hash_string(&sha, tc->name);
+        for (j = 0; j < tc->n_columns; j++) {
+            const struct ovsdb_type *type = &tc->columns[j].type;
+            uint32_t words[4];
+
+            words[0] = type->key.type;
+            words[1] = type->value.type;
+            words[2] = type->n_min;
+            words[3] = type->n_max;
+            sysd_replay_hash_string(&sha, tc->columns[j].name);
+            sha1_update(&sha, words, sizeof words);
+        }
+    }
+    return sysd_replay_digest(&sha);
+}
+
+/*
+ * Function       : sysd_replay_key
+ * Responsibility : hashes what the initial configuration is built from
+ * Parameters     : ctx
+ * Returns        : a JSON object with one hash per input, or NULL if one
+ *                  could not be read
+ */
+static struct json *
+sysd_replay_key(const struct sysd_ctx *ctx)
+{
+    char manifest_path[1024];
+    char release_path[1024];
+    struct json *hw_desc;
+    struct json *key;
+    struct sha1_ctx sha;
+    struct sha1_ctx release_sha;
+
+    hw_desc = sysd_replay_hash_hw_desc(ctx->hw_desc_dir);
+    if (!hw_desc) {
+        return NULL;
+    }
+
+    sysd_install_path(manifest_path, sizeof manifest_path,
+                      IMAGE_MANIFEST_FILE_PATH);
+    sha1_init(&sha);
+    if (!sysd_replay_hash_file(&sha, manifest_path)) {
+        json_destroy(hw_desc);
+        return NULL;
+    }
+
+    /* The image's build identity, since a different sysd may build
+     * different rows from the same hardware. */
+    sysd_install_path(release_path, sizeof release_path,
+                      OS_RELEASE_FILE_PATH);
+    sha1_init(&release_sha);
+    if (!sysd_replay_hash_file(&release_sha, release_path)) {
+        json_destroy(hw_desc);
+        return NULL;
+    }
+
+    key = json_object_create();
+    json_object_put(key, "hw_desc", hw_desc);
+    json_object_put(key, "fru", sysd_replay_hash_fru(ctx));
+    json_object_put(key, "manifest", sysd_replay_digest(&sha));
+    json_object_put(key, "release", sysd_replay_digest(&release_sha));
+    json_object_put(key, "schema", sysd_replay_hash_schema());
+    return key;
+
+} /* sysd_replay_key */
+
+/* Returns the name of the first input whose hash differs between 'a' and
+ * 'b'. */
+static const char *
+sysd_replay_key_diff(const struct json *a, const struct json *b)
+{
+    struct shash_node *node;
+
+    if (b->type != JSON_OBJECT) {
+        return "key";
+    }
+    SHASH_FOR_EACH (node, json_object(a)) {
+        const struct json *value = shash_find_data(json_object(b),
+                                                   node->name);
+
+        if (!value || !json_equal(node->data, value)) {
+            return node->name;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function       : sysd_replay_open
+ * Responsibility : enables recording and loads the record file if it
+ *                  matches what the context was built from
+ * Parameters     : ctx, record file, database remote
+ * Returns        : void
+ */
+void
+sysd_replay_open(struct sysd_ctx *ctx, const char *path, const char *remote)
+{
+    struct sysd_replay *r = &ctx->replay;
+    const struct json *version, *key, *ops;
+    const char *changed = NULL;
+    struct json *file;
+    struct stat st;
+
+    r->key = sysd_replay_key(ctx);
+    if (!r->key) {
+        VLOG_WARN("Unable to hash the inputs of the initial configuration; "
+                  "it will not be recorded");
+        return;
+    }
+    r->path = xstrdup(path);
+    r->remote = xstrdup(remote);
+
+    if (stat(path, &st)) {
+        VLOG_INFO("No recorded initial configuration at %s", path);
+        return;
+    }
+
+    file = json_from_file(path);
+    if (file->type != JSON_OBJECT) {
+        VLOG_WARN("%s: not a recorded initial configuration", path);
+        json_destroy(file);
+        return;
+    }
+
+    version = shash_find_data(json_object(file), "version");
+    key = shash_find_data(json_object(file), "key");
+    ops = shash_find_data(json_object(file), "ops");
+    if (!version || version->type != JSON_INTEGER
+        || json_integer(version) != SYSD_REPLAY_VERSION) {
+        VLOG_INFO("%s was recorded by a different version of sysd; "
+                  "not replaying it", path);
+    } else if (!key || (changed = sysd_replay_key_diff(r->key, key))) {
+        VLOG_INFO("%s was recorded for a different %s; not replaying it",
+                  path, key ? changed : "key");
+    } else if (!ops || ops->type != JSON_ARRAY) {
+        VLOG_WARN("%s: no operations recorded", path);
+    } else {
+        r->ops = json_clone(ops);
+        VLOG_INFO("Loaded the recorded initial configuration from %s "
+                  "(%"PRIuSIZE" rows)", path, r->ops->u.array.n);
+    }
+    json_destroy(file);
+
+} /* sysd_replay_open */
+
+/* A row inserted by the transaction being recorded. */
+struct sysd_replay_row {
+    struct hmap_node node;              /* In a hmap by uuid_hash(). */
+    struct uuid uuid;
+    char *name;                         /* Its "uuid-name". */
+};
+
+static const char *
+sysd_replay_row_name(const struct hmap *rows, const struct uuid *uuid)
+{
+    const struct sysd_replay_row *rr;
+
+    HMAP_FOR_EACH_WITH_HASH (rr, node, uuid_hash(uuid), rows) {
+        if (uuid_equals(&rr->uuid, uuid)) {
+            return rr->name;
+        }
+    }
+    return NULL;
+}
+
+/* Like ovsdb_atom_to_json(), except that a reference to an inserted row
+ * becomes its "named-uuid".  Clears '*ok' on a reference to any other
+ * row. */
+static struct json *
+sysd_replay_atom_to_json(const struct hmap *rows,
+                         const union ovsdb_atom *atom,
+                         enum ovsdb_atomic_type type, bool *ok)
+{
+    const char *name;
+
+    if (type != OVSDB_TYPE_UUID) {
+        return ovsdb_atom_to_json(atom, type);
+    }
+
+    name = sysd_replay_row_name(rows, &atom->uuid);
+    if (!name) {
+        *ok = false;
+        return json_null_create();
+    }
+    return json_array_create_2(json_string_create("named-uuid"),
+                               json_string_create(name));
+}
+
+/* Like ovsdb_datum_to_json(), with references translated as by
+ * sysd_replay_atom_to_json(). */
+static struct json *
+sysd_replay_datum_to_json(const struct hmap *rows,
+                          const struct ovsdb_datum *datum,
+                          const struct ovsdb_type *type, bool *ok)
+{
+    struct json **elems;
+    size_t i;
+
+    if (ovsdb_type_is_map(type)) {
+        elems = xmalloc(datum->n * sizeof *elems);
+        for (i = 0; i < datum->n; i++) {
+            struct json *key, *value;
+
+            key = sysd_replay_atom_to_json(rows, &datum->keys[i],
+                                           type->key.type, ok);
+            value = sysd_replay_atom_to_json(rows, &datum->values[i],
+                                             type->value.type, ok);
+            elems[i] = json_array_create_2(key, value);
+        }
+        return json_array_create_2(json_string_create("map"),
+                                   json_array_create(elems, datum->n));
+    } else if (datum->n == 1) {
+        return sysd_replay_atom_to_json(rows, &datum->keys[0],
+                                        type->key.type, ok);
+    }
+
+    elems = xmalloc(datum->n * sizeof *elems);
+    for (i = 0; i < datum->n; i++) {
+        elems[i] = sysd_replay_atom_to_json(rows, &datum->keys[i],
+                                            type->key.type, ok);
+    }
+    return json_array_create_2(json_string_create("set"),
+                               json_array_create(elems, datum->n));
+}
+
+/*
+ * Function       : sysd_replay_txn_ops
+ * Responsibility : turns the rows an uncommitted transaction inserts into
+ *                  "insert" operations with only the columns it wrote.
+ *                  Rows the transaction deletes are not visible here; sysd
+ *                  does not delete rows while it builds the initial
+ *                  configuration.
+ * Parameters     : idl
+ * Returns        : a JSON array, or NULL
+ */
+struct json *
+sysd_replay_txn_ops(const struct ovsdb_idl *idl)
+{
+    struct hmap rows = HMAP_INITIALIZER(&rows);
+    struct sysd_replay_row *rr, *next;
+    struct json *ops;
+    unsigned int n = 0;
+    bool ok = true;
+    size_t i, j;
+
+    /* Name every inserted row first, since rows refer to rows of tables
+     * that come later. */
+    for (i = 0; ok && i < ovsrec_idl_class.n_tables; i++) {
+        const struct ovsdb_idl_table_class *tc = &ovsrec_idl_class.tables[i];
+        const struct ovsdb_idl_row *row;
+
+        for (row = ovsdb_idl_first_row(idl, tc); row;
+             row = ovsdb_idl_next_row(row)) {
+            if (row->old) {
+                if (row->written) {
+                    ok = false;
+                    break;
+                }
+                continue;
+            }
+            rr = xmalloc(sizeof *rr);
+            rr->uuid = row->uuid;
+            rr->name = xasprintf("row%u", n++);
+            hmap_insert(&rows, &rr->node, uuid_hash(&row->uuid));
+        }
+    }
+
+    ops = json_array_create_empty();
+    for (i = 0; ok && i < ovsrec_idl_class.n_tables; i++) {
+        const struct ovsdb_idl_table_class *tc = &ovsrec_idl_class.tables[i];
+        const struct ovsdb_idl_row *row;
+
+        for (row = ovsdb_idl_first_row(idl, tc); row;
+             row = ovsdb_idl_next_row(row)) {
+            struct json *op, *columns;
+
+            if (row->old) {
+                continue;
+            }
+
+            columns = json_object_create();
+            for (j = 0; row->written && j < tc->n_columns; j++) {
+                if (bitmap_is_set(row->written, j)) {
+                    json_object_put(columns, tc->columns[j].name,
+                                    sysd_replay_datum_to_json(
+                                        &rows, &row->new[j],
+                                        &tc->columns[j].type, &ok));
+                }
+            }
+
+            op = json_object_create();
+            json_object_put_string(op, "op", "insert");
+            json_object_put_string(op, "table", tc->name);
+            json_object_put_string(op, "uuid-name",
+                                   sysd_replay_row_name(&rows, &row->uuid));
+            json_object_put(op, "row", columns);
+            json_array_add(ops, op);
+        }
+    }
+
+    HMAP_FOR_EACH_SAFE (rr, next, node, &rows) {
+        hmap_remove(&rows, &rr->node);
+        free(rr->name);
+        free(rr);
+    }
+    hmap_destroy(&rows);
+
+    if (!ok) {
+        json_destroy(ops);
+        return NULL;
+    }
+    return ops;
+
+} /* sysd_replay_txn_ops */
+
+void
+sysd_replay_capture(struct sysd_replay *r, const struct ovsdb_idl *idl)
+{
+    if (!r->path) {
+        return;
+    }
+
+    /* Called again for every retry of the transaction. */
+    json_destroy(r->recorded);
+    r->recorded = sysd_replay_txn_ops(idl);
+    if (!r->recorded) {
+        VLOG_WARN("The initial configuration changes or refers to rows "
+                  "already in the database; not recording it");
+    }
+}
+
+/*
+ * Function       : sysd_replay_save
+ * Responsibility : writes the captured operations to the record file,
+ *                  through a temporary file so that a crash never leaves a
+ *                  partial one, and keeps them to replay if the database
+ *                  comes back empty
+ * Parameters     : replay
+ * Returns        : void
+ */
+void
+sysd_replay_save(struct sysd_replay *r)
+{
+    struct json *file;
+    char *tmp, *dir;
+    char *s;
+    FILE *f;
+    int error = 0;
+
+    if (!r->recorded) {
+        return;
+    }
+    json_destroy(r->ops);
+    r->ops = r->recorded;
+    r->recorded = NULL;
+
+    file = json_object_create();
+    json_object_put(file, "version", json_integer_create(SYSD_REPLAY_VERSION));
+    json_object_put(file, "key", json_clone(r->key));
+    json_object_put(file, "ops", json_clone(r->ops));
+    s = json_to_string(file, 0);
+    json_destroy(file);
+
+    dir = dir_name(r->path);
+    if (mkdir(dir, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) && errno != EEXIST) {
+        VLOG_WARN("Failed to create %s (%s)", dir, ovs_strerror(errno));
+    }
+    free(dir);
+
+    tmp = xasprintf("%s.tmp", r->path);
+    f = fopen(tmp, "w");
+    if (!f) {
+        error = errno;
+    } else {
+        if (fputs(s, f) == EOF) {
+            error = errno;
+        }
+        if (fclose(f) && !error) {
+            error = errno;
+        }
+    }
+    if (!error && rename(tmp, r->path)) {
+        error = errno;
+    }
+
+    if (error) {
+        VLOG_WARN("Failed to record the initial configuration in %s (%s)",
+                  r->path, ovs_strerror(error));
+        remove(tmp);
+    } else {
+        VLOG_INFO("Recorded the initial configuration in %s "
+                  "(%"PRIuSIZE" rows)", r->path, r->ops->u.array.n);
+    }
+    free(tmp);
+    free(s);
+
+} /* sysd_replay_save */
+
+bool
+sysd_replay_start(struct sysd_replay *r)
+{
+    if (r->session) {
+        return true;
+    }
+    if (!r->ops) {
+        return false;
+    }
+
+    r->session = jsonrpc_session_open(r->remote, false);
+    r->sample.rows = r->ops->u.array.n;
+    r->sample.bytes = 0;
+    sysd_txn_stats_begin(SYSD_TXN_INITIAL_REPLAY, &r->sample);
+    return true;
+}
+
+/* Sends the recorded operations after a "wait" that holds the transaction
+ * back unless the System table is still empty, so that a replay never
+ * races an IDL commit of the initial configuration. */
+static void
+sysd_replay_send(struct sysd_replay *r)
+{
+    struct json *params, *wait;
+    struct jsonrpc_msg *request;
+    size_t i;
+
+    wait = json_object_create();
+    json_object_put_string(wait, "op", "wait");
+    json_object_put_string(wait, "table", ovsrec_table_system.name);
+    json_object_put(wait, "timeout", json_integer_create(0));
+    json_object_put(wait, "where", json_array_create_empty());
+    json_object_put(wait, "columns",
+                    json_array_create_1(json_string_create("_uuid")));
+    json_object_put_string(wait, "until", "==");
+    json_object_put(wait, "rows", json_array_create_empty());
+
+    params = json_array_create_empty();
+    json_array_add(params, json_string_create(ovsrec_idl_class.database));
+    json_array_add(params, wait);
+    for (i = 0; i < r->ops->u.array.n; i++) {
+        json_array_add(params, json_clone(r->ops->u.array.elems[i]));
+    }
+
+    request = jsonrpc_create_request("transact", params, &r->request_id);
+    for (i = 0; i < r->ops->u.array.n; i++) {
+        char *s = json_to_string(r->ops->u.array.elems[i], 0);
+
+        r->sample.bytes += strlen(s);
+        free(s);
+    }
+    jsonrpc_session_send(r->session, request);
+}
+
+/*
+ * Function       : sysd_replay_check_reply
+ * Responsibility : checks the reply to the replayed "transact".  When only
+ *                  the leading "wait" failed, the database was no longer
+ *                  empty and the record is kept; otherwise a failure stops
+ *                  it from being replayed again.
+ * Parameters     : replay, reply
+ * Returns        : true if the rows were inserted
+ */
+static bool
+sysd_replay_check_reply(struct sysd_replay *r, const struct jsonrpc_msg *msg)
+{
+    const struct json_array *results;
+    char *s;
+    size_t i;
+
+    if (msg->type == JSONRPC_ERROR || !msg->result
+        || msg->result->type != JSON_ARRAY) {
+        s = json_to_string(msg->error ? msg->error : msg->result, 0);
+        VLOG_WARN("Replaying %s failed: %s", r->path, s);
+        free(s);
+        goto drop;
+    }
+
+    results = json_array(msg->result);
+    for (i = 0; i < results->n; i++) {
+        const struct json *result = results->elems[i];
+
+        if (result->type == JSON_OBJECT
+            && shash_find(json_object(result), "error")) {
+            if (i == 0) {
+                VLOG_INFO("The database was no longer empty; "
+                          "not replaying %s", r->path);
+                return false;
+            }
+            s = json_to_string(result, 0);
+            VLOG_WARN("Replaying %s failed: %s", r->path, s);
+            free(s);
+            goto drop;
+        }
+    }
+    return true;
+
+drop:
+    json_destroy(r->ops);
+    r->ops = NULL;
+    return false;
+
+} /* sysd_replay_check_reply */
+
+/*
+ * Function       : sysd_replay_run
+ * Responsibility : sends the replay once its connection is up and collects
+ *                  the reply, which is recorded in 'stats'
+ * Parameters     : replay, transaction statistics
+ * Returns        : the replay's status
+ */
+enum sysd_replay_status
+sysd_replay_run(struct sysd_replay *r, struct sysd_txn_stats *stats)
+{
+    enum sysd_replay_status status = SYSD_REPLAY_PENDING;
+    struct jsonrpc_msg *msg;
+
+    if (!r->session) {
+        return SYSD_REPLAY_IDLE;
+    }
+
+    jsonrpc_session_run(r->session);
+    if (!r->request_id && jsonrpc_session_is_connected(r->session)) {
+        sysd_replay_send(r);
+    }
+
+    while (r->request_id && status == SYSD_REPLAY_PENDING
+           && (msg = jsonrpc_session_recv(r->session)) != NULL) {
+        if ((msg->type == JSONRPC_REPLY || msg->type == JSONRPC_ERROR)
+            && json_equal(msg->id, r->request_id)) {
+            status = (sysd_replay_check_reply(r, msg)
+                      ? SYSD_REPLAY_SUCCESS : SYSD_REPLAY_FAILED);
+        }
+        jsonrpc_msg_destroy(msg);
+    }
+
+    if (status == SYSD_REPLAY_PENDING
+        && !jsonrpc_session_is_alive(r->session)) {
+        VLOG_WARN("Lost the connection to %s while replaying %s",
+                  r->remote, r->path);
+        status = SYSD_REPLAY_FAILED;
+    }
+
+    if (status != SYSD_REPLAY_PENDING) {
+        sysd_txn_stats_end(stats, SYSD_TXN_INITIAL_REPLAY, &r->sample,
+                           (status == SYSD_REPLAY_SUCCESS
+                            ? TXN_SUCCESS : TXN_ERROR));
+        sysd_replay_finish(r);
+    }
+    return status;
+
+} /* sysd_replay_run */
+
+void
+sysd_replay_wait(struct sysd_replay *r)
+{
+    if (r->session) {
+        jsonrpc_session_wait(r->session);
+        jsonrpc_session_recv_wait(r->session);
+    }
+}
+/** @} end of group ops-sysd */
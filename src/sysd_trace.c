@@ -0,0 +1,304 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the ops-sysd trace ring buffer.
+ *
+ * Tracepoints append fixed-size binary records to a ring that overwrites
+ * its oldest records once full.  Every context records into the same ring,
+ * possibly from different threads, without a lock: a tracepoint claims the
+ * next slot with an atomic fetch-and-add on the head, and each slot carries
+ * a sequence number, odd while its record is written and even once it is
+ * complete, so that sysd_trace_save() can tell a torn record and skip it.
+ * A saved ring starts with a header and a table of the names the records
+ * refer to by number, so it can be decoded away from the switch.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <dynamic-string.h>
+#include <ovs-atomic.h>
+#include <ovs-thread.h>
+#include <timeval.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_util.h"
+#include "sysd_ctx.h"
+#include "sysd_mem.h"
+#include "sysd_txn_stats.h"
+#include "sysd_trace.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_trace);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Number of records in the ring; a power of 2.  At 32 bytes a slot this is
+ * 512 kB, allocated the first time tracing is turned on. */
+#define SYSD_TRACE_RING_SIZE 16384
+
+#define SYSD_TRACE_FILE_MAGIC "SYSDTRC"
+#define SYSD_TRACE_FILE_VERSION 1
+
+/* On-disk header, followed by 'names_len' bytes of name table and then
+ * 'n_records' records, all in host byte order. */
+struct sysd_trace_file_header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t n_records;
+    uint64_t names_len;
+};
+
+static const char *sysd_trace_event_names[SYSD_TRACE_N_EVENTS] = {
+    [SYSD_TRACE_IDL_RUN]       = "idl_run",
+    [SYSD_TRACE_SEQNO_CHANGE]  = "seqno_change",
+    [SYSD_TRACE_STARTUP_STAGE] = "startup",
+    [SYSD_TRACE_I2C]           = "i2c",
+    [SYSD_TRACE_COMMIT]        = "commit",
+    [SYSD_TRACE_CUR_HW]        = "cur_hw",
+};
+
+static const char *sysd_trace_stage_names[SYSD_TRACE_N_STAGES] = {
+    [SYSD_TRACE_STAGE_MANIFEST]   = "manifest",
+    [SYSD_TRACE_STAGE_HW_DESC]    = "hw_desc",
+    [SYSD_TRACE_STAGE_CFG_YAML]   = "cfg_yaml",
+    [SYSD_TRACE_STAGE_SUBSYSTEMS] = "subsystems",
+    [SYSD_TRACE_STAGE_INTERFACES] = "interfaces",
+};
+
+struct sysd_trace_slot {
+    /* For the record at position 'pos' since the ring was allocated:
+     * 2 * pos + 1 while it is written, 2 * pos + 2 once it is complete.
+     * 0 if the slot was never written. */
+    atomic_uint64_t seq;
+    struct sysd_trace_record rec;
+};
+
+atomic_bool sysd_trace_enabled = ATOMIC_VAR_INIT(false);
+
+static ATOMIC(struct sysd_trace_slot *) ring;
+static atomic_uint64_t ring_head = ATOMIC_VAR_INIT(0);
+                                /* Records claimed since the ring was
+                                 * allocated; the next slot is
+                                 * ring_head % SYSD_TRACE_RING_SIZE. */
+
+/*
+ * Function       : sysd_trace_record_
+ * Responsibility : claims the next slot of the ring and fills it in,
+ *                  marking it as being written until it is complete
+ * Parameters     : event, phase, arguments
+ * Returns        : void
+ */
+void
+sysd_trace_record_(enum sysd_trace_event event, enum sysd_trace_phase phase,
+                   uint32_t arg, uint64_t arg2)
+{
+    struct sysd_trace_slot *slots, *slot;
+    long long int usec = time_usec();
+    uint64_t pos;
+
+    atomic_read_explicit(&ring, &slots, memory_order_acquire);
+    if (!slots) {
+        return;
+    }
+
+    atomic_add_relaxed(&ring_head, 1, &pos);
+    slot = &slots[pos & (SYSD_TRACE_RING_SIZE - 1)];
+    atomic_store_relaxed(&slot->seq, 2 * pos + 1);
+    atomic_thread_fence(memory_order_release);
+
+    slot->rec.usec = usec;
+    slot->rec.event = event;
+    slot->rec.phase = phase;
+    slot->rec.pad = 0;
+    slot->rec.arg = arg;
+    slot->rec.arg2 = arg2;
+
+    atomic_store_explicit(&slot->seq, 2 * pos + 2, memory_order_release);
+
+} /* sysd_trace_record_ */
+
+/*
+ * Function       : sysd_trace_enable
+ * Responsibility : turns the tracepoints on or off.  The ring is kept
+ *                  when tracing is turned off, so it can still be saved.
+ * Parameters     : enable
+ * Returns        : void
+ */
+void
+sysd_trace_enable(bool enable)
+{
+    static struct ovsthread_once once = OVSTHREAD_ONCE_INITIALIZER;
+
+    /* The ring is published before the flag, so a tracepoint that sees
+     * tracing on also finds the ring. */
+    if (enable && ovsthread_once_start(&once)) {
+        struct sysd_trace_slot *slots;
+
+        slots = sysd_mem_calloc(SYSD_MEM_TRACE, SYSD_TRACE_RING_SIZE,
+                                sizeof *slots);
+        atomic_store_explicit(&ring, slots, memory_order_release);
+        ovsthread_once_done(&once);
+    }
+    atomic_store_explicit(&sysd_trace_enabled, enable,
+                          memory_order_release);
+
+} /* sysd_trace_enable */
+
+/* Returns the number of records claimed so far. */
+static uint64_t
+sysd_trace_head(void)
+{
+    uint64_t head;
+
+    atomic_read_explicit(&ring_head, &head, memory_order_acquire);
+    return head;
+}
+
+void
+sysd_trace_format(struct ds *ds)
+{
+    uint64_t head = sysd_trace_head();
+    uint64_t n = MIN(head, SYSD_TRACE_RING_SIZE);
+    bool enabled;
+
+    atomic_read_relaxed(&sysd_trace_enabled, &enabled);
+    ds_put_format(ds, "Tracing: %s\n", enabled ? "on" : "off");
+    ds_put_format(ds, "Records: %llu of %d (%llu overwritten)\n",
+                  (unsigned long long int) n, SYSD_TRACE_RING_SIZE,
+                  (unsigned long long int) (head - n));
+
+} /* sysd_trace_format */
+
+/*
+ * Function       : sysd_trace_copy
+ * Responsibility : copies the complete records of the ring, oldest first,
+ *                  leaving out any that are being written or that were
+ *                  overwritten while they were copied
+ * Parameters     : destination for up to SYSD_TRACE_RING_SIZE records
+ * Returns        : the number of records copied
+ */
+static size_t
+sysd_trace_copy(struct sysd_trace_record *out)
+{
+    struct sysd_trace_slot *slots;
+    uint64_t head, pos;
+    size_t n = 0;
+
+    atomic_read_explicit(&ring, &slots, memory_order_acquire);
+    if (!slots) {
+        return 0;
+    }
+
+    head = sysd_trace_head();
+    for (pos = head - MIN(head, SYSD_TRACE_RING_SIZE); pos < head; pos++) {
+        struct sysd_trace_slot *slot;
+        uint64_t seq, seq2;
+
+        slot = &slots[pos & (SYSD_TRACE_RING_SIZE - 1)];
+        atomic_read_explicit(&slot->seq, &seq, memory_order_acquire);
+        if (seq != 2 * pos + 2) {
+            continue;
+        }
+        out[n] = slot->rec;
+        atomic_thread_fence(memory_order_acquire);
+        atomic_read_relaxed(&slot->seq, &seq2);
+        if (seq2 == seq) {
+            n++;
+        }
+    }
+    return n;
+}
+
+/* Appends the name table: one "<kind> <number> <name>" line per name. */
+static void
+sysd_trace_put_names(const struct sysd_ctx *ctx, struct ds *ds)
+{
+    int i;
+
+    for (i = 0; i < SYSD_TRACE_N_EVENTS; i++) {
+        ds_put_format(ds, "event %d %s\n", i, sysd_trace_event_names[i]);
+    }
+    for (i = 0; i < SYSD_TRACE_N_STAGES; i++) {
+        ds_put_format(ds, "stage %d %s\n", i, sysd_trace_stage_names[i]);
+    }
+    for (i = 0; i < SYSD_TXN_N_SITES; i++) {
+        ds_put_format(ds, "site %d %s\n", i, sysd_txn_site_name(i));
+    }
+    for (i = 0; i < ctx->num_daemons; i++) {
+        ds_put_format(ds, "daemon %d %s\n", i, ctx->daemons[i]->name);
+    }
+}
+
+/*
+ * Function       : sysd_trace_save
+ * Responsibility : writes the ring to a file, oldest record first
+ * Parameters     : ctx whose daemons the records name, file name
+ * Returns        : 0 on success, otherwise a positive errno value
+ */
+int
+sysd_trace_save(const struct sysd_ctx *ctx, const char *file_name)
+{
+    struct sysd_trace_file_header hdr;
+    struct ds names = DS_EMPTY_INITIALIZER;
+    struct sysd_trace_record *records;
+    FILE *file;
+    size_t n;
+    int error = 0;
+
+    file = fopen(file_name, "wb");
+    if (!file) {
+        return errno;
+    }
+
+    /* Tracepoints keep firing while the ring is copied. */
+    records = xmalloc(SYSD_TRACE_RING_SIZE * sizeof *records);
+    n = sysd_trace_copy(records);
+    sysd_trace_put_names(ctx, &names);
+
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, SYSD_TRACE_FILE_MAGIC, sizeof SYSD_TRACE_FILE_MAGIC);
+    hdr.version = SYSD_TRACE_FILE_VERSION;
+    hdr.record_size = sizeof(struct sysd_trace_record);
+    hdr.n_records = n;
+    hdr.names_len = names.length;
+
+    if (fwrite(&hdr, sizeof hdr, 1, file) != 1
+        || fwrite(names.string, 1, names.length, file) != names.length
+        || fwrite(records, sizeof *records, n, file) != n) {
+        error = errno;
+    }
+
+    if (fclose(file) && !error) {
+        error = errno;
+    }
+    ds_destroy(&names);
+    free(records);
+
+    if (error) {
+        VLOG_WARN("Failed to save trace to %s (%s)",
+                  file_name, ovs_strerror(error));
+    }
+    return error;
+
+} /* sysd_trace_save */
+/** @} end of group ops-sysd */
@@ -0,0 +1,355 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for the ops-sysd OVSDB transaction manager.
+ *
+ * sysd never waits for ovsdb-server.  Writes are queued with a function
+ * that builds them, and one transaction at a time is committed with
+ * ovsdb_idl_txn_commit() from the main loop.  The IDL allows only one open
+ * transaction, so the queue is also what keeps writes from different parts
+ * of sysd apart.  A transaction that hits a conflict is rebuilt from the
+ * updated replica and retried after a backoff.  Small writes that are
+ * queued together are committed as one transaction.  Each sysd_ctx has
+ * its own IDL and so its own queue.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <dynamic-string.h>
+#include <list.h>
+#include <ovsdb-idl.h>
+#include <poll-loop.h>
+#include <timeval.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_txn.h"
+#include "sysd_txn_stats.h"
+#include "sysd_write.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_txn);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Retry backoff after TXN_TRY_AGAIN, doubled on each retry. */
+#define SYSD_TXN_BACKOFF_MIN_MSEC 20
+#define SYSD_TXN_BACKOFF_MAX_MSEC 2000
+
+/* Most writes committed together in one transaction. */
+#define SYSD_TXN_MAX_BATCH 8
+
+/* Transactions started by one sysd_txn_run() call. */
+#define SYSD_TXN_MAX_PER_RUN 16
+
+/* Sites whose writes touch a few columns of rows that already exist, and
+ * so may share a transaction with each other. */
+static const bool sysd_txn_site_small[SYSD_TXN_N_SITES] = {
+    [SYSD_TXN_SW_INFO]    = true,
+    [SYSD_TXN_HW_DONE]    = true,
+    [SYSD_TXN_HW_EXPIRED] = true,
+};
+
+struct sysd_txn_req {
+    struct ovs_list node;       /* In 'queue' or 'inflight'. */
+    enum sysd_txn_site site;
+    sysd_txn_build_func *build;
+    sysd_txn_done_func *done;
+    void *aux;
+    size_t n_changed;           /* From the last build. */
+    int backoff_msec;           /* Last backoff, or 0 before any retry. */
+    long long int start_usec;   /* First commit attempt, or 0. */
+};
+
+void
+sysd_txn_queue_init(struct sysd_txn_queue *q)
+{
+    memset(q, 0, sizeof *q);
+    list_init(&q->queue);
+    list_init(&q->inflight);
+    sysd_write_stats_init(&q->writes);
+
+} /* sysd_txn_queue_init */
+
+/* Reports 'status' to every write in 'list' and frees them. */
+static void
+sysd_txn_complete(struct ovs_list *list, enum ovsdb_idl_txn_status status)
+{
+    struct sysd_txn_req *req;
+
+    LIST_FOR_EACH_POP (req, node, list) {
+        if (req->done) {
+            req->done(status, req->n_changed, req->aux);
+        }
+        free(req);
+    }
+
+} /* sysd_txn_complete */
+
+void
+sysd_txn_queue_destroy(struct sysd_txn_queue *q)
+{
+    if (q->txn) {
+        ovsdb_idl_txn_abort(q->txn);
+        ovsdb_idl_txn_destroy(q->txn);
+        q->txn = NULL;
+    }
+    sysd_txn_complete(&q->inflight, TXN_ABORTED);
+    sysd_txn_complete(&q->queue, TXN_ABORTED);
+    sysd_write_stats_destroy(&q->writes);
+
+} /* sysd_txn_queue_destroy */
+
+void
+sysd_txn_submit(struct sysd_txn_queue *q, enum sysd_txn_site site,
+                sysd_txn_build_func *build, sysd_txn_done_func *done,
+                void *aux)
+{
+    struct sysd_txn_req *req;
+
+    q->counters.submitted++;
+    LIST_FOR_EACH (req, node, &q->queue) {
+        if (req->build == build && req->done == done && req->aux == aux) {
+            q->counters.dropped++;
+            return;
+        }
+    }
+
+    req = xzalloc(sizeof *req);
+    req->site = site;
+    req->build = build;
+    req->done = done;
+    req->aux = aux;
+    list_push_back(&q->queue, &req->node);
+
+} /* sysd_txn_submit */
+
+static bool
+sysd_txn_list_has(const struct ovs_list *list, sysd_txn_build_func *build,
+                  const void *aux)
+{
+    const struct sysd_txn_req *req;
+
+    LIST_FOR_EACH (req, node, list) {
+        if (req->build == build && req->aux == aux) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+sysd_txn_is_pending(const struct sysd_txn_queue *q,
+                    sysd_txn_build_func *build, const void *aux)
+{
+    return (sysd_txn_list_has(&q->queue, build, aux)
+            || sysd_txn_list_has(&q->inflight, build, aux));
+
+} /* sysd_txn_is_pending */
+
+static bool
+sysd_txn_list_has_site(const struct ovs_list *list, enum sysd_txn_site site)
+{
+    const struct sysd_txn_req *req;
+
+    LIST_FOR_EACH (req, node, list) {
+        if (req->site == site) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+sysd_txn_site_is_pending(const struct sysd_txn_queue *q,
+                         enum sysd_txn_site site)
+{
+    return (sysd_txn_list_has_site(&q->queue, site)
+            || sysd_txn_list_has_site(&q->inflight, site));
+
+} /* sysd_txn_site_is_pending */
+
+/*
+ * Function       : sysd_txn_start
+ * Responsibility : moves the head of the queue, and the small writes
+ *                  queued right behind a small head, into one transaction
+ *                  and builds it
+ * Parameters     : queue, idl
+ * Returns        : true if there is something to commit
+ */
+static bool
+sysd_txn_start(struct sysd_txn_queue *q, struct ovsdb_idl *idl)
+{
+    unsigned long long int bytes = q->writes.bytes;
+    struct sysd_txn_req *req;
+    size_t n_changed = 0;
+    int n = 0;
+
+    q->txn = ovsdb_idl_txn_create(idl);
+    while (!list_is_empty(&q->queue) && n < SYSD_TXN_MAX_BATCH) {
+        req = CONTAINER_OF(list_front(&q->queue), struct sysd_txn_req, node);
+        if (n && (!sysd_txn_site_small[req->site]
+                  || !sysd_txn_site_small[q->site])) {
+            break;
+        }
+
+        list_remove(&req->node);
+        list_push_back(&q->inflight, &req->node);
+        if (!n++) {
+            q->site = req->site;
+        } else {
+            q->counters.batched++;
+        }
+
+        req->n_changed = req->build(q->txn, req->aux);
+        n_changed += req->n_changed;
+    }
+
+    if (!n_changed) {
+        ovsdb_idl_txn_destroy(q->txn);
+        q->txn = NULL;
+        q->counters.unchanged++;
+        sysd_txn_complete(&q->inflight, TXN_UNCHANGED);
+        return false;
+    }
+
+    /* A retried transaction is timed from its first attempt.  Writes made
+     * with the generated setters, such as the columns of inserted rows, are
+     * not in the byte estimate. */
+    q->sample.rows = n_changed;
+    q->sample.bytes = q->writes.bytes - bytes;
+    sysd_txn_stats_begin(q->site, &q->sample);
+    req = CONTAINER_OF(list_front(&q->inflight), struct sysd_txn_req, node);
+    if (req->start_usec) {
+        q->sample.start_usec = req->start_usec;
+    } else {
+        req->start_usec = q->sample.start_usec;
+    }
+    return true;
+
+} /* sysd_txn_start */
+
+/* Puts the writes of a transaction that hit a conflict back at the head of
+ * the queue, in order, to be rebuilt after a backoff. */
+static void
+sysd_txn_requeue(struct sysd_txn_queue *q)
+{
+    struct sysd_txn_req *req, *first = NULL;
+    int backoff;
+
+    while (!list_is_empty(&q->inflight)) {
+        req = CONTAINER_OF(q->inflight.prev, struct sysd_txn_req, node);
+        list_remove(&req->node);
+        list_push_front(&q->queue, &req->node);
+        first = req;
+    }
+
+    backoff = (first->backoff_msec
+               ? MIN(first->backoff_msec * 2, SYSD_TXN_BACKOFF_MAX_MSEC)
+               : SYSD_TXN_BACKOFF_MIN_MSEC);
+    first->backoff_msec = backoff;
+    q->retry_at = time_msec() + backoff;
+    q->counters.retries++;
+
+    VLOG_DBG("%s transaction conflicted; retrying in %d ms",
+             sysd_txn_site_name(first->site), backoff);
+
+} /* sysd_txn_requeue */
+
+/*
+ * Function       : sysd_txn_run
+ * Responsibility : collects the outcome of the transaction in flight and
+ *                  starts the next one, without waiting for ovsdb-server
+ * Parameters     : queue, idl
+ * Returns        : void
+ */
+void
+sysd_txn_run(struct sysd_txn_queue *q, struct ovsdb_idl *idl)
+{
+    enum ovsdb_idl_txn_status status;
+    int i;
+
+    for (i = 0; i < SYSD_TXN_MAX_PER_RUN; i++) {
+        if (!q->txn) {
+            if (list_is_empty(&q->queue) || time_msec() < q->retry_at) {
+                return;
+            }
+            if (!sysd_txn_start(q, idl)) {
+                continue;
+            }
+        }
+
+        status = ovsdb_idl_txn_commit(q->txn);
+        if (status == TXN_INCOMPLETE) {
+            return;
+        }
+
+        sysd_txn_stats_end(&q->stats, q->site, &q->sample, status);
+        ovsdb_idl_txn_destroy(q->txn);
+        q->txn = NULL;
+
+        if (status == TXN_TRY_AGAIN) {
+            sysd_txn_requeue(q);
+            return;
+        }
+        q->retry_at = 0;
+        sysd_txn_complete(&q->inflight, status);
+    }
+
+    /* Leave the rest for the next iteration, so the loop stays responsive
+     * when many writes complete at once. */
+    poll_immediate_wake();
+
+} /* sysd_txn_run */
+
+void
+sysd_txn_wait(const struct sysd_txn_queue *q)
+{
+    if (q->txn) {
+        ovsdb_idl_txn_wait(q->txn);
+    } else if (!list_is_empty(&q->queue)) {
+        poll_timer_wait_until(q->retry_at);
+    }
+
+} /* sysd_txn_wait */
+
+/*
+ * Function       : sysd_txn_format
+ * Responsibility : formats the state and counters of a transaction queue
+ *                  for ops-sysd/txn-stats
+ * Parameters     : queue, ds
+ * Returns        : void
+ */
+void
+sysd_txn_format(const struct sysd_txn_queue *q, struct ds *ds)
+{
+    ds_put_format(ds, "Queued: %"PRIuSIZE", in flight: %"PRIuSIZE"%s%s\n",
+                  list_size(&q->queue), list_size(&q->inflight),
+                  q->txn ? " " : "",
+                  q->txn ? sysd_txn_site_name(q->site) : "");
+    ds_put_format(ds, "Submitted: %llu, dropped: %llu, batched: %llu, "
+                  "retries: %llu, unchanged: %llu\n",
+                  q->counters.submitted, q->counters.dropped,
+                  q->counters.batched, q->counters.retries,
+                  q->counters.unchanged);
+
+} /* sysd_txn_format */
+/** @} end of group ops-sysd */
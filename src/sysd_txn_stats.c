@@ -0,0 +1,179 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for ops-sysd OVSDB transaction statistics.
+ *
+ * Every commit is timed with the monotonic clock, from its first attempt
+ * to its outcome, and counted in a log2-bucketed latency histogram for its
+ * call site, so that a slow ovsdb-server shows up in ops-sysd/txn-stats
+ * even when every commit eventually succeeds.
+ *
+ * The size of a transaction is not measured here: scanning the replica and
+ * encoding the written columns on every commit would cost more than many
+ * of the commits.  The rows are those the build functions report changed,
+ * and the bytes are estimated by sysd_write_*() as they write.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <dynamic-string.h>
+#include <ovsdb-idl.h>
+#include <timeval.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_histogram.h"
+#include "sysd_txn_stats.h"
+#include "sysd_trace.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_txn_stats);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+/* Commits slower than this are logged at WARN level. */
+#define SYSD_TXN_SLOW_USEC (1000 * 1000)
+
+static const char *sysd_txn_site_names[SYSD_TXN_N_SITES] = {
+    [SYSD_TXN_INITIAL_CONFIG] = "initial-config",
+    [SYSD_TXN_PACKAGE_INFO]   = "package-info",
+    [SYSD_TXN_SW_INFO]        = "sw-info",
+    [SYSD_TXN_HW_DONE]        = "hw-done",
+    [SYSD_TXN_HW_EXPIRED]     = "hw-expired",
+    [SYSD_TXN_MANIFEST_RELOAD] = "manifest-reload",
+    [SYSD_TXN_QOS_RECONCILE]  = "qos-reconcile",
+    [SYSD_TXN_QOS_RESTORE]    = "qos-restore",
+    [SYSD_TXN_INITIAL_REPLAY] = "initial-replay",
+    [SYSD_TXN_PER_BOX]        = "per-box",
+};
+
+/*
+ * Function       : sysd_txn_stats_begin
+ * Responsibility : starts timing a transaction about to be committed
+ * Parameters     : call site, sample holding its size
+ * Returns        : void
+ */
+void
+sysd_txn_stats_begin(enum sysd_txn_site site, struct sysd_txn_sample *sample)
+{
+    SYSD_TRACE(SYSD_TRACE_COMMIT, SYSD_TRACE_BEGIN, site, 0);
+    sample->start_usec = time_usec();
+
+} /* sysd_txn_stats_begin */
+
+/*
+ * Function       : sysd_txn_stats_end
+ * Responsibility : records the latency, size and result of a transaction
+ *                  for the given call site.  The latency covers every loop
+ *                  iteration the commit was outstanding for.
+ * Parameters     : statistics, call site, sample from
+ *                  sysd_txn_stats_begin(), status
+ * Returns        : void
+ */
+void
+sysd_txn_stats_end(struct sysd_txn_stats *txn_stats, enum sysd_txn_site site,
+                   const struct sysd_txn_sample *sample,
+                   enum ovsdb_idl_txn_status status)
+{
+    struct sysd_txn_site_stats *stats = &txn_stats->sites[site];
+    unsigned long long int usec;
+
+    usec = MAX(time_usec() - sample->start_usec, 0);
+    SYSD_TRACE(SYSD_TRACE_COMMIT, SYSD_TRACE_END, site, status);
+
+    stats->commits++;
+    if (status != TXN_SUCCESS && status != TXN_UNCHANGED) {
+        stats->failures++;
+    }
+    stats->last_status = status;
+    sysd_histogram_add(&stats->usec, usec);
+    stats->total_rows += sample->rows;
+    stats->max_rows = MAX(stats->max_rows, sample->rows);
+    stats->total_bytes += sample->bytes;
+    stats->max_bytes = MAX(stats->max_bytes, sample->bytes);
+
+    if (usec >= SYSD_TXN_SLOW_USEC) {
+        VLOG_WARN("%s commit took %llu ms (%llu rows, %llu bytes, %s)",
+                  sysd_txn_site_names[site], usec / 1000, sample->rows,
+                  sample->bytes, ovsdb_idl_txn_status_to_string(status));
+    }
+
+} /* sysd_txn_stats_end */
+
+/*
+ * Function       : sysd_txn_stats_format
+ * Responsibility : formats the per call site statistics and the non-empty
+ *                  latency histogram buckets for ops-sysd/txn-stats
+ * Parameters     : statistics, ds
+ * Returns        : void
+ */
+void
+sysd_txn_stats_format(const struct sysd_txn_stats *txn_stats, struct ds *ds)
+{
+    int i;
+
+    ds_put_format(ds, "%-16s %8s %7s %10s %10s %9s %9s %11s %11s %s\n",
+                  "site", "commits", "failed", "avg_us", "max_us",
+                  "avg_rows", "max_rows", "avg_bytes", "max_bytes", "last");
+    for (i = 0; i < SYSD_TXN_N_SITES; i++) {
+        const struct sysd_txn_site_stats *stats = &txn_stats->sites[i];
+        unsigned long long int n = MAX(stats->commits, 1);
+
+        ds_put_format(ds, "%-16s %8llu %7llu %10llu %10llu %9llu %9llu "
+                      "%11llu %11llu %s\n",
+                      sysd_txn_site_names[i], stats->commits,
+                      stats->failures, stats->usec.total / n,
+                      stats->usec.max, stats->total_rows / n,
+                      stats->max_rows, stats->total_bytes / n,
+                      stats->max_bytes,
+                      (stats->commits
+                       ? ovsdb_idl_txn_status_to_string(stats->last_status)
+                       : "-"));
+    }
+
+    ds_put_cstr(ds, "\nLatency histograms (us):\n");
+    for (i = 0; i < SYSD_TXN_N_SITES; i++) {
+        const struct sysd_txn_site_stats *stats = &txn_stats->sites[i];
+
+        if (!stats->commits) {
+            continue;
+        }
+
+        ds_put_format(ds, "%s:", sysd_txn_site_names[i]);
+        sysd_histogram_format(&stats->usec, ds);
+        ds_put_char(ds, '\n');
+    }
+
+} /* sysd_txn_stats_format */
+
+const char *
+sysd_txn_site_name(enum sysd_txn_site site)
+{
+    return sysd_txn_site_names[site];
+
+} /* sysd_txn_site_name */
+
+void
+sysd_txn_stats_reset(struct sysd_txn_stats *stats)
+{
+    memset(stats, 0, sizeof *stats);
+
+} /* sysd_txn_stats_reset */
+/** @} end of group ops-sysd */
@@ -25,17 +25,25 @@
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
 #include <sys/stat.h>
 #include <zlib.h>
 
 #include "util.h"
 #include "openvswitch/vlog.h"
+#include "hash.h"
 #include "json.h"
+#include "poll-loop.h"
+#include "sset.h"
+#include "timeval.h"
 #include "sysd_util.h"
 
 #include <config-yaml.h>
 #include "sysd_cfg_yaml.h"
 #include "sysd.h"
+#include "sysd_ctx.h"
+#include "sysd_mem.h"
 
 /***********************************************************/
 
@@ -46,8 +54,6 @@ VLOG_DEFINE_THIS_MODULE(sysd_util);
 /** @ingroup sysd
  * @{ */
 
-struct json *manifest_info = NULL;
-
 #ifndef PLATFORM_SIMULATION
 static int
 dmidecode_exists(char *cmd_path)
@@ -143,13 +149,12 @@ get_manuf_and_prodname(char *cmd_path, char **manufacturer, char **product_name)
 #endif	/* PLATFORM_SIMULATION */
 
 static int
-create_link_to_desc_files(char *manufacturer, char *product_name)
+create_link_to_desc_files(struct sysd_ctx *ctx, char *manufacturer,
+                          char *product_name)
 {
     char        path[1024];
     int         rc = 0;
     struct stat sbuf;
-    extern char *g_hw_desc_dir;
-    extern char *g_hw_desc_link;
     char        *install_rootdir;
     char        *data_rootdir;
 
@@ -162,17 +167,20 @@ create_link_to_desc_files(char *manufacturer, char *product_name)
 
     VLOG_INFO("Location to HW descrptor files: %s", path);
 
-    g_hw_desc_dir = strdup(path);
+    sysd_mem_free(ctx->hw_desc_dir);
+    ctx->hw_desc_dir = sysd_mem_strdup(SYSD_MEM_PATHS, path);
 
-    if (stat(g_hw_desc_dir, &sbuf) != 0) {
-        VLOG_ERR("Unable to find hardware description files at %s", g_hw_desc_dir);
+    if (stat(ctx->hw_desc_dir, &sbuf) != 0) {
+        VLOG_ERR("Unable to find hardware description files at %s",
+                 ctx->hw_desc_dir);
         return -1;
     }
 
     /* Remove old link if it exists */
     snprintf(path, sizeof(path), "%s%s", data_rootdir, HWDESC_FILE_LINK);
-    g_hw_desc_link = strdup(path);
-    remove(g_hw_desc_link);
+    sysd_mem_free(ctx->hw_desc_link);
+    ctx->hw_desc_link = sysd_mem_strdup(SYSD_MEM_PATHS, path);
+    remove(ctx->hw_desc_link);
 
     /* mkdir for the new link */
     snprintf(path, sizeof(path), "%s%s", data_rootdir, HWDESC_FILE_LINK_PATH);
@@ -183,9 +191,9 @@ create_link_to_desc_files(char *manufacturer, char *product_name)
     }
 
     /* Create link to these files */
-    if (-1 == symlink(g_hw_desc_dir, g_hw_desc_link)) {
+    if (-1 == symlink(ctx->hw_desc_dir, ctx->hw_desc_link)) {
         VLOG_ERR("Unable to create  soft link to %s -> %s. Error %s",
-                 g_hw_desc_link, g_hw_desc_dir, ovs_strerror(errno));
+                 ctx->hw_desc_link, ctx->hw_desc_dir, ovs_strerror(errno));
         return -1;
     }
 
@@ -194,7 +202,7 @@ create_link_to_desc_files(char *manufacturer, char *product_name)
 } /* create_link_to_desc_files */
 
 int
-sysd_create_link_to_hwdesc_files(void)
+sysd_create_link_to_hwdesc_files(struct sysd_ctx *ctx)
 {
     char    *manufacturer = NULL;
     char    *product_name = NULL;
@@ -224,7 +232,7 @@ sysd_create_link_to_hwdesc_files(void)
 
     VLOG_DBG("manufacturer=%s product_name=%s", manufacturer, product_name);
 
-    rc = create_link_to_desc_files(manufacturer, product_name);
+    rc = create_link_to_desc_files(ctx, manufacturer, product_name);
     if (rc) {
         VLOG_ERR("Failed to create link to HW descriptor files");
         return -1;
@@ -249,232 +257,609 @@ calc_crc(unsigned char *buf, int len)
 
 } /* calc_crc() */
 
-static void
-_sysd_get_hw_handler(struct shash *object) {
-    const struct shash_node *dnode;
-    struct json *jp;
+static daemon_info_t *
+sysd_daemon_lookup(const struct hmap *index, const char *name)
+{
+    daemon_info_t *daemon;
 
-    SHASH_FOR_EACH (dnode, object) {
-        if (strncmp(dnode->name, HW_HANDLER_TAG, strlen(HW_HANDLER_TAG))
-                                                        == 0) {
-            jp = dnode->data;
-            switch (jp->type) {
-                case JSON_TRUE:
-                    daemons[num_daemons]->is_hw_handler = true;
-                    break;
-                case JSON_FALSE:
-                    /* Fall through */
-                default:
-                    daemons[num_daemons]->is_hw_handler = false;
-                    break;
+    HMAP_FOR_EACH_WITH_HASH (daemon, node, hash_string(name, 0), index) {
+        if (!strcmp(daemon->name, name)) {
+            return daemon;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function       : sysd_daemon_find
+ * Responsibility : looks up a manifest daemon by its exact name
+ * Parameters     : ctx, name
+ * Returns        : the daemon, or NULL if the manifest does not list it
+ */
+daemon_info_t *
+sysd_daemon_find(const struct sysd_ctx *ctx, const char *name)
+{
+    return sysd_daemon_lookup(&ctx->daemon_index, name);
+
+} /* sysd_daemon_find */
+
+static const char *sysd_ready_policy_names[SYSD_READY_N_POLICIES] = {
+    [SYSD_READY_BLOCK]    = "block",
+    [SYSD_READY_DEGRADED] = "degraded",
+    [SYSD_READY_ALARM]    = "alarm",
+};
+
+const char *
+sysd_ready_policy_name(enum sysd_ready_policy policy)
+{
+    return sysd_ready_policy_names[policy];
+}
+
+/*
+ * Function       : sysd_process_ready_deadline
+ * Responsibility : reads a daemon's optional "ready_timeout", in seconds,
+ *                  and "on_timeout" policy.  Without a timeout sysd waits
+ *                  for the daemon forever, as it always has.
+ * Parameters     : daemon, its manifest entry
+ * Returns        : 0 on success, -1 on an invalid value
+ */
+static int
+sysd_process_ready_deadline(daemon_info_t *daemon, const struct json *entry)
+{
+    const struct json *timeout, *policy;
+    int i;
+
+    timeout = shash_find_data(json_object(entry), READY_TIMEOUT_TAG);
+    if (timeout) {
+        if (timeout->type != JSON_INTEGER || timeout->u.integer <= 0) {
+            VLOG_ERR("%s of %s must be a positive number of seconds",
+                     READY_TIMEOUT_TAG, daemon->name);
+            return -1;
+        }
+        daemon->ready_timeout_ms = timeout->u.integer * 1000;
+    }
+
+    daemon->on_timeout = SYSD_READY_BLOCK;
+    policy = shash_find_data(json_object(entry), ON_TIMEOUT_TAG);
+    if (!policy) {
+        return 0;
+    }
+    if (policy->type == JSON_STRING) {
+        for (i = 0; i < SYSD_READY_N_POLICIES; i++) {
+            if (!strcmp(json_string(policy), sysd_ready_policy_names[i])) {
+                daemon->on_timeout = i;
+                return 0;
             }
-            return;
         }
     }
-    return;
-} /*_sysd_get_hw_handler() */
+    VLOG_ERR("%s of %s must be \"block\", \"degraded\" or \"alarm\"",
+             ON_TIMEOUT_TAG, daemon->name);
+    return -1;
 
+} /* sysd_process_ready_deadline() */
+
+/*
+ * Function       : sysd_assign_hw_levels
+ * Responsibility : turns the manifest's "hw_stage" and "depends_on"
+ *                  declarations into the System:cur_hw level each h/w
+ *                  daemon gates.  A daemon without "hw_stage" gates the
+ *                  last stage, and a daemon is moved up to the stage of
+ *                  any daemon it depends on, so no level is reached before
+ *                  the dependencies of its daemons.  The stages in use are
+ *                  then numbered 1..num_hw_levels.
+ * Parameters     : ctx, the "daemons" object; each daemon's hw_level holds
+ *                  its declared stage, or 0, on entry
+ * Returns        : 0 on success, -1 on an invalid dependency
+ */
 static int
-_sysd_process_daemons(struct shash *object) {
+sysd_assign_hw_levels(struct sysd_ctx *ctx, const struct shash *object)
+{
+    daemon_info_t **daemons = ctx->daemons;
     const struct shash_node *dnode;
+    bool used[SYSD_MAX_HW_LEVELS + 1] = { false };
+    int level_of_stage[SYSD_MAX_HW_LEVELS + 1];
+    int last_stage = 1;
+    int i, pass, stage;
+    size_t j;
+    bool changed;
+
+    for (i = 0; i < ctx->num_daemons; i++) {
+        last_stage = MAX(last_stage, daemons[i]->hw_level);
+    }
+    for (i = 0; i < ctx->num_daemons; i++) {
+        if (!daemons[i]->hw_level) {
+            daemons[i]->hw_level = last_stage;
+        }
+    }
 
+    /* Check the dependencies before relying on them. */
     SHASH_FOR_EACH (dnode, object) {
-        daemons = realloc(daemons, sizeof(daemon_info_t*)*(num_daemons+1));
-        daemons[num_daemons] = calloc(sizeof(daemon_info_t), 1);
-        if (daemons[num_daemons] == (daemon_info_t *) NULL) {
-            VLOG_ERR("Error processing daemon information");
-            return (-1);
-        }
+        const struct json *deps;
 
-        strncpy(daemons[num_daemons]->name, dnode->name, strlen(dnode->name));
+        deps = shash_find_data(json_object(dnode->data), DEPENDS_ON_TAG);
+        if (!deps) {
+            continue;
+        }
+        if (deps->type != JSON_ARRAY) {
+            VLOG_ERR("%s of %s is not an array", DEPENDS_ON_TAG, dnode->name);
+            return -1;
+        }
+        for (j = 0; j < json_array(deps)->n; j++) {
+            const struct json *dep = json_array(deps)->elems[j];
 
-        /* If this row is sysd, then go ahead and set cur_hw = 1 since
-           ...everything is being done in one transaction. */
+            if (dep->type != JSON_STRING
+                || !sysd_daemon_find(ctx, json_string(dep))) {
+                VLOG_ERR("%s depends on an unknown daemon", dnode->name);
+                return -1;
+            }
+        }
+    }
 
-        if (strncmp(daemons[num_daemons]->name, NAME_IN_DAEMON_TABLE,
-                    strlen(NAME_IN_DAEMON_TABLE)) == 0 ) {
-            daemons[num_daemons]->cur_hw = 1;
+    /* Raising a stage to the highest of its dependencies settles within
+     * one pass per daemon, cycles included. */
+    for (pass = 0; pass < ctx->num_daemons; pass++) {
+        changed = false;
+        SHASH_FOR_EACH (dnode, object) {
+            daemon_info_t *daemon = sysd_daemon_find(ctx, dnode->name);
+            const struct json *deps;
+
+            deps = shash_find_data(json_object(dnode->data), DEPENDS_ON_TAG);
+            for (j = 0; deps && j < json_array(deps)->n; j++) {
+                const daemon_info_t *dep;
+
+                dep = sysd_daemon_find(
+                        ctx, json_string(json_array(deps)->elems[j]));
+                if (dep->hw_level > daemon->hw_level) {
+                    daemon->hw_level = dep->hw_level;
+                    changed = true;
+                }
+            }
         }
-        else
-        {
-            daemons[num_daemons]->cur_hw = 0;
+        if (!changed) {
+            break;
         }
+    }
 
-        _sysd_get_hw_handler(json_object(dnode->data));
-
-        num_daemons++;
+    for (i = 0; i < ctx->num_daemons; i++) {
+        if (daemons[i]->is_hw_handler) {
+            used[daemons[i]->hw_level] = true;
+        }
+    }
+    ctx->num_hw_levels = 0;
+    for (stage = 1; stage <= SYSD_MAX_HW_LEVELS; stage++) {
+        if (used[stage]) {
+            level_of_stage[stage] = ++ctx->num_hw_levels;
+        }
+    }
+    ctx->num_hw_levels = MAX(ctx->num_hw_levels, 1);
+    for (i = 0; i < ctx->num_daemons; i++) {
+        daemons[i]->hw_level = (daemons[i]->is_hw_handler
+                                ? level_of_stage[daemons[i]->hw_level] : 0);
     }
 
-    return(0);
-} /*_sysd_process_daemons() */
+    return 0;
 
+} /* sysd_assign_hw_levels() */
 
+/*
+ * Function       : _sysd_process_daemons
+ * Responsibility : builds daemons[] and its name index from the manifest's
+ *                  "daemons" object.  The table is sized once, from the
+ *                  number of entries.  Also assigns readiness levels.
+ * Parameters     : ctx, the "daemons" object
+ * Returns        : 0 on success, -1 on an invalid entry
+ */
 static int
-_sysd_process_mgmt_intf(struct shash *object)
+_sysd_process_daemons(struct sysd_ctx *ctx, const struct json *json)
 {
+    const struct shash *object = json_object(json);
     const struct shash_node *dnode;
-    struct json *jp;
-    static bool is_mgmt_intf_present = false;
+    daemon_info_t *table;
+    size_t n = shash_count(object);
+
+    ctx->daemons = sysd_mem_calloc(SYSD_MEM_DAEMONS, n,
+                                   sizeof *ctx->daemons);
+    table = ctx->daemon_table = sysd_mem_calloc(SYSD_MEM_DAEMONS, n,
+                                                sizeof *table);
 
     SHASH_FOR_EACH (dnode, object) {
-        if (strncmp(dnode->name, MGMT_INTF_NAME_TAG, strlen(MGMT_INTF_NAME_TAG)) == 0) {
-            jp = dnode->data;
-            switch (jp->type) {
-                case JSON_STRING:
-                    mgmt_intf = xcalloc(sizeof(mgmt_intf_info_t), 0);
-
-                    strncpy(mgmt_intf->name,jp->u.string,strlen(jp->u.string));
-                    is_mgmt_intf_present = true;
-                    VLOG_DBG("Management Interface read successfully: %s",mgmt_intf->name);
-                    break;
-                default:
-                    VLOG_ERR("Error retreiving management interface name");
-                    break;
-            }
+        daemon_info_t *daemon = &table[ctx->num_daemons];
+        const struct json *entry = dnode->data;
+        const struct json *hw_handler;
+        const struct json *hw_stage;
+
+        if (strlen(dnode->name) >= sizeof daemon->name) {
+            VLOG_ERR("Daemon name %s is longer than %d characters",
+                     dnode->name, MAX_DAEMON_NAME_LEN - 1);
+            return -1;
+        }
+        if (entry->type != JSON_OBJECT) {
+            VLOG_ERR("Daemon %s is not a JSON object", dnode->name);
+            return -1;
+        }
+        if (sysd_daemon_find(ctx, dnode->name)) {
+            VLOG_ERR("Daemon %s is listed more than once", dnode->name);
+            return -1;
+        }
+
+        ovs_strlcpy(daemon->name, dnode->name, sizeof daemon->name);
+
+        /* sysd sets its own cur_hw = 1, since everything it does is
+         * done in one transaction. */
+        daemon->cur_hw = !strcmp(daemon->name, NAME_IN_DAEMON_TABLE);
+        daemon->listed_msec = time_msec();
 
-            if (is_mgmt_intf_present == false)
-            {
-                VLOG_ERR("Management interface not present in image.manifest file");
+        hw_handler = shash_find_data(json_object(entry), HW_HANDLER_TAG);
+        daemon->is_hw_handler = hw_handler && hw_handler->type == JSON_TRUE;
+
+        hw_stage = shash_find_data(json_object(entry), HW_STAGE_TAG);
+        if (hw_stage) {
+            if (hw_stage->type != JSON_INTEGER
+                || hw_stage->u.integer < 1
+                || hw_stage->u.integer > SYSD_MAX_HW_LEVELS) {
+                VLOG_ERR("%s of %s must be an integer from 1 to %d",
+                         HW_STAGE_TAG, dnode->name, SYSD_MAX_HW_LEVELS);
                 return -1;
             }
-
-            return 0;
+            daemon->hw_level = hw_stage->u.integer;
         }
+        if (sysd_process_ready_deadline(daemon, entry)) {
+            return -1;
+        }
+
+        hmap_insert(&ctx->daemon_index, &daemon->node,
+                    hash_string(daemon->name, 0));
+        ctx->daemons[ctx->num_daemons++] = daemon;
     }
 
-    if (is_mgmt_intf_present == false)
-    {
+    return sysd_assign_hw_levels(ctx, object);
+
+} /* _sysd_process_daemons() */
+
+static int
+_sysd_process_mgmt_intf(struct sysd_ctx *ctx, const struct json *json)
+{
+    const struct json *jp;
+
+    jp = shash_find_data(json_object(json), MGMT_INTF_NAME_TAG);
+    if (!jp) {
         VLOG_ERR("Management interface not present in image.manifest file");
         return -1;
     }
+    if (jp->type != JSON_STRING) {
+        VLOG_ERR("Error retreiving management interface name");
+        return -1;
+    }
 
-    return(0);
-} /*_sysd_process_mgmt_intf() */
+    ctx->mgmt_intf = sysd_mem_calloc(SYSD_MEM_MANIFEST, 1,
+                                     sizeof *ctx->mgmt_intf);
+    ovs_strlcpy(ctx->mgmt_intf->name, json_string(jp),
+                sizeof ctx->mgmt_intf->name);
+    VLOG_DBG("Management Interface read successfully: %s",
+             ctx->mgmt_intf->name);
 
+    return 0;
 
-int
-sysd_process_json(struct json *json)
+} /* _sysd_process_mgmt_intf() */
+
+/* Top level image.manifest sections sysd understands. */
+static const struct {
+    const char *name;
+    int (*process)(struct sysd_ctx *, const struct json *);
+} manifest_sections[] = {
+    { DAEMONS_TAG,   _sysd_process_daemons },
+    { MGMT_INTF_TAG, _sysd_process_mgmt_intf },
+};
+
+/*
+ * Function       : sysd_process_manifest
+ * Responsibility : processes the known top level sections of the manifest
+ *                  in one pass.  Other sections are counted and logged,
+ *                  not searched.
+ * Parameters     : ctx, the manifest's top level object
+ * Returns        : 0 on success, -1 on error
+ */
+static int
+sysd_process_manifest(struct sysd_ctx *ctx, const struct json *json)
 {
-    struct shash *object;
-    struct json_array *array;
     const struct shash_node *node;
-    struct json *jp;
-    int i;
-
-    /* The approach is to recursively look for type==OBJECT and then
-       ...see if it is what we care about (for now, only "dameons").
-       ...When we find something we care about, call a specific function
-       ...to process it. */
-
-    switch (json->type) {
-        case JSON_OBJECT:
-            object = json_object(json);
-
-            SHASH_FOR_EACH (node, object) {
-                jp = node->data;
-                if (jp->type == JSON_OBJECT) {
-                    if (strncmp(node->name, DAEMONS_TAG, strlen(DAEMONS_TAG))
-                                                        == 0) {
-                        if (_sysd_process_daemons(json_object(node->data))) {
-                            return (-1);
-                        }
-                    }
-                    else if (strncmp(node->name, MGMT_INTF_TAG, strlen(MGMT_INTF_TAG)) == 0)
-                    {
-                        if (_sysd_process_mgmt_intf(json_object(node->data)))
-                        {
-                            return (-1);
-                        }
-                    }
-                    else
-                    {
-                        if (sysd_process_json(jp)) {
-                            return (-1);
-                        }
-                    }
-                }
-                else
-                {
-                    if (jp->type == JSON_ARRAY) {
-                        /* Don't yet care about anything that is an array
-                           ...so just keep looking in case what we do care
-                           ...about is nested inside an array. */
-                        if (sysd_process_json(jp)) {
-                            return (-1);
-                        }
-                    }
-                }
-                /* Ignore anything that isn't an object or array. */
-            }
-            break;
-        case JSON_ARRAY:
-            /* Don't yet care about anything that is an array
-               ...so just keep looking in case what we do care
-               ...about is nested inside an array. */
+    size_t i;
 
-            array = json_array(json);
+    SHASH_FOR_EACH (node, json_object(json)) {
+        const struct json *jp = node->data;
 
-            for (i = 0; i < (int) array->n; i++) {
-                jp = array->elems[i];
-                if (sysd_process_json(jp)) {
-                    return (-1);
-                }
+        for (i = 0; i < ARRAY_SIZE(manifest_sections); i++) {
+            if (!strcmp(node->name, manifest_sections[i].name)) {
+                break;
             }
-            break;
-        default:
-            /* Ignore anything that isn't an object or array. */
-            break;
+        }
+
+        if (i == ARRAY_SIZE(manifest_sections)) {
+            VLOG_INFO("Ignoring unknown image.manifest section %s",
+                      node->name);
+            ctx->manifest_unknown_sections++;
+        } else if (jp->type != JSON_OBJECT) {
+            VLOG_ERR("image.manifest section %s is not a JSON object",
+                     node->name);
+            return -1;
+        } else if (manifest_sections[i].process(ctx, jp)) {
+            return -1;
+        }
     }
 
-    return(0);
-} /* sysd_process_json() */
+    return 0;
+
+} /* sysd_process_manifest() */
 
 static void
-sysd_set_num_hw_daemons()
+sysd_set_num_hw_daemons(struct sysd_ctx *ctx)
 {
     int i;
 
-    num_hw_daemons = 0;
-    for (i = 0; i < num_daemons; i++) {
-        if (daemons[i]->is_hw_handler) {
-            num_hw_daemons++;
+    ctx->num_hw_daemons = 0;
+    for (i = 0; i < ctx->num_daemons; i++) {
+        if (ctx->daemons[i]->is_hw_handler) {
+            ctx->num_hw_daemons++;
         }
     }
     return;
 } /* sysd_set_num_hw_daemons() */
 
-int
-sysd_read_manifest_file(void)
+/*
+ * Function       : sysd_install_path
+ * Responsibility : writes the path of an installed file, under
+ *                  $OPENSWITCH_INSTALL_PATH if it is set, to 'path'
+ * Parameters     : path, its size, absolute path of the file in the image
+ * Returns        : void
+ */
+void
+sysd_install_path(char *path, size_t size, const char *file)
 {
-    char image_manifest_path[1024];
     char *install_rootdir;
 
     if (!(install_rootdir = getenv("OPENSWITCH_INSTALL_PATH")))
         install_rootdir  = "";
-    snprintf(image_manifest_path, sizeof(image_manifest_path), "%s%s",
-             install_rootdir, IMAGE_MANIFEST_FILE_PATH);
+    snprintf(path, size, "%s%s", install_rootdir, file);
+
+} /* sysd_install_path */
+
+/*
+ * Function       : sysd_data_path
+ * Responsibility : writes the path of a file sysd writes, under
+ *                  $OPENSWITCH_DATA_PATH if it is set, to 'path'
+ * Parameters     : path, its size, absolute path of the file on the switch
+ * Returns        : void
+ */
+void
+sysd_data_path(char *path, size_t size, const char *file)
+{
+    char *data_rootdir;
+
+    if (!(data_rootdir = getenv("OPENSWITCH_DATA_PATH")))
+        data_rootdir  = "";
+    snprintf(path, size, "%s%s", data_rootdir, file);
+
+} /* sysd_data_path */
+
+int
+sysd_read_manifest_file(struct sysd_ctx *ctx)
+{
+    char image_manifest_path[1024];
+    struct json *manifest_info;
+    int rc = -1;
+
+    sysd_install_path(image_manifest_path, sizeof image_manifest_path,
+                      IMAGE_MANIFEST_FILE_PATH);
     manifest_info = json_from_file(image_manifest_path);
 
     if (manifest_info == (struct json *) NULL) {
         return -1;
     }
 
-    /* The top level JSON blob must be either OBJECT or ARRAY. */
-    if ((manifest_info->type != JSON_OBJECT) &&
-                            (manifest_info->type != JSON_ARRAY)) {
+    /* The top level JSON blob must be an OBJECT. */
+    if (manifest_info->type != JSON_OBJECT) {
         VLOG_ERR("invalid JSON type of %d", (int)manifest_info->type);
-        return (-1);
-    }
-
-    if (sysd_process_json(manifest_info)) {
+    } else if (sysd_process_manifest(ctx, manifest_info)) {
         VLOG_ERR("Error processing %s", IMAGE_MANIFEST_FILE_PATH);
-        return(-1);
+    } else {
+        sysd_set_num_hw_daemons(ctx);
+        rc = 0;
     }
 
     json_destroy(manifest_info);
 
-    sysd_set_num_hw_daemons();
-
-    return(0);
+    return rc;
 } /* sysd_read_manifest_file() */
+
+/*
+ * Function       : sysd_free_manifest_info
+ * Responsibility : frees the daemon model and management interface read
+ *                  from image.manifest
+ * Parameters     : ctx
+ * Returns        : void
+ */
+void
+sysd_free_manifest_info(struct sysd_ctx *ctx)
+{
+    hmap_clear(&ctx->daemon_index);
+    sysd_mem_free(ctx->daemon_table);
+    sysd_mem_free(ctx->daemons);
+    sysd_mem_free(ctx->mgmt_intf);
+    ctx->daemon_table = NULL;
+    ctx->daemons = NULL;
+    ctx->mgmt_intf = NULL;
+    ctx->num_daemons = 0;
+    ctx->num_hw_daemons = 0;
+    ctx->num_hw_levels = 1;
+    ctx->manifest_unknown_sections = 0;
+
+} /* sysd_free_manifest_info() */
+
+/*
+ * Function       : sysd_reread_manifest_file
+ * Responsibility : reads image.manifest again and replaces the daemon
+ *                  model with it.  Daemons still listed keep what sysd has
+ *                  seen of their readiness.  If the file is invalid the
+ *                  current model is kept.  The management interface is only
+ *                  applied at boot and is not changed.
+ * Parameters     : ctx, set to add the names of daemons no longer listed to
+ * Returns        : 0 on success, -1 on error
+ */
+int
+sysd_reread_manifest_file(struct sysd_ctx *ctx, struct sset *removed)
+{
+    daemon_info_t **old_daemons = ctx->daemons;
+    daemon_info_t *old_table = ctx->daemon_table;
+    mgmt_intf_info_t *old_mgmt_intf = ctx->mgmt_intf;
+    int old_num_daemons = ctx->num_daemons;
+    int old_num_hw_daemons = ctx->num_hw_daemons;
+    int old_num_hw_levels = ctx->num_hw_levels;
+    int old_unknown_sections = ctx->manifest_unknown_sections;
+    struct hmap old_index = HMAP_INITIALIZER(&old_index);
+    int i, rc;
+
+    hmap_swap(&old_index, &ctx->daemon_index);
+    ctx->daemons = NULL;
+    ctx->daemon_table = NULL;
+    ctx->mgmt_intf = NULL;
+    ctx->num_daemons = 0;
+    ctx->manifest_unknown_sections = 0;
+
+    rc = sysd_read_manifest_file(ctx);
+
+    if (ctx->mgmt_intf) {
+        if (!rc && old_mgmt_intf
+            && strcmp(ctx->mgmt_intf->name, old_mgmt_intf->name)) {
+            VLOG_WARN("Management interface %s takes effect after a restart",
+                      ctx->mgmt_intf->name);
+        }
+        sysd_mem_free(ctx->mgmt_intf);
+    }
+    ctx->mgmt_intf = old_mgmt_intf;
+
+    if (rc) {
+        /* Drop what was parsed and go back to the current model. */
+        hmap_swap(&old_index, &ctx->daemon_index);
+        sysd_mem_free(ctx->daemon_table);
+        sysd_mem_free(ctx->daemons);
+        ctx->daemons = old_daemons;
+        ctx->daemon_table = old_table;
+        ctx->num_daemons = old_num_daemons;
+        ctx->num_hw_daemons = old_num_hw_daemons;
+        ctx->num_hw_levels = old_num_hw_levels;
+        ctx->manifest_unknown_sections = old_unknown_sections;
+        hmap_destroy(&old_index);
+        return -1;
+    }
+
+    for (i = 0; i < ctx->num_daemons; i++) {
+        daemon_info_t *daemon = ctx->daemons[i];
+        const daemon_info_t *old;
+
+        old = sysd_daemon_lookup(&old_index, daemon->name);
+        if (old && old->is_hw_handler && daemon->is_hw_handler) {
+            daemon->listed_msec = old->listed_msec;
+            daemon->ready_msec = old->ready_msec;
+            daemon->seen_cur_hw = old->seen_cur_hw;
+            daemon->expired_msec = old->expired_msec;
+            daemon->generation = old->generation;
+            daemon->reinit_msec = old->reinit_msec;
+            daemon->last_reinit_ms = old->last_reinit_ms;
+        }
+    }
+    for (i = 0; i < old_num_daemons; i++) {
+        if (!sysd_daemon_find(ctx, old_daemons[i]->name)) {
+            sset_add(removed, old_daemons[i]->name);
+        }
+    }
+
+    hmap_destroy(&old_index);
+    sysd_mem_free(old_table);
+    sysd_mem_free(old_daemons);
+
+    return 0;
+
+} /* sysd_reread_manifest_file() */
+
+/*
+ * Function       : sysd_manifest_watch_open
+ * Responsibility : watches image.manifest for changes with inotify.  The
+ *                  directory is watched, since the file may be replaced
+ *                  rather than rewritten.
+ * Parameters     : ctx
+ * Returns        : 0 on success, otherwise a positive errno value
+ */
+int
+sysd_manifest_watch_open(struct sysd_ctx *ctx)
+{
+    char path[1024];
+    char *slash;
+    int error;
+
+    sysd_install_path(path, sizeof path, IMAGE_MANIFEST_FILE_PATH);
+    slash = strrchr(path, '/');
+    if (slash) {
+        *slash = '\0';
+    }
+
+    ctx->manifest_watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (ctx->manifest_watch_fd < 0) {
+        error = errno;
+        VLOG_ERR("inotify_init1 failed (%s)", ovs_strerror(error));
+        return error;
+    }
+    if (inotify_add_watch(ctx->manifest_watch_fd, slash ? path : ".",
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        error = errno;
+        VLOG_ERR("Cannot watch %s (%s)", path, ovs_strerror(error));
+        close(ctx->manifest_watch_fd);
+        ctx->manifest_watch_fd = -1;
+        return error;
+    }
+    return 0;
+
+} /* sysd_manifest_watch_open() */
+
+/*
+ * Function       : sysd_manifest_watch_run
+ * Responsibility : drains the pending inotify events
+ * Parameters     : ctx
+ * Returns        : true if image.manifest was written or replaced
+ */
+bool
+sysd_manifest_watch_run(struct sysd_ctx *ctx)
+{
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const char *name = strrchr(IMAGE_MANIFEST_FILE_PATH, '/');
+    bool changed = false;
+    ssize_t n;
+
+    if (ctx->manifest_watch_fd < 0) {
+        return false;
+    }
+
+    name = name ? name + 1 : IMAGE_MANIFEST_FILE_PATH;
+    while ((n = read(ctx->manifest_watch_fd, buf, sizeof buf)) > 0) {
+        const char *p = buf;
+
+        while (p < buf + n) {
+            const struct inotify_event *event = (const void *) p;
+
+            if (event->len && !strcmp(event->name, name)) {
+                changed = true;
+            }
+            p += sizeof *event + event->len;
+        }
+    }
+    return changed;
+
+} /* sysd_manifest_watch_run() */
+
+void
+sysd_manifest_watch_wait(const struct sysd_ctx *ctx)
+{
+    if (ctx->manifest_watch_fd >= 0) {
+        poll_fd_wait(ctx->manifest_watch_fd, POLLIN);
+    }
+}
 /** @} end of group sysd */
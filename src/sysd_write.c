@@ -0,0 +1,288 @@
+/************************************************************************//**
+ * (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ *    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ *    License for the specific language governing permissions and limitations
+ *    under the License.
+ *
+ ***************************************************************************/
+/* @ingroup ops-sysd
+ *
+ * @file
+ * Source for ops-sysd's compare-before-write OVSDB column setters.
+ *
+ * The IDL only drops a write of an unchanged value for write-only columns;
+ * sysd monitors the columns it writes, so every refresh of a value would
+ * otherwise be sent and echoed to every client that monitors the column.
+ * These setters compare the new value with ovsdb_idl_read() first and
+ * count, per column, how many writes they made and how many they dropped.
+ * The counts belong to the transaction queue of one context.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <dynamic-string.h>
+#include <hash.h>
+#include <hmap.h>
+#include <ovsdb-data.h>
+#include <ovsdb-idl.h>
+#include <ovsdb-idl-provider.h>
+#include <smap.h>
+#include <util.h>
+#include <openvswitch/vlog.h>
+
+#include "sysd_write.h"
+
+VLOG_DEFINE_THIS_MODULE(sysd_write);
+
+/** @ingroup ops-sysd
+ * @{ */
+
+struct sysd_write_column {
+    struct hmap_node hmap_node;         /* In 'columns', by column. */
+    const struct ovsdb_idl_column *column;
+    char *name;                         /* "Table:column". */
+    unsigned long long int written;
+    unsigned long long int elided;
+};
+
+void
+sysd_write_stats_init(struct sysd_write_stats *stats)
+{
+    hmap_init(&stats->columns);
+    stats->written = stats->elided = stats->bytes = 0;
+
+} /* sysd_write_stats_init */
+
+void
+sysd_write_stats_destroy(struct sysd_write_stats *stats)
+{
+    struct sysd_write_column *wc, *next;
+
+    HMAP_FOR_EACH_SAFE (wc, next, hmap_node, &stats->columns) {
+        hmap_remove(&stats->columns, &wc->hmap_node);
+        free(wc->name);
+        free(wc);
+    }
+    hmap_destroy(&stats->columns);
+
+} /* sysd_write_stats_destroy */
+
+static struct sysd_write_column *
+sysd_write_column_get(struct sysd_write_stats *stats,
+                      const struct ovsdb_idl_row *row,
+                      const struct ovsdb_idl_column *column)
+{
+    struct sysd_write_column *wc;
+    uint32_t hash = hash_pointer(column, 0);
+
+    HMAP_FOR_EACH_WITH_HASH (wc, hmap_node, hash, &stats->columns) {
+        if (wc->column == column) {
+            return wc;
+        }
+    }
+
+    wc = xzalloc(sizeof *wc);
+    wc->column = column;
+    wc->name = xasprintf("%s:%s", row->table->class->name, column->name);
+    hmap_insert(&stats->columns, &wc->hmap_node, hash);
+    return wc;
+}
+
+/* Estimates what 'n' atoms of 'type' add to a "transact" request, from
+ * their count and a typical encoded width, so that nothing is encoded on
+ * the commit path.  Only strings are measured. */
+static unsigned long long int
+sysd_write_atoms_bytes(const union ovsdb_atom *atoms, size_t n,
+                       enum ovsdb_atomic_type type)
+{
+    static const unsigned int widths[OVSDB_N_TYPES] = {
+        [OVSDB_TYPE_INTEGER] = 8,
+        [OVSDB_TYPE_REAL]    = 12,
+        [OVSDB_TYPE_BOOLEAN] = 5,
+        [OVSDB_TYPE_UUID]    = 46,      /* ["uuid","..."] */
+    };
+    unsigned long long int bytes = 0;
+    size_t i;
+
+    if (type != OVSDB_TYPE_STRING) {
+        return n * widths[type];
+    }
+    for (i = 0; i < n; i++) {
+        bytes += strlen(atoms[i].string) + 3;   /* Quotes and separator. */
+    }
+    return bytes;
+}
+
+/*
+ * Function       : sysd_write_datum
+ * Responsibility : writes 'datum' to 'column' of 'row' unless the column
+ *                  already holds it.  Takes ownership of 'datum'.
+ * Parameters     : stats, row, column, datum
+ * Returns        : true if the column was written
+ */
+static bool
+sysd_write_datum(struct sysd_write_stats *stats,
+                 const struct ovsdb_idl_row *row,
+                 const struct ovsdb_idl_column *column,
+                 struct ovsdb_datum *datum)
+{
+    struct sysd_write_column *wc = sysd_write_column_get(stats, row, column);
+
+    if (ovsdb_datum_equals(ovsdb_idl_read(row, column), datum,
+                           &column->type)) {
+        ovsdb_datum_destroy(datum, &column->type);
+        wc->elided++;
+        stats->elided++;
+        return false;
+    }
+
+    stats->bytes += strlen(column->name);
+    stats->bytes += sysd_write_atoms_bytes(datum->keys, datum->n,
+                                           column->type.key.type);
+    if (datum->values) {
+        stats->bytes += sysd_write_atoms_bytes(datum->values, datum->n,
+                                               column->type.value.type);
+    }
+
+    ovsdb_idl_txn_write(row, column, datum);
+    wc->written++;
+    stats->written++;
+    return true;
+
+} /* sysd_write_datum */
+
+bool
+sysd_write_integer(struct sysd_write_stats *stats,
+                   const struct ovsdb_idl_row *row,
+                   const struct ovsdb_idl_column *column, int64_t value)
+{
+    return sysd_write_integers(stats, row, column, &value, 1);
+
+} /* sysd_write_integer */
+
+bool
+sysd_write_integers(struct sysd_write_stats *stats,
+                    const struct ovsdb_idl_row *row,
+                    const struct ovsdb_idl_column *column,
+                    const int64_t *values, size_t n)
+{
+    struct ovsdb_datum datum;
+    size_t i;
+
+    datum.n = n;
+    datum.keys = n ? xmalloc(n * sizeof *datum.keys) : NULL;
+    datum.values = NULL;
+    for (i = 0; i < n; i++) {
+        datum.keys[i].integer = values[i];
+    }
+    ovsdb_datum_sort_unique(&datum, OVSDB_TYPE_INTEGER, OVSDB_TYPE_VOID);
+    return sysd_write_datum(stats, row, column, &datum);
+
+} /* sysd_write_integers */
+
+bool
+sysd_write_bool(struct sysd_write_stats *stats,
+                const struct ovsdb_idl_row *row,
+                const struct ovsdb_idl_column *column, bool value)
+{
+    struct ovsdb_datum datum;
+
+    datum.n = 1;
+    datum.keys = xmalloc(sizeof *datum.keys);
+    datum.keys[0].boolean = value;
+    datum.values = NULL;
+    return sysd_write_datum(stats, row, column, &datum);
+
+} /* sysd_write_bool */
+
+bool
+sysd_write_string(struct sysd_write_stats *stats,
+                  const struct ovsdb_idl_row *row,
+                  const struct ovsdb_idl_column *column, const char *value)
+{
+    struct ovsdb_datum datum;
+
+    /* NULL clears an optional column. */
+    if (value) {
+        datum.n = 1;
+        datum.keys = xmalloc(sizeof *datum.keys);
+        datum.keys[0].string = xstrdup(value);
+    } else {
+        ovsdb_datum_init_empty(&datum);
+    }
+    datum.values = NULL;
+    return sysd_write_datum(stats, row, column, &datum);
+
+} /* sysd_write_string */
+
+bool
+sysd_write_smap(struct sysd_write_stats *stats,
+                const struct ovsdb_idl_row *row,
+                const struct ovsdb_idl_column *column, const struct smap *smap)
+{
+    struct ovsdb_datum datum;
+
+    ovsdb_datum_from_smap(&datum, smap);
+    return sysd_write_datum(stats, row, column, &datum);
+
+} /* sysd_write_smap */
+
+static int
+sysd_write_column_compare(const void *a_, const void *b_)
+{
+    const struct sysd_write_column *const *a = a_;
+    const struct sysd_write_column *const *b = b_;
+
+    return strcmp((*a)->name, (*b)->name);
+}
+
+/*
+ * Function       : sysd_write_format
+ * Responsibility : formats the columns sysd wrote, with the writes made
+ *                  and dropped for each, for ops-sysd/txn-stats
+ * Parameters     : stats, ds
+ * Returns        : void
+ */
+void
+sysd_write_format(const struct sysd_write_stats *stats, struct ds *ds)
+{
+    const struct sysd_write_column **sorted;
+    const struct sysd_write_column *wc;
+    size_t n = 0, i;
+
+    sorted = xmalloc(MAX(hmap_count(&stats->columns), 1) * sizeof *sorted);
+    HMAP_FOR_EACH (wc, hmap_node, &stats->columns) {
+        sorted[n++] = wc;
+    }
+    qsort(sorted, n, sizeof *sorted, sysd_write_column_compare);
+
+    ds_put_format(ds, "%-40s %10s %10s\n", "column", "written", "elided");
+    for (i = 0; i < n; i++) {
+        ds_put_format(ds, "%-40s %10llu %10llu\n", sorted[i]->name,
+                      sorted[i]->written, sorted[i]->elided);
+    }
+    free(sorted);
+
+} /* sysd_write_format */
+
+void
+sysd_write_reset(struct sysd_write_stats *stats)
+{
+    struct sysd_write_column *wc;
+
+    HMAP_FOR_EACH (wc, hmap_node, &stats->columns) {
+        wc->written = wc->elided = 0;
+    }
+
+} /* sysd_write_reset */
+/** @} end of group ops-sysd */
@@ -0,0 +1,170 @@
+#!/usr/bin/python
+#
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+
+import time
+
+from mininet.net import Mininet
+from mininet.node import Host
+from mininet.topo import SingleSwitchTopo
+from opsvsi.opsvsitest import info
+from opsvsi.opsvsitest import OpsVsiTest
+from opsvsi.opsvsitest import OpsVsiLink
+from opsvsi.opsvsitest import VsiOpenSwitch
+
+
+OVS_VSCTL = "/usr/bin/ovs-vsctl "
+OVS_APPCTL = "/usr/bin/ovs-appctl "
+OVSDB_TOOL = "/usr/bin/ovsdb-tool "
+OPS_SYSD = "/usr/bin/ops-sysd "
+
+DB_FILE = "/var/run/openvswitch/ovsdb.db"
+SCHEMA_FILE = "/usr/share/openvswitch/vswitch.ovsschema"
+EMIT_FILE = "/tmp/ops-sysd-emitted-db.json"
+HW_DESC_DIR = "/etc/openswitch/hwdesc"
+
+PER_BOX_MARKER = "per_box_values"
+PER_BOX_PLACEHOLDER = "@PER_BOX@"
+ZERO_MAC = "00:00:00:00:00:00"
+
+
+class EmitDbTest(OpsVsiTest):
+    """Mininet based OpenSwitch component test class.
+
+    This class will be instantiated by the py.test TestRunner below.
+    """
+    def setupNet(self):
+        # Create a topology with single openswitch.
+        switch_opts = self.getSwitchOpts()
+        intfd_topo = SingleSwitchTopo(k=0, sopts=switch_opts)
+        self.net = Mininet(intfd_topo, switch=VsiOpenSwitch,
+                           host=Host, link=OpsVsiLink,
+                           controller=None, build=True)
+        self.s1 = self.net.switches[0]
+
+    def setup(self):
+        pass
+
+    def teardown(self):
+        self.s1.cmd("/bin/rm -f " + EMIT_FILE)
+
+    def check_seeded_db(self):
+        """sysd fills in the per-box values of an emitted database."""
+        self.s1.cmd(OPS_SYSD + "--emit-db=" + EMIT_FILE +
+                    " --hw-desc-dir=" + HW_DESC_DIR)
+        out = self.s1.cmd("/bin/cat " + EMIT_FILE)
+        assert PER_BOX_MARKER in out and PER_BOX_PLACEHOLDER in out, \
+            "--emit-db did not write a database to patch: " + out
+
+        self.__stop()
+        self.__start_ovsdb(EMIT_FILE)
+        self.__sleep(3)
+        self.__start_sysd()
+        self.__wait_until_per_box_values_are_set()
+
+        out = self.s1.ovscmd(OVS_VSCTL + "--bare --columns=other_info list "
+                             "subsystem")
+        assert PER_BOX_PLACEHOLDER not in out, \
+            "A FRU value was left as the placeholder: " + out
+
+        for column in ["system_mac", "management_mac"]:
+            mac = self.__get_system(column)
+            assert mac and mac != ZERO_MAC, \
+                "System %s was not set: %s" % (column, mac)
+
+    def __get_system(self, column):
+        out = self.s1.ovscmd(OVS_VSCTL + "get system . " + column)
+        return out.replace('\r\n', '').strip('"')
+
+    def __stop(self):
+        self.__stop_sysd()
+        self.__stop_ovsdb()
+        self.__sleep(3)
+
+    def __start_sysd(self):
+        self.s1.cmd("/bin/systemctl start ops-sysd")
+
+    def __stop_sysd(self):
+        self.s1.cmd(OVS_APPCTL + "-t ops-sysd exit")
+
+    def __start_ovsdb(self, seed):
+        """Create a DB file from 'seed' and load it into ovsdb-server."""
+
+        # Create an empty database file and insert the emitted rows.
+        self.s1.cmd(OVSDB_TOOL + "create " + DB_FILE + " " + SCHEMA_FILE)
+        self.s1.cmd(OVSDB_TOOL + "transact " + DB_FILE +
+                    " \"$(/bin/cat " + seed + ")\"")
+
+        # Load the newly created DB into ovsdb-server
+        self.s1.cmd(OVS_APPCTL + "-t ovsdb-server ovsdb-server/add-db " +
+                    DB_FILE)
+
+    def __stop_ovsdb(self):
+        """Remove the OpenSwitch DB from ovsdb-server.
+
+        It also removes the DB file from the file system.
+        """
+
+        # Remove the database from the ovsdb-server.
+        self.s1.cmd(OVS_APPCTL +
+                    "-t ovsdb-server ovsdb-server/remove-db OpenSwitch")
+
+        # Remove the DB file from the file system.
+        self.s1.cmd("/bin/rm -f " + DB_FILE)
+
+    def __wait_until_per_box_values_are_set(self):
+        """Wait until sysd has removed the per-box marker."""
+        cmd = OVS_VSCTL + "--bare --columns=other_info list subsystem"
+        wait_count = 20
+        while wait_count > 0:
+            out = self.s1.ovscmd(cmd)
+            if out.strip() and PER_BOX_MARKER not in out:
+                break
+
+            info(out)
+            wait_count -= 1
+            self.__sleep(1)
+        assert wait_count != 0, \
+            "sysd did not fill in the per-box values of the database."
+
+    def __sleep(self, tm=.5):
+        time.sleep(tm)
+
+
+class TestRunner:
+    """py.test based test runner class."""
+    @classmethod
+    def setup_class(cls):
+        # Create the Mininet topology based on mininet.
+        cls.test = EmitDbTest()
+
+    @classmethod
+    def teardown_class(cls):
+        # Stop the Docker containers, and
+        # mininet topology
+        cls.test.net.stop()
+
+    def setup(self):
+        self.test.setup()
+
+    def teardown(self):
+        self.test.teardown()
+
+    def __del__(self):
+        del self.test
+
+    def test_seeded_db(self):
+        self.test.check_seeded_db()
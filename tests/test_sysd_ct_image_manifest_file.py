@@ -81,6 +81,106 @@ class ImageManifestTest(OpsVsiTest):
         ret = cmp(ovsdb_daemons_list, file_daemons_list)
         assert ret == 0, "incorrect image.manifest info."
 
+    def hw_levels_read(self, file_name, levels, daemon_levels):
+        """Testing ops-sysd derives readiness levels from the manifest
+
+        Test if the hw_stage and depends_on declarations of the image
+        manifest file give each hardware daemon the expected level.
+        """
+        self.__copy_image_manifest_file(file_name)
+        self.__start()
+
+        out = self.s1.cmd(OVS_APPCTL +
+                          "-t ops-sysd ops-sysd/dump --json daemons")
+        dump = json.loads(out)['daemons']
+        assert dump['hw_levels'] == levels, "incorrect number of levels."
+        for entry in dump['daemons']:
+            assert entry['hw_level'] == daemon_levels[entry['name']], \
+                "incorrect level for " + entry['name']
+
+    def ready_deadline_read(self, file_name, daemon):
+        """Testing ops-sysd gives up on a h/w daemon at its deadline
+
+        Test if a h/w daemon that never reports, and whose manifest entry
+        lets sysd proceed without it, is marked expired and does not hold
+        System:cur_hw back.
+        """
+        self.__copy_image_manifest_file(file_name)
+        self.__start()
+
+        wait_count = 20
+        while wait_count > 0:
+            out = self.s1.ovscmd(OVS_VSCTL + "get System . cur_hw")
+            if out.strip() == "1":
+                break
+            wait_count -= 1
+            self.__sleep(1)
+        assert wait_count != 0, "System:cur_hw was never set."
+
+        out = self.s1.ovscmd(OVS_VSCTL + "--format json list daemon")
+        for item in json.loads(out)['data']:
+            if item[3] == daemon:
+                assert item[1] == -1, "Daemon:cur_hw is not marked expired."
+
+        out = self.s1.cmd(OVS_APPCTL +
+                          "-t ops-sysd ops-sysd/dump --json daemons")
+        for entry in json.loads(out)['daemons']['daemons']:
+            if entry['name'] == daemon:
+                assert entry['expired'], "daemon is not reported expired."
+
+    def daemon_restart_read(self, file_name, daemon):
+        """Testing ops-sysd follows a h/w daemon that restarts after boot
+
+        Test if a h/w daemon that resets Daemon:cur_hw and sets it again is
+        counted as re-initialized, without withdrawing System:cur_hw.
+        """
+        self.__copy_image_manifest_file(file_name)
+        self.__start()
+
+        uuid = None
+        out = self.s1.ovscmd(OVS_VSCTL + "--format json list daemon")
+        for item in json.loads(out)['data']:
+            if item[3] == daemon:
+                uuid = item[0][1]
+        assert uuid, "daemon is not in the Daemon table."
+
+        for cur_hw in (1, 0, 1):
+            self.s1.ovscmd(OVS_VSCTL + "set daemon " + uuid +
+                           " cur_hw=" + str(cur_hw))
+            self.__sleep(1)
+            out = self.s1.ovscmd(OVS_VSCTL + "get System . cur_hw")
+            assert out.strip() == "1", "System:cur_hw was withdrawn."
+
+        out = self.s1.cmd(OVS_APPCTL +
+                          "-t ops-sysd ops-sysd/dump --json daemons")
+        for entry in json.loads(out)['daemons']['daemons']:
+            if entry['name'] == daemon:
+                assert entry['generation'] == 2, "restart was not counted."
+                assert not entry['reinitializing'], \
+                    "daemon is still reported re-initializing."
+
+    def image_manifest_reload(self, first_file, second_file):
+        """Testing ops-sysd applies a changed image manifest file
+
+        Test if ops-sysd/reload-manifest brings the Daemon table and
+        System:daemons in line with a new manifest without a restart.
+        """
+        self.__copy_image_manifest_file(first_file)
+        self.__start()
+
+        self.__copy_image_manifest_file(second_file)
+        out = self.s1.cmd(OVS_APPCTL + "-t ops-sysd ops-sysd/reload-manifest")
+        info(out)
+
+        ovsdb_daemons_list = self.__list_daemons()
+        file_daemons_list = self.__read_image_manifest_file(second_file)
+        ret = cmp(ovsdb_daemons_list, file_daemons_list)
+        assert ret == 0, "incorrect image.manifest info after reload."
+
+        out = self.s1.ovscmd(OVS_VSCTL + "get System . daemons")
+        assert out.count(",") + 1 == len(file_daemons_list), \
+            "System:daemons does not match the reloaded manifest."
+
     def __list_daemons(self):
         """Get daemon table from ovsdb-server."""
         daemon_list = {}
@@ -216,3 +316,22 @@ class TestRunner:
     def test_add_random_stuff(self):
         """Add Random_stuff field."""
         self.test.image_manifest_read("image.manifest3")
+
+    def test_staged_hw_levels(self):
+        """Declare readiness stages and dependencies."""
+        self.test.hw_levels_read("image.manifest4", 3,
+                                 {'ops-sysd': 1, 'ops-pmd': 1, 'ops-fand': 2,
+                                  'ops-tempd': 3, 'ops-ledd': 3,
+                                  'ops-powerd': 3})
+
+    def test_ready_deadline_degraded(self):
+        """Proceed without a h/w daemon that never reports."""
+        self.test.ready_deadline_read("image.manifest5", "ops-missingd")
+
+    def test_hw_daemon_restart(self):
+        """Restart a h/w daemon after boot."""
+        self.test.daemon_restart_read("image.manifest6", "ops-faked")
+
+    def test_reload_manifest(self):
+        """Reload a manifest that drops and adds daemons."""
+        self.test.image_manifest_reload("image.manifest", "image.manifest6")
@@ -0,0 +1,220 @@
+#!/usr/bin/python
+#
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+
+import json
+import time
+
+from mininet.net import Mininet
+from mininet.node import Host
+from mininet.topo import SingleSwitchTopo
+from opsvsi.opsvsitest import info
+from opsvsi.opsvsitest import OpsVsiTest
+from opsvsi.opsvsitest import OpsVsiLink
+from opsvsi.opsvsitest import VsiOpenSwitch
+
+
+OVS_VSCTL = "/usr/bin/ovs-vsctl "
+OVS_APPCTL = "/usr/bin/ovs-appctl "
+OVSDB_TOOL = "/usr/bin/ovsdb-tool "
+
+RECORD_FILE = "/var/lib/openswitch/ops-sysd-initial-txn.json"
+KEY_INPUTS = ["hw_desc", "fru", "manifest", "release", "schema"]
+
+
+class InitialConfigReplayTest(OpsVsiTest):
+    """Mininet based OpenSwitch component test class.
+
+    This class will be instantiated by the py.test TestRunner below.
+    """
+    def setupNet(self):
+        # Create a topology with single openswitch.
+        switch_opts = self.getSwitchOpts()
+        intfd_topo = SingleSwitchTopo(k=0, sopts=switch_opts)
+        self.net = Mininet(intfd_topo, switch=VsiOpenSwitch,
+                           host=Host, link=OpsVsiLink,
+                           controller=None, build=True)
+        self.s1 = self.net.switches[0]
+
+    def setup(self):
+        """Start every test from an empty database and no record file."""
+        self.__stop()
+        self.s1.cmd("/bin/rm -f " + RECORD_FILE)
+        self.__start()
+
+    def teardown(self):
+        pass
+
+    def check_record(self):
+        """The initial configuration is recorded with its inputs' hashes."""
+        record = self.__wait_for_record()
+        assert not self.__replayed(), \
+            "The first boot cannot have replayed the initial configuration."
+
+        for name in KEY_INPUTS:
+            assert record["key"].get(name), \
+                "The record has no %s hash." % name
+        assert record["ops"], "The record has no operations."
+
+    def check_replay(self):
+        """A second boot on an empty database replays the record."""
+        self.__wait_for_record()
+        built = self.__count_subsystems()
+
+        self.__stop()
+        self.__start()
+
+        assert self.__replayed(), \
+            "The initial configuration was not replayed."
+        assert self.__count_subsystems() == built, \
+            "The replay did not insert the rows the first boot built."
+
+    def check_stale_record(self):
+        """A record made by another image is not replayed."""
+        release = self.__wait_for_record()["key"]["release"]
+
+        self.__stop()
+        self.s1.cmd("/bin/sed -i s/" + release + "/" + "0" * len(release) +
+                    "/ " + RECORD_FILE)
+        self.__start()
+
+        assert not self.__replayed(), \
+            "A record with another release hash was replayed."
+        assert self.__wait_for_record(release)["key"]["release"] == release, \
+            "The initial configuration was not recorded again."
+
+    def __wait_for_record(self, release=None):
+        """Wait until sysd has written the record file and return it.
+
+        With 'release', also wait until the record has that release hash.
+        """
+        wait_count = 20
+        while wait_count > 0:
+            out = self.s1.cmd("/bin/cat " + RECORD_FILE + " 2>/dev/null")
+            try:
+                record = json.loads(out)
+                if release is None or record["key"]["release"] == release:
+                    return record
+            except ValueError:
+                pass
+
+            info(out)
+            wait_count -= 1
+            self.__sleep(1)
+        assert False, "sysd did not record the initial configuration."
+
+    def __replayed(self):
+        out = self.s1.ovscmd(OVS_APPCTL + "-t ops-sysd ops-sysd/dump timings")
+        for line in out.splitlines():
+            if line.startswith("initial_config_replayed"):
+                return line.split(":")[1].strip() == "true"
+        assert False, "Unexpected dump: " + out
+
+    def __count_subsystems(self):
+        out = self.s1.ovscmd(OVS_VSCTL + "--bare --columns=_uuid list "
+                             "subsystem")
+        return len(out.split())
+
+    def __start(self):
+        self.__start_ovsdb()
+        self.__sleep(3)
+        self.__start_sysd()
+        self.__wait_until_ovsdb_is_up()
+
+    def __stop(self):
+        self.__stop_sysd()
+        self.__stop_ovsdb()
+        self.__sleep(3)
+
+    def __start_sysd(self):
+        self.s1.cmd("/bin/systemctl start ops-sysd")
+
+    def __stop_sysd(self):
+        self.s1.cmd(OVS_APPCTL + "-t ops-sysd exit")
+
+    def __start_ovsdb(self):
+        """Create an empty DB file and load it into ovsdb-server."""
+
+        # Create an empty database file.
+        c = OVSDB_TOOL + "create /var/run/openvswitch/ovsdb.db " \
+                         "/usr/share/openvswitch/vswitch.ovsschema"
+        self.s1.cmd(c)
+
+        # Load the newly created DB into ovsdb-server
+        self.s1.cmd(OVS_APPCTL + "-t ovsdb-server ovsdb-server/add-db "
+                    "/var/run/openvswitch/ovsdb.db")
+
+    def __stop_ovsdb(self):
+        """Remove the OpenSwitch DB from ovsdb-server.
+
+        It also removes the DB file from the file system.
+        """
+
+        # Remove the database from the ovsdb-server.
+        self.s1.cmd(OVS_APPCTL +
+                    "-t ovsdb-server ovsdb-server/remove-db OpenSwitch")
+
+        # Remove the DB file from the file system.
+        self.s1.cmd("/bin/rm -f /var/run/openvswitch/ovsdb.db")
+
+    def __wait_until_ovsdb_is_up(self):
+        """Wait until sysd has written the System row."""
+        cmd = OVS_VSCTL + "--bare --columns=_uuid list system"
+        wait_count = 20
+        while wait_count > 0:
+            out = self.s1.ovscmd(cmd)
+            if out.strip():
+                break
+
+            info(out)
+            wait_count -= 1
+            self.__sleep(1)
+        assert wait_count != 0, "Failed to bring up ovsdb-server."
+
+    def __sleep(self, tm=.5):
+        time.sleep(tm)
+
+
+class TestRunner:
+    """py.test based test runner class."""
+    @classmethod
+    def setup_class(cls):
+        # Create the Mininet topology based on mininet.
+        cls.test = InitialConfigReplayTest()
+
+    @classmethod
+    def teardown_class(cls):
+        # Stop the Docker containers, and
+        # mininet topology
+        cls.test.net.stop()
+
+    def setup(self):
+        self.test.setup()
+
+    def teardown(self):
+        self.test.teardown()
+
+    def __del__(self):
+        del self.test
+
+    def test_record(self):
+        self.test.check_record()
+
+    def test_replay(self):
+        self.test.check_replay()
+
+    def test_stale_record(self):
+        self.test.check_stale_record()
@@ -0,0 +1,213 @@
+#!/usr/bin/python
+#
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+#
+
+import time
+
+from mininet.net import Mininet
+from mininet.node import Host
+from mininet.topo import SingleSwitchTopo
+from opsvsi.opsvsitest import info
+from opsvsi.opsvsitest import OpsVsiTest
+from opsvsi.opsvsitest import OpsVsiLink
+from opsvsi.opsvsitest import VsiOpenSwitch
+
+
+OVS_VSCTL = "/usr/bin/ovs-vsctl "
+OVS_APPCTL = "/usr/bin/ovs-appctl "
+OVSDB_TOOL = "/usr/bin/ovsdb-tool "
+
+RESTORE = OVS_APPCTL + "-t ops-sysd ops-sysd/qos-restore-defaults "
+
+# From the platform qos.yaml.
+DEFAULT_PROFILE = "default"
+FACTORY_DEFAULT_PROFILE = "factory-default"
+COS_0_LOCAL_PRIORITY = "1"
+
+
+class QosRestoreDefaultsTest(OpsVsiTest):
+    """Mininet based OpenSwitch component test class.
+
+    This class will be instantiated by the py.test TestRunner below.
+    """
+    def setupNet(self):
+        # Create a topology with single openswitch.
+        switch_opts = self.getSwitchOpts()
+        intfd_topo = SingleSwitchTopo(k=0, sopts=switch_opts)
+        self.net = Mininet(intfd_topo, switch=VsiOpenSwitch,
+                           host=Host, link=OpsVsiLink,
+                           controller=None, build=True)
+        self.s1 = self.net.switches[0]
+
+    def setup(self):
+        """Start every test from a database sysd just populated."""
+        self.__stop()
+        self.__start()
+
+    def teardown(self):
+        pass
+
+    def check_restore_cos_map(self):
+        """A changed cos map entry goes back to its hw_defaults."""
+        uuid = self.__find("qos_cos_map_entry", "code_point=0")
+        self.s1.ovscmd(OVS_VSCTL + "set qos_cos_map_entry " + uuid +
+                       " local_priority=5")
+
+        out = self.s1.ovscmd(RESTORE + "cos-map")
+        assert "1 row updated" in out, "Unexpected reply: " + out
+
+        value = self.__get("qos_cos_map_entry", uuid, "local_priority")
+        assert value == COS_0_LOCAL_PRIORITY, \
+            "cos map entry 0 was not restored."
+
+    def check_restore_unchanged(self):
+        """Restoring defaults that are already in place writes nothing."""
+        out = self.s1.ovscmd(RESTORE + "all")
+        assert "0 rows updated" in out, "Unexpected reply: " + out
+
+    def check_restore_queue_profile_extra_queue(self):
+        """A profile that only has extra queues is still restored.
+
+        Only the Q_Profile row is written: its map loses the extra queue
+        and none of its Q_Profile_Entry rows change.
+        """
+        factory = self.__find("q_profile", "name=" + FACTORY_DEFAULT_PROFILE)
+        default = self.__find("q_profile", "name=" + DEFAULT_PROFILE)
+
+        # Leave the default profile with one queue more than the factory
+        # default, and every other queue equal.
+        self.s1.ovscmd(OVS_VSCTL + "remove q_profile " + factory +
+                       " q_profile_entries 7")
+        n_queues = self.__count_queues(default)
+
+        out = self.s1.ovscmd(RESTORE + "queue-profile")
+        assert "1 row updated" in out, "Unexpected reply: " + out
+        assert self.__count_queues(default) == n_queues - 1, \
+            "The extra queue of the default profile was not removed."
+
+    def check_restore_unknown_target(self):
+        out = self.s1.ovscmd(RESTORE + "no-such-target")
+        assert "unknown target" in out, "Unexpected reply: " + out
+
+    def __find(self, table, condition):
+        out = self.s1.ovscmd(OVS_VSCTL + "--bare --columns=_uuid find " +
+                             table + " " + condition)
+        uuid = out.strip()
+        assert uuid, "No %s row with %s." % (table, condition)
+        return uuid
+
+    def __get(self, table, uuid, column):
+        out = self.s1.ovscmd(OVS_VSCTL + "get " + table + " " + uuid + " " +
+                             column)
+        return out.replace('\r\n', '')
+
+    def __count_queues(self, uuid):
+        out = self.__get("q_profile", uuid, "q_profile_entries")
+        return len([e for e in out.strip("{}").split(",") if e.strip()])
+
+    def __start(self):
+        self.__start_ovsdb()
+        self.__sleep(3)
+        self.__start_sysd()
+        self.__wait_until_ovsdb_is_up()
+
+    def __stop(self):
+        self.__stop_sysd()
+        self.__stop_ovsdb()
+        self.__sleep(3)
+
+    def __start_sysd(self):
+        self.s1.cmd("/bin/systemctl start ops-sysd")
+
+    def __stop_sysd(self):
+        self.s1.cmd(OVS_APPCTL + "-t ops-sysd exit")
+
+    def __start_ovsdb(self):
+        """Create an empty DB file and load it into ovsdb-server."""
+
+        # Create an empty database file.
+        c = OVSDB_TOOL + "create /var/run/openvswitch/ovsdb.db " \
+                         "/usr/share/openvswitch/vswitch.ovsschema"
+        self.s1.cmd(c)
+
+        # Load the newly created DB into ovsdb-server
+        self.s1.cmd(OVS_APPCTL + "-t ovsdb-server ovsdb-server/add-db "
+                    "/var/run/openvswitch/ovsdb.db")
+
+    def __stop_ovsdb(self):
+        """Remove the OpenSwitch DB from ovsdb-server.
+
+        It also removes the DB file from the file system.
+        """
+
+        # Remove the database from the ovsdb-server.
+        self.s1.cmd(OVS_APPCTL +
+                    "-t ovsdb-server ovsdb-server/remove-db OpenSwitch")
+
+        # Remove the DB file from the file system.
+        self.s1.cmd("/bin/rm -f /var/run/openvswitch/ovsdb.db")
+
+    def __wait_until_ovsdb_is_up(self):
+        """Wait until sysd has written the QoS factory defaults."""
+        cmd = OVS_VSCTL + "--bare --columns=name list q_profile"
+        wait_count = 20
+        while wait_count > 0:
+            out = self.s1.ovscmd(cmd)
+            if FACTORY_DEFAULT_PROFILE in out:
+                break
+
+            info(out)
+            wait_count -= 1
+            self.__sleep(1)
+        assert wait_count != 0, "Failed to bring up ovsdb-server."
+
+    def __sleep(self, tm=.5):
+        time.sleep(tm)
+
+
+class TestRunner:
+    """py.test based test runner class."""
+    @classmethod
+    def setup_class(cls):
+        # Create the Mininet topology based on mininet.
+        cls.test = QosRestoreDefaultsTest()
+
+    @classmethod
+    def teardown_class(cls):
+        # Stop the Docker containers, and
+        # mininet topology
+        cls.test.net.stop()
+
+    def setup(self):
+        self.test.setup()
+
+    def teardown(self):
+        self.test.teardown()
+
+    def __del__(self):
+        del self.test
+
+    def test_restore_cos_map(self):
+        self.test.check_restore_cos_map()
+
+    def test_restore_unchanged(self):
+        self.test.check_restore_unchanged()
+
+    def test_restore_queue_profile_extra_queue(self):
+        self.test.check_restore_queue_profile_extra_queue()
+
+    def test_restore_unknown_target(self):
+        self.test.check_restore_unknown_target()
@@ -17,6 +17,7 @@
 # Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
 # 02111-1307, USA.
 
+import json
 from time import sleep
 from opsvsi.docker import *
 from opsvsi.opsvsitest import *
@@ -156,6 +157,34 @@ class PlatformSystemTests(OpsVsiTest):
             'Test to verify \'show system\' command - FAILED!'
         return True
 
+    def showSystemJsonTest(self):
+
+        # Test to verify show system json command
+
+        s1 = self.net.switches[0]
+        info('''
+##########  Test to verify \'show system json\' command ##########
+''')
+        out = s1.cmdCLI('show system json')
+        start = out.find('{')
+        end = out.rfind('}')
+        assert start >= 0 and end > start, \
+            'Test to verify \'show system json\' command - FAILED!'
+        doc = json.loads(out[start:end + 1])
+
+        assert doc['version'] == 1
+        assert 'openswitch_version' in doc['system']
+        assert 'max_interface_speed' in doc['system']
+        assert [fan['name'] for fan in doc['fans']] == ['Fan_base']
+        assert doc['fans'][0]['rpm'] == 9000
+        assert [led['id'] for led in doc['leds']] == ['Led_base']
+        assert doc['power_supplies'] == [{'name': 'Psu_base',
+                                          'status': 'ok'}]
+        assert doc['temp_sensors'] == [{'name': 'Temp_base',
+                                        'location': 'Chassis',
+                                        'temperature': 20000}]
+        return True
+
 
 class Test_sys:
 
@@ -178,6 +207,12 @@ class Test_sys:
         if self.test.showSystemTest():
             info('''
 ##########  Test to verify \'show system\' command - SUCCESS! ##########
+''')
+
+    def test_show_system_json_command(self):
+        if self.test.showSystemJsonTest():
+            info('''
+##########  Test to verify \'show system json\' command - SUCCESS! ##########
 ''')
 
     def teardown_class(cls):
@@ -0,0 +1,300 @@
+#!/usr/bin/env python
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+"""Validate platform qos.yaml files and compile them into a C table.
+
+usage: qos_defaults_gen.py OUTPUT.c [QOS_YAML ...]
+
+Every qos.yaml is checked against the limits ops-sysd enforces when it
+writes the factory defaults, and emitted as one entry of
+qos_defaults_table (see src/qos_defaults.h).  Each entry is keyed by the
+SHA-1 of the file it came from, so ops-sysd only uses it when the qos.yaml
+found at run time is byte for byte the one compiled in.
+"""
+
+import hashlib
+import sys
+
+import yaml
+
+COS_MAP_ENTRY_COUNT = 8
+DSCP_MAP_ENTRY_COUNT = 64
+MAX_LOCAL_PRIORITY = 7
+TRUST_VALUES = ("none", "cos", "dscp")
+COLOR_VALUES = ("green", "yellow", "red")
+ALGORITHM_VALUES = ("dwrr", "strict")
+
+
+class QosYamlError(Exception):
+    pass
+
+
+def require(cond, fmt, *args):
+    if not cond:
+        raise QosYamlError(fmt % args)
+
+
+def get_int(entry, key, what, lo, hi):
+    require(key in entry, "%s: missing '%s'", what, key)
+    value = entry[key]
+    require(isinstance(value, int) and not isinstance(value, bool),
+            "%s: '%s' must be an integer", what, key)
+    require(lo <= value <= hi, "%s: '%s' %d is outside [%d, %d]",
+            what, key, value, lo, hi)
+    return value
+
+
+def get_str(entry, key, what, choices=None):
+    require(key in entry, "%s: missing '%s'", what, key)
+    value = entry[key]
+    if value is None:
+        value = ""
+    require(not isinstance(value, (dict, list)),
+            "%s: '%s' must be a string", what, key)
+    value = str(value)
+    if choices:
+        require(value in choices, "%s: '%s' must be one of %s",
+                what, key, ", ".join(choices))
+    return value
+
+
+def get_list(doc, key):
+    entries = doc.get(key)
+    require(isinstance(entries, list), "'%s' must be a list", key)
+    return entries
+
+
+def check_code_points(entries, key, count):
+    seen = sorted(e["code_point"] for e in entries)
+    require(seen == list(range(count)),
+            "'%s' must map each code point 0..%d exactly once", key, count - 1)
+
+
+def parse_map(doc, key, count, with_pcp):
+    entries = []
+    for i, entry in enumerate(get_list(doc, key)):
+        what = "%s[%d]" % (key, i)
+        require(isinstance(entry, dict), "%s: must be a mapping", what)
+        parsed = {
+            "code_point": get_int(entry, "code_point", what, 0, count - 1),
+            "local_priority": get_int(entry, "local_priority", what,
+                                      0, MAX_LOCAL_PRIORITY),
+            "color": get_str(entry, "color", what, COLOR_VALUES),
+            "description": get_str(entry, "description", what),
+        }
+        if with_pcp:
+            if "priority_code_point" in entry:
+                parsed["priority_code_point"] = get_int(
+                    entry, "priority_code_point", what,
+                    0, COS_MAP_ENTRY_COUNT - 1)
+            else:
+                parsed["priority_code_point"] = 0
+        entries.append(parsed)
+    check_code_points(entries, key, count)
+    return entries
+
+
+def check_queues(entries, key):
+    queues = [e["queue"] for e in entries]
+    require(len(set(queues)) == len(queues),
+            "'%s' lists a queue more than once", key)
+
+
+def parse_queue_profile(doc):
+    key = "queue_profile_entries"
+    entries = []
+    for i, entry in enumerate(get_list(doc, key)):
+        what = "%s[%d]" % (key, i)
+        require(isinstance(entry, dict), "%s: must be a mapping", what)
+        entries.append({
+            "queue": get_int(entry, "queue", what, 0, MAX_LOCAL_PRIORITY),
+            "local_priority": get_int(entry, "local_priority", what,
+                                      0, MAX_LOCAL_PRIORITY),
+            "description": get_str(entry, "description", what),
+        })
+    return entries
+
+
+def parse_schedule_profile(doc):
+    key = "schedule_profile_entries"
+    entries = []
+    for i, entry in enumerate(get_list(doc, key)):
+        what = "%s[%d]" % (key, i)
+        require(isinstance(entry, dict), "%s: must be a mapping", what)
+        algorithm = get_str(entry, "algorithm", what, ALGORITHM_VALUES)
+        if algorithm == "strict":
+            weight = 0
+        else:
+            weight = get_int(entry, "weight", what, 1, 1024)
+        entries.append({
+            "queue": get_int(entry, "queue", what, 0, MAX_LOCAL_PRIORITY),
+            "algorithm": algorithm,
+            "weight": weight,
+        })
+    check_queues(entries, key)
+    return entries
+
+
+def parse_qos_yaml(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    doc = yaml.safe_load(data)
+    require(isinstance(doc, dict), "top level must be a mapping")
+
+    info = doc.get("qos_info")
+    require(isinstance(info, dict), "'qos_info' must be a mapping")
+    defaults = {
+        "platform": "%s %s" % (doc.get("manufacturer", ""),
+                               doc.get("product_name", "")),
+        "sha1": hashlib.sha1(data).hexdigest(),
+        "default_name": get_str(info, "default_name", "qos_info"),
+        "factory_default_name": get_str(info, "factory_default_name",
+                                        "qos_info"),
+        "trust": get_str(info, "default_qos_trust", "qos_info",
+                         TRUST_VALUES),
+        "cos_map": parse_map(doc, "cos_map_entries",
+                             COS_MAP_ENTRY_COUNT, False),
+        "dscp_map": parse_map(doc, "dscp_map_entries",
+                              DSCP_MAP_ENTRY_COUNT, True),
+        "queue_profile": parse_queue_profile(doc),
+        "schedule_profile": parse_schedule_profile(doc),
+    }
+    require(defaults["default_name"] != defaults["factory_default_name"],
+            "qos_info: default_name and factory_default_name must differ")
+    return defaults
+
+
+def c_string(value):
+    out = []
+    for ch in value:
+        if ch in '"\\':
+            out.append("\\" + ch)
+        elif 0x20 <= ord(ch) < 0x7f:
+            out.append(ch)
+        else:
+            out.append("\\%03o" % (ord(ch) & 0xff))
+    return '"%s"' % "".join(out)
+
+
+def c_fields(entry, keys):
+    fields = []
+    for key in keys:
+        value = entry[key]
+        if isinstance(value, str):
+            value = c_string(value)
+        fields.append(".%s = %s" % (key, value))
+    return "{ %s }" % ", ".join(fields)
+
+
+def emit_array(out, ctype, name, entries, keys):
+    if not entries:
+        return "NULL"
+    out.append("static const %s %s[] = {" % (ctype, name))
+    for entry in entries:
+        out.append("    %s," % c_fields(entry, keys))
+    out.append("};")
+    out.append("")
+    return name
+
+
+def emit(paths, tables):
+    out = [
+        "/* Generated by tools/qos_defaults_gen.py.  Do not edit.",
+        " *",
+        " * Sources:",
+    ]
+    out.extend(" *     %s" % p for p in paths)
+    out.extend([
+        " */",
+        "",
+        "#include <config.h>",
+        "",
+        '#include "qos_defaults.h"',
+        "",
+    ])
+
+    entries = []
+    for i, d in enumerate(tables):
+        prefix = "qos_defaults_%d" % i
+        arrays = {
+            "cos_map": emit_array(
+                out, "YamlCosMapEntry", prefix + "_cos_map", d["cos_map"],
+                ("code_point", "local_priority", "color", "description")),
+            "dscp_map": emit_array(
+                out, "YamlDscpMapEntry", prefix + "_dscp_map", d["dscp_map"],
+                ("code_point", "local_priority", "priority_code_point",
+                 "color", "description")),
+            "queue_profile": emit_array(
+                out, "YamlQueueProfileEntry", prefix + "_queue_profile",
+                d["queue_profile"],
+                ("queue", "local_priority", "description")),
+            "schedule_profile": emit_array(
+                out, "YamlScheduleProfileEntry", prefix + "_schedule_profile",
+                d["schedule_profile"], ("queue", "algorithm", "weight")),
+        }
+        entries.append([
+            "    {",
+            "        .platform = %s," % c_string(d["platform"].strip()),
+            "        .sha1 = %s," % c_string(d["sha1"]),
+            "        .info = {",
+            "            .default_name = %s," % c_string(d["default_name"]),
+            "            .factory_default_name = %s,"
+            % c_string(d["factory_default_name"]),
+            "            .trust = %s," % c_string(d["trust"]),
+            "        },",
+        ])
+        for key in ("cos_map", "dscp_map", "queue_profile",
+                    "schedule_profile"):
+            entries[-1].append("        .%s = %s," % (key, arrays[key]))
+            entries[-1].append("        .n_%s = %d," % (key, len(d[key])))
+        entries[-1].append("    },")
+
+    if entries:
+        out.append("static const struct qos_defaults qos_defaults_entries[] "
+                   "= {")
+        for entry in entries:
+            out.extend(entry)
+        out.append("};")
+        out.append("")
+        out.append("const struct qos_defaults *const qos_defaults_table = "
+                   "qos_defaults_entries;")
+    else:
+        out.append("const struct qos_defaults *const qos_defaults_table = "
+                   "NULL;")
+    out.append("const size_t qos_defaults_table_size = %d;" % len(tables))
+    return "\n".join(out) + "\n"
+
+
+def main(argv):
+    if len(argv) < 2:
+        sys.stderr.write(__doc__)
+        return 1
+
+    output, paths = argv[1], argv[2:]
+    tables = []
+    for path in paths:
+        try:
+            tables.append(parse_qos_yaml(path))
+        except (QosYamlError, yaml.YAMLError, IOError) as e:
+            sys.stderr.write("%s: %s\n" % (path, e))
+            return 1
+
+    with open(output, "w") as f:
+        f.write(emit(paths, tables))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
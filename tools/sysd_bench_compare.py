@@ -0,0 +1,82 @@
+#!/usr/bin/env python
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+"""Compare two sysd-bench runs.
+
+usage: sysd_bench_compare.py [--threshold=PCT] OLD.json NEW.json
+
+OLD.json and NEW.json are the output of "bench/sysd-bench" (see
+bench/sysd_bench.c).  Prints ns/op and allocs/op of each benchmark found
+in both runs with the relative change, and exits with status 1 if any
+benchmark got slower by more than PCT percent (default 10) or now makes
+more allocations per op.
+"""
+
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return dict((b["name"], b) for b in json.load(f)["benchmarks"])
+
+
+def change(old, new):
+    if not old:
+        return 0.0
+    return (new - old) * 100.0 / old
+
+
+def main(argv):
+    threshold = 10.0
+    args = []
+    for arg in argv[1:]:
+        if arg.startswith("--threshold="):
+            threshold = float(arg[len("--threshold="):])
+        elif arg in ("-h", "--help"):
+            print(__doc__)
+            return 0
+        else:
+            args.append(arg)
+    if len(args) != 2:
+        sys.stderr.write(__doc__)
+        return 2
+
+    old, new = load(args[0]), load(args[1])
+    regressed = False
+
+    print("%-40s %14s %14s %8s %10s %10s" % ("benchmark", "old ns/op",
+                                              "new ns/op", "delta",
+                                              "old allocs", "new allocs"))
+    for name in sorted(set(old) & set(new)):
+        o, n = old[name], new[name]
+        delta = change(o["ns_per_op"], n["ns_per_op"])
+        flag = ""
+        if delta > threshold or n["allocs_per_op"] > o["allocs_per_op"]:
+            flag = "  <-- regression"
+            regressed = True
+        print("%-40s %14.1f %14.1f %+7.1f%% %10.1f %10.1f%s"
+              % (name, o["ns_per_op"], n["ns_per_op"], delta,
+                 o["allocs_per_op"], n["allocs_per_op"], flag))
+
+    for name in sorted(set(old) ^ set(new)):
+        print("%-40s only in %s" % (name, args[0] if name in old
+                                    else args[1]))
+
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+# (c) Copyright 2016 Hewlett Packard Enterprise Development LP
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at
+#
+#         http://www.apache.org/licenses/LICENSE-2.0
+#
+#    Unless required by applicable law or agreed to in writing, software
+#    distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+#    WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+#    License for the specific language governing permissions and limitations
+#    under the License.
+
+"""Convert an ops-sysd trace file into a Chrome trace-event timeline.
+
+usage: sysd_trace_decode.py TRACE_FILE [OUTPUT.json]
+
+TRACE_FILE is written by "ovs-appctl -t ops-sysd ops-sysd/trace save FILE"
+(see src/sysd_trace.c).  The output loads in chrome://tracing or Perfetto.
+Timestamps are relative to the oldest record in the file.
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = b"SYSDTRC\0"
+VERSION = 1
+HEADER = "8sIIQQ"
+RECORD = "QHBBIQ"
+
+
+class TraceError(Exception):
+    pass
+
+
+def read_trace(data):
+    """Returns (names, records) from the contents of a trace file.
+
+    'names' maps each kind ("event", "stage", "site", "daemon") to a
+    dictionary from number to name.  The file is in the byte order of the
+    switch that wrote it, which is detected from the version field."""
+    for order in "<>":
+        hdr_fmt = order + HEADER
+        if len(data) < struct.calcsize(hdr_fmt):
+            raise TraceError("file is too short")
+        magic, version, record_size, n_records, names_len = \
+            struct.unpack_from(hdr_fmt, data)
+        if magic != MAGIC:
+            raise TraceError("not an ops-sysd trace file")
+        if version == VERSION:
+            break
+    else:
+        raise TraceError("unsupported trace file version")
+
+    rec_fmt = order + RECORD
+    if record_size != struct.calcsize(rec_fmt):
+        raise TraceError("unexpected record size %d" % record_size)
+
+    offset = struct.calcsize(hdr_fmt)
+    names = {}
+    table = data[offset:offset + names_len].decode("utf-8", "replace")
+    for line in table.splitlines():
+        kind, number, name = line.split(" ", 2)
+        names.setdefault(kind, {})[int(number)] = name
+    offset += names_len
+
+    if len(data) < offset + n_records * record_size:
+        raise TraceError("file is truncated")
+    records = [struct.unpack_from(rec_fmt, data, offset + i * record_size)
+               for i in range(n_records)]
+    return names, records
+
+
+def to_chrome(names, records):
+    """Returns the Chrome trace-event document for 'records'."""
+    def name_of(kind, number):
+        return names.get(kind, {}).get(number, "%s%d" % (kind, number))
+
+    events = []
+    open_spans = {}
+    base = records[0][0] if records else 0
+    for usec, event, phase, _, arg, arg2 in records:
+        event_name = name_of("event", event)
+        phase = chr(phase)
+        args = {}
+        if event_name == "startup":
+            title = "startup:" + name_of("stage", arg)
+            if phase == "E":
+                args["rc"] = arg2
+        elif event_name == "commit":
+            title = "commit:" + name_of("site", arg)
+            if phase == "E":
+                args["status"] = arg2
+        elif event_name == "i2c":
+            title = "i2c"
+            args["bytes"] = arg
+            if phase == "E":
+                args["rc"] = arg2
+        elif event_name == "cur_hw":
+            title = "cur_hw:" + name_of("daemon", arg)
+            args["cur_hw"] = arg2
+        elif event_name == "seqno_change":
+            title = "seqno_change"
+            args["seqno"] = arg
+        else:
+            title = event_name
+
+        # The ring may have overwritten the start of a span whose end it
+        # still holds; such an end would close an unrelated span.
+        if phase == "B":
+            open_spans[title] = open_spans.get(title, 0) + 1
+        elif phase == "E":
+            if not open_spans.get(title):
+                continue
+            open_spans[title] -= 1
+
+        entry = {"name": title, "ph": phase, "ts": usec - base,
+                 "pid": 1, "tid": 1, "args": args}
+        if phase == "i":
+            entry["s"] = "t"
+        events.append(entry)
+
+    return {"traceEvents": events, "displayTimeUnit": "ms",
+            "otherData": {"source": "ops-sysd"}}
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+
+    with open(argv[1], "rb") as f:
+        data = f.read()
+    try:
+        names, records = read_trace(data)
+    except TraceError as e:
+        sys.stderr.write("%s: %s\n" % (argv[1], e))
+        return 1
+
+    doc = json.dumps(to_chrome(names, records), indent=1)
+    if len(argv) == 3:
+        with open(argv[2], "w") as f:
+            f.write(doc)
+    else:
+        sys.stdout.write(doc + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))